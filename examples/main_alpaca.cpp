@@ -6,33 +6,15 @@
 #include "Executor.hpp"
 #include "express/Express.hpp"
 #include "tokenizers/BPE/Bpe.hpp"
+#include "backends/cpu/compute/Reduce.hpp"
 using namespace mllm;
 
-unsigned int argmax(const std::vector<float>& scores) {
-    if(scores.empty()) {
-        throw std::invalid_argument("Input vector is empty");
-    }
-    unsigned int maxIndex = 0;
-    float maxValue = scores[0];
-    for(size_t i = 1; i < scores.size(); ++i) {
-        if(scores[i] > maxValue) {
-            maxIndex = i;
-            maxValue = scores[i];
-        }
-    }
-    return maxIndex;
-}
 unsigned int postProcessing(shared_ptr<Tensor> result, shared_ptr<Tensor>& out_result){
     assert(result->batch() == 1);
     assert(result->head() ==  1);
     out_result->reshape(1, 1, 1, 1);
     out_result->alloc();
-    vector<float> scores;
-    for (int i = 0; i < result->dimension(); ++i) {
-        auto value = result->dataAt<float>(0, 0, result->sequence()-1, i);
-        scores.push_back(value);
-    }
-    auto token_idx =  argmax(scores);
+    auto token_idx = (unsigned int)reduce_row(REDUCE_ARGMAX, *result, 0, 0, result->sequence() - 1);
     out_result->setDataAt<float>(0, 0, 0, 0, token_idx);
     return token_idx;
 }
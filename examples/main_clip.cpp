@@ -7,6 +7,7 @@
 #include "express/Express.hpp"
 #include "tokenizers/BPE/Bpe.hpp"
 #include "processor/ClipPreProcess.hpp"
+#include "processor/ZeroShot.hpp"
 #include <cmath>
 #include <vector>
 #include <numeric>
@@ -120,12 +121,117 @@ void CLIP(Context* c) {
     auto *o = _Matmul( {i, p}, false, true, "matmul");
     o = _Scale( {o}, 100.0, 0.0F, false, "scale");
 }
+// the two towers on their own, for zero-shot classification against cached label embeddings
+static const int projection_dim = 512;
+void CLIPText(Context* c) {
+    auto *i = _Input(c, {}, "input_ids");
+    i = transformer(c, i);
+    _Linear( {i}, 512, projection_dim, false, "text_projection");
+}
+void CLIPVision(Context* c) {
+    auto *p = _Input(c, {}, "input_imgs");
+    p = vit(c, p);
+    _Linear( {p}, 768, projection_dim, false, "visual_projection");
+}
+vector<float> embedding(shared_ptr<Tensor> result) {
+    vector<float> values(result->dimension());
+    for (int d = 0; d < result->dimension(); ++d) {
+        values[d] = result->dataAt<float>(0, 0, 0, d);
+    }
+    return values;
+}
+void freeContext(Context *c) {
+    for (auto *op : c->net_ops) {
+        delete op;
+    }
+    for (auto *tensor : c->net_tensors) {
+        delete tensor;
+    }
+}
+/*
+ * Zero-shot mode: the label prompts go through the text tower only when the cache is missing or was written
+ * for other labels. Each image then costs the vision tower and one similarity GEMV against the cached labels.
+ */
+int zeroShot(cmdline::parser &cmdParser, BPETokenizer *tokenizer, const string &model_path, int thread_num) {
+    vector<string> labels;
+    std::ifstream label_file(cmdParser.get<string>("labels"));
+    std::string line;
+    while (std::getline(label_file, line)) {
+        if (!line.empty()) {
+            labels.push_back(line);
+        }
+    }
+    if (labels.empty()) {
+        std::cerr << "No labels in " << cmdParser.get<string>("labels") << std::endl;
+        return -1;
+    }
+    ParamLoader param_loader(model_path);
+    ZeroShotClassifier classifier(thread_num);
+    // the text tower is only built if a label has to be encoded
+    std::unique_ptr<Context> text_ctx;
+    std::unique_ptr<Net> text_net;
+    std::unique_ptr<Executor> text_ex;
+    auto encode = [&](const string &label) {
+        if (text_net == nullptr) {
+            text_ctx.reset(new Context());
+            CLIPText(text_ctx.get());
+            BackendConfig bn;
+            text_net.reset(new Net(bn));
+            text_net->convert(text_ctx->sub_param_, BackendType::MLLM_CPU, thread_num);
+            text_ex.reset(new Executor(&param_loader));
+            text_ex->setup(text_net.get());
+        }
+        vector<token_id_t> tokens_id = {};
+        tokenizer->tokenize(label, tokens_id, true, true, "</w>");
+        shared_ptr<Tensor> input_text = std::make_shared<Tensor>();
+        BPETokenizer::tokens2Tensor(text_net.get(), {tokens_id}, input_text);
+        text_ex->run(text_net.get(), {input_text});
+        return embedding(text_ex->result()[0]);
+    };
+    if (!classifier.prepare(labels, encode, cmdParser.get<string>("cache"), ZeroShotClassifier::modelIdentity(model_path), projection_dim)) {
+        std::cout << "Encoded " << labels.size() << " labels into " << cmdParser.get<string>("cache") << std::endl;
+        freeContext(text_ctx.get());
+    }
+
+    std::unique_ptr<Context> c_ptr(new Context());
+    auto *c = c_ptr.get();
+    CLIPVision(c);
+    BackendConfig bn;
+    Net net(bn);
+    net.convert(c->sub_param_, BackendType::MLLM_CPU, thread_num);
+    Executor ex(&param_loader);
+    ex.setup(&net);
+
+    std::unique_ptr<ClipProcessor> clip_processor(new ClipProcessor(tokenizer));
+    std::stringstream images(cmdParser.get<string>("image"));
+    string image;
+    while (std::getline(images, image, ',')) {
+        clip_processor->pixel_values_.clear();
+        clip_processor->PreProcessImages({image});
+        shared_ptr<Tensor> input_img = std::make_shared<Tensor>();
+        clip_processor->Img2Tensor(net.backends()[BackendType::MLLM_CPU].get(), input_img, clip_processor->pixel_values_[0]);
+        ex.run(&net, {input_img});
+        auto features = embedding(ex.result()[0]);
+        auto matches = classifier.classify(features.data(), 1, cmdParser.get<int>("topk"));
+        std::cout << image << std::endl;
+        for (const auto &match : matches[0]) {
+            std::cout << "  " << match.probability << "  " << classifier.labels()[match.label] << std::endl;
+        }
+    }
+    freeContext(c);
+    return 0;
+}
+
 int main(int argc, char **argv) {
     cmdline::parser cmdParser;
     cmdParser.add<string>("vocab", 'v', "specify mllm tokenizer model path", false, "../vocab/clip_vocab.mllm");
     cmdParser.add<string>("model", 'm', "specify mllm model path", false, "../models/clip-vit-base-patch32-q4_k.mllm");
     cmdParser.add<string>("merges", 'f', "specify mllm tokenizer merges.txt path", false, "../vocab/clip_merges.txt");
     cmdParser.add<int>("thread", 't', "num of threads", false, 4);
+    cmdParser.add<string>("labels", 'l', "zero-shot mode: file with one label prompt per line", false, "");
+    cmdParser.add<string>("cache", 'c', "zero-shot mode: label embedding cache, rebuilt if the labels change", false, "../models/clip_labels.cache");
+    cmdParser.add<string>("image", 'i', "zero-shot mode: images to classify, separated by ','", false, "../assets/cat.jpg");
+    cmdParser.add<int>("topk", 'k', "zero-shot mode: number of labels printed per image", false, 5);
     cmdParser.parse_check(argc, argv);
 
     string vocab_path = cmdParser.get<string>("vocab");
@@ -133,19 +239,6 @@ int main(int argc, char **argv) {
     string merges_path = cmdParser.get<string>("merges");
     int thread_num = cmdParser.get<int>("thread");
 
-    std::unique_ptr<Context> c_ptr(new Context());
-    auto *c = c_ptr.get();
-
-    CLIP(c);
-
-    BackendConfig bn;
-    Net net(bn);
-    net.convert(c->sub_param_, BackendType::MLLM_CPU, thread_num);
-
-    ParamLoader param_loader(model_path);
-    Executor ex(&param_loader);
-    ex.setup(&net);
-
     auto tokenizer = new BPETokenizer(vocab_path);
     std::unordered_map<string,unsigned> merge_rank;
     auto merge_file = std::ifstream(merges_path);
@@ -164,6 +257,23 @@ int main(int argc, char **argv) {
     tokenizer->setMergeRank(merge_rank);
     tokenizer->setSpecialToken("<|startoftext|>","<|endoftext|>");
 
+    if (!cmdParser.get<string>("labels").empty()) {
+        return zeroShot(cmdParser, tokenizer, model_path, thread_num);
+    }
+
+    std::unique_ptr<Context> c_ptr(new Context());
+    auto *c = c_ptr.get();
+
+    CLIP(c);
+
+    BackendConfig bn;
+    Net net(bn);
+    net.convert(c->sub_param_, BackendType::MLLM_CPU, thread_num);
+
+    ParamLoader param_loader(model_path);
+    Executor ex(&param_loader);
+    ex.setup(&net);
+
     vector<string> in_strs = {"a photo of a cat", "a photo of a dog"};
     auto tokens_ids = vector<vector<token_id_t>>();
     for (auto in_str : in_strs) {
@@ -189,11 +299,6 @@ int main(int argc, char **argv) {
     // ex.perf();
 
     // free memory
-    for (auto *op : c->net_ops) {
-        delete op;
-    }
-    for (auto *tensor : c->net_tensors) {
-        delete tensor;
-    }
+    freeContext(c);
     return 0;
 }
@@ -6,37 +6,68 @@
 #include "Executor.hpp"
 #include "express/Express.hpp"
 #include "tokenizers/BPE/Bpe.hpp"
+#include "backends/cpu/compute/Reduce.hpp"
+#include "backends/cpu/CPUBackend.hpp"
+#include "backends/cpu/CPUActivationStats.hpp"
+#include "Timing.hpp"
+#include <fstream>
+#include <sstream>
 using namespace mllm;
 
-unsigned int argmax(const std::vector<float> &scores) {
-    if (scores.empty()) {
-        throw std::invalid_argument("Input vector is empty");
-    }
-    unsigned int maxIndex = 0;
-    float maxValue = scores[0];
-    for (size_t i = 1; i < scores.size(); ++i) {
-        if (scores[i] > maxValue) {
-            maxIndex = i;
-            maxValue = scores[i];
-        }
-    }
-    return maxIndex;
-}
 unsigned int postProcessing(shared_ptr<Tensor> result, shared_ptr<Tensor> &out_result) {
     assert(result->batch() == 1);
     assert(result->head() == 1);
     out_result->reshape(1, 1, 1, 1);
     out_result->alloc();
-    vector<float> scores;
-    for (int i = 0; i < result->dimension(); ++i) {
-        auto value = result->dataAt<float>(0, 0, result->sequence() - 1, i);
-        scores.push_back(value);
-    }
-    auto token_idx = argmax(scores);
+    auto token_idx = (unsigned int)reduce_row(REDUCE_ARGMAX, *result, 0, 0, result->sequence() - 1);
     out_result->setDataAt<float>(0, 0, 0, 0, token_idx);
     return token_idx;
 }
 
+// perplexity of the model on a text file, read in windows of `window` tokens that each start a new sequence
+void perplexity(Net &net, Executor &ex, BPETokenizer &tokenizer, const string &path, int window) {
+    std::ifstream file(path);
+    std::stringstream text;
+    text << file.rdbuf();
+    vector<token_id_t> tokens;
+    tokenizer.tokenize(" " + text.str(), tokens, true);
+    double nll = 0;
+    int64_t count = 0;
+    uint64_t prefill_us = 0;
+    size_t prefill_tokens = 0;
+    shared_ptr<Tensor> input = std::make_shared<Tensor>();
+    for (size_t start = 0; start + 1 < tokens.size(); start += window) {
+        vector<token_id_t> chunk(tokens.begin() + start, tokens.begin() + std::min(tokens.size(), start + window));
+        if (chunk.size() < 2) {
+            break;
+        }
+        for (auto &graph : net.subGraph()) {
+            graph.second->restoreState({});
+        }
+        BPETokenizer::token2Tensor(&net, chunk, input);
+        const uint64_t t_start = mllm_time_us();
+        ex.run(&net, {input});
+        prefill_us += mllm_time_us() - t_start;
+        prefill_tokens += chunk.size();
+        auto &logits = *ex.result()[0];
+        for (int s = 0; s + 1 < (int)chunk.size(); ++s) {
+            const float *row = logits.ptrAt<float>(0, 0, s, 0);
+            const float max = reduce_row(REDUCE_MAX, logits.dimension(), row);
+            double sum = 0;
+            for (int v = 0; v < logits.dimension(); ++v) {
+                sum += std::exp(row[v] - max);
+            }
+            nll -= row[chunk[s + 1]] - max - std::log(sum);
+            count++;
+        }
+        std::cout << "[" << start + chunk.size() << "/" << tokens.size() << "] perplexity " << std::exp(nll / count) << std::endl;
+    }
+    if (count > 0) {
+        std::cout << "perplexity: " << std::exp(nll / count) << " over " << count << " tokens, prefill "
+                  << (double)prefill_tokens * 1e6 / (double)prefill_us << " tokens/s" << std::endl;
+    }
+}
+
 NetTensor *Attention(NetTensor *x, int embedding_size, int hidden_size, int head_size, int cache_max, string name) {
     auto *q = _Linear({x}, embedding_size, hidden_size * head_size, false, name + ".wq");
     auto *k = _Linear({x}, embedding_size, hidden_size * head_size, false, name + ".wk");
@@ -86,12 +117,29 @@ int main(int argc, char **argv) {
     cmdParser.add<string>("model", 'm', "specify mllm model path", false, "../models/llama-2-7b-chat-q4_k.mllm");
     cmdParser.add<int>("limits", 'l', "max KV cache size", false, 400);
     cmdParser.add<int>("thread", 't', "num of threads", false, 4);
+    cmdParser.add<int>("numa", '\0', "num of NUMA nodes to split large layers across, 0 for all", false, 1);
+    cmdParser.add<int>("decode_cpus", '\0', "num of CPUs reserved for decode, 0 to share all", false, 0);
+    cmdParser.add<string>("kv_spill", '\0', "directory to spill old KV cache tokens to, empty to keep them in RAM", false, "");
+    cmdParser.add<int>("kv_ram", '\0', "MB of KV cache tokens kept in RAM when spilling", false, 256);
+    cmdParser.add<string>("tune", '\0', "kernel tuning cache path, tune on first use", false, "");
+    cmdParser.add<string>("ppl", '\0', "text file to measure the perplexity on instead of chatting", false, "");
+    cmdParser.add<string>("calibrate", '\0', "record the activation stats of the Linears to this file, for quantize W8A8", false, "");
+    cmdParser.add<int>("power", '\0', "power mode: 0 normal, 1 high, 2 low (fewer, smaller cores and CPU-seconds per token)", false, 0);
+    cmdParser.add<int>("prefetch", '\0', "KB at the head of the next op's weights loaded while the current op runs, 0 to disable", false, 0);
     cmdParser.parse_check(argc, argv);
 
     string vocab_path = cmdParser.get<string>("vocab");
     string model_path = cmdParser.get<string>("model");
     int tokens_limit = cmdParser.get<int>("limits");
     int thread_num = cmdParser.get<int>("thread");
+    int numa_nodes = cmdParser.get<int>("numa");
+    int decode_cpus = cmdParser.get<int>("decode_cpus");
+    string kv_spill_dir = cmdParser.get<string>("kv_spill");
+    int kv_ram_mb = cmdParser.get<int>("kv_ram");
+    string tune_path = cmdParser.get<string>("tune");
+    int prefetch_kb = cmdParser.get<int>("prefetch");
+    string ppl_path = cmdParser.get<string>("ppl");
+    string calibrate_path = cmdParser.get<string>("calibrate");
 
     auto tokenizer = BPETokenizer(vocab_path);
 
@@ -105,45 +153,66 @@ int main(int argc, char **argv) {
     llama(c, vocab_size, hidden_dim, ffn_hidden_dim, mutil_head_size, tokens_limit);
 
     BackendConfig bn;
+    bn.numa_nodes = numa_nodes;
+    bn.decode_cpus = decode_cpus;
+    bn.kv_spill_dir = kv_spill_dir;
+    bn.kv_ram_budget = (size_t)kv_ram_mb << 20;
+    bn.weight_prefetch = (size_t)prefetch_kb << 10;
+    bn.power = (BackendConfig::PowerMode)cmdParser.get<int>("power");
     Net net(bn);
     net.convert(c->sub_param_, BackendType::MLLM_CPU, thread_num);
 
     ParamLoader param_loader(model_path);
     Executor ex(&param_loader);
     ex.setup(&net);
+    if (!tune_path.empty()) {
+        ex.autotune(&net, c->sub_param_, tune_path, thread_num);
+    }
 
-    vector<string> in_strs = {
-        " Hello, who are you?",
-        " What can you do?",
-        "Please introduce Beijing University of Posts and Telecommunications."};
-    shared_ptr<Tensor> input = std::make_shared<Tensor>();
-    for (int str_i = 0; str_i < in_strs.size(); ++str_i) {
-        auto in_str = in_strs[str_i];
-        if (in_str[0] != ' ') {
-            in_str = ' ' + in_str;
-        }
-        auto tokens_id = vector<token_id_t>();
-        tokenizer.tokenize(in_str, tokens_id, true);
-        if (str_i > 0) {
-            tokens_id[0] = 13;
-        }
-        BPETokenizer::token2Tensor(&net, tokens_id, input);
-        std::cout << "[Q] " << in_str << std::endl;
-        std::cout << "[A] " << std::flush;
-        for (int step = 0; step < 100; step++) {
-            ex.run(&net, {input});
-            auto result = ex.result();
-            auto token_idx = postProcessing(result[0], input);
-            if (token_idx == 2) { // "</s>"
-                break;
+    shared_ptr<ActivationStats> stats;
+    if (!calibrate_path.empty()) {
+        stats = std::make_shared<ActivationStats>();
+        static_cast<CPUBackend *>(net.backends()[MLLM_CPU].get())->setActivationStats(stats);
+    }
+    if (!ppl_path.empty()) {
+        perplexity(net, ex, tokenizer, ppl_path, std::min(tokens_limit, 256));
+    } else {
+        vector<string> in_strs = {
+            " Hello, who are you?",
+            " What can you do?",
+            "Please introduce Beijing University of Posts and Telecommunications."};
+        shared_ptr<Tensor> input = std::make_shared<Tensor>();
+        for (int str_i = 0; str_i < in_strs.size(); ++str_i) {
+            auto in_str = in_strs[str_i];
+            if (in_str[0] != ' ') {
+                in_str = ' ' + in_str;
+            }
+            auto tokens_id = vector<token_id_t>();
+            tokenizer.tokenize(in_str, tokens_id, true);
+            if (str_i > 0) {
+                tokens_id[0] = 13;
+            }
+            BPETokenizer::token2Tensor(&net, tokens_id, input);
+            std::cout << "[Q] " << in_str << std::endl;
+            std::cout << "[A] " << std::flush;
+            for (int step = 0; step < 100; step++) {
+                ex.run(&net, {input});
+                auto result = ex.result();
+                auto token_idx = postProcessing(result[0], input);
+                if (token_idx == 2) { // "</s>"
+                    break;
+                }
+                auto out_token = tokenizer.detokenize({token_idx});
+                std::cout << out_token << std::flush;
             }
-            auto out_token = tokenizer.detokenize({token_idx});
-            std::cout << out_token << std::flush;
+            printf("\n");
         }
-        printf("\n");
-    }
 
-    ex.perf();
+        ex.perf();
+    }
+    if (stats != nullptr && stats->save(calibrate_path)) {
+        std::cout << "activation stats of " << stats->size() << " layers saved to " << calibrate_path << std::endl;
+    }
 
     // free memory
     for (auto *op : c->net_ops) {
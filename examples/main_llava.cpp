@@ -7,6 +7,7 @@
 #include "express/Express.hpp"
 #include "tokenizers/BPE/Bpe.hpp"
 #include "processor/ClipPreProcess.hpp"
+#include "backends/cpu/compute/Reduce.hpp"
 
 void print2DVetcors(std::vector<std::vector<float>> chunk_feats) {
     std::cout << std::fixed;
@@ -29,31 +30,12 @@ void print3DVetcors(std::vector<std::vector<std::vector<float>>> all_clips) {
 int cache_max = 700;
 
 using namespace mllm;
-unsigned int argmax(const std::vector<float> &scores) {
-    if (scores.empty()) {
-        throw std::invalid_argument("Input vector is empty");
-    }
-    unsigned int maxIndex = 0;
-    float maxValue = scores[0];
-    for (size_t i = 1; i < scores.size(); ++i) {
-        if (scores[i] > maxValue) {
-            maxIndex = i;
-            maxValue = scores[i];
-        }
-    }
-    return maxIndex;
-}
 unsigned int postProcessing(shared_ptr<Tensor> result, shared_ptr<Tensor> &out_result, shared_ptr<Tensor> &input_img) {
     assert(result->batch() == 1);
     assert(result->head() == 1);
     out_result->reshape(1, 1, 1, 1);
     out_result->alloc();
-    vector<float> scores;
-    for (int i = 0; i < result->dimension(); ++i) {
-        auto value = result->dataAt<float>(0, 0, result->sequence() - 1, i);
-        scores.push_back(value);
-    }
-    auto token_idx = argmax(scores);
+    auto token_idx = (unsigned int)reduce_row(REDUCE_ARGMAX, *result, 0, 0, result->sequence() - 1);
     out_result->setDataAt<float>(0, 0, 0, 0, token_idx);
     input_img->reshape(0, 0, 0, 0);
     input_img->alloc();
@@ -12,6 +12,7 @@
 #else
 #include <cstdint>
 #include <ctime>
+#include <sys/resource.h>
 #endif
 
 
@@ -41,6 +42,14 @@ inline int64_t mllm_time_us(void) {
     QueryPerformanceCounter(&t);
     return ((t.QuadPart-timer_start) * 1000000) / timer_freq;
 }
+// CPU time of the process, all threads, user and system
+inline int64_t mllm_cpu_time_us(void) {
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    const int64_t k = ((int64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+    const int64_t u = ((int64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+    return (k + u) / 10;
+}
 #else
 inline void mllm_time_init(void) {}
 inline int64_t mllm_time_ms(void) {
@@ -54,6 +63,13 @@ inline int64_t mllm_time_us(void) {
     clock_gettime(CLOCK_MONOTONIC, &ts);
     return (int64_t)ts.tv_sec*1000000 + (int64_t)ts.tv_nsec/1000;
 }
+
+// CPU time of the process, all threads, user and system
+inline int64_t mllm_cpu_time_us(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (int64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
 #endif
 
 }
@@ -47,6 +47,13 @@ enum DataType {
     MLLM_TYPE_I8,
     MLLM_TYPE_I16,
     MLLM_TYPE_I32,
+    MLLM_TYPE_BF16,
+    // 2:4 sparse
+    MLLM_TYPE_Q4_0_24,
+    MLLM_TYPE_Q8_0_24,
+    // bit planes for lookup-table GEMV
+    MLLM_TYPE_Q2_LUT,
+    MLLM_TYPE_Q3_LUT,
     MLLM_TYPE_COUNT,
 };
 enum ChlType {
@@ -120,6 +127,8 @@ typedef __fp16 mllm_fp16_t;
 #else
 typedef uint16_t mllm_fp16_t;
 #endif
+// bfloat16: the high half of an fp32, kept as its bits
+typedef uint16_t mllm_bf16_t;
 
 //#define MLLM_QKK_64
 #ifdef MLLM_QKK_64
@@ -181,6 +190,48 @@ typedef struct {
 } block_q8_0;
 #pragma pack()
 
+/*
+ * 2:4 sparse blocks: of every group of 4 consecutive weights at most 2 are not zero, and only those 2 are
+ * stored, QK_24 / 2 quants for QK_24 weights. idx holds the positions of the kept weights in their group,
+ * 2 bits each, 4 bits per group, the groups of byte i being 2i (low nibble) and 2i + 1.
+ */
+#define QK_24 32
+#pragma pack(1)
+typedef struct {
+    mllm_fp16_t d;          // delta
+    uint8_t idx[QK_24 / 8]; // positions of the kept weights
+    uint8_t qs[QK_24 / 4];  // nibbles, kept weight 2j in the low half of qs[j]
+} block_q4_0_24;
+static_assert(sizeof(block_q4_0_24) == sizeof(mllm_fp16_t) + QK_24 / 8 + QK_24 / 4, "wrong q4_0_24 block size/padding");
+typedef struct {
+    mllm_fp16_t d;          // delta
+    uint8_t idx[QK_24 / 8]; // positions of the kept weights
+    int8_t qs[QK_24 / 2];   // quants
+} block_q8_0_24;
+static_assert(sizeof(block_q8_0_24) == sizeof(mllm_fp16_t) + QK_24 / 8 + QK_24 / 2, "wrong q8_0_24 block size/padding");
+#pragma pack()
+
+/*
+ * 2 and 3-bit blocks for the lookup-table kernels: weight i of a block is d * q_i + m, q_i stored as bit planes,
+ * bit p of q_i at bit i % 8 of qs[p][i / 8]. A nibble of a plane is then the index of 4 weights in the table of
+ * partial sums of their 4 activations, see QuantizeLUT.hpp.
+ */
+#define QK_LUT 128
+#pragma pack(1)
+typedef struct {
+    mllm_fp16_t d;              // delta
+    mllm_fp16_t m;              // min
+    uint8_t qs[2][QK_LUT / 8];  // bit planes
+} block_q2_lut;
+static_assert(sizeof(block_q2_lut) == 2 * sizeof(mllm_fp16_t) + 2 * QK_LUT / 8, "wrong q2_lut block size/padding");
+typedef struct {
+    mllm_fp16_t d;              // delta
+    mllm_fp16_t m;              // min
+    uint8_t qs[3][QK_LUT / 8];  // bit planes
+} block_q3_lut;
+static_assert(sizeof(block_q3_lut) == 2 * sizeof(mllm_fp16_t) + 3 * QK_LUT / 8, "wrong q3_lut block size/padding");
+#pragma pack()
+
 // This is only used for intermediate quantization and dot products
 #pragma pack(1)
 typedef struct {
@@ -199,6 +250,8 @@ static string DataTypeName(DataType dataType) {
         return "F32";
     case MLLM_TYPE_F16:
         return "F16";
+    case MLLM_TYPE_BF16:
+        return "BF16";
     case MLLM_TYPE_I32:
         return "I32";
     case MLLM_TYPE_I16:
@@ -215,6 +268,14 @@ static string DataTypeName(DataType dataType) {
         return "Q8_0";
     case MLLM_TYPE_Q8_K:
         return "Q8_K";
+    case MLLM_TYPE_Q4_0_24:
+        return "Q4_0_24";
+    case MLLM_TYPE_Q8_0_24:
+        return "Q8_0_24";
+    case MLLM_TYPE_Q2_LUT:
+        return "Q2_LUT";
+    case MLLM_TYPE_Q3_LUT:
+        return "Q3_LUT";
     case MLLM_TYPE_Q4_1:
         return "Q4_1";
     case MLLM_TYPE_Q8_1:
@@ -231,6 +292,8 @@ static size_t DataTypeSize(DataType dtype, int count=1) {
         return sizeof(float) *count;
     case MLLM_TYPE_F16:
         return sizeof(mllm_fp16_t)*count;
+    case MLLM_TYPE_BF16:
+        return sizeof(mllm_bf16_t)*count;
     case MLLM_TYPE_I32:
         return sizeof(int)*count;
     case MLLM_TYPE_I16:
@@ -247,6 +310,14 @@ static size_t DataTypeSize(DataType dtype, int count=1) {
         return (sizeof(block_q8_0))*count / (QK8_0);
     case MLLM_TYPE_Q8_K:
         return (sizeof(block_q8_K))*count / (QK_K);
+    case MLLM_TYPE_Q4_0_24:
+        return (sizeof(block_q4_0_24))*count / (QK_24);
+    case MLLM_TYPE_Q8_0_24:
+        return (sizeof(block_q8_0_24))*count / (QK_24);
+    case MLLM_TYPE_Q2_LUT:
+        return (sizeof(block_q2_lut))*count / (QK_LUT);
+    case MLLM_TYPE_Q3_LUT:
+        return (sizeof(block_q3_lut))*count / (QK_LUT);
     case MLLM_TYPE_Q4_1:
     case MLLM_TYPE_Q8_1:
     case MLLM_TYPE_COUNT:
@@ -273,6 +344,11 @@ struct BackendConfig {
         Power_Low
     };
 
+    /**
+     * Power_Low trades latency for CPU time: the little cores only, idle OpenMP workers sleep at once, and small
+     * ops run on the calling thread. Power_High runs on every CPU, decode on the biggest cores, and keeps idle
+     * workers spinning. See CPUWorkerPools::configure
+     */
     PowerMode power = Power_Normal;
 
     enum PrecisionMode {
@@ -283,6 +359,24 @@ struct BackendConfig {
 
     PrecisionMode precision = Precision_Normal;
 
+    /** NUMA nodes large layers are split across, 0 for all nodes of the machine */
+    int numa_nodes = 1;
+
+    /** CPUs reserved for decode steps, the rest run prefills; 0 to share all CPUs. See CPUWorkerPools */
+    int decode_cpus = 0;
+
+    /** directory to spill old KV cache tokens to, empty to keep the KV caches in RAM. See CPUKVSpill */
+    std::string kv_spill_dir;
+    /** bytes of KV cache tokens kept in RAM when spilling, the caches of the layer being attended included */
+    size_t kv_ram_budget = 0;
+
+    /** bytes at the head of the next op's weights loaded while the current op runs, 0 disables. See CPUPrefetcher */
+    size_t weight_prefetch = 0;
+
+    /** run the repeated blocks of a model (layers.<n>...) with one set of ops, and let them reuse each other's
+     *  activation buffers. See Graph::Graph */
+    bool block_plan = true;
+
     /** user defined context */
     void *sharedContext = nullptr;
 };
@@ -4,6 +4,7 @@
 #include "MemoryManager.hpp"
 #include "Types.hpp"
 #include <memory>
+#include <vector>
 using std::shared_ptr;
 
 namespace mllm {
@@ -51,6 +52,21 @@ public:
      */
     virtual void registerOps() = 0;
 
+    /**
+     * \brief start loading the weights of an op into the caches, without waiting for them.
+     * Called by Graph with the weights of the next op that has some, before it runs the current op.
+     * Does nothing unless the backend supports it.
+     * \param ranges  the data and bytes of the weights, see Op::weights(); read until the next prefetchWeights()
+     *                or stopPrefetch(), which must come before the weights are freed.
+     */
+    virtual void prefetchWeights(const std::vector<std::pair<const char *, size_t>> &ranges) {
+    }
+    /**
+     * \brief wait until the weights passed to prefetchWeights() are no longer read.
+     */
+    virtual void stopPrefetch() {
+    }
+
 private:
     shared_ptr<MemoryManager> mem_manager_;
 };
@@ -1,6 +1,8 @@
 #include <csignal>
 #include "Timing.hpp"
 #include "Executor.hpp"
+#include "backends/cpu/CPUTuner.hpp"
+#include "backends/cpu/CPUWorkerPools.hpp"
 
 namespace mllm {
 void Executor::setup(Net *net) {
@@ -9,9 +11,7 @@ void Executor::setup(Net *net) {
     uint64_t time_start = mllm_time_us();
     uint64_t time_end;
 
-    for (int i = 0; i < (int)net->subGraph().size(); ++i) {
-        string name = "G" + std::to_string(i);
-        auto &g = net->subGraph()[name];
+    for (auto *g : net->graphs()) {
 
         g->setUpOps(*data_loader_);
     }
@@ -22,41 +22,50 @@ void Executor::setup(Net *net) {
     }
 }
 
-void Executor::run(Net *net, vector<shared_ptr<Tensor>> input_tensors) {
+void Executor::setInputs(Net *net, const vector<shared_ptr<Tensor>> &input_tensors) {
+    input_graphs_.clear();
+    for (int tid = 0; tid < (int)net->inputNames().size(); ++tid) {
+        const auto &input_name = net->inputNames()[tid];
+        const auto &input_tensor = input_tensors[tid];
+        if (input_tensor->name() != input_name) {
+            input_tensor->setName(input_name);
+        }
+        net->tensors()[input_name] = input_tensor;
+        auto *g = net->graphs()[net->inGmap().at(input_name)];
+        if (std::find(input_graphs_.begin(), input_graphs_.end(), g) == input_graphs_.end()) {
+            input_graphs_.push_back(g);
+        }
+    }
+    for (auto *g : input_graphs_) {
+        g->reflashInput(net->tensors());
+    }
+}
+
+void Executor::run(Net *net, const vector<shared_ptr<Tensor>> &input_tensors) {
     bool init = false;
     bool reshape = false;
+    CPUWorkerPools::Scope phase(input_tensors[0]->sequence() == 1 ? CPUWorkerPools::DECODE : CPUWorkerPools::PREFILL);
 
     checkReshape(init, reshape, input_tensors);
 
-    // set Input tensor
-    vector<int> flashGid = {};
-    for (int tid = 0; tid < net->inputNames().size(); ++tid) {
-        auto input_name = net->inputNames()[tid];
-        auto input_tensor = input_tensors[tid];
-        input_tensor->setName(input_name);
-        net->tensors()[input_name] = input_tensor;
-        if (std::find(flashGid.begin(), flashGid.end(), net->inGmap()[input_name]) == flashGid.end()) {
-            flashGid.push_back(net->inGmap()[input_name]);
-        }
-    }
-    for (auto Gid : flashGid) {
-        net->subGraph()["G" + std::to_string(Gid)]->reflashInput(net->tensors());
-    }
+    setInputs(net, input_tensors);
 
     auto ex_time_start = mllm_time_us();
+    auto ex_cpu_start = mllm_cpu_time_us();
 
-    for (int i = 0; i < (int)net->subGraph().size(); ++i) {
-        string name = "G" + std::to_string(i);
-        auto &g = net->subGraph()[name];
-
+    for (int i = 0; i < (int)net->graphs().size(); ++i) {
+        auto *g = net->graphs()[i];
         g->reshape();
         g->setUpTensors();
 
         result_ = g->forward();
+        if (input_tensors[0]->sequence() == 1) {
+            recordOpStats(*g);
+        }
 
         // free
         if (false) {
-            if (i < (int)net->subGraph().size() - 1) {
+            if (i < (int)net->graphs().size() - 1) {
                 g->freeTensors();
             }
             net->freeTensors(i);
@@ -66,15 +75,44 @@ void Executor::run(Net *net, vector<shared_ptr<Tensor>> input_tensors) {
     if (input_tensors[0]->sequence() == 1) {
         auto token_run_time = (ex_time_end - ex_time_start) / 1000.0F;
         run_time_.push_back(token_run_time);
+        cpu_time_.push_back((mllm_cpu_time_us() - ex_cpu_start) / 1000.0);
+    }
+}
+
+void Executor::autotune(Net *net, const vector<NetParameter> &params, const string &cache_path, int thread_count) {
+    const string machine = tuningMachineKey(thread_count);
+    if (loadKernelParams(cache_path, thread_count)) {
+        std::cout << "Load tuned kernel parameters of " << machine << " from " << cache_path << std::endl;
+        return;
+    }
+    std::cout << "Tune kernel parameters of " << machine << std::endl;
+    vector<CPUTuner::LinearShape> shapes;
+    for (const auto &param : params) {
+        for (auto *op : param.net_ops) {
+            if (op->type != LINEAR) {
+                continue;
+            }
+            auto type = data_loader_->getDataType(op->name + ".weight");
+            shapes.push_back({(int)op->param.at("in_features"), (int)op->param.at("out_features"), type});
+        }
+    }
+    // benchmark with a prefill chunk: decode Linears run through the GEMV kernels, which are not tuned
+    const int seq = 32;
+    uint64_t time_start = mllm_time_us();
+    CPUTuner::tune(net->backends()[MLLM_CPU].get(), shapes, seq, thread_count);
+    std::cout << "Tuning took " << (mllm_time_us() - time_start) / 1e6 << " s" << std::endl;
+    if (saveKernelParams(cache_path, thread_count)) {
+        std::cout << "Saved tuned kernel parameters to " << cache_path << std::endl;
     }
 }
 
 // #define DYNAMIC
 bool paramloaded = false;
 bool freeGraph = false;
-void Executor::execute(Net *net, vector<shared_ptr<Tensor>> input_tensors) {
+void Executor::execute(Net *net, const vector<shared_ptr<Tensor>> &input_tensors) {
     bool init = false;
     bool reshape = false;
+    CPUWorkerPools::Scope phase(input_tensors[0]->sequence() == 1 ? CPUWorkerPools::DECODE : CPUWorkerPools::PREFILL);
     // TODO: when reshape begin
     checkReshape(init, reshape, input_tensors);
     // set Input tensor
@@ -83,23 +121,10 @@ void Executor::execute(Net *net, vector<shared_ptr<Tensor>> input_tensors) {
     uint64_t time_end;
 
     // Init inputs
-    vector<int> flashGid = {};
-    for (int tid = 0; tid < net->inputNames().size(); ++tid) {
-        auto input_name = net->inputNames()[tid];
-        auto input_tensor = input_tensors[tid];
-        input_tensor->setName(input_name);
-        net->tensors()[input_name] = input_tensor;
-        if (std::find(flashGid.begin(), flashGid.end(), net->inGmap()[input_name]) == flashGid.end()) {
-            flashGid.push_back(net->inGmap()[input_name]);
-        }
-    }
-    for (auto Gid : flashGid) {
-        net->subGraph()["G" + std::to_string(Gid)]->reflashInput(net->tensors());
-    }
+    setInputs(net, input_tensors);
 
-    for (int i = 0; i < (int)net->subGraph().size(); ++i) {
-        string name = "G" + std::to_string(i);
-        auto &g = net->subGraph()[name];
+    for (int i = 0; i < (int)net->graphs().size(); ++i) {
+        auto *g = net->graphs()[i];
         if (init || reshape) {
             g->reshape();
         }
@@ -116,17 +141,20 @@ void Executor::execute(Net *net, vector<shared_ptr<Tensor>> input_tensors) {
     }
 
     auto ex_time_start = mllm_time_us();
+    auto ex_cpu_start = mllm_cpu_time_us();
     float exe_time = 0;
 
-    for (int i = 0; i < (int)net->subGraph().size(); ++i) {
-        string name = "G" + std::to_string(i);
-        auto &g = net->subGraph()[name];
+    for (int i = 0; i < (int)net->graphs().size(); ++i) {
+        auto *g = net->graphs()[i];
 #endif
 
         g->reshape();
         g->setUpTensors();
 
         result_ = g->forward();
+        if (input_tensors[0]->sequence() == 1) {
+            recordOpStats(*g);
+        }
 
         // free
         if (freeGraph) {
@@ -134,7 +162,7 @@ void Executor::execute(Net *net, vector<shared_ptr<Tensor>> input_tensors) {
             g->freeOps();
             paramloaded = false;
 #endif
-            if (i < (int)net->subGraph().size() - 1) {
+            if (i < (int)net->graphs().size() - 1) {
                 g->freeTensors();
             }
             net->freeTensors(i);
@@ -144,6 +172,7 @@ void Executor::execute(Net *net, vector<shared_ptr<Tensor>> input_tensors) {
     if (input_tensors[0]->sequence() == 1) {
         auto token_run_time = (ex_time_end - ex_time_start) / 1000.0F;
         run_time_.push_back(token_run_time);
+        cpu_time_.push_back((mllm_cpu_time_us() - ex_cpu_start) / 1000.0);
     }
 }
 
@@ -2,6 +2,8 @@
 #define MLLM_EXECUTOR_H
 #include "Net.hpp"
 #include <numeric>
+#include <algorithm>
+#include <map>
 
 namespace mllm {
 class Executor {
@@ -22,7 +24,7 @@ public:
      * \param net       An instance of the Net class representing the network to be run
      * \param input_tensors     A vector of input tensors to be processed by the network
      */
-    void run(Net *net, vector<shared_ptr<Tensor>> input_tensors);
+    void run(Net *net, const vector<shared_ptr<Tensor>> &input_tensors);
 
     /**
      * \brief Setup&Executes the foreword propagation of provided network
@@ -31,9 +33,21 @@ public:
      *
      * execute(net, input_tensors) is equivalent to setup(net) + run(net, input_tensors)
      */
-    void execute(Net *net, vector<shared_ptr<Tensor>> input_tensor);
+    void execute(Net *net, const vector<shared_ptr<Tensor>> &input_tensor);
 
-    bool checkSame(vector<shared_ptr<Tensor>> input_tensor) {
+    /**
+     * \brief Use kernel parameters tuned for this machine, see backends/cpu/compute/Tuning.hpp
+     * \param net           An instance of the Net class, converted from `params`
+     * \param params        The NetParameters of the model
+     * \param cache_path    Tuning cache file
+     * \param thread_count  Number of threads the model runs with
+     *
+     * The parameters are loaded from cache_path if it has an entry for this machine. Otherwise they are
+     * swept on the Linear shapes of the model and saved to cache_path, so only the first run pays for it.
+     */
+    void autotune(Net *net, const vector<NetParameter> &params, const string &cache_path, int thread_count);
+
+    bool checkSame(const vector<shared_ptr<Tensor>> &input_tensor) {
         if (input_tensor.size() != input_sizes_.size()) {
             return false;
         }
@@ -54,7 +68,7 @@ public:
      * \param input_tensor   A vector of input tensors to be processed by the network
      * \return
      */
-    bool checkReshape(bool &init, bool &reshape, vector<shared_ptr<Tensor>> input_tensor) {
+    bool checkReshape(bool &init, bool &reshape, const vector<shared_ptr<Tensor>> &input_tensor) {
         if (input_sizes_.empty()) {
             for (auto &t : input_tensor) {
                 input_sizes_.push_back(t->shape());
@@ -81,16 +95,61 @@ public:
         double sum_time = std::accumulate(std::begin(run_time_), std::end(run_time_), 0.0);
         double mean_time = sum_time / run_time_.size();
         std::cout << "token time: " << mean_time << " ms" << std::endl;
+        if (!run_time_.empty()) {
+            // streaming stalls show up in the tail, not in the mean
+            vector<double> sorted(run_time_.begin(), run_time_.end());
+            std::sort(sorted.begin(), sorted.end());
+            std::cout << "token time p99: " << sorted[(sorted.size() - 1) * 99 / 100] << " ms" << std::endl;
+        }
         std::cout << "inference speed: " << 1000 / mean_time << " tokens/s" << std::endl;
+        if (!cpu_time_.empty()) {
+            // CPU time of the whole process, workers included: what the power modes trade against latency
+            const double cpu_mean = std::accumulate(cpu_time_.begin(), cpu_time_.end(), 0.0) / cpu_time_.size();
+            std::cout << "token CPU time: " << cpu_mean << " ms, " << cpu_mean / mean_time << " CPUs busy" << std::endl;
+        }
+        if (!decode_op_stats_.empty()) {
+            std::cout << "decode ops per token, by thread width (-: fixed width):" << std::endl;
+            for (const auto &stat : decode_op_stats_) {
+                std::cout << "  " << OpNames[stat.first.first] << " x"
+                          << (stat.first.second > 0 ? std::to_string(stat.first.second) : "-") << ": "
+                          << (double)stat.second.count / run_time_.size() << " calls, "
+                          << stat.second.time_us / 1000.0 / run_time_.size() << " ms" << std::endl;
+            }
+            std::cout << "decode copies avoided per token: " << decode_bytes_saved_ / 1e6 / run_time_.size() << " MB" << std::endl;
+        }
     }
 
 private:
+    // binds the input tensors to the graphs that read them
+    void setInputs(Net *net, const vector<shared_ptr<Tensor>> &input_tensors);
+
     vector<vector<int>> input_sizes_;
+    // the graphs setInputs() rebinds, kept to reuse its storage
+    vector<Graph *> input_graphs_;
     vector<shared_ptr<Tensor>> result_;
     ParamLoader *data_loader_;
 
     double load_time_ = 0;
     vector<double> run_time_;
+    // process CPU time of the steps in run_time_, in ms
+    vector<double> cpu_time_;
+
+    struct OpWidthStat {
+        int count = 0;
+        double time_us = 0;
+    };
+    // (op type, thread width) -> accumulated over the decode steps counted in run_time_
+    std::map<std::pair<OpType, int>, OpWidthStat> decode_op_stats_;
+    // bytes the decode steps did not copy thanks to destination passing, see Op::bytesSaved()
+    uint64_t decode_bytes_saved_ = 0;
+    void recordOpStats(const Graph &g) {
+        for (const auto &op : g.opStats()) {
+            auto &stat = decode_op_stats_[{op.type, op.thread_width}];
+            stat.count++;
+            stat.time_us += op.time_us;
+            decode_bytes_saved_ += op.bytes_saved;
+        }
+    }
 };
 
 } // namespace mllm
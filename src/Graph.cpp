@@ -2,6 +2,10 @@
 // Created by Rongjie Yi.
 //
 #include "Graph.hpp"
+#include <algorithm>
+#include <set>
+#include <unordered_set>
+#include "Timing.hpp"
 
 std::string intToStringWithLeadingZero(int num) {
     if (num < 10) {
@@ -12,97 +16,585 @@ std::string intToStringWithLeadingZero(int num) {
 
 namespace mllm {
 
+/*
+ * the layer of an op named <prefix>.<layer>.<name>, the length of <prefix> and where .<name> starts.
+ * Ops made by NetTensor methods (views, arithmetic) are named after their input, so they carry its layer too.
+ */
+static bool blockOpName(const string &name, size_t &prefix_size, int &layer, size_t &suffix) {
+    size_t start = 0;
+    while (start < name.size()) {
+        size_t end = name.find('.', start);
+        if (end == string::npos) {
+            break;
+        }
+        if (start > 0 && end > start && std::all_of(name.begin() + start, name.begin() + end, ::isdigit)) {
+            layer = 0;
+            for (size_t c = start; c < end; ++c) {
+                layer = layer * 10 + (name[c] - '0');
+            }
+            prefix_size = start - 1;
+            suffix = end;
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+// the names Express gives to unnamed ops: the op type and a counter, e.g. Add12
+static bool unnamedOp(const string &name) {
+    size_t digits = name.size();
+    while (digits > 0 && isdigit(name[digits - 1])) {
+        --digits;
+    }
+    return digits > 0 && digits < name.size() && std::all_of(name.begin(), name.begin() + digits, ::isalpha);
+}
+
+// ops whose inputs and outputs view each other's buffers, see Op::redirectInput
+static bool viewsTensors(OpType type) {
+    switch (type) {
+    case VIEW:
+    case TRANSPOSE:
+    case SCALE:
+    case CAUSALMASK:
+    case GATHER:
+    case CAT:
+    case REPLACE:
+    case SPLIT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// ops that only read their inputs and write their own outputs
+static bool computesTensors(OpType type) {
+    switch (type) {
+    case ADD:
+    case SOFTMAX:
+    case SILU:
+    case MATMUL:
+    case ROPE:
+    case RMSNORM:
+    case LINEAR:
+    case EMBEDDING:
+    case MUL:
+    case RELU:
+    case RELU2:
+    case GELU:
+    case QUICKGLUE:
+    case LAYERNORM:
+    case CONVOLUTION2D:
+    case CONVOLUTION3D:
+    case AVGPOOL2D:
+    case MAXPOOL2D:
+    case SUBDIM:
+    case DIVISION:
+    case NORM:
+    case SHAPE:
+    case MEAN:
+    case WHERE:
+    case RANGE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// ops that keep nothing from one call to the next but their params: one of them runs every block as is
+static bool sharedAcrossBlocks(OpType type) {
+    switch (type) {
+    case VIEW:
+    case TRANSPOSE:
+    case SCALE:
+    case CAUSALMASK:
+    case SOFTMAX:
+    case SILU:
+    case MUL:
+    case ADD:
+    case MATMUL:
+    case GELU:
+    case QUICKGLUE:
+    case RELU:
+    case RELU2:
+    case DIVISION:
+    case SPLIT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*
+ * where the ops of a graph sit in the repeated blocks of a model: the prefix and layer of every op (-1 outside
+ * blocks), and the op at its place in the first block of its prefix if it has the same name in the block, type and
+ * params (the op itself otherwise). An unnamed op is at the place of its offset from the named op it follows. The
+ * ops of a block are expected to run one after the other, as they do once sorted; other ops are not shared.
+ */
+struct Graph::BlockLayout {
+    vector<string> prefixes;
+    vector<int> prefix;
+    vector<int> layer;
+    vector<int> first;
+
+    explicit BlockLayout(const NetParameter &param, bool plan) {
+        const int n = (int)param.net_ops.size();
+        prefix.assign(n, -1);
+        layer.assign(n, -1);
+        first.resize(n);
+        for (int i = 0; i < n; ++i) {
+            first[i] = i;
+        }
+        if (!plan) {
+            return;
+        }
+        vector<size_t> suffix(n, 0);
+        vector<int> named(n, -1); // the named op an unnamed one follows
+        vector<int> first_start;  // the first op of the first block of every prefix
+        int start = 0;            // the first op of the current block
+        for (int i = 0; i < n; ++i) {
+            const auto *op = param.net_ops[i];
+            size_t prefix_size = 0;
+            if (blockOpName(op->name, prefix_size, layer[i], suffix[i])) {
+                int p = 0;
+                while (p < (int)prefixes.size() && op->name.compare(0, prefix_size, prefixes[p]) != 0) {
+                    ++p;
+                }
+                if (p == (int)prefixes.size()) {
+                    prefixes.push_back(op->name.substr(0, prefix_size));
+                    first_start.push_back(i);
+                }
+                prefix[i] = p;
+            } else if (i > 0 && layer[i - 1] >= 0 && unnamedOp(op->name)) {
+                prefix[i] = prefix[i - 1];
+                layer[i] = layer[i - 1];
+                named[i] = named[i - 1] >= 0 ? named[i - 1] : i - 1;
+            } else {
+                continue;
+            }
+            if (i == 0 || prefix[i - 1] != prefix[i] || layer[i - 1] != layer[i]) {
+                start = i;
+            }
+            const int f = first_start[prefix[i]] + (i - start);
+            if (f >= i || prefix[f] != prefix[i] || layer[f] != layer[first_start[prefix[i]]]) {
+                continue;
+            }
+            const auto *first_op = param.net_ops[f];
+            const bool same_place = named[i] < 0 ? named[f] < 0 && op->name.compare(suffix[i], string::npos, first_op->name, suffix[f], string::npos) == 0 :
+                                                   named[f] >= 0 && first[named[i]] == named[f] && i - named[i] == f - named[f];
+            if (same_place && first_op->type == op->type && first_op->param == op->param
+                && first_op->in.size() == op->in.size() && first_op->out_size == op->out_size) {
+                first[i] = f;
+            }
+        }
+    }
+};
+
 Graph::Graph(const NetParameter &param, Backend *bn,
              unordered_map<string, shared_ptr<Tensor>> &external_tensors,
-             int threadCount) {
+             int threadCount, bool block_plan, bool share_activations) {
     backend_ = bn;
 
+    tensors_.reserve(param.net_tensors.size());
     for (auto net_tensor : param.net_tensors) {
         auto it = external_tensors.find(net_tensor->name);
         if (it == tensors_.end()) { // not in external_tensors
-            tensors_[net_tensor->name] = std::make_shared<Tensor>(backend_);
-            tensors_[net_tensor->name]->setName(net_tensor->name);
+            auto &tensor = tensors_[net_tensor->name];
+            tensor = std::make_shared<Tensor>(backend_);
+            tensor->setName(net_tensor->name);
         }
     }
-    for (auto net_op : param.net_ops) {
-        shared_ptr<Op> my_op(nullptr);
-        auto *new_op = backend_->opCreate(net_op->param, net_op->name, threadCount);
-        my_op.reset(new_op);
-        my_op->setOpType(net_op->type);
-        ops_[net_op->name] = my_op;
+    const BlockLayout layout(param, block_plan);
+    const int n = (int)param.net_ops.size();
+    vector<shared_ptr<Op>> op_of(n);
+    vector<int> block_of(n, -1);
+    for (int i = 0; i < n; ++i) {
+        auto *net_op = param.net_ops[i];
+        const int first = layout.first[i];
+        if (first != i && sharedAcrossBlocks(net_op->type)) {
+            op_of[i] = op_of[first];
+        } else if (first != i) {
+            // the first block's op takes this block's weights and caches
+            const int block = op_of[first]->addBlock(net_op->name);
+            if (block >= 0) {
+                op_of[i] = op_of[first];
+                block_of[i] = block;
+                block_of[first] = 0;
+            }
+        }
+        if (op_of[i] == nullptr) {
+            op_of[i].reset(backend_->opCreate(net_op->param, net_op->name, threadCount));
+            op_of[i]->setOpType(net_op->type);
+        }
+        ops_[net_op->name] = op_of[i];
     }
-    for (auto net_op : param.net_ops) {
+    op_names_.reserve(n);
+    op_calls_.reserve(n);
+    ops_input_tensors_.reserve(n);
+    ops_output_tensors_.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        auto *net_op = param.net_ops[i];
         bool connect_input = false;
-        string op_name = net_op->name;
-        op_names_.push_back(op_name);
-        auto in_tensors = net_op->in;
-        vector<shared_ptr<Tensor>> inTensors;
-        for (auto *in_t : in_tensors) {
+        op_names_.push_back(net_op->name);
+        const auto &op_name = op_names_.back();
+        auto &inTensors = ops_input_tensors_[op_name];
+        inTensors.clear();
+        inTensors.reserve(net_op->in.size());
+        for (auto *in_t : net_op->in) {
             if(in_t->in == NULL){
                 connect_input = true;
             }
-            auto in_t_name = in_t->name;
-            auto it = tensors_.find(in_t_name);
+            auto it = tensors_.find(in_t->name);
             if (it != tensors_.end()) {
-                inTensors.push_back(tensors_[in_t_name]);
+                inTensors.push_back(it->second);
             } else {
-                inTensors.push_back(external_tensors[in_t_name]);
+                inTensors.push_back(external_tensors[in_t->name]);
             }
         }
-        vector<shared_ptr<Tensor>> outTensors;
+        auto &outTensors = ops_output_tensors_[op_name];
+        outTensors.clear();
+        outTensors.reserve(net_op->out_size);
         for (int oz = 0; oz < net_op->out_size; oz++) {
             auto out_t_name = "outtensor-" + op_name + "-" + intToStringWithLeadingZero(oz);
             auto it = tensors_.find(out_t_name);
             if (it != tensors_.end()) {
-                outTensors.push_back(tensors_[out_t_name]);
+                outTensors.push_back(it->second);
             } else {
                 outTensors.push_back(external_tensors[out_t_name]);
             }
         }
-        ops_input_tensors_[op_name] = inTensors;
-        ops_output_tensors_[op_name] = outTensors;
         if (connect_input) { ops_connect_input_.push_back(op_name); }
+        const bool shared = layout.first[i] != i && op_of[i] == op_of[layout.first[i]] && block_of[i] < 0;
+        op_calls_.push_back({&op_name, op_of[i].get(), block_of[i], shared, &inTensors, &outTensors, true, nullptr});
+    }
+    op_stats_.reserve(op_calls_.size());
+    weight_ranges_.resize(op_calls_.size());
+    if (block_plan) {
+        planBlocks(param, layout, share_activations);
+    }
+    // only tensors produced in this graph may be redirected into the buffers of their consumers; an op running
+    // several calls may redirect an input only if it may in all of them
+    std::unordered_set<Tensor *> produced;
+    produced.reserve(2 * op_calls_.size());
+    for (const auto &call : op_calls_) {
+        for (const auto &t : *call.outputs) {
+            produced.insert(t.get());
+        }
+    }
+    std::unordered_map<Op *, vector<bool>> redirectable;
+    for (const auto &call : op_calls_) {
+        auto found = redirectable.emplace(call.op, vector<bool>(call.inputs->size(), true));
+        auto &inputs = found.first->second;
+        for (size_t k = 0; k < call.inputs->size() && k < inputs.size(); ++k) {
+            inputs[k] = inputs[k] && produced.count((*call.inputs)[k].get()) > 0;
+        }
+    }
+    for (auto &op : redirectable) {
+        op.first->setRedirectableInputs(std::move(op.second));
+    }
+}
+
+void Graph::planBlocks(const NetParameter &param, const BlockLayout &layout, bool share_activations) {
+    const int n = (int)op_calls_.size();
+    const int prefixes = (int)layout.prefixes.size();
+    if (prefixes == 0) {
+        return;
+    }
+    // the tensors of the calls, numbered by the outputs producing them and then by the other inputs as they are met,
+    // with the op and output producing them; found by address in a sorted list, which is cheaper to build than a map
+    vector<Tensor *> tensors;
+    vector<int> producer;
+    vector<int> producer_out;
+    vector<std::pair<Tensor *, int>> produced;
+    vector<std::pair<Tensor *, int>> external;
+    vector<vector<int>> inputs(n);
+    vector<vector<int>> outputs(n);
+    for (int i = 0; i < n; ++i) {
+        for (int o = 0; o < (int)op_calls_[i].outputs->size(); ++o) {
+            const int t = (int)tensors.size();
+            tensors.push_back((*op_calls_[i].outputs)[o].get());
+            producer.push_back(i);
+            producer_out.push_back(o);
+            produced.emplace_back(tensors.back(), t);
+            outputs[i].push_back(t);
+        }
+    }
+    std::sort(produced.begin(), produced.end());
+    vector<int> last_use(tensors.size(), -1);
+    for (int i = 0; i < n; ++i) {
+        for (const auto &input : *op_calls_[i].inputs) {
+            auto found = std::lower_bound(produced.begin(), produced.end(), std::make_pair(input.get(), INT32_MIN));
+            int t = -1;
+            if (found != produced.end() && found->first == input.get()) {
+                t = found->second;
+            } else {
+                for (const auto &e : external) {
+                    t = e.first == input.get() ? e.second : t;
+                }
+                if (t < 0) {
+                    t = (int)tensors.size();
+                    tensors.push_back(input.get());
+                    producer.push_back(-1);
+                    producer_out.push_back(-1);
+                    last_use.push_back(-1);
+                    external.emplace_back(input.get(), t);
+                }
+            }
+            inputs[i].push_back(t);
+            last_use[t] = i;
+        }
+    }
+    const int count = (int)tensors.size();
+    // the place of an input of op `i` in its block: its producer and output if that is in the block, else -1
+    auto inBlock = [&](int i, int t) {
+        const int p = producer[t];
+        const bool inside = p >= 0 && layout.prefix[p] == layout.prefix[i] && layout.layer[p] == layout.layer[i];
+        return inside ? std::make_pair(p, producer_out[t]) : std::make_pair(-1, -1);
+    };
+    // the position of a tensor in its block: the op of the first block at the place of its producer, and the output
+    auto position = [&](int t) {
+        return std::make_pair(layout.first[producer[t]], producer_out[t]);
+    };
+
+    // the blocks with the ops, params and wiring of the first block of their prefix
+    vector<int> first_layer(prefixes, -1);
+    vector<vector<int>> block_ops(prefixes); // by prefix and layer, -1 for layers without ops
+    vector<vector<bool>> same(prefixes);
+    vector<int> shared_ops(prefixes, 0);
+    for (int i = 0; i < n; ++i) {
+        const int p = layout.prefix[i];
+        if (p < 0) {
+            continue;
+        }
+        if (first_layer[p] < 0) {
+            first_layer[p] = layout.layer[i];
+        }
+        const int first = layout.first[i];
+        shared_ops[p] += first != i && op_calls_[i].op == op_calls_[first].op;
+        const int layer = layout.layer[i];
+        if (layer >= (int)block_ops[p].size()) {
+            block_ops[p].resize(layer + 1, -1);
+            same[p].resize(layer + 1, true);
+        }
+        block_ops[p][layer] = std::max(block_ops[p][layer], 0) + 1;
+        bool wired = layout.layer[i] == first_layer[p];
+        if (!wired && first != i && layout.layer[first] == first_layer[p]) {
+            wired = true;
+            for (size_t k = 0; k < inputs[i].size(); ++k) {
+                auto a = inBlock(i, inputs[i][k]);
+                auto b = inBlock(first, inputs[first][k]);
+                wired &= (a.first < 0) == (b.first < 0) && (a.first < 0 || (layout.first[a.first] == b.first && a.second == b.second));
+            }
+        }
+        same[p][layer] = same[p][layer] && wired;
+    }
+    vector<vector<bool>> repeated(prefixes);
+    vector<int> repeats_of(prefixes, 0);
+    vector<int> layers(prefixes, 0);
+    for (int p = 0; p < prefixes; ++p) {
+        repeated[p].assign(block_ops[p].size(), false);
+        for (int layer = 0; layer < (int)block_ops[p].size(); ++layer) {
+            if (block_ops[p][layer] < 0) {
+                continue;
+            }
+            ++layers[p];
+            if (same[p][layer] && block_ops[p][layer] == block_ops[p][first_layer[p]]) {
+                repeated[p][layer] = true;
+                ++repeats_of[p];
+            }
+        }
+    }
+    vector<int> shared_tensors(prefixes, 0);
+    auto report = [&]() {
+        for (int p = 0; p < prefixes; ++p) {
+            if (layers[p] >= 2) {
+                block_plans_.push_back({layout.prefixes[p], layers[p], block_ops[p][first_layer[p]], shared_ops[p], shared_tensors[p]});
+            }
+        }
+    };
+    if (!share_activations) {
+        report();
+        return;
+    }
+    auto repeats = [&](int op) {
+        const int p = layout.prefix[op];
+        return p >= 0 && repeats_of[p] >= 2 && repeated[p][layout.layer[op]];
+    };
+
+    // tensors viewing each other share one buffer and are handled together
+    vector<int> parent(count);
+    for (int t = 0; t < count; ++t) {
+        parent[t] = t;
+    }
+    auto find = [&](int t) {
+        while (parent[t] != t) {
+            t = parent[t] = parent[parent[t]];
+        }
+        return t;
+    };
+    vector<bool> pinned(count, false);
+    for (int t : outputs[n - 1]) {
+        pinned[t] = true;
     }
+    for (int i = 0; i < n; ++i) {
+        const OpType type = param.net_ops[i]->type;
+        if (viewsTensors(type)) {
+            const int root = find(!inputs[i].empty() ? inputs[i][0] : outputs[i][0]);
+            for (const auto *list : {&inputs[i], &outputs[i]}) {
+                for (int t : *list) {
+                    parent[find(t)] = root;
+                }
+            }
+        } else if (!computesTensors(type)) {
+            // e.g. KV caches and parameters: their tensors are bound to the op's own buffers
+            for (const auto *list : {&inputs[i], &outputs[i]}) {
+                for (int t : *list) {
+                    pinned[t] = true;
+                }
+            }
+        }
+    }
+    struct Group {
+        vector<int> tensors;
+        vector<std::pair<int, int>> positions; // of the tensors in their block, sorted
+        int layer = -1;
+        int start = INT32_MAX;
+        int end = -1;
+        bool shareable = true;
+    };
+    vector<Group> groups(count);
+    vector<int> group_order; // by their first tensor, so that the plan does not depend on addresses
+    vector<bool> grouped(count, false);
+    for (int i = 0; i < n; ++i) {
+        for (const auto *list : {&inputs[i], &outputs[i]}) {
+            for (int t : *list) {
+                if (grouped[t]) {
+                    continue;
+                }
+                grouped[t] = true;
+                const int root = find(t);
+                auto &group = groups[root];
+                if (group.tensors.empty()) {
+                    group_order.push_back(root);
+                }
+                group.tensors.push_back(t);
+                const int p = producer[t];
+                if (p < 0 || last_use[t] < 0 || !repeats(p) || pinned[t] || (group.layer >= 0 && group.layer != layout.layer[p])) {
+                    group.shareable = false;
+                    continue;
+                }
+                group.layer = layout.layer[p];
+                group.start = std::min(group.start, p);
+                group.end = std::max(group.end, last_use[t]);
+            }
+        }
+    }
+
+    // the groups at the same position in successive blocks reuse one buffer while their lives do not overlap
+    vector<Group *> by_position;
+    for (int root : group_order) {
+        auto &group = groups[root];
+        if (!group.shareable) {
+            continue;
+        }
+        for (int t : group.tensors) {
+            group.positions.push_back(position(t));
+        }
+        std::sort(group.positions.begin(), group.positions.end());
+        by_position.push_back(&group);
+    }
+    std::sort(by_position.begin(), by_position.end(), [](const Group *a, const Group *b) {
+        return a->positions != b->positions ? a->positions < b->positions : a->start < b->start;
+    });
+    vector<int> rebind(count, -1);
+    for (size_t begin = 0, end = 0; begin < by_position.size(); begin = end) {
+        end = begin + 1;
+        while (end < by_position.size() && by_position[end]->positions == by_position[begin]->positions) {
+            ++end;
+        }
+        const Group *owner = by_position[begin];
+        int owner_end = owner->end;
+        for (size_t g = begin + 1; g < end; ++g) {
+            const Group *group = by_position[g];
+            if (group->start <= owner_end) {
+                owner = group;
+                owner_end = owner->end;
+                continue;
+            }
+            for (int t : group->tensors) {
+                for (int o : owner->tensors) {
+                    if (position(o) == position(t)) {
+                        rebind[t] = o;
+                    }
+                }
+            }
+            owner_end = group->end;
+            shared_tensors[layout.prefix[producer[group->tensors[0]]]] += (int)group->tensors.size();
+        }
+    }
+    for (int t = 0; t < count; ++t) {
+        if (rebind[t] >= 0) {
+            auto it = tensors_.find(tensors[t]->name());
+            if (it != tensors_.end() && it->second.get() == tensors[t]) {
+                tensors_.erase(it);
+            }
+        }
+    }
+    // the tensor vectors of the calls are the ones in ops_input_tensors_ and ops_output_tensors_; an owner is
+    // never rebound itself
+    auto owner = [&](int t) -> const shared_ptr<Tensor> & {
+        return (*op_calls_[producer[t]].outputs)[producer_out[t]];
+    };
+    for (int i = 0; i < n; ++i) {
+        for (size_t k = 0; k < inputs[i].size(); ++k) {
+            if (rebind[inputs[i][k]] >= 0) {
+                (*op_calls_[i].inputs)[k] = owner(rebind[inputs[i][k]]);
+            }
+        }
+        for (size_t k = 0; k < outputs[i].size(); ++k) {
+            if (rebind[outputs[i][k]] >= 0) {
+                (*op_calls_[i].outputs)[k] = owner(rebind[outputs[i][k]]);
+            }
+        }
+    }
+    report();
 }
 
 void Graph::reflashInput(
     unordered_map<string, shared_ptr<Tensor>> &external_tensors) {
-    for (auto op : ops_connect_input_) {
-        vector<string> tmp_name;
-        for (auto in_t : ops_input_tensors_[op]) {
-            tmp_name.push_back(in_t->name());
-        }
-        ops_input_tensors_[op].clear();
-        for (auto input_tensor_name : tmp_name) {
-            if (tensors_.find(input_tensor_name) != tensors_.end()) {
-                ops_input_tensors_[op].push_back(tensors_[input_tensor_name]);
+    for (const auto &op : ops_connect_input_) {
+        for (auto &in_t : ops_input_tensors_[op]) {
+            auto it = tensors_.find(in_t->name());
+            if (it != tensors_.end()) {
+                in_t = it->second;
             } else {
-                ops_input_tensors_[op].push_back(
-                    external_tensors[input_tensor_name]);
+                in_t = external_tensors[in_t->name()];
             }
         }
     }
 }
 void Graph::reshape() {
-    for (const auto &op_name : op_names_) {
+    for (auto &call : op_calls_) {
         bool do_ = true;
-        if(ops_[op_name]->type() == PARAMETER || ops_[op_name]->type() == RANGE|| ops_[op_name]->type() == GATHER|| ops_[op_name]->type() == REPLACE){
+        const auto type = call.op->type();
+        if(type == PARAMETER || type == RANGE|| type == GATHER|| type == REPLACE){
             do_ = true;
         }else {
-            for (auto &input_tensor : ops_input_tensors_[op_name]) {
+            for (const auto &input_tensor : *call.inputs) {
                 if (input_tensor->count() == 0) {
                     do_ = false;
                 }
             }
         }
-        ops_not_inputs_empty_[op_name] = do_;
+        call.run = do_;
         if(do_) {
-            ops_[op_name]->reshape(
-                ops_input_tensors_[op_name],
-                ops_output_tensors_[op_name]); // tensors_[op_name]:1.reshape
+            if (call.block >= 0) {
+                call.op->bindBlock(call.block);
+            }
+            call.op->reshape(*call.inputs, *call.outputs); // tensors_[op_name]:1.reshape
         }else{
 //            std::cout<<"op_name:"<<op_name<<" is not do"<<std::endl;
-            for (auto &output_tensor : ops_output_tensors_[op_name]) {
+            for (const auto &output_tensor : *call.outputs) {
                 output_tensor->reshape(0, 0, 0, 0);
             }
         }
@@ -110,68 +602,160 @@ void Graph::reshape() {
 }
 
 void Graph::setUpTensors() {
-    auto &graph_in_tensors = ops_input_tensors_[op_names_[0]];
+    auto &graph_in_tensors = *op_calls_[0].inputs;
     for (auto &t : graph_in_tensors) { t->alloc(); }
-    for (const auto &op_name : op_names_) {
-        if (ops_not_inputs_empty_[op_name] ) {
-            ops_[op_name]->setUp(ops_input_tensors_[op_name],
-                                 ops_output_tensors_[op_name]);
+    for (const auto &call : op_calls_) {
+        if (call.run) {
+            if (call.block >= 0) {
+                call.op->bindBlock(call.block);
+            }
+            call.op->setUp(*call.inputs, *call.outputs);
         }else{
 //            std::cout<<"op_name:"<<op_name<<" is not do"<<std::endl;
         }
     }
+    if (!weight_ranges_ready_) {
+        for (size_t i = 0; i < op_calls_.size(); ++i) {
+            weight_ranges_[i].clear();
+            if (op_calls_[i].block >= 0) {
+                op_calls_[i].op->bindBlock(op_calls_[i].block);
+            }
+            for (auto *weight : op_calls_[i].op->weights()) {
+                if (weight->hostPtr<char>() != nullptr) {
+                    weight_ranges_[i].emplace_back(weight->hostPtr<char>(), weight->cntSize());
+                }
+            }
+        }
+        weight_ranges_ready_ = true;
+    }
+    const vector<std::pair<const char *, size_t>> *next_weighted = nullptr;
+    for (int i = (int)op_calls_.size() - 1; i >= 0; --i) {
+        op_calls_[i].prefetch = next_weighted;
+        if (op_calls_[i].run && !weight_ranges_[i].empty()) {
+            next_weighted = &weight_ranges_[i];
+        }
+    }
+}
+
+size_t Graph::activationBytes() const {
+    std::set<Tensor *> tensors;
+    for (const auto &call : op_calls_) {
+        for (const auto &t : *call.inputs) {
+            tensors.insert(t.get());
+        }
+        for (const auto &t : *call.outputs) {
+            tensors.insert(t.get());
+        }
+    }
+    size_t bytes = 0;
+    for (auto *t : tensors) {
+        // views hold no buffer of their own
+        if (t->hostPtr<char>() != nullptr && t->masterTensor() == nullptr) {
+            bytes += t->dtypeSize(t->allocted());
+        }
+    }
+    return bytes;
 }
 
 void Graph::setUpOps(ParamLoader &loader) {
-    for (const auto &op_name : op_names_) {
-        ops_[op_name]->load(loader);
+    for (const auto &call : op_calls_) {
+        if (call.shared) {
+            continue;
+        }
+        if (call.block >= 0) {
+            call.op->bindBlock(call.block);
+        }
+        call.op->load(loader);
     }
+    weight_ranges_ready_ = false;
 }
 //#define SAVECHECK
 const vector<shared_ptr<Tensor>> &Graph::forward(bool autofree) {
-
-    for (const auto &op_name : op_names_) {
-        if (ops_not_inputs_empty_[op_name] ) {
+    op_stats_.clear();
+    for (const auto &call : op_calls_) {
+        if (call.run) {
 #ifdef SAVECHECK
-            for (auto &t : ops_input_tensors_[op_name]) {
+            for (auto &t : *call.inputs) {
                 t->checkData<float>();
                 t->saveData<float>();
             }
 #endif
-#ifdef DEBUGPRINT
+            // with autofree the weights are freed right after their op, so nothing is read ahead
+            if (call.prefetch != nullptr && !autofree) {
+                backend_->prefetchWeights(*call.prefetch);
+            }
+            if (call.block >= 0) {
+                call.op->bindBlock(call.block);
+            }
             uint64_t t_start = mllm_time_us();
-#endif
-            ops_[op_name]->execute(ops_input_tensors_[op_name],
-                                   ops_output_tensors_[op_name]);
+            call.op->execute(*call.inputs, *call.outputs);
+            uint64_t t_end = mllm_time_us();
+            op_stats_.push_back({call.op->type(), call.op->threadWidth(), t_end - t_start, call.op->bytesSaved()});
 
 #ifdef SAVECHECK
-            for (auto &t : ops_output_tensors_[op_name]) {
+            for (auto &t : *call.outputs) {
                 t->checkData<float>();
                 t->saveData<float>();
             }
 #endif
 
 #ifdef DEBUGPRINT
-            uint64_t t_end = mllm_time_us();
-            std::cout << "" << op_name
+            std::cout << "" << *call.name
                       << "       exe_time:" << (t_end - t_start) / 1000.0F << " ms"
                       << std::endl;
 #endif
-            if (autofree) {
-                ops_[op_name]->free(ops_input_tensors_[op_name],
-                                    ops_output_tensors_[op_name]);
+            if (autofree && !call.shared) {
+                call.op->free(*call.inputs, *call.outputs);
             }
         }else{
 //            std::cout<<"op_name:"<<op_name<<" is not do"<<std::endl;
         }
     }
-    return ops_output_tensors_[op_names_[op_names_.size() - 1]];
+    // the weights may be freed or reloaded once the graph returns
+    backend_->stopPrefetch();
+    if (autofree) {
+        weight_ranges_ready_ = false;
+    }
+    return *op_calls_.back().outputs;
+}
+
+void Graph::saveState(unordered_map<string, Op::SequenceState> &states) {
+    for (const auto &call : op_calls_) {
+        if (call.shared) {
+            continue;
+        }
+        if (call.block >= 0) {
+            call.op->bindBlock(call.block);
+        }
+        call.op->saveState(states[*call.name]);
+    }
+}
+
+void Graph::restoreState(const unordered_map<string, Op::SequenceState> &states) {
+    static const Op::SequenceState new_sequence;
+    for (const auto &call : op_calls_) {
+        if (call.shared) {
+            continue;
+        }
+        if (call.block >= 0) {
+            call.op->bindBlock(call.block);
+        }
+        auto state = states.find(*call.name);
+        call.op->restoreState(state == states.end() ? new_sequence : state->second);
+    }
 }
 
 void Graph::freeOps() {
-    for (const auto &op_name : op_names_) {
-        ops_[op_name]->free(ops_input_tensors_[op_name],
-                            ops_output_tensors_[op_name]);
+    backend_->stopPrefetch();
+    weight_ranges_ready_ = false;
+    for (const auto &call : op_calls_) {
+        if (call.shared) {
+            continue;
+        }
+        if (call.block >= 0) {
+            call.op->bindBlock(call.block);
+        }
+        call.op->free(*call.inputs, *call.outputs);
     }
 }
 void Graph::freeTensors(){
@@ -16,14 +16,43 @@ namespace mllm {
 
 class Graph {
 public:
+    /**
+     * \brief how one op ran in the last forward().
+     */
+    struct OpStat {
+        OpType type;
+        int thread_width; // see Op::threadWidth()
+        uint64_t time_us;
+        uint64_t bytes_saved; // see Op::bytesSaved()
+    };
+    /**
+     * \brief the repeated blocks of a prefix run by one set of ops, see Graph::Graph.
+     */
+    struct BlockPlan {
+        string prefix;      // e.g. "layers"
+        int layers;         // blocks of the prefix
+        int ops;            // ops of the first block
+        int shared_ops;     // ops of the other blocks run by an op of the first block
+        int shared_tensors; // activations of a block held in the buffers of an earlier block
+    };
     /**
      * \brief Graph
      * \param param NetParameter contains the structure of this graph
      * \param bn Backend like CPU/QNN etc
      * \param external_tensors external tensors from other graph and inter graphs.
      * \param threadCount number of Threads
+     * \param block_plan  run repeated blocks with one set of ops. A block is declared by the names of its ops,
+     *                    <prefix>.<layer>.<name> (e.g. layers.3.attention.wq); unnamed ops belong to the block of
+     *                    the last named op. An op with the type and params of the op of the same name in the first
+     *                    block of its prefix is run by that op: ops without state share it as is, the others add
+     *                    their weights, caches and positions to it as a block (Op::addBlock) and bind it before
+     *                    every call.
+     * \param share_activations  with block_plan, among the blocks with the ops and wiring of the first one, an
+     *                           activation that is dead before the next block produces it shares that block's
+     *                           buffer. Only for a graph whose activations no other graph reads.
      */
-    explicit Graph(const NetParameter &param, Backend *bn, unordered_map<string, shared_ptr<Tensor>> &external_tensors, int threadCount);
+    explicit Graph(const NetParameter &param, Backend *bn, unordered_map<string, shared_ptr<Tensor>> &external_tensors,
+                   int threadCount, bool block_plan = false, bool share_activations = false);
     virtual ~Graph() = default;
 
     /**
@@ -72,6 +101,30 @@ public:
      * \param external_tensors external tensors from other graph and inter graphs.
      */
     void reflashInput(unordered_map<string, shared_ptr<Tensor>> &external_tensors);
+    /**
+     * \brief save the sequence state of every op, see Op::saveState.
+     * \param states  op name -> state
+     */
+    void saveState(unordered_map<string, Op::SequenceState> &states);
+    /**
+     * \brief restore the sequence state of every op, see Op::restoreState. Ops missing in `states` start a
+     *        new sequence.
+     */
+    void restoreState(const unordered_map<string, Op::SequenceState> &states);
+    /**
+     * \brief statistics of the ops executed by the last forward(), in execution order.
+     */
+    const vector<OpStat> &opStats() const {
+        return op_stats_;
+    }
+    const vector<BlockPlan> &blockPlans() const {
+        return block_plans_;
+    }
+    /**
+     * \brief bytes of the buffers the tensors of the graph hold, that is its activations; the weights and KV
+     *        caches are held by the ops.
+     */
+    size_t activationBytes() const;
 
 protected:
     Backend *backend_;
@@ -89,11 +142,36 @@ protected:
     unordered_map<string, vector<shared_ptr<Tensor>>> ops_output_tensors_; // opname: op's output Tensors
     unordered_map<string, shared_ptr<Tensor>> tensors_;                    // opname: Tensors
     unordered_map<string, shared_ptr<Op>> ops_;                            // opname: op
-    unordered_map<string, bool> ops_not_inputs_empty_;                      // opname: ops_not_inputs_empty
 
     vector<string> op_names_;
 
     vector<string> ops_connect_input_;
+    vector<OpStat> op_stats_;
+
+    /**
+     * \brief an op and its tensors, resolved once so that running the graph does no name lookups and copies
+     *        no shared_ptr. The tensor vectors are the ones in ops_input_tensors_ and ops_output_tensors_.
+     */
+    struct OpCall {
+        const string *name;
+        Op *op;
+        int block;   // the block op binds for the call, -1 if it runs no blocks, see Op::bindBlock
+        bool shared; // the op runs an earlier call too and holds no state, so it is loaded and freed by that one
+        vector<shared_ptr<Tensor>> *inputs;
+        vector<shared_ptr<Tensor>> *outputs;
+        bool run; // false if an input is empty, set by reshape()
+        // the weights of the next op to run that has some, prefetched while this one runs; set by setUpTensors()
+        const vector<std::pair<const char *, size_t>> *prefetch;
+    };
+    vector<OpCall> op_calls_; // in the order of op_names_
+    // the data and bytes of the weights of every op call, built by the first setUpTensors() after they are loaded
+    vector<vector<std::pair<const char *, size_t>>> weight_ranges_;
+    bool weight_ranges_ready_ = false;
+    vector<BlockPlan> block_plans_;
+
+private:
+    struct BlockLayout;
+    void planBlocks(const NetParameter &param, const BlockLayout &layout, bool share_activations);
 };
 
 } // namespace mllm
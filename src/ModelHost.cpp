@@ -0,0 +1,264 @@
+#include "ModelHost.hpp"
+#include "backends/cpu/CPUWorkerPools.hpp"
+
+namespace mllm {
+
+struct ModelHost::Version {
+    int number = 0;
+    string path;
+    uint64_t bytes = 0;
+    // destroyed in reverse order: the scheduler and executor before the net, the net before its loader
+    std::unique_ptr<ParamLoader> loader;
+    std::unique_ptr<Net> net;
+    std::unique_ptr<Executor> ex;
+    std::unique_ptr<Scheduler> scheduler;
+};
+
+ModelHost::ModelHost(vector<NetParameter> &params, BackendConfig config, int thread_count, uint64_t overlap_budget,
+                     Scheduler::MemoryPolicy policy) :
+    params_(params), config_(std::move(config)), thread_count_(thread_count), overlap_budget_(overlap_budget), policy_(policy) {
+    freer_ = std::thread(&ModelHost::freeInBackground, this);
+}
+
+ModelHost::~ModelHost() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    background_.notify_all();
+    if (loader_.joinable()) {
+        loader_.join();
+    }
+    freer_.join();
+}
+
+std::unique_ptr<ModelHost::Version> ModelHost::create(const string &path, std::unique_ptr<ParamLoader> loader) {
+    auto version = std::make_unique<Version>();
+    version->path = path;
+    version->bytes = loader->getParamBytes();
+    version->loader = std::move(loader);
+    version->net = std::make_unique<Net>(config_);
+    version->net->convert(params_, MLLM_CPU, thread_count_);
+    version->ex = std::make_unique<Executor>(version->loader.get());
+    return version;
+}
+
+void ModelHost::setup(Version &version) {
+    version.ex->setup(version.net.get());
+    // a first step of two tokens allocates the activations, then every op starts a new sequence again
+    auto input = std::make_shared<Tensor>();
+    input->setBackend(version.net->backends()[MLLM_CPU].get());
+    input->reshape(1, 1, 2, 1);
+    input->alloc();
+    input->setDataAt<float>(0, 0, 0, 0, 0);
+    input->setDataAt<float>(0, 0, 1, 0, 0);
+    version.ex->run(version.net.get(), {input});
+    for (auto &graph : version.net->subGraph()) {
+        graph.second->restoreState({});
+    }
+    version.scheduler = std::make_unique<Scheduler>(version.net.get(), version.ex.get(), policy_);
+}
+
+bool ModelHost::load(const string &path) {
+    auto loader = std::make_unique<ParamLoader>(path);
+    if (!loader->isAvailible()) {
+        std::cerr << "Cannot load model " << path << std::endl;
+        return false;
+    }
+    const uint64_t bytes = loader->getParamBytes();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!versions_.empty() || loading_) {
+            std::cerr << "A model is already loaded, use reload" << std::endl;
+            return false;
+        }
+        if (overlap_budget_ > 0 && bytes > overlap_budget_) {
+            std::cerr << "Model " << path << " needs " << bytes << " bytes, the budget is " << overlap_budget_ << std::endl;
+            return false;
+        }
+        weight_bytes_ += bytes;
+    }
+    auto version = create(path, std::move(loader));
+    setup(*version);
+    std::lock_guard<std::mutex> lock(mutex_);
+    version->number = next_version_++;
+    versions_.push_back(std::move(version));
+    return true;
+}
+
+bool ModelHost::reload(const string &path) {
+    auto loader = std::make_unique<ParamLoader>(path);
+    if (!loader->isAvailible()) {
+        std::cerr << "Cannot load model " << path << std::endl;
+        return false;
+    }
+    const uint64_t bytes = loader->getParamBytes();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (versions_.empty()) {
+            std::cerr << "No model loaded yet, use load" << std::endl;
+            return false;
+        }
+        if (loading_) {
+            std::cerr << "Model " << path << " not loaded: another version is loading" << std::endl;
+            return false;
+        }
+        if (overlap_budget_ > 0 && versions_.back()->bytes + bytes > overlap_budget_) {
+            std::cerr << "Model " << path << " needs " << bytes << " bytes next to the " << versions_.back()->bytes
+                      << " of the current one, the budget is " << overlap_budget_ << std::endl;
+            return false;
+        }
+        loading_ = true;
+    }
+    // only the weights are loaded in the background
+    auto version = create(path, std::move(loader));
+    // under mutex_, as switchVersion() joins it
+    std::lock_guard<std::mutex> lock(mutex_);
+    loader_ = std::thread(&ModelHost::loadInBackground, this, std::move(version));
+    return true;
+}
+
+void ModelHost::loadInBackground(std::unique_ptr<Version> version) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiting_budget_ = true;
+        background_.notify_all();
+        background_.wait(lock, [&] {
+            return stopping_ || overlap_budget_ == 0 || weight_bytes_ + version->bytes <= overlap_budget_;
+        });
+        waiting_budget_ = false;
+        if (stopping_) {
+            return;
+        }
+        weight_bytes_ += version->bytes;
+    }
+    {
+        CPUWorkerPools::Scope phase(CPUWorkerPools::PREFILL);
+        setup(*version);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        incoming_ = std::move(version);
+    }
+    background_.notify_all();
+}
+
+void ModelHost::freeInBackground() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        background_.wait(lock, [&] { return stopping_ || !retired_.empty(); });
+        if (retired_.empty()) {
+            return;
+        }
+        auto retired = std::move(retired_);
+        retired_.clear();
+        freeing_ = true;
+        lock.unlock();
+        // unmaps the weights and frees the activations
+        uint64_t bytes = 0;
+        for (auto &version : retired) {
+            bytes += version->bytes;
+            version.reset();
+        }
+        lock.lock();
+        freeing_ = false;
+        weight_bytes_ -= bytes;
+        background_.notify_all();
+    }
+}
+
+void ModelHost::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    background_.wait(lock, [&] {
+        return retired_.empty() && !freeing_ && (!loading_ || incoming_ != nullptr || waiting_budget_);
+    });
+}
+
+bool ModelHost::loading() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return loading_;
+}
+
+void ModelHost::switchVersion() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (incoming_ == nullptr) {
+        return;
+    }
+    // the loader thread only has to return
+    loader_.join();
+    incoming_->number = next_version_++;
+    std::cout << "Model version " << incoming_->number << " (" << incoming_->path << ") serves new requests" << std::endl;
+    versions_.push_back(std::move(incoming_));
+    loading_ = false;
+}
+
+void ModelHost::retire() {
+    bool retired = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = versions_.begin(); it + 1 < versions_.end();) {
+            if ((*it)->scheduler->pending() == 0) {
+                retired_.push_back(std::move(*it));
+                it = versions_.erase(it);
+                retired = true;
+            } else {
+                ++it;
+            }
+        }
+    }
+    if (retired) {
+        background_.notify_all();
+    }
+}
+
+int ModelHost::submit(GenerationRequest request) {
+    if (versions_.empty()) {
+        std::cerr << "No model loaded" << std::endl;
+        return -1;
+    }
+    const int id = next_id_++;
+    if (request.on_token) {
+        // report the id of the host, not the one of the version's scheduler
+        auto on_token = std::move(request.on_token);
+        request.on_token = [id, on_token](int, token_id_t token) { on_token(id, token); };
+    }
+    versions_.back()->scheduler->submit(std::move(request));
+    return id;
+}
+
+bool ModelHost::step() {
+    switchVersion();
+    bool ran = false;
+    for (size_t i = 0; i < versions_.size(); ++i) {
+        const size_t index = (next_step_ + i) % versions_.size();
+        if (versions_[index]->scheduler->pending() > 0) {
+            ran = versions_[index]->scheduler->step();
+            next_step_ = index + 1;
+            break;
+        }
+    }
+    retire();
+    return ran;
+}
+
+void ModelHost::run() {
+    while (step()) {
+    }
+}
+
+int ModelHost::version() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return versions_.empty() ? -1 : versions_.back()->number;
+}
+
+size_t ModelHost::loadedVersions() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return versions_.size();
+}
+
+uint64_t ModelHost::weightBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return weight_bytes_;
+}
+
+} // namespace mllm
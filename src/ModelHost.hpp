@@ -0,0 +1,130 @@
+#ifndef MLLM_MODELHOST_H
+#define MLLM_MODELHOST_H
+
+#include "Scheduler.hpp"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace mllm {
+/**
+ * \brief Serves generation requests from one model while a new version of its weights loads next to it.
+ *
+ * Every loaded version has its own ParamLoader, Net, Executor and Scheduler, built from the same NetParameters.
+ * reload() builds the Net of the new version, then loads its weights on a background thread in the prefill CPUs
+ * (see CPUWorkerPools), and runs one step through it so that its first request does not pay for the first
+ * allocations. Meanwhile step() keeps serving the live version. Between two steps, step() switches to the new
+ * version once it is ready: from then on, submit() queues new requests on it, while the requests already
+ * queued finish on the version they started on. A version that is no longer current is handed to a background
+ * thread as soon as its last request ends, which frees it, so that step() never waits for its weights to be unmapped.
+ *
+ * The weights of all loaded versions, plus the one loading, stay within the overlap budget: reload() refuses a
+ * version that does not fit next to the current one, and the background load waits for older versions to
+ * drain and be freed until it fits. weightBytes() counts a retired version until it is freed.
+ *
+ * submit() and step() are called from one thread; reload() may be called from any thread.
+ */
+class ModelHost {
+public:
+    /**
+     * \param params          The NetParameters of the model, shared by every version
+     * \param config          The backend configuration of every version
+     * \param thread_count    Number of threads each version runs with
+     * \param overlap_budget  Bytes of weights loaded at once, the version being loaded included; 0 for no bound
+     * \param policy          The memory policy of the Scheduler of every version
+     */
+    ModelHost(vector<NetParameter> &params, BackendConfig config, int thread_count, uint64_t overlap_budget,
+              Scheduler::MemoryPolicy policy = Scheduler::KEEP_KV);
+    ~ModelHost();
+
+    /**
+     * \brief load the first version, on the calling thread.
+     * \return false if the file cannot be opened or does not fit in the budget.
+     */
+    bool load(const string &path);
+    /**
+     * \brief start loading a new version in the background, see the class comment.
+     * \return false if the file cannot be opened, a version is already loading, or it does not fit in the
+     *         budget next to the current one.
+     */
+    bool reload(const string &path);
+    /**
+     * \brief whether a version is loading, or loaded and waiting for the next step() to switch to it.
+     */
+    bool loading() const;
+    /**
+     * \brief wait for the background threads: until the retired versions are freed, and the version loading is
+     *        loaded, unless it waits for versions that still have requests to drain.
+     */
+    void waitIdle();
+
+    /**
+     * \brief queue a request on the current version.
+     * \return the id of the request, passed to on_token.
+     */
+    int submit(GenerationRequest request);
+    /**
+     * \brief switch to a loaded version, run one step of one of the versions with requests (in turn), and free
+     *        the versions left without requests.
+     * \return false if there is nothing to run.
+     */
+    bool step();
+    /**
+     * \brief run steps until every request has finished.
+     */
+    void run();
+
+    /**
+     * \brief the number of the current version: 0 for the first load, then 1, 2... for every switch.
+     */
+    int version() const;
+    /**
+     * \brief number of versions loaded, the current one and the ones still finishing their requests.
+     */
+    size_t loadedVersions() const;
+    /**
+     * \brief bytes of the weights of the loaded versions, plus the one loading.
+     */
+    uint64_t weightBytes() const;
+
+private:
+    struct Version;
+    std::unique_ptr<Version> create(const string &path, std::unique_ptr<ParamLoader> loader);
+    void setup(Version &version);
+    void loadInBackground(std::unique_ptr<Version> version);
+    void freeInBackground();
+    void switchVersion();
+    void retire();
+
+    vector<NetParameter> &params_;
+    BackendConfig config_;
+    int thread_count_;
+    uint64_t overlap_budget_;
+    Scheduler::MemoryPolicy policy_;
+
+    mutable std::mutex mutex_;
+    // notified when a version is freed or loaded in the background, and on stop
+    std::condition_variable background_;
+    // the current version last; only step() and load() change it, under mutex_
+    vector<std::unique_ptr<Version>> versions_;
+    // the version loaded in the background, until step() switches to it
+    std::unique_ptr<Version> incoming_;
+    // the versions retire() took out of versions_, until the freeing thread destroys them
+    vector<std::unique_ptr<Version>> retired_;
+    std::thread loader_;
+    std::thread freer_;
+    bool loading_ = false;
+    // the loader waits for older versions to drain
+    bool waiting_budget_ = false;
+    bool freeing_ = false;
+    bool stopping_ = false;
+    uint64_t weight_bytes_ = 0;
+    int next_version_ = 0;
+
+    int next_id_ = 0;
+    size_t next_step_ = 0;
+};
+} // namespace mllm
+
+#endif // MLLM_MODELHOST_H
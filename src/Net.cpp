@@ -3,6 +3,7 @@
 #include "Op.hpp"
 #include "Types.hpp"
 #include "backends/cpu/CPUBackend.hpp"
+#include "backends/cpu/CPUWorkerPools.hpp"
 #include <vector>
 
 namespace mllm {
@@ -21,6 +22,13 @@ Net::Net(BackendConfig config){
     }
 
     cpuBn.reset(new CPUBackend(mm));
+    cpuBn->setNumaNodes(config.numa_nodes);
+    CPUWorkerPools::require(config.decode_cpus, config.power);
+    if (!config.kv_spill_dir.empty()) {
+        cpuBn->setKVSpill(config.kv_spill_dir, config.kv_ram_budget);
+    }
+    cpuBn->setWeightPrefetch(config.weight_prefetch);
+    block_plan_ = config.block_plan;
     backends_.emplace(BackendType::MLLM_CPU,  cpuBn);
 }
 
@@ -54,8 +62,10 @@ void Net::convert(vector<NetParameter> &param, BackendType backend_type, int thr
     for (int i = 0; i < (int)param.size(); ++i) {
         param[i].topologySort();
         shared_ptr<Graph> subg_1;
-        subg_1.reset(new Graph( param[i], backends_[backend_type].get(), tensors_, threadCount));
+        // a graph's activations may be read by the next graphs, so only a lone graph shares them
+        subg_1.reset(new Graph( param[i], backends_[backend_type].get(), tensors_, threadCount, block_plan_, param.size() == 1));
         subGraphs_["G" + std::to_string(i)] = subg_1;
+        graphs_.push_back(subg_1.get());
     }
 }
 
@@ -17,6 +17,12 @@ public:
     unordered_map<string, shared_ptr<Graph>> &subGraph() {
         return subGraphs_;
     }
+    /**
+     * \brief the graphs in the order they run, the same as subGraph()["G0"], subGraph()["G1"]...
+     */
+    const vector<Graph *> &graphs() const {
+        return graphs_;
+    }
     unordered_map<string, shared_ptr<Tensor>> &tensors() {
         return tensors_;
     }
@@ -28,21 +34,24 @@ public:
         return tensor_names_;
     }
     void freeTensors(int graph_idx);
-    vector<string> inputNames() const{
+    const vector<string> &inputNames() const{
         return input_names_;
     }
-    map<string, int> inGmap() const{
+    const map<string, int> &inGmap() const{
         return inputname_graphidx_;
     }
 
 private:
+    // first, so that the backends outlive the tensors they free
+    unordered_map<BackendType, shared_ptr<Backend>> backends_;
     unordered_map<string, shared_ptr<Graph>> subGraphs_;
+    vector<Graph *> graphs_;
     unordered_map<string, shared_ptr<Tensor>> tensors_;
     vector<vector<string>> tensor_names_;
     vector<NetOp *> ops_;
-    unordered_map<BackendType, shared_ptr<Backend>> backends_;
     vector<string> input_names_ ;
     map<string, int> inputname_graphidx_;
+    bool block_plan_;
 
 };
 
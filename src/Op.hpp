@@ -12,6 +12,54 @@ class Backend;
 class Tensor;
 class ParamLoader;
 
+/**
+ * \brief the state an op keeps per block of a block plan, see Op::addBlock. -> reaches the state of the bound
+ *        block; the states are never moved, their tensors may be referred to by address.
+ */
+template <class State>
+class BlockStates {
+public:
+    explicit BlockStates(const string &name) {
+        add(name);
+    }
+    /**
+     * \brief adds the state of the block whose op is named `name`.
+     * \return its index
+     */
+    int add(const string &name) {
+        states_.push_back(std::make_shared<State>());
+        names_.push_back(name);
+        if (bound_ == nullptr) {
+            bound_ = states_[0].get();
+        }
+        return (int)states_.size() - 1;
+    }
+    void bind(int block) {
+        bound_ = states_[block].get();
+    }
+    State *operator->() const {
+        return bound_;
+    }
+    State &operator*() const {
+        return *bound_;
+    }
+    State &operator[](int block) const {
+        return *states_[block];
+    }
+    const string &name(int block) const {
+        return names_[block];
+    }
+    int size() const {
+        return (int)states_.size();
+    }
+
+private:
+    vector<shared_ptr<State>> states_;
+    vector<string> names_;
+    State *bound_ = nullptr;
+};
+
+
 class Op {
 public:
     /**
@@ -31,15 +79,15 @@ public:
      * @param outputs   output tensors
      * @return MLLM_NO_ERROR
      */
-    virtual ErrorCode reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+    virtual ErrorCode reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 #ifdef DEBUGPRINT
         std::cout << "" << name() << "     reshape:";
         std::cout << "\n    || ";
-        for (auto input : inputs) {
+        for (const auto &input : inputs) {
             std::cout << "Input " << input->name() << " shape: " << input->ShapeString() << " |";
         }
         std::cout << "\n    || ";
-        for (auto output : outputs) {
+        for (const auto &output : outputs) {
             std::cout << "Output " << output->name() << " shape: " << output->ShapeString() << " |";
         }
         std::cout << std::endl;
@@ -53,7 +101,7 @@ public:
      * @param outputs   output tensors
      * @return MLLM_NO_ERROR
      */
-    virtual ErrorCode setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+    virtual ErrorCode setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
         for (auto &output : outputs) {
             output->setDtype(activation_dtype_);
             output->alloc();
@@ -79,7 +127,7 @@ public:
      * @param outputs   output tensors
      * @return MLLM_NO_ERROR
      */
-    virtual ErrorCode execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+    virtual ErrorCode execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
         return MLLM_NO_ERROR;
     }
 
@@ -89,7 +137,7 @@ public:
      * @param outputs   output tensors
      * @return MLLM_NO_ERROR
      */
-    virtual ErrorCode free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+    virtual ErrorCode free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
         return MLLM_NO_ERROR;
     }
 
@@ -99,7 +147,7 @@ public:
     string name() const {
         return name_;
     }
-    void setName(string name) {
+    void setName(const string &name) {
         name_ = name;
     }
     DataType activation_dtype() const {
@@ -111,6 +159,89 @@ public:
     void setOpType(OpType type) {
         type_ = type;
     }
+    /**
+     * \brief what an op carries from one execute() of a sequence to the next, e.g. the tokens of a KV cache.
+     */
+    struct SequenceState {
+        int position = 0;  // tokens of the sequence seen by the op
+        vector<char> data;
+    };
+    /**
+     * \brief save the state of the current sequence, so that another sequence can run in between.
+     */
+    virtual void saveState(SequenceState & /*state*/) {
+    }
+    /**
+     * \brief continue a sequence saved by saveState, or start a new one if `state` is a default SequenceState.
+     */
+    virtual void restoreState(const SequenceState & /*state*/) {
+    }
+    /**
+     * \brief the weights execute() reads, in the order it reads them, see Backend::prefetchWeights.
+     */
+    virtual vector<Tensor *> weights() {
+        return {};
+    }
+    /**
+     * \brief block plans (see Graph): one op object runs the op at the same place in every repeated block of a
+     *        model. An op with weights, caches or a sequence position keeps them per block: addBlock() adds a
+     *        block whose op is named `name`, the op being block 0, and bindBlock() makes a block the one that
+     *        load(), reshape(), setUp(), execute(), free(), weights() and the sequence state act on.
+     * \return the index of the block, -1 if the op cannot run several blocks; the graph then creates an op per
+     *         block.
+     */
+    virtual int addBlock(const string & /*name*/) {
+        return -1;
+    }
+    virtual void bindBlock(int /*block*/) {
+    }
+    /**
+     * \brief number of threads the last execute() ran with.
+     * \return 0 if the op does not size its parallelism from its work.
+     */
+    int threadWidth() const {
+        return thread_width_;
+    }
+
+    /**
+     * \brief bytes the last execute() did not copy, because the producers of its inputs wrote straight into
+     *        its buffers (see redirectInput).
+     */
+    uint64_t bytesSaved() const {
+        return bytes_saved_;
+    }
+    /**
+     * \brief tell the op which of its inputs are produced by an op of the same graph, and can be redirected.
+     *        Called by Graph before setUp(); if it is never called, every input can be redirected.
+     */
+    void setRedirectableInputs(vector<bool> redirectable) {
+        redirectable_inputs_ = std::move(redirectable);
+    }
+
+protected:
+    void setThreadWidth(int width) {
+        thread_width_ = width;
+    }
+    void setBytesSaved(uint64_t bytes) {
+        bytes_saved_ = bytes;
+    }
+    /**
+     * \brief destination passing: turn `input` into a view of `dest` at `offset` (b, h, s, d), so that its producer
+     *        writes there and the op does not have to copy it. Tensors viewing `input` follow it.
+     *        Must be called in setUp(), after the producer's setUp().
+     * \param index  index of `input` in the inputs of the op
+     * \return false if the input is not produced in the graph (e.g. a graph input) and was left alone.
+     */
+    bool redirectInput(int index, const shared_ptr<Tensor> &input, Tensor &dest, const vector<int> &offset) {
+        if (index < (int)redirectable_inputs_.size() && !redirectable_inputs_[index]) {
+            return false;
+        }
+        if (input->masterTensor() == nullptr) {
+            input->free();
+        }
+        input->deepCopyFrom(dest, false, offset);
+        return true;
+    }
 
 private:
     Backend *backend_;
@@ -119,6 +250,9 @@ private:
     string name_;
     DataType activation_dtype_ = MLLM_TYPE_F32;
     OpType type_;
+    int thread_width_ = 0;
+    uint64_t bytes_saved_ = 0;
+    vector<bool> redirectable_inputs_;
 };
 
 } // namespace mllm
@@ -4,6 +4,7 @@
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <set>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -29,6 +30,9 @@
 namespace mllm {
 bool ParamLoader::load(mllm::Tensor *tensor) {
     string name = tensor->name();
+    if (offsets_.find(name) == offsets_.end() && !tiedTo(name).empty()) {
+        name = tiedTo(name);
+    }
 #ifndef USE_MMAP
     if (offsets_.find(name) == offsets_.end()) { return false; }
     std::pair<uint64_t, uint64_t> offset = offsets_[name];
@@ -38,6 +42,16 @@ bool ParamLoader::load(mllm::Tensor *tensor) {
     // TODO:Data?
     //  tenor. = data;
     auto *p = tensor->hostPtr<char>();
+    if (data_type_[name] == MLLM_TYPE_BF16 && tensor->dtype() == MLLM_TYPE_F32) {
+        // an op without bf16 kernels: widen, bf16 is the high half of an fp32
+        const auto *bf16 = reinterpret_cast<const uint16_t *>(data);
+        auto *f32 = reinterpret_cast<uint32_t *>(p);
+        for (uint64_t i = 0; i < offset.second / sizeof(uint16_t); ++i) {
+            f32[i] = (uint32_t)bf16[i] << 16;
+        }
+        delete[] data;
+        return true;
+    }
     memcpy(static_cast<void *>(p), static_cast<void *>(data),
            offset.second); // Cast pointers to void*
     delete[] data;         // Free the memory allocated by new
@@ -89,6 +103,17 @@ ParamLoader::ParamLoader(std::string filename, bool use_mmap) :
         // std::cout<<name<<"   length:"<<length<<std::endl;
         data_type_[name] = readInt(fp_);
     }
+    // the converter stores tied weights once, every name of the group points to the same data
+    std::map<std::pair<uint64_t, uint64_t>, std::string> stored;
+    for (const auto &[name, offset] : offsets_) {
+        if (offset.second == 0) {
+            continue;
+        }
+        auto first = stored.emplace(offset, name);
+        if (!first.second) {
+            tie(name, first.first->second);
+        }
+    }
 // int len = sizeof(int);
 // while (len<size) {
 //     int index = readInt(fp_);
@@ -114,6 +139,16 @@ for (auto &[fst, snd] : data_type_) {
     }
     return keys;
 }
+uint64_t ParamLoader::getParamBytes() const {
+    std::set<std::pair<uint64_t, uint64_t>> stored;
+    uint64_t bytes = 0;
+    for (const auto &[name, offset] : offsets_) {
+        if (stored.insert(offset).second) {
+            bytes += offset.second;
+        }
+    }
+    return bytes;
+}
 std::tuple<uint8_t *, uint64_t> ParamLoader::load(string name) {
     auto [offset, length] = offsets_[name];
     auto *data = new uint8_t[length];
@@ -122,6 +157,9 @@ std::tuple<uint8_t *, uint64_t> ParamLoader::load(string name) {
     return std::make_tuple(data, length);
 }
 DataType ParamLoader::getDataType(string name) {
+    if (data_type_.count(name) != 1 && !tiedTo(name).empty()) {
+        name = tiedTo(name);
+    }
     if (data_type_.count(name) != 1) {
         std::cerr<<name<<" not found"<<std::endl;
         return DataType::MLLM_TYPE_COUNT;
@@ -130,4 +168,13 @@ DataType ParamLoader::getDataType(string name) {
     // check if exists
     return static_cast<DataType>(type);
 }
-} // namespace mllm
\ No newline at end of file
+string ParamLoader::tiedTo(string name) {
+    auto it = tied_.find(name);
+    return it == tied_.end() ? "" : it->second;
+}
+void ParamLoader::tie(const string &name, const string &target) {
+    const string shared = tiedTo(target).empty() ? target : tiedTo(target);
+    tied_[shared] = shared;
+    tied_[name] = shared;
+}
+} // namespace mllm
@@ -52,6 +52,12 @@ public:
     virtual bool load(mllm::Tensor *tensor) = 0;
     virtual bool load(std::shared_ptr<mllm::Tensor> tensor) = 0;
     virtual DataType getDataType(string name) {return MLLM_TYPE_COUNT;}
+    /**
+     * \brief weights tied together (e.g. the input embedding and the LM head) share one buffer.
+     * \return the name of the weight whose data `name` shares, the same for every weight of the group;
+     *         empty if `name` is not tied.
+     */
+    virtual string tiedTo(string name) {return "";}
 };
 
 /**
@@ -72,12 +78,23 @@ public:
     vector<std::string> getParamNames();
     std::tuple<uint8_t *, uint64_t> load(string name);
     DataType getDataType(string name) override;
+    string tiedTo(string name) override;
+    /**
+     * \brief tie `name` to `target`: the ops loading either of them share one buffer, filled from `target`.
+     *        `name` does not have to be in the file. Weights stored once in the file under several names (same
+     *        offset) are tied when the file is opened.
+     */
+    void tie(const string &name, const string &target);
     bool isAvailible() const {
         return fp_ != nullptr&& !offsets_.empty();
     }
     unsigned int getParamSize() const {
         return offsets_.size();
     }
+    /**
+     * \brief bytes of the weights in the file, the data of tied weights counted once.
+     */
+    uint64_t getParamBytes() const;
 
 
 private:
@@ -87,6 +104,7 @@ private:
     std::uint64_t size_;
     std::map<std::string, std::pair<uint64_t, uint64_t>> offsets_; // offsets,length
     std::map<std::string, int> data_type_;
+    std::map<std::string, std::string> tied_; // name -> the weight it shares
     bool use_mmap_;
 };
 
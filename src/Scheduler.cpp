@@ -0,0 +1,156 @@
+#include "Scheduler.hpp"
+#include "Timing.hpp"
+
+namespace mllm {
+
+static token_id_t argmaxLastRow(shared_ptr<Tensor> result) {
+    token_id_t best = 0;
+    float best_value = result->dataAt<float>(0, 0, result->sequence() - 1, 0);
+    for (int i = 1; i < result->dimension(); ++i) {
+        auto value = result->dataAt<float>(0, 0, result->sequence() - 1, i);
+        if (value > best_value) {
+            best = i;
+            best_value = value;
+        }
+    }
+    return best;
+}
+
+Scheduler::Scheduler(Net *net, Executor *ex, MemoryPolicy policy, std::function<token_id_t(shared_ptr<Tensor>)> sample) :
+    net_(net), ex_(ex), policy_(policy), sample_(std::move(sample)), input_(std::make_shared<Tensor>()) {
+    if (!sample_) {
+        sample_ = argmaxLastRow;
+    }
+    input_->setBackend(net_->backends()[MLLM_CPU].get());
+}
+
+int Scheduler::submit(GenerationRequest request) {
+    Sequence seq;
+    seq.id = next_id_++;
+    seq.pending = request.prompt;
+    seq.request = std::move(request);
+    RequestStats stat;
+    stat.priority = seq.request.priority;
+    stat.arrival_us = mllm_time_us();
+    stats_[seq.id] = stat;
+    sequences_.push_back(std::move(seq));
+    return sequences_.back().id;
+}
+
+bool Scheduler::before(const Sequence &a, const Sequence &b) const {
+    if (a.request.priority != b.request.priority) {
+        return a.request.priority > b.request.priority;
+    }
+    if (a.request.deadline_us != b.request.deadline_us) {
+        // no deadline comes last
+        return b.request.deadline_us == 0 || (a.request.deadline_us != 0 && a.request.deadline_us < b.request.deadline_us);
+    }
+    return a.id < b.id;
+}
+
+void Scheduler::pause(Sequence &seq) {
+    seq.states.clear();
+    if (policy_ == KEEP_KV) {
+        seq.states.resize(net_->graphs().size());
+        for (int i = 0; i < (int)net_->graphs().size(); ++i) {
+            net_->graphs()[i]->saveState(seq.states[i]);
+        }
+    } else {
+        // the last generated token has not been fed yet, everything before it is prefilled again
+        seq.pending = seq.request.prompt;
+        seq.pending.insert(seq.pending.end(), seq.generated.begin(), seq.generated.end());
+    }
+    stats_[seq.id].preemptions++;
+}
+
+void Scheduler::resume(Sequence &seq) {
+    static const unordered_map<string, Op::SequenceState> new_sequence;
+    for (int i = 0; i < (int)net_->graphs().size(); ++i) {
+        net_->graphs()[i]->restoreState(i < (int)seq.states.size() ? seq.states[i] : new_sequence);
+    }
+    seq.states.clear();
+}
+
+bool Scheduler::step() {
+    if (sequences_.empty()) {
+        return false;
+    }
+    Sequence *next = &sequences_.front();
+    for (auto &seq : sequences_) {
+        if (before(seq, *next)) {
+            next = &seq;
+        }
+    }
+    if (running_ != nullptr && running_ != next) {
+        if (next->request.priority > running_->request.priority) {
+            pause(*running_);
+            running_ = nullptr;
+        } else {
+            next = running_;
+        }
+    }
+    if (running_ != next) {
+        resume(*next);
+        running_ = next;
+    }
+
+    auto &seq = *running_;
+    input_->reshape(1, 1, (int)seq.pending.size(), 1);
+    input_->alloc();
+    for (int i = 0; i < (int)seq.pending.size(); ++i) {
+        input_->setDataAt<float>(0, 0, i, 0, seq.pending[i]);
+    }
+    ex_->run(net_, {input_});
+    const token_id_t token = sample_(ex_->result()[0]);
+    seq.generated.push_back(token);
+    seq.pending = {token};
+
+    auto &stat = stats_[seq.id];
+    stat.tokens++;
+    if (stat.first_token_us == 0) {
+        stat.first_token_us = mllm_time_us();
+    }
+    if (seq.request.on_token) {
+        seq.request.on_token(seq.id, token);
+    }
+    if (token == seq.request.eos || (int)seq.generated.size() >= seq.request.max_new_tokens) {
+        stat.finish_us = mllm_time_us();
+        const int id = seq.id;
+        running_ = nullptr;
+        sequences_.remove_if([id](const Sequence &s) { return s.id == id; });
+    }
+    return true;
+}
+
+void Scheduler::run() {
+    while (step()) {
+    }
+}
+
+void Scheduler::report() const {
+    struct ClassStats {
+        int requests = 0;
+        double ttft_ms = 0;
+        double max_ttft_ms = 0;
+        int preemptions = 0;
+    };
+    std::map<int, ClassStats, std::greater<int>> classes;
+    for (const auto &s : stats_) {
+        if (s.second.first_token_us == 0) {
+            continue;
+        }
+        auto &c = classes[s.second.priority];
+        const double ttft = (s.second.first_token_us - s.second.arrival_us) / 1000.0;
+        c.requests++;
+        c.ttft_ms += ttft;
+        c.max_ttft_ms = std::max(c.max_ttft_ms, ttft);
+        c.preemptions += s.second.preemptions;
+    }
+    for (const auto &c : classes) {
+        std::cout << "priority " << c.first << ": " << c.second.requests << " requests, time to first token "
+                  << c.second.ttft_ms / c.second.requests << " ms mean, " << c.second.max_ttft_ms << " ms max, "
+                  << c.second.preemptions << " preemptions" << std::endl;
+    }
+}
+
+} // namespace mllm
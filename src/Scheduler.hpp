@@ -0,0 +1,117 @@
+#ifndef MLLM_SCHEDULER_H
+#define MLLM_SCHEDULER_H
+
+#include "Executor.hpp"
+#include "tokenizers/Tokenizer.hpp"
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+namespace mllm {
+/**
+ * \brief A generation request handled by the Scheduler.
+ */
+struct GenerationRequest {
+    vector<token_id_t> prompt;
+    int max_new_tokens = 100;
+    token_id_t eos = 2;
+    // higher priorities run first and pause the lower ones
+    int priority = 0;
+    // mllm_time_us() by which the first token is due, 0 for none; orders the requests of a priority
+    uint64_t deadline_us = 0;
+    // called with every generated token
+    std::function<void(int id, token_id_t token)> on_token;
+};
+
+/**
+ * \brief Runs several generation requests on one Net, most urgent first.
+ *
+ * The Scheduler runs one step at a time: the prefill of a request, or one decode step. Before every step it picks
+ * the runnable request with the highest priority, then the earliest deadline, then the earliest arrival. A running
+ * request is only paused for a request of higher priority. Pausing happens between two steps, so no step is cut
+ * short. The KV caches and positions of the paused sequence are then handled by the memory policy:
+ * - KEEP_KV copies them aside and copies them back on resume;
+ * - RELEASE_KV drops them, and the sequence is prefilled again from its prompt and the tokens generated so far.
+ * Either way, a resumed request generates the same tokens as if it had never been paused.
+ */
+class Scheduler {
+public:
+    enum MemoryPolicy {
+        KEEP_KV = 0,
+        RELEASE_KV,
+    };
+    struct RequestStats {
+        int priority;
+        uint64_t arrival_us;
+        uint64_t first_token_us = 0;
+        uint64_t finish_us = 0;
+        int tokens = 0;
+        int preemptions = 0;
+    };
+
+    /**
+     * \param net     An instance of the Net class, set up by `ex`
+     * \param ex      The Executor running `net`
+     * \param policy  What to do with the KV caches of a paused request
+     * \param sample  Picks the next token from the output of the net; argmax of the last row by default
+     */
+    Scheduler(Net *net, Executor *ex, MemoryPolicy policy = KEEP_KV,
+              std::function<token_id_t(shared_ptr<Tensor>)> sample = nullptr);
+
+    /**
+     * \brief queue a request.
+     * \return the id of the request, passed to on_token and used by stats().
+     */
+    int submit(GenerationRequest request);
+    /**
+     * \brief run one step of the most urgent request.
+     * \return false if there is nothing to run.
+     */
+    bool step();
+    /**
+     * \brief run steps until every request has finished.
+     */
+    void run();
+
+    /**
+     * \brief number of requests queued or running.
+     */
+    size_t pending() const {
+        return sequences_.size();
+    }
+
+    const std::map<int, RequestStats> &stats() const {
+        return stats_;
+    }
+    /**
+     * \brief print the time to first token and the preemptions, by priority.
+     */
+    void report() const;
+
+private:
+    struct Sequence {
+        int id;
+        GenerationRequest request;
+        vector<token_id_t> generated;
+        // tokens to feed at the next step: the prompt, the last token, or everything again after a release
+        vector<token_id_t> pending;
+        // op name -> state, per graph; empty while running or when released
+        vector<unordered_map<string, Op::SequenceState>> states;
+    };
+    bool before(const Sequence &a, const Sequence &b) const;
+    void pause(Sequence &seq);
+    void resume(Sequence &seq);
+
+    Net *net_;
+    Executor *ex_;
+    MemoryPolicy policy_;
+    std::function<token_id_t(shared_ptr<Tensor>)> sample_;
+    std::list<Sequence> sequences_;
+    Sequence *running_ = nullptr;
+    int next_id_ = 0;
+    std::map<int, RequestStats> stats_;
+    shared_ptr<Tensor> input_;
+};
+} // namespace mllm
+
+#endif // MLLM_SCHEDULER_H
@@ -13,8 +13,8 @@ Tensor::Tensor(const vector<int> &shape) :
 }
 
 bool Tensor::reshape(const int batch, const int head, const int sequence, const int dimension) {
-    vector<int> shape(4);
-    shape[0] = batch;
+    // reshaped by every op on every step: no vector for the new shape
+    int shape[4] = {batch, 0, 0, 0};
     switch (ctype_) {
     case BSHD:
         shape[1] = sequence;
@@ -34,11 +34,15 @@ bool Tensor::reshape(const int batch, const int head, const int sequence, const
     default:
         break;
     }
-    return reshape(shape);
+    return reshape(shape, 4);
 }
 
 
 void Tensor::alloc() {
+    allocAligned(8);
+}
+
+void Tensor::allocAligned(size_t alignment) {
     if(aggregated_){return;}
     assert(backend_ != nullptr);
     if(masterTensor() != nullptr) {
@@ -49,11 +53,16 @@ void Tensor::alloc() {
     }
     if (allocated_ != count_) {
         if (host_ptr_ != nullptr) {
-            backend_->free(host_ptr_);
+            freeHost(host_ptr_);
             host_ptr_ = nullptr;
         }
         if(count_ >0) {
-            backend_->alloc(&host_ptr_, cntSize(), 8);
+            const size_t size = (cntSize() + alignment - 1) / alignment * alignment;
+            if (mem_manager_ != nullptr) {
+                mem_manager_->alloc(&host_ptr_, size, alignment);
+            } else {
+                backend_->alloc(&host_ptr_, size, alignment);
+            }
         }
         allocated_ = count_;
     }
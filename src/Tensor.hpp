@@ -62,7 +62,7 @@ public:
     }
     ~Tensor() {
         if (host_ptr_ != nullptr && masterTensor() == nullptr && !aggregated_) {
-            backend_->free(host_ptr_);
+            freeHost(host_ptr_);
             host_ptr_ = nullptr;
         }
     }
@@ -72,6 +72,8 @@ private:
     DataType dtype_;
     ChlType ctype_ = BSHD;
     Backend *backend_;
+    // allocates host_ptr_ instead of the backend when set
+    MemoryManager *mem_manager_ = nullptr;
     void *host_ptr_;
     void *device_ptr_; // not used for CPU
     vector<int> shape_;
@@ -93,6 +95,14 @@ private:
     Chl aggregated_dim_;
     vector<int> aggregated_dims_;
 
+    void freeHost(void *ptr) {
+        if (mem_manager_ != nullptr) {
+            mem_manager_->free(ptr);
+        } else {
+            backend_->free(ptr);
+        }
+    }
+
 public:
     /**
      * \brief build 4-D Tensor with four dimensions: [batch, head, sequence, dimension].
@@ -131,13 +141,18 @@ public:
         alloc();
     }
     void alloc();
+    /**
+     * \brief alloc the memory of Tensor at a multiple of `alignment`, and round its size up to a multiple of it,
+     *        so that the buffer shares no page with other allocations when `alignment` is the page size.
+     */
+    void allocAligned(size_t alignment);
     /**
      * \brief free the memory of Tensor.
      */
     void free() {
         if (aggregated_) { return; }
         if (host_ptr_ != nullptr && masterTensor() == nullptr) {
-            backend_->free(host_ptr_);
+            freeHost(host_ptr_);
             host_ptr_ = nullptr;
             allocated_ = 0;
         }
@@ -437,6 +452,14 @@ public:
     void setBackend(Backend *bn) {
         backend_ = bn;
     };
+    /**
+     * \brief allocate the memory of the Tensor from `mm` rather than from its Backend, e.g. a file mapping.
+     *        Must be set before alloc(), nullptr goes back to the Backend.
+     */
+    void setMemoryManager(MemoryManager *mm) {
+        assert(host_ptr_ == nullptr);
+        mem_manager_ = mm;
+    }
 
     DataType dtype() const {
         return dtype_;
@@ -467,7 +490,7 @@ public:
     void setName(string name) {
         name_ = name;
     }
-    string name() const {
+    const string &name() const {
         return name_;
     }
     int allocted() const {
@@ -612,10 +635,10 @@ public:
         deepCopyFrom(&source, copyshape, shape_offset, head_rep);
     }
 
-    vector<int> shape_offset() const {
+    const vector<int> &shape_offset() const {
         return shape_offset_;
     }
-    vector<int> shape_master() const {
+    const vector<int> &shape_master() const {
         return shape_master_;
     }
 
@@ -630,7 +653,10 @@ public:
         return child_tensors_;
     }
     void addChildTensor(Tensor *child) {
-        child_tensors_.push_back(child);
+        // views are re-attached every token (KVCache, Cat); keep each child once
+        if (std::find(child_tensors_.begin(), child_tensors_.end(), child) == child_tensors_.end()) {
+            child_tensors_.push_back(child);
+        }
     }
 
     /* Functions used for AggregatedTensor:
@@ -687,6 +713,9 @@ public:
         }
         aggregated_tensors_ = ts;
     }
+    bool aggregated() const {
+        return aggregated_;
+    }
 
     /* Functions used for 5-D Tensor:
      * - reshape
@@ -1069,10 +1098,13 @@ public:
 
 private:
     bool reshape(const vector<int> &shape) {
-        assert(shape.size() <= 32);
+        return reshape(shape.data(), (int)shape.size());
+    }
+    bool reshape(const int *shape, int dims) {
+        assert(dims <= 32);
         count_ = 1;
-        shape_.resize(shape.size());
-        for (int i = 0; i < shape.size(); ++i) {
+        shape_.resize(dims);
+        for (int i = 0; i < dims; ++i) {
             assert(shape[i] >= 0);
             if (count_ != 0) {
                 assert(shape[i] <= INT_MAX / count_);
@@ -0,0 +1,99 @@
+#ifndef MLLM_TENSORACCESSOR_H
+#define MLLM_TENSORACCESSOR_H
+
+#include "Tensor.hpp"
+
+namespace mllm {
+/**
+ * \brief typed element access to a 4-D Tensor (batch, head, sequence, dimension) for the inner loops of kernels.
+ *
+ * Tensor::dataAt/ptrAt/setDataAt switch on the layout and, for a ChildTensor, wrap every index around its
+ * MasterTensor on each call. A TensorAccessor resolves the layout and the child offset once, when it is created,
+ * so that reaching an element is one multiply-add per axis.
+ * Tensors it cannot flatten this way keep the Tensor::ptrAt path: aggregated tensors, and ChildTensors whose
+ * window wraps around the end of their master (a KV cache ring buffer).
+ *
+ * Create it in execute(): it does not follow a later reshape, alloc or deepCopyFrom of the tensor.
+ *
+ * e.g.
+ *   TensorAccessor<float> in(*inputs[0]);
+ *   const float *row = in.ptr(n, h, s, 0); // row[d * in.strideDimension()]
+ */
+template <typename Dtype>
+class TensorAccessor {
+public:
+    explicit TensorAccessor(Tensor &tensor) :
+        tensor_(&tensor) {
+        bool child = tensor.shape_offset().size() == 4 && tensor.shape_master().size() == 4;
+        const int size[4] = {tensor.batch(), tensor.head(), tensor.sequence(), tensor.dimension()};
+        const int *extent = size;
+        if (child) {
+            extent = tensor.shape_master().data();
+            const auto &offset = tensor.shape_offset();
+            for (int i = 0; i < 4; ++i) {
+                wraps_ |= offset[i] + size[i] > extent[i];
+            }
+        }
+        const int64_t b = extent[0];
+        const int64_t h = extent[1];
+        const int64_t s = extent[2];
+        const int64_t d = extent[3];
+        switch (tensor.ctype()) {
+        case BSHD:
+            stride_[3] = 1, stride_[1] = d, stride_[2] = h * d, stride_[0] = s * h * d;
+            break;
+        case BHDS:
+            stride_[2] = 1, stride_[3] = s, stride_[1] = d * s, stride_[0] = h * d * s;
+            break;
+        case SBHD:
+            stride_[3] = 1, stride_[1] = d, stride_[0] = h * d, stride_[2] = b * h * d;
+            break;
+        default:
+            wraps_ = true;
+            break;
+        }
+        wraps_ |= tensor.aggregated();
+        if (!wraps_) {
+            // the child offset is folded into the base pointer
+            base_ = tensor.hostPtr<Dtype>() + (child ? tensor.offset(0, 0, 0, 0) : 0);
+        }
+    }
+
+    Dtype *ptr(const int b, const int h, const int s, const int d) const {
+        if (wraps_) {
+            return tensor_->ptrAt<Dtype>(b, h, s, d);
+        }
+        return base_ + b * stride_[0] + h * stride_[1] + s * stride_[2] + d * stride_[3];
+    }
+    Dtype &operator()(const int b, const int h, const int s, const int d) const {
+        return *ptr(b, h, s, d);
+    }
+    /**
+     * \brief distance between two consecutive elements of a row (same b, h, s), 1 unless the layout is BHDS.
+     *        Only meaningful if direct() is true.
+     */
+    int64_t strideDimension() const {
+        return stride_[3];
+    }
+    /**
+     * \brief true if ptr() is plain pointer arithmetic, false if it goes through Tensor::ptrAt.
+     */
+    bool direct() const {
+        return !wraps_;
+    }
+    /**
+     * \brief true if the rows (same b, h, s) are contiguous, so ptr(b, h, s, 0) can be handed to a vector kernel.
+     */
+    bool contiguousRows() const {
+        return !wraps_ && stride_[3] == 1;
+    }
+
+private:
+    Tensor *tensor_;
+    Dtype *base_ = nullptr;
+    int64_t stride_[4] = {0, 0, 0, 0};
+    bool wraps_ = false;
+};
+} // namespace mllm
+
+#endif // MLLM_TENSORACCESSOR_H
@@ -0,0 +1,117 @@
+#include "CPUActivationStats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+
+#define MLLM_ACTIVATION_STATS_MAGIC 0x53414C4D // "MLAS"
+#define MLLM_ACTIVATION_STATS_VERSION 1
+
+namespace mllm {
+
+void ActivationStats::record(const std::string &name, const float *x, int rows, int cols, size_t row_stride) {
+    std::vector<float> absmax(cols, 0.0F);
+    for (int r = 0; r < rows; ++r) {
+        const float *row = x + r * row_stride;
+        for (int c = 0; c < cols; ++c) {
+            absmax[c] = std::max(absmax[c], std::fabs(row[c]));
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &seen = absmax_[name];
+    if (seen.size() != absmax.size()) {
+        seen = std::move(absmax);
+        return;
+    }
+    for (int c = 0; c < cols; ++c) {
+        seen[c] = std::max(seen[c], absmax[c]);
+    }
+}
+
+const std::vector<float> *ActivationStats::find(const std::string &name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = absmax_.find(name);
+    return it == absmax_.end() ? nullptr : &it->second;
+}
+
+bool ActivationStats::save(const std::string &path) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr) {
+        std::cerr << "Cannot write activation stats to " << path << std::endl;
+        return false;
+    }
+    const int32_t header[3] = {MLLM_ACTIVATION_STATS_MAGIC, MLLM_ACTIVATION_STATS_VERSION, (int32_t)absmax_.size()};
+    bool ok = fwrite(header, sizeof(header), 1, fp) == 1;
+    for (const auto &entry : absmax_) {
+        const int32_t sizes[2] = {(int32_t)entry.first.size(), (int32_t)entry.second.size()};
+        ok = ok && fwrite(sizes, sizeof(sizes), 1, fp) == 1;
+        ok = ok && fwrite(entry.first.data(), 1, entry.first.size(), fp) == entry.first.size();
+        ok = ok && fwrite(entry.second.data(), sizeof(float), entry.second.size(), fp) == entry.second.size();
+    }
+    fclose(fp);
+    return ok;
+}
+
+bool ActivationStats::load(const std::string &path) {
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp == nullptr) {
+        std::cerr << "Cannot read activation stats from " << path << std::endl;
+        return false;
+    }
+    std::map<std::string, std::vector<float>> absmax;
+    int32_t header[3];
+    bool ok = fread(header, sizeof(header), 1, fp) == 1 && header[0] == MLLM_ACTIVATION_STATS_MAGIC
+              && header[1] == MLLM_ACTIVATION_STATS_VERSION;
+    for (int i = 0; ok && i < header[2]; ++i) {
+        int32_t sizes[2];
+        ok = fread(sizes, sizeof(sizes), 1, fp) == 1 && sizes[0] >= 0 && sizes[1] >= 0;
+        if (!ok) {
+            break;
+        }
+        std::string name(sizes[0], '\0');
+        std::vector<float> values(sizes[1]);
+        ok = fread(&name[0], 1, name.size(), fp) == name.size()
+             && fread(values.data(), sizeof(float), values.size(), fp) == values.size();
+        absmax[name] = std::move(values);
+    }
+    fclose(fp);
+    if (!ok) {
+        std::cerr << path << " is not an activation stats file" << std::endl;
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    absmax_ = std::move(absmax);
+    return true;
+}
+
+std::vector<float> ActivationStats::smoothing(const std::string &name, float *weight, int rows, int cols, float alpha) const {
+    const auto *absmax = find(name);
+    if (absmax == nullptr || (int)absmax->size() != cols) {
+        return {};
+    }
+    std::vector<float> weight_max(cols, 0.0F);
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            weight_max[c] = std::max(weight_max[c], std::fabs(weight[(size_t)r * cols + c]));
+        }
+    }
+    std::vector<float> scale(cols, 1.0F);
+    std::vector<float> factors(cols);
+    for (int c = 0; c < cols; ++c) {
+        // channels never active, or with an empty weight column, are left alone
+        if ((*absmax)[c] > 0 && weight_max[c] > 0) {
+            scale[c] = std::pow((*absmax)[c], alpha) / std::pow(weight_max[c], 1.0F - alpha);
+            scale[c] = std::min(std::max(scale[c], 1e-5F), 1e5F);
+        }
+        factors[c] = 1.0F / scale[c];
+    }
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            weight[(size_t)r * cols + c] *= scale[c];
+        }
+    }
+    return factors;
+}
+} // namespace mllm
@@ -0,0 +1,54 @@
+#ifndef MLLM_CPUACTIVATIONSTATS_H
+#define MLLM_CPUACTIVATIONSTATS_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mllm {
+/**
+ * \brief calibration for W8A8: the largest |activation| seen by every input channel of every Linear.
+ *
+ * A few input channels of the projections carry activations tens of times larger than the others, and a
+ * per-row int8 scale sized for them flattens every other channel to a handful of levels. Smoothing moves that
+ * range into the weights: channel j of the activations is multiplied by 1 / s_j and column j of the weight by
+ * s_j, with s_j = max|x_j|^alpha / max|W_j|^(1 - alpha), which leaves the product unchanged.
+ *
+ * The stats are recorded by CPULinear while the model runs on calibration text (CPUBackend::setActivationStats),
+ * saved, and read back by the quantizer, which writes the smoothed weight of each layer as I8 with one scale per
+ * row ("<layer>.scale") and the factors ("<layer>.smooth"), see mat_mul_fp32_i8.
+ */
+class ActivationStats {
+public:
+    /**
+     * \brief fold `rows` rows of `cols` activations read by the Linear `name` into its channel maxima.
+     * \param row_stride  floats between the starts of two rows.
+     */
+    void record(const std::string &name, const float *x, int rows, int cols, size_t row_stride);
+    /**
+     * \return the maxima of a Linear, nullptr if it was never recorded.
+     */
+    const std::vector<float> *find(const std::string &name) const;
+    size_t size() const {
+        return absmax_.size();
+    }
+    bool save(const std::string &path) const;
+    bool load(const std::string &path);
+
+    /**
+     * \brief the factors the activations of the Linear `name` are multiplied by, 1 / s_j, after `weight` has
+     *        been smoothed in place (column j multiplied by s_j).
+     * \param weight  the F32 weight, `rows` x `cols` (output x input features).
+     * \param alpha   share of the activation range moved into the weights, 0.5 for most LLMs.
+     * \return empty if `name` was not recorded or has another number of channels; `weight` is then unchanged.
+     */
+    std::vector<float> smoothing(const std::string &name, float *weight, int rows, int cols, float alpha) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::map<std::string, std::vector<float>> absmax_;
+};
+} // namespace mllm
+
+#endif // MLLM_CPUACTIVATIONSTATS_H
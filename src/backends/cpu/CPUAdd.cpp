@@ -9,7 +9,7 @@ CPUAdd::CPUAdd(Backend *bn, string opName, int threadCount) :
     Op(bn, opName) {
 }
 
-ErrorCode CPUAdd::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUAdd::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     assert(inputs.size() == 2);
     assert(outputs.size() == 1);
     if (inputs[0]->batch() == 1 || inputs[1]->batch() == 1) {
@@ -24,7 +24,7 @@ ErrorCode CPUAdd::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<T
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPUAdd::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUAdd::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     int N = std::max(inputs[0]->batch(), inputs[1]->batch());
     int C = inputs[0]->head();
     int H = inputs[0]->sequence();
@@ -37,14 +37,19 @@ ErrorCode CPUAdd::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<T
             auto in0_ptr = inputs[0]->ptrAt<float>(n_0, 0, 0, 0);
             auto in1_ptr = inputs[1]->ptrAt<float>(n_1, 0, 0, 0);
             auto out_ptr = outputs[0]->ptrAt<float>(n, 0, 0, 0);
-#pragma omp parallel for num_threads(thread_count)
+            const int threads = CPUBackend::threadsFor(copy_size, thread_count);
+            setThreadWidth(threads);
+#pragma omp parallel for num_threads(threads)
             for (int is = 0; is < copy_size; ++is) {
                 out_ptr[is] = in0_ptr[is] + in1_ptr[is];
             }
         } else {
+            // one team per row, and dataAt/setDataAt cost a few operations per element
+            const int threads = CPUBackend::threadsFor(4.0 * W, thread_count);
+            setThreadWidth(threads);
             for (int c = 0; c < C; ++c) {
                 for (int h = 0; h < H; ++h) {
-#pragma omp parallel for num_threads(thread_count)
+#pragma omp parallel for num_threads(threads)
                     for (int w = 0; w < W; ++w) {
                         outputs[0]->setDataAt<float>(n, c, h, w, inputs[0]->dataAt<float>(n_0, c, h, w) + inputs[1]->dataAt<float>(n_1, c, h, w));
                     }
@@ -10,8 +10,8 @@ class CPUAdd final : public Op {
 public:
     CPUAdd(Backend *bn, string opName, int threadCount);
     virtual ~CPUAdd() = default;
-    virtual ErrorCode reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-    virtual ErrorCode execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
+    virtual ErrorCode reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual ErrorCode execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
 
 
 private:
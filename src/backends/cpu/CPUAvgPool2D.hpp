@@ -11,9 +11,9 @@ class CPUAvgPool2D final : public Op {
 public:
     CPUAvgPool2D(Backend *bn, string opName,  vector<int> kernal_size, vector<int> stride, PaddingType padding_type, int threadCount);
     virtual ~CPUAvgPool2D() = default;
-    virtual ErrorCode reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-    virtual ErrorCode execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-    virtual ErrorCode setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
+    virtual ErrorCode reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual ErrorCode execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual ErrorCode setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
 
 private:
     PaddingType padding_type_ = VALID;
@@ -1,5 +1,7 @@
 #include "CPUBackend.hpp"
+#include "ParamLoader.hpp"
 #include <math.h>
+#include <iostream>
 #include "CPUView.hpp"
 #include "CPUAdd.hpp"
 #include "CPUCausalMask.hpp"
@@ -35,6 +37,10 @@
 #include "CPURange.hpp"
 #include "CPUWhere.hpp"
 #include "CPUReplace.hpp"
+#include "CPUWorkerPools.hpp"
+#include "CPUKVSpill.hpp"
+#include "CPUPrefetcher.hpp"
+#include <chrono>
 
 
 namespace mllm {
@@ -43,6 +49,60 @@ CPUBackend::CPUBackend(shared_ptr<MemoryManager>& mm) :
     registerOps();
 }
 
+void CPUBackend::setNumaNodes(int nodes) {
+    if (nodes == 0) {
+        nodes = (int)numaNodeCpus().size();
+    }
+    numa_pool_.reset(nodes >= 2 ? new NumaPool(nodes) : nullptr);
+}
+
+void CPUBackend::setKVSpill(const string &dir, size_t ram_budget) {
+    kv_spill_ = std::make_shared<CPUKVSpill>(dir, ram_budget);
+}
+
+void CPUBackend::setWeightPrefetch(size_t head_bytes) {
+    prefetcher_.reset(head_bytes > 0 ? new CPUPrefetcher(head_bytes) : nullptr);
+}
+
+void CPUBackend::prefetchWeights(const vector<std::pair<const char *, size_t>> &ranges) {
+    if (prefetcher_ != nullptr) {
+        prefetcher_->prefetch(ranges);
+    }
+}
+
+void CPUBackend::stopPrefetch() {
+    if (prefetcher_ != nullptr) {
+        prefetcher_->stop();
+    }
+}
+
+bool CPUBackend::loadTiedWeight(AbstructLoader &loader, Tensor &weight) {
+    const string shared_name = loader.tiedTo(weight.name());
+    if (shared_name.empty()) {
+        return false;
+    }
+    auto &shared = tied_weights_[shared_name];
+    if (shared == nullptr) {
+        shared = std::make_shared<Tensor>(this);
+        shared->setName(shared_name);
+        shared->reshape(weight.batch(), weight.head(), weight.sequence(), weight.dimension());
+        shared->setDtype(loader.getDataType(shared_name));
+        if (shared->dtype() == MLLM_TYPE_COUNT) {
+            std::cerr << "Tied weight " << shared_name << " is not in the model" << std::endl;
+            tied_weights_.erase(shared_name);
+            return false;
+        }
+        shared->alloc();
+        loader.load(shared.get());
+    } else if (shared->count() != weight.count()) {
+        std::cerr << weight.name() << " is tied to " << shared_name << " but their shapes differ" << std::endl;
+        return false;
+    }
+    // the embedding (vocab, hidden) and the LM head (out = vocab, in = hidden) read the same row-major layout
+    weight.deepCopyFrom(shared.get(), false);
+    return true;
+}
+
 Op *CPUBackend::opCreate(const OpParam &op_param, string name, int threadCount) {
     OpType optype = OpType(op_param.find("type")->second);
     auto iter = map_creator_.find(optype);
@@ -91,4 +151,79 @@ void CPUBackend::registerOps() {
     addCreator(REPLACE, (CPUBackend::Creator *)(new CPUReplaceCreator()));
 }
 
+/*
+ * Cost model used by threadsFor(): running `work` elementwise operations on n threads takes about
+ *     work * ns_per_op / n + n * ns_per_thread
+ * which is minimal for n = sqrt(work * ns_per_op / ns_per_thread).
+ */
+struct ThreadCostModel {
+    double ns_per_op;     // one elementwise float operation on one thread
+    double ns_per_thread; // fork/join of an OpenMP team, per thread of the team
+};
+
+static double elapsedNs(std::chrono::steady_clock::time_point start) {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static ThreadCostModel calibrateThreadCost() {
+    ThreadCostModel model{};
+    const int len = 1 << 14;
+    const int reps = 64;
+    vector<float> buf(len, 1.0F);
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+        float *p = buf.data();
+        for (int i = 0; i < len; ++i) {
+            p[i] = p[i] * 0.999F + 0.001F;
+        }
+    }
+    model.ns_per_op = elapsedNs(start) / ((double)len * reps);
+    volatile float sink = buf[len - 1];
+    (void)sink;
+
+    const int max_threads = std::max(omp_get_max_threads(), 1);
+    const int regions = 200;
+    // the first region spawns the thread pool, keep it out of the measurement
+#pragma omp parallel num_threads(max_threads)
+    {}
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < regions; ++r) {
+#pragma omp parallel num_threads(max_threads)
+        {}
+    }
+    model.ns_per_thread = elapsedNs(start) / ((double)regions * max_threads);
+
+    model.ns_per_op = std::max(model.ns_per_op, 1e-3);
+    model.ns_per_thread = std::max(model.ns_per_thread, 1.0);
+    return model;
+}
+
+/*
+ * Under Power_Low a thread of a team also costs the CPU time its worker spins around the op, so each thread is
+ * charged LOW_POWER_THREAD_COST times its fork/join time: teams are a quarter as wide, and the small ops run on
+ * the calling thread without waking the workers.
+ */
+#define LOW_POWER_THREAD_COST 16
+
+int CPUBackend::threadsFor(double work, int max_threads) {
+    static const ThreadCostModel model = calibrateThreadCost();
+    const int limit = CPUWorkerPools::threadLimit();
+    if (limit > 0) {
+        max_threads = std::min(max_threads, limit);
+    }
+    const bool low_power = CPUWorkerPools::power() == BackendConfig::Power_Low;
+    if (low_power) {
+        max_threads = std::min(max_threads, CPUWorkerPools::cpuCount());
+    }
+    if (max_threads <= 1) {
+        return 1;
+    }
+    const double ns_per_thread = model.ns_per_thread * (low_power ? LOW_POWER_THREAD_COST : 1);
+    const double n = std::sqrt(work * model.ns_per_op / ns_per_thread);
+    if (n >= max_threads) {
+        return max_threads;
+    }
+    return std::max((int)n, 1);
+}
+
 } // namespace mllm
@@ -5,8 +5,13 @@
 #include "Op.hpp"
 #include "Types.hpp"
 #include "quantize/Quantize.hpp"
+#include "compute/Numa.hpp"
 
 namespace mllm {
+class CPUKVSpill;
+class CPUPrefetcher;
+class ActivationStats;
+class AbstructLoader;
 class CPUBackend final : public Backend {
 public:
     explicit CPUBackend(shared_ptr<MemoryManager> &mm);
@@ -28,8 +33,86 @@ public:
 
     void registerOps() override;
 
+    /**
+     * \brief number of threads worth forking for an op of the given size.
+     * The cost of an OpenMP team grows with its width, so an op only fans out while the time saved on its work
+     * exceeds the fork/join overhead. Both costs are measured once per process. Power_Low weighs that overhead
+     * more, since idle workers spin on CPU time.
+     * \param work         estimated work of the op, in elementwise float operations.
+     * \param max_threads  the thread count the op was created with, capped by the CPUs of the calling thread's
+     *                     CPUWorkerPools phase, and by the CPUs of Power_Low.
+     * \return a width in [1, max_threads].
+     */
+    static int threadsFor(double work, int max_threads);
+
+    /**
+     * \brief split large Linear layers by output column and attention by head across NUMA nodes.
+     * Each node keeps its shard of the weights in its local memory and computes it with threads pinned to it.
+     * Must be set before the weights are loaded.
+     * \param nodes  number of nodes, 0 for all nodes of the machine. Less than 2 disables the split.
+     */
+    void setNumaNodes(int nodes);
+    /**
+     * \return the workers of the NUMA nodes, nullptr if the layers are not split.
+     */
+    NumaPool *numaPool() const {
+        return numa_pool_.get();
+    }
+
+    /**
+     * \brief keep only the recent tokens of the KV caches in RAM and spill the older ones to scratch files,
+     *        see CPUKVSpill. Must be set before the first inference.
+     * \param dir         directory of the scratch files.
+     * \param ram_budget  bytes of recent tokens kept in RAM, over all KV caches.
+     */
+    void setKVSpill(const string &dir, size_t ram_budget);
+    /**
+     * \return the tiered KV storage, nullptr if the KV caches are kept in RAM.
+     */
+    CPUKVSpill *kvSpill() const {
+        return kv_spill_.get();
+    }
+
+    /**
+     * \brief load the head of the next op's weights while the current op runs, see CPUPrefetcher.
+     * \param head_bytes  bytes loaded at the start of every weight, 0 disables the prefetch.
+     */
+    void setWeightPrefetch(size_t head_bytes);
+    /**
+     * \return the weight prefetcher, nullptr if the weights are not prefetched.
+     */
+    CPUPrefetcher *weightPrefetcher() const {
+        return prefetcher_.get();
+    }
+    void prefetchWeights(const vector<std::pair<const char *, size_t>> &ranges) override;
+    void stopPrefetch() override;
+
+    /**
+     * \brief record the input channel maxima of every Linear into `stats` (W8A8 calibration), nullptr to stop.
+     */
+    void setActivationStats(shared_ptr<ActivationStats> stats) {
+        activation_stats_ = std::move(stats);
+    }
+    ActivationStats *activationStats() const {
+        return activation_stats_.get();
+    }
+
+    /**
+     * \brief load a weight tied to others (see AbstructLoader::tiedTo) into the buffer they share.
+     * The first op to load a weight of the group loads the data into a tensor kept by the backend, `weight`
+     * and the weights of the other ops become views of it.
+     * \param weight  the weight of the op, named and shaped.
+     * \return false if the weight is not tied, the op then loads it itself.
+     */
+    bool loadTiedWeight(AbstructLoader &loader, Tensor &weight);
+
 private:
     std::map<OpType, CPUBackend::Creator *> map_creator_;
+    shared_ptr<NumaPool> numa_pool_;
+    shared_ptr<CPUKVSpill> kv_spill_;
+    shared_ptr<CPUPrefetcher> prefetcher_;
+    shared_ptr<ActivationStats> activation_stats_;
+    std::map<string, shared_ptr<Tensor>> tied_weights_;
 };
 
 } // namespace mllm
@@ -9,10 +9,10 @@ CPUCat::CPUCat(Backend *bn, string opName, Chl axis, int threadCount) :
     axis_ = axis;
 }
 
-ErrorCode CPUCat::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUCat::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     expd_batch_ = inputs[0]->batch();
     for (int ii = 0; ii < inputs.size(); ++ii) {
-        auto input = inputs[ii];
+        auto &input = inputs[ii];
         if (input->batch() > expd_batch_) {
             expd_batch_ = input->batch();
             expd_batch_input_idx = ii;
@@ -21,7 +21,7 @@ ErrorCode CPUCat::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<T
     switch (axis_) {
     case BATCH: {
         int batch_size = 0;
-        for (auto input : inputs) {
+        for (const auto &input : inputs) {
             batch_size += input->batch();
         }
         outputs[0]->reshape(batch_size, inputs[0]->head(), inputs[0]->sequence(), inputs[0]->dimension());
@@ -29,7 +29,7 @@ ErrorCode CPUCat::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<T
     }
     case HEAD: {
         int head_size = 0;
-        for (auto input : inputs) {
+        for (const auto &input : inputs) {
             head_size += input->head();
         }
         outputs[0]->reshape(expd_batch_, head_size, inputs[0]->sequence(), inputs[0]->dimension());
@@ -37,7 +37,7 @@ ErrorCode CPUCat::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<T
     }
     case SEQUENCE: {
         int seq_size = 0;
-        for (auto input : inputs) {
+        for (const auto &input : inputs) {
             seq_size += input->sequence();
         }
         outputs[0]->reshape(expd_batch_, inputs[0]->head(), seq_size, inputs[0]->dimension());
@@ -45,7 +45,7 @@ ErrorCode CPUCat::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<T
     }
     case DIMENSION: {
         int dim_size = 0;
-        for (auto input : inputs) {
+        for (const auto &input : inputs) {
             dim_size += input->dimension();
         }
         outputs[0]->reshape(expd_batch_, inputs[0]->head(), inputs[0]->sequence(), dim_size);
@@ -61,10 +61,15 @@ ErrorCode CPUCat::load(AbstructLoader &loader) {
     return Op::load(loader);
 }
 
-ErrorCode CPUCat::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUCat::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    uint64_t saved = 0;
     if (axis_ == BATCH) {
         for (int n = 0; n < inputs.size(); ++n) {
             auto copysize = inputs[0]->batch() * inputs[0]->head() * inputs[0]->sequence() * inputs[0]->dimension();
+            if (redirected_[n]) {
+                saved += sizeof(float) * copysize;
+                continue;
+            }
             memcpy(outputs[0]->ptrAt<float>(n * inputs[0]->batch(), 0, 0, 0), inputs[n]->ptrAt<float>(0, 0, 0, 0), sizeof(float) * copysize);
         }
     } else if (axis_ == DIMENSION) {
@@ -85,7 +90,25 @@ ErrorCode CPUCat::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<T
             }
         }
     } else if ((axis_ == SEQUENCE) && inputs[0]->head() != 1) {
-        return Op::execute(inputs, outputs);
+        int cseq = 0;
+        for (int idx = 0; idx < inputs.size(); idx++) {
+            if (redirected_[idx]) {
+                // count() of a child tensor is the one of its master
+                saved += sizeof(float) * inputs[idx]->batch() * inputs[idx]->head() * inputs[idx]->sequence() * inputs[idx]->dimension();
+            } else {
+                // row by row, the heads of the output interleave with the sequence
+                for (int n = 0; n < expd_batch_; ++n) {
+                    auto n_ = inputs[idx]->batch() == 1 ? 0 : n;
+                    for (int c = 0; c < inputs[idx]->head(); ++c) {
+                        for (int s = 0; s < inputs[idx]->sequence(); ++s) {
+                            memcpy(outputs[0]->ptrAt<float>(n, c, cseq + s, 0), inputs[idx]->ptrAt<float>(n_, c, s, 0),
+                                   sizeof(float) * inputs[idx]->dimension());
+                        }
+                    }
+                }
+            }
+            cseq += inputs[idx]->sequence();
+        }
     } else if ((axis_ == SEQUENCE) && inputs[0]->head() == 1) {
         for (int n = 0; n < expd_batch_; ++n) {
             int h = 0;
@@ -94,41 +117,54 @@ ErrorCode CPUCat::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<T
                 if (idx != expd_batch_input_idx) {
                     n_ = 0;
                 }
-                memcpy(outputs[0]->ptrAt<float>(n, 0, h, 0),
-                       inputs[idx]->ptrAt<float>(n_, 0, 0, 0),
-                       sizeof(float) * (inputs[idx]->sequence() * inputs[idx]->dimension()));
+                if (redirected_[idx]) {
+                    saved += sizeof(float) * (inputs[idx]->sequence() * inputs[idx]->dimension());
+                } else {
+                    memcpy(outputs[0]->ptrAt<float>(n, 0, h, 0),
+                           inputs[idx]->ptrAt<float>(n_, 0, 0, 0),
+                           sizeof(float) * (inputs[idx]->sequence() * inputs[idx]->dimension()));
+                }
                 h += inputs[idx]->sequence();
             }
         }
     }
+    setBytesSaved(saved);
     return Op::execute(inputs, outputs);
 }
 
-ErrorCode CPUCat::free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUCat::free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     return Op::free(inputs, outputs);
 }
 
-ErrorCode CPUCat::setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
-    if (axis_ == SEQUENCE && inputs[0]->head() != 1) { //
-        assert(outputs.size() == 1);
-        outputs[0]->setDtype(activation_dtype());
-        outputs[0]->alloc();
-        int cbatch = 0;
-        int chead = 0;
-        int cseq = 0;
-        int cdim = 0;
-        for (int idx = 0; idx < inputs.size(); idx++) {
-            if (inputs[idx]->masterTensor() == nullptr) {
-                inputs[idx]->free();
-            }
-            if (idx > 0) {
-                cseq += inputs[idx - 1]->sequence();
-            }
-            inputs[idx]->deepCopyFrom(outputs[0].get(), false, {cbatch, chead, cseq, cdim}); // b,h,s,d
-        }
-        return MLLM_NO_ERROR;
-    } else {
+ErrorCode CPUCat::setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    redirected_.assign(inputs.size(), false);
+    if (axis_ != SEQUENCE && axis_ != BATCH) {
+        // the inputs would be strided views of the output, their producers expect contiguous rows
         return Op::setUp(inputs, outputs);
     }
+    assert(outputs.size() == 1);
+    outputs[0]->setDtype(activation_dtype());
+    outputs[0]->alloc();
+    int cbatch = 0;
+    int cseq = 0;
+    for (int idx = 0; idx < inputs.size(); idx++) {
+        auto &input = inputs[idx];
+        // a broadcast input, an input shared with another op's buffer or listed twice stays where it is
+        bool can_redirect = input->batch() == expd_batch_ || axis_ == BATCH;
+        can_redirect &= input->masterTensor() == nullptr || input->masterTensor() == outputs[0].get();
+        can_redirect &= input->dtype() == outputs[0]->dtype();
+        for (int prev = 0; prev < idx; ++prev) {
+            can_redirect &= inputs[prev] != input;
+        }
+        if (can_redirect) {
+            redirected_[idx] = redirectInput(idx, input, *outputs[0], {cbatch, 0, cseq, 0}); // b,h,s,d
+        }
+        if (axis_ == SEQUENCE) {
+            cseq += input->sequence();
+        } else {
+            cbatch += input->batch();
+        }
+    }
+    return MLLM_NO_ERROR;
 }
 } // namespace mllm
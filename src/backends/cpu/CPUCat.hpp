@@ -11,17 +11,19 @@ class CPUCat final : public Op {
 public:
     CPUCat(Backend *bn, string opName,Chl axis, int threadCount);
     virtual ~CPUCat() = default;
-    virtual ErrorCode reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
+    virtual ErrorCode reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
     virtual ErrorCode load(AbstructLoader &loader) override;
-    virtual ErrorCode execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-    virtual ErrorCode free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-    virtual ErrorCode setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
+    virtual ErrorCode execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual ErrorCode free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual ErrorCode setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
 
 private:
     int thread_count = 4;
     Chl axis_;
     int expd_batch_;
     int expd_batch_input_idx;
+    // inputs written straight into the output by their producers, set in setUp
+    vector<bool> redirected_;
 };
 
 class CPUCatCreator : public CPUBackend::Creator {
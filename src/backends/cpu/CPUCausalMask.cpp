@@ -1,5 +1,6 @@
 
 #include "CPUCausalMask.hpp"
+#include "TensorAccessor.hpp"
 #include <cmath>
 
 namespace mllm {
@@ -9,7 +10,7 @@ CPUCausalMask::CPUCausalMask(Backend *bn, string opName, int threadCount) : thre
     Op(bn, opName) {
 }
 
-ErrorCode CPUCausalMask::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUCausalMask::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     //std::cout << "CPUMask  reshape" << std::endl;
     assert(inputs.size() == 1);
     assert(outputs.size() == 1);
@@ -17,23 +18,27 @@ ErrorCode CPUCausalMask::reshape(vector<shared_ptr<Tensor>> inputs, vector<share
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPUCausalMask::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUCausalMask::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     if(inputs[0]->sequence() >1 ) {
         int batch_size = inputs[0]->batch();
         int head_num = inputs[0]->head();
         int sequence = inputs[0]->sequence();
         int dimension = inputs[0]->dimension();
         int old_dim = dimension - sequence;
+        const int threads = CPUBackend::threadsFor(4.0 * dimension, thread_count);
+        setThreadWidth(threads);
+        TensorAccessor<float> in(*inputs[0]);
+        TensorAccessor<float> out(*outputs[0]);
         for (int n = 0; n < batch_size; ++n) {
             for (int h = 0; h < head_num; ++h) {
                 for (int s = 0; s < sequence; ++s) {
-                    #pragma omp parallel for num_threads(thread_count)
+                    #pragma omp parallel for num_threads(threads)
                     for (int d = 0; d < dimension; ++d) {
                         if (d > s + old_dim) {
-                            outputs[0]->setDataAt<float>({n, h, s, d}, -INFINITY);
+                            out(n, h, s, d) = -INFINITY;
                         }
                         else{
-                            outputs[0]->setDataAt<float>({n, h, s, d}, inputs[0]->dataAt<float>(n, h, s, d));
+                            out(n, h, s, d) = in(n, h, s, d);
                         }
                     }
                 }
@@ -41,12 +46,13 @@ ErrorCode CPUCausalMask::execute(vector<shared_ptr<Tensor>> inputs, vector<share
         }
     }
     else{
+        setThreadWidth(1);
         outputs[0]->copyFrom(inputs[0]);
     }
     return Op::execute(inputs, outputs);
 }
 
-ErrorCode CPUCausalMask::setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUCausalMask::setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     assert(inputs.size() == 1);
     assert(outputs.size() == 1);
     if(inputs[0]->masterTensor() == nullptr) {
@@ -18,7 +18,7 @@ Op(bn, opName) {
     bias_.setBackend(bn);
 }
 
-ErrorCode CPUConvolution2D::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUConvolution2D::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     //batch = batch
     //sequence = out_channel
     //head = height
@@ -74,7 +74,7 @@ ErrorCode CPUConvolution2D::load(AbstructLoader &loader) {
     return Op::load(loader);
 }
 
-ErrorCode CPUConvolution2D::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUConvolution2D::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     switch (padding_type_) {
     case SAME:{
@@ -89,13 +89,13 @@ ErrorCode CPUConvolution2D::execute(vector<shared_ptr<Tensor>> inputs, vector<sh
     return Op::execute(inputs, outputs);
 }
 
-ErrorCode CPUConvolution2D::free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUConvolution2D::free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     weight_.free();
     return Op::free(inputs, outputs);
 }
 
-ErrorCode CPUConvolution2D::setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUConvolution2D::setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     return Op::setUp(inputs, outputs);
 }
@@ -20,7 +20,7 @@ Op(bn, opName) {
     bias_.setBackend(bn);
 }
 
-ErrorCode CPUConvolution3D::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUConvolution3D::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     //batch = batch
     //sequence = out_channel
     //head = height
@@ -81,7 +81,7 @@ ErrorCode CPUConvolution3D::load(AbstructLoader &loader) {
     return Op::load(loader);
 }
 
-ErrorCode CPUConvolution3D::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUConvolution3D::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     switch (padding_type_) {
     case SAME:{
@@ -98,13 +98,13 @@ ErrorCode CPUConvolution3D::execute(vector<shared_ptr<Tensor>> inputs, vector<sh
     return Op::execute(inputs, outputs);
 }
 
-ErrorCode CPUConvolution3D::free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUConvolution3D::free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     weight_.free();
     return Op::free(inputs, outputs);
 }
 
-ErrorCode CPUConvolution3D::setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUConvolution3D::setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     return Op::setUp(inputs, outputs);
 }
@@ -7,7 +7,7 @@ CPUDivision::CPUDivision(Backend *bn, string opName, int threadCount) : thread_c
     Op(bn, opName) {
 }
 
-ErrorCode CPUDivision::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUDivision::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     assert(inputs.size() == 2);
     assert(outputs.size() == 1);
@@ -22,7 +22,7 @@ ErrorCode CPUDivision::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_
     // outputs[0]->setDtype(activationDtype());
     return Op::reshape(inputs, outputs);
 }
-ErrorCode CPUDivision::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUDivision::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     int N = inputs[0]->batch();
     int C = inputs[0]->head();
@@ -34,7 +34,9 @@ ErrorCode CPUDivision::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_
         auto in0_ptr = inputs[0]->hostPtr<float>();
         auto in1_ptr = inputs[1]->hostPtr<float>();
         auto out_ptr = outputs[0]->hostPtr<float>();
-#pragma omp parallel for num_threads(thread_count)
+        const int threads = CPUBackend::threadsFor(copy_size, thread_count);
+        setThreadWidth(threads);
+#pragma omp parallel for num_threads(threads)
         for (int is = 0; is < copy_size; ++is) {
             if (inputs[1]->count() == 1) {
                 out_ptr[is] = in0_ptr[is] / in1_000;
@@ -43,10 +45,12 @@ ErrorCode CPUDivision::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_
             }
         }
     }else {
+        const int threads = CPUBackend::threadsFor(4.0 * W, thread_count);
+        setThreadWidth(threads);
         for (int n = 0; n < N; ++n) {
             for (int c = 0; c < C; ++c) {
                 for (int h = 0; h < H; ++h) {
-#pragma omp parallel for num_threads(thread_count)
+#pragma omp parallel for num_threads(threads)
                     for (int w = 0; w < W; ++w) {
                         auto divisor = (inputs[1]->count() != 1) ?
                                            inputs[1]->dataAt<float>(n, c, h, w) :
@@ -2,6 +2,8 @@
 #include "ParamLoader.hpp"
 #include "quantize/QuantizeQ4.hpp"
 #include "quantize/QuantizeQ8.hpp"
+#include "quantize/QuantizeSparse.hpp"
+#include "quantize/QuantizeLUT.hpp"
 
 namespace mllm {
 CPUEmbedding::CPUEmbedding(Backend *bn,  string opName, int hiddenSize, int vocabSize, int threadCount) : thread_count(threadCount),
@@ -10,12 +12,12 @@ CPUEmbedding::CPUEmbedding(Backend *bn,  string opName, int hiddenSize, int voca
     assert(vocabSize_ > 0);
     weight_.setBackend(bn);
 }
-ErrorCode CPUEmbedding::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUEmbedding::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     assert(inputs.size() == 1);
     assert(outputs.size() == 1);
-    auto input = inputs[0];
-    auto output = outputs[0];
+    auto &input = inputs[0];
+    auto &output = outputs[0];
     // Input: [batch, 1, sequence, 1]
     output->reshape(input->batch(), 1, input->sequence(), hiddenSize_);
     //outputs[0]->setDtype(activationDtype());
@@ -25,7 +27,9 @@ ErrorCode CPUEmbedding::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared
 ErrorCode CPUEmbedding::load(AbstructLoader &loader) {
     weight_.setName(name() + ".weight");
     weight_.reshape(1, 1, vocabSize_, hiddenSize_);
-    if (loader.getDataType(weight_.name()) != MLLM_TYPE_COUNT) {
+    if (static_cast<CPUBackend *>(backend())->loadTiedWeight(loader, weight_)) {
+        // shared with the LM head
+    } else if (loader.getDataType(weight_.name()) != MLLM_TYPE_COUNT) {
         weight_.setDtype(loader.getDataType(weight_.name()));
         weight_.alloc();
         loader.load(&weight_);
@@ -35,17 +39,19 @@ ErrorCode CPUEmbedding::load(AbstructLoader &loader) {
     }
     return Op::load(loader);
 }
-ErrorCode CPUEmbedding::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUEmbedding::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     assert(inputs.size() == 1);
     assert(outputs.size() == 1);
     auto &input = inputs[0];
     auto &output = outputs[0];
+    const int threads = CPUBackend::threadsFor((double)input->sequence() * hiddenSize_, thread_count);
+    setThreadWidth(threads);
     switch (weight_.dtype()) {
     case MLLM_TYPE_F32: {
         for (int batch = 0; batch < input->batch(); ++batch) {
             for (int head = 0; head < input->head(); ++head) { // NOLINT(*-use-default-none)
-                #pragma omp parallel for num_threads(thread_count)
+                #pragma omp parallel for num_threads(threads)
                 for (int seq = 0; seq < input->sequence(); ++seq) {
                     memcpy(output->hostPtr<float>() + output->offset(batch, head, seq, 0),
                            weight_.hostPtr<float>() + weight_.offset(0, 0, (int)input->dataAt<float>(batch, head, seq, 0), 0),
@@ -58,7 +64,7 @@ ErrorCode CPUEmbedding::execute(vector<shared_ptr<Tensor>> inputs, vector<shared
     case MLLM_TYPE_Q4_0: {
         for (int batch = 0; batch < input->batch(); ++batch) {
             for (int head = 0; head < input->head(); ++head) {
-            #pragma omp parallel for num_threads(thread_count)
+            #pragma omp parallel for num_threads(threads)
                 for (int seq = 0; seq < input->sequence(); ++seq) {
                     dequantize_row_q4_0(weight_.hostPtr<block_q4_0>() + weight_.offset(0, 0, (int)input->dataAt<float>(batch, head, seq, 0), 0)/(QK4_0),
                                         output->hostPtr<float>() + output->offset(batch, head, seq, 0),
@@ -71,7 +77,7 @@ ErrorCode CPUEmbedding::execute(vector<shared_ptr<Tensor>> inputs, vector<shared
     case MLLM_TYPE_Q4_K: {
         for (int batch = 0; batch < input->batch(); ++batch) {
             for (int head = 0; head < input->head(); ++head) {
-                #pragma omp parallel for num_threads(thread_count)
+                #pragma omp parallel for num_threads(threads)
                 for (int seq = 0; seq < input->sequence(); ++seq) {
                     dequantize_row_q4_K(weight_.hostPtr<block_q4_K>() + weight_.offset(0, 0, (int)inputs[0]->dataAt<float>(batch, head, seq, 0), 0)/(QK_K),
                                         outputs[0]->hostPtr<float>() + outputs[0]->offset(batch, head, seq, 0),
@@ -84,7 +90,7 @@ ErrorCode CPUEmbedding::execute(vector<shared_ptr<Tensor>> inputs, vector<shared
     case MLLM_TYPE_Q8_0: {
         for (int batch = 0; batch < input->batch(); ++batch) {
             for (int head = 0; head < input->head(); ++head) {
-                #pragma omp parallel for num_threads(thread_count)
+                #pragma omp parallel for num_threads(threads)
                 for (int seq = 0; seq < input->sequence(); ++seq) {
                     dequantize_row_q8_0(weight_.hostPtr<block_q8_0>() + weight_.offset(0, 0, (int)input->dataAt<float>(batch, head, seq, 0), 0)/(QK8_0),
                                         output->hostPtr<float>() + output->offset(batch, head, seq, 0),
@@ -97,7 +103,7 @@ ErrorCode CPUEmbedding::execute(vector<shared_ptr<Tensor>> inputs, vector<shared
     case MLLM_TYPE_Q8_K: {
         for (int batch = 0; batch < input->batch(); ++batch) {
             for (int head = 0; head < input->head(); ++head) {
-                #pragma omp parallel for num_threads(thread_count)
+                #pragma omp parallel for num_threads(threads)
                 for (int seq = 0; seq < input->sequence(); ++seq) {
                     dequantize_row_q8_K(weight_.hostPtr<block_q8_K>() + weight_.offset(0, 0, (int)input->dataAt<float>(batch, head, seq, 0), 0)/(QK_K),
                                         output->hostPtr<float>() + output->offset(batch, head, seq, 0),
@@ -107,7 +113,53 @@ ErrorCode CPUEmbedding::execute(vector<shared_ptr<Tensor>> inputs, vector<shared
         }
         break;
     }
-    case MLLM_TYPE_F16: break;
+    case MLLM_TYPE_F16: {
+        for (int batch = 0; batch < input->batch(); ++batch) {
+            for (int head = 0; head < input->head(); ++head) {
+                #pragma omp parallel for num_threads(threads)
+                for (int seq = 0; seq < input->sequence(); ++seq) {
+                    mllm_fp16_to_fp32_row(weight_.hostPtr<mllm_fp16_t>() + weight_.offset(0, 0, (int)input->dataAt<float>(batch, head, seq, 0), 0),
+                                          output->hostPtr<float>() + output->offset(batch, head, seq, 0),
+                                          hiddenSize_);
+                }
+            }
+        }
+        break;
+    }
+    case MLLM_TYPE_BF16: {
+        for (int batch = 0; batch < input->batch(); ++batch) {
+            for (int head = 0; head < input->head(); ++head) {
+                #pragma omp parallel for num_threads(threads)
+                for (int seq = 0; seq < input->sequence(); ++seq) {
+                    mllm_bf16_to_fp32_row(weight_.hostPtr<mllm_bf16_t>() + weight_.offset(0, 0, (int)input->dataAt<float>(batch, head, seq, 0), 0),
+                                          output->hostPtr<float>() + output->offset(batch, head, seq, 0),
+                                          hiddenSize_);
+                }
+            }
+        }
+        break;
+    }
+    case MLLM_TYPE_Q4_0_24:
+    case MLLM_TYPE_Q8_0_24:
+    case MLLM_TYPE_Q2_LUT:
+    case MLLM_TYPE_Q3_LUT: {
+        const size_t row_size = DataTypeSize(weight_.dtype(), hiddenSize_);
+        auto dequantize = weight_.dtype() == MLLM_TYPE_Q4_0_24 ? dequantize_row_q4_0_24
+                          : weight_.dtype() == MLLM_TYPE_Q8_0_24 ? dequantize_row_q8_0_24
+                          : weight_.dtype() == MLLM_TYPE_Q2_LUT  ? dequantize_row_q2_lut
+                                                                 : dequantize_row_q3_lut;
+        for (int batch = 0; batch < input->batch(); ++batch) {
+            for (int head = 0; head < input->head(); ++head) {
+                #pragma omp parallel for num_threads(threads)
+                for (int seq = 0; seq < input->sequence(); ++seq) {
+                    dequantize(weight_.hostPtr<char>() + row_size * (int)input->dataAt<float>(batch, head, seq, 0),
+                               output->hostPtr<float>() + output->offset(batch, head, seq, 0),
+                               hiddenSize_);
+                }
+            }
+        }
+        break;
+    }
     case MLLM_TYPE_Q4_1: break;
     case MLLM_TYPE_Q8_1: break;
     case MLLM_TYPE_Q6_K: break;
@@ -118,7 +170,7 @@ ErrorCode CPUEmbedding::execute(vector<shared_ptr<Tensor>> inputs, vector<shared
     }
     return MLLM_NO_ERROR;
 }
-ErrorCode CPUEmbedding::free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUEmbedding::free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     weight_.free();
     return Op::free(inputs, outputs);
 }
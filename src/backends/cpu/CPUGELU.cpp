@@ -5,27 +5,26 @@
 
 namespace mllm {
 CPUGELU::CPUGELU(Backend *bn, string opName, int threadCount):thread_count(threadCount), Op(bn, std::move(opName))  {
-    if (!init_table_gelu_f16_flag) {
-        init_table_gelu_f16();
-        init_table_gelu_f16_flag = true;
-    }
+    init_table_gelu_f16();
 }
 
-ErrorCode CPUGELU::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUGELU::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     assert(inputs.size() == 1);
     assert(outputs.size() == 1);
     outputs[0]->reshape(inputs[0]->batch(), inputs[0]->head(), inputs[0]->sequence(), inputs[0]->dimension());
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPUGELU::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
-    auto input = inputs[0];
-    auto output = outputs[0];
+ErrorCode CPUGELU::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    auto &input = inputs[0];
+    auto &output = outputs[0];
     int batch = input->batch();
     int head = input->head();
     int seq = input->sequence();
     int dim = input->dimension();
-#pragma omp parallel for collapse(3) num_threads(thread_count)
+    const int threads = CPUBackend::threadsFor(2.0 * input->count(), thread_count);
+    setThreadWidth(threads);
+#pragma omp parallel for collapse(3) num_threads(threads)
     for (int b = 0; b <batch ; ++b) {
         for (int h = 0; h < head; ++h) {
             for (int s = 0; s < seq; ++s) {
@@ -43,7 +42,7 @@ ErrorCode CPUGELU::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<
     return Op::execute(inputs, outputs);
 }
 
-ErrorCode CPUGELU::free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUGELU::free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     return Op::free(inputs, outputs);
 }
 } // namespace mllm
\ No newline at end of file
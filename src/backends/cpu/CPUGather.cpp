@@ -7,7 +7,7 @@ CPUGather::CPUGather(Backend *bn,  string opName, int threadCount) : thread_coun
     Op(bn, opName) {
 }
 
-ErrorCode CPUGather::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUGather::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     assert(inputs.size() == 3);
     assert(outputs.size() == 1);
@@ -24,7 +24,7 @@ ErrorCode CPUGather::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_pt
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPUGather::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUGather::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     if(inputs[1]->batch() == 0) {
         return Op::execute(inputs, outputs);
     }
@@ -32,21 +32,32 @@ ErrorCode CPUGather::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_pt
     assert(inputs[0]->ctype() == BSHD);
     assert(inputs[1]->ctype() == BSHD);
     assert(outputs[0]->ctype() == BSHD);
-    auto input_indices = inputs[2];
+    auto &input_indices = inputs[2];
     int hiddenSize = inputs[0]->dimension();
+    const size_t row_size = inputs[1]->dtypeSize() * hiddenSize;
     for (int batch = 0; batch < inputs[0]->batch(); ++batch) {
-        for (int seq = 0; seq < inputs[0]->sequence(); ++seq) {
-            if(input_indices->dataAt<float>(batch, 0, seq, 0) >= 0) {
-                memcpy(outputs[0]->hostPtr<float>() + outputs[0]->offset(batch, 0, seq, 0),
-                       inputs[1]->hostPtr<float>() + (int)inputs[1]->offset(batch, 0, input_indices->dataAt<float>(batch, 0, seq, 0), 0),
-                       inputs[1]->dtypeSize() * hiddenSize);
+        int seq = 0;
+        while (seq < inputs[0]->sequence()) {
+            const int first = (int)input_indices->dataAt<float>(batch, 0, seq, 0);
+            if (first < 0) {
+                ++seq;
+                continue;
             }
+            // consecutive patches at consecutive positions are copied as one block
+            int rows = 1;
+            while (seq + rows < inputs[0]->sequence() && (int)input_indices->dataAt<float>(batch, 0, seq + rows, 0) == first + rows) {
+                ++rows;
+            }
+            memcpy(outputs[0]->hostPtr<float>() + outputs[0]->offset(batch, 0, seq, 0),
+                   inputs[1]->hostPtr<float>() + inputs[1]->offset(batch, 0, first, 0),
+                   row_size * rows);
+            seq += rows;
         }
     }
     return Op::execute(inputs, outputs);
 }
 
-ErrorCode CPUGather::setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUGather::setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     if(inputs[0]->masterTensor() == nullptr) {
         inputs[0]->free();
@@ -2,30 +2,59 @@
 
 #include "CPUKVCache.hpp"
 #include "ParamLoader.hpp"
+#include "CPUKVSpill.hpp"
 
 namespace mllm {
 CPUKVCache::CPUKVCache(Backend *bn, string opName, int n_rep, int cache_max, int threadCount) : thread_count(threadCount),
-    Op(bn, opName) {
-    cache_.setBackend(bn);
-    cache_.setDtype(MLLM_TYPE_F16);
+    Op(bn, opName), blocks_(opName) {
+    blocks_->cache.setBackend(bn);
+    blocks_->cache.setDtype(MLLM_TYPE_F16);
     cache_limit_ = cache_max;
     n_rep_ = n_rep;
 }
 
-ErrorCode CPUKVCache::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+CPUKVCache::~CPUKVCache() {
+    if (auto *spill = static_cast<CPUBackend *>(backend())->kvSpill()) {
+        for (int b = 0; b < blocks_.size(); ++b) {
+            spill->remove(&blocks_[b].cache);
+        }
+    }
+}
+
+int CPUKVCache::addBlock(const string &name) {
+    const int block = blocks_.add(name);
+    blocks_[block].cache.setBackend(backend());
+    blocks_[block].cache.setDtype(MLLM_TYPE_F16);
+    return block;
+}
+
+void CPUKVCache::bindBlock(int block) {
+    blocks_.bind(block);
+    setName(blocks_.name(block));
+}
+
+ErrorCode CPUKVCache::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    auto &block = *blocks_;
 
     assert(inputs.size() == 1);
     assert(outputs.size() == 1);
-    if(cache_seq_len_ < 0) {
-        cache_.reshape(inputs[0]->batch(), inputs[0]->head()*n_rep_, cache_limit_, inputs[0]->dimension());
-        cache_.setName(name() + ".Cache");
-        cache_.alloc();
-        cache_seq_len_ = 0;
+    if(block.cache_seq_len < 0) {
+        block.cache.reshape(inputs[0]->batch(), inputs[0]->head()*n_rep_, cache_limit_, inputs[0]->dimension());
+        block.cache.setName(name() + ".Cache");
+        auto *spill = static_cast<CPUBackend *>(backend())->kvSpill();
+        if (spill != nullptr) {
+            block.cache.setMemoryManager(spill->memoryManager());
+        }
+        block.cache.alloc();
+        if (spill != nullptr) {
+            spill->add(&block.cache);
+        }
+        block.cache_seq_len = 0;
     }
 
-    outputs[0]->reshape(inputs[0]->batch(), inputs[0]->head()*n_rep_, inputs[0]->sequence() + cache_seq_len_, inputs[0]->dimension());
-    if(inputs[0]->sequence() + cache_seq_len_ >cache_limit_){
-        std::cerr<<"\n[ERROR]: Current tokens exceed cache limit: "<<inputs[0]->sequence() + cache_seq_len_<<">"<<cache_limit_<<";";
+    outputs[0]->reshape(inputs[0]->batch(), inputs[0]->head()*n_rep_, inputs[0]->sequence() + block.cache_seq_len, inputs[0]->dimension());
+    if(inputs[0]->sequence() + block.cache_seq_len >cache_limit_){
+        std::cerr<<"\n[ERROR]: Current tokens exceed cache limit: "<<inputs[0]->sequence() + block.cache_seq_len<<">"<<cache_limit_<<";";
         std::cerr<<"\n         Please set args `--limits` >"<<cache_limit_<<std::endl;
 
         exit(1);
@@ -39,51 +68,75 @@ ErrorCode CPUKVCache::load(AbstructLoader &loader) {
     return Op::load(loader);
 }
 
-ErrorCode CPUKVCache::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+// copies n contiguous values of src to dest, converting them to the dtype of the cache
+static void copyValues(const Tensor &src, const void *src_ptr, const Tensor &dest, void *dest_ptr, int n) {
+    if (src.dtype() == dest.dtype()) {
+        memcpy(dest_ptr, src_ptr, DataTypeSize(dest.dtype(), n));
+    } else if (dest.dtype() == MLLM_TYPE_F16) {
+        mllm_fp32_to_fp16_row((const float *)src_ptr, (mllm_fp16_t *)dest_ptr, n);
+    } else if (dest.dtype() == MLLM_TYPE_F32) {
+        mllm_fp16_to_fp32_row((const mllm_fp16_t *)src_ptr, (float *)dest_ptr, n);
+    }
+}
+
+// address of (b, h, s, d) in a tensor of any dtype
+static char *addressOf(Tensor &t, int b, int h, int s, int d) {
+    return t.hostPtr<char>() + DataTypeSize(t.dtype(), t.offset(b, h, s, d));
+}
+
+ErrorCode CPUKVCache::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    auto &block = *blocks_;
 
-    int cache_seq_len_old = cache_seq_len_;
-    cache_seq_len_ += inputs[0]->sequence();
+    int cache_seq_len_old = block.cache_seq_len;
+    block.cache_seq_len += inputs[0]->sequence();
+    setBytesSaved(0);
+    if(n_rep_ == 1) {
+        if (block.input_in_cache) {
+            // count() of a child tensor is the one of its master
+            setBytesSaved(DataTypeSize(block.cache.dtype(), (uint64_t)inputs[0]->batch() * inputs[0]->head() * inputs[0]->sequence() * inputs[0]->dimension()));
+        } else {
+            for (int b = 0; b < block.cache.batch(); ++b) {
+                for (int seq = cache_seq_len_old; seq < block.cache_seq_len; ++seq) {
+                    for (int h = 0; h < inputs[0]->head(); ++h) {
+                        copyValues(*inputs[0], addressOf(*inputs[0], b, h, seq - cache_seq_len_old, 0),
+                                   block.cache, addressOf(block.cache, b, h, seq, 0), block.cache.dimension());
+                    }
+                }
+            }
+        }
+    }
+    // one team per head, copying n_rep_ replicas of the new rows
+    const int threads = CPUBackend::threadsFor((double)n_rep_ * inputs[0]->sequence() * inputs[0]->dimension(), thread_count);
+    setThreadWidth(threads);
     if(n_rep_ >1) {
-        if(cache_.ctype() == BSHD) {
-            for (int b = 0; b < cache_.batch(); ++b) {
+        if(block.cache.ctype() == BSHD) {
+            for (int b = 0; b < block.cache.batch(); ++b) {
                 for (int h = inputs[0]->head()-1; h >= 0; --h) {
-#pragma omp parallel for collapse(2) num_threads(thread_count)
-                    for (int seq = cache_seq_len_old; seq < cache_seq_len_; ++seq) {
+#pragma omp parallel for collapse(2) num_threads(threads)
+                    for (int seq = cache_seq_len_old; seq < block.cache_seq_len; ++seq) {
                         for (int i_rep = 0; i_rep < n_rep_; ++i_rep) {
                             auto cache_head = h * n_rep_ + i_rep;
-                            if(cache_.dtype() == MLLM_TYPE_F32) {
-                                auto src_ptr = inputs[0]->ptrAt<float>(b, h, seq-cache_seq_len_old, 0);
-                                auto dest_ptr = cache_.ptrAt<float>(b, cache_head, seq, 0);
-                                int copy_size = cache_.dimension();
-                                memcpy(dest_ptr, src_ptr, copy_size * sizeof(float));
-                            }else if(cache_.dtype() == MLLM_TYPE_F16) {
-                                auto src_ptr = inputs[0]->ptrAt<mllm_fp16_t>(b, h, seq-cache_seq_len_old, 0);
-                                auto dest_ptr = cache_.ptrAt<mllm_fp16_t>(b, cache_head, seq, 0);
-                                int copy_size = cache_.dimension();
-                                memcpy(dest_ptr, src_ptr, copy_size * sizeof(mllm_fp16_t));
+                            if (block.input_in_cache && cache_head == h) {
+                                continue; // the row is already in place
                             }
+                            copyValues(*inputs[0], addressOf(*inputs[0], b, h, seq - cache_seq_len_old, 0),
+                                       block.cache, addressOf(block.cache, b, cache_head, seq, 0), block.cache.dimension());
                         }
                     }
                 }
             }
-        }else if(cache_.ctype() == BHDS) {
-            for (int b = 0; b < cache_.batch(); ++b) {
+        }else if(block.cache.ctype() == BHDS) {
+            for (int b = 0; b < block.cache.batch(); ++b) {
                 for (int h = inputs[0]->head() - 1; h >= 0; --h) {
-#pragma omp parallel for collapse(2) num_threads(thread_count)
+#pragma omp parallel for collapse(2) num_threads(threads)
                     for (int d = 0; d < inputs[0]->dimension(); ++d) {
                         for (int i_rep = 0; i_rep < n_rep_; ++i_rep) {
                             auto cache_head = h * n_rep_ + i_rep;
-                            if (cache_.dtype() == MLLM_TYPE_F32) {
-                                auto src_ptr = inputs[0]->ptrAt<float>(b, h, 0, d);
-                                auto dest_ptr = cache_.ptrAt<float>(b, cache_head, cache_seq_len_old, d);
-                                int copy_size = cache_seq_len_ - cache_seq_len_old;
-                                memcpy(dest_ptr, src_ptr, copy_size * sizeof(float));
-                            } else if (cache_.dtype() == MLLM_TYPE_F16) {
-                                auto src_ptr = inputs[0]->ptrAt<mllm_fp16_t>(b, h, 0, d);
-                                auto dest_ptr = cache_.ptrAt<mllm_fp16_t>(b, cache_head, cache_seq_len_old, d);
-                                int copy_size = cache_seq_len_ - cache_seq_len_old;
-                                memcpy(dest_ptr, src_ptr, copy_size * sizeof(mllm_fp16_t));
+                            if (block.input_in_cache && cache_head == h) {
+                                continue; // the column is already in place
                             }
+                            copyValues(*inputs[0], addressOf(*inputs[0], b, h, 0, d),
+                                       block.cache, addressOf(block.cache, b, cache_head, cache_seq_len_old, d), block.cache_seq_len - cache_seq_len_old);
                         }
                     }
                 }
@@ -92,27 +145,73 @@ ErrorCode CPUKVCache::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_p
             std::cout<<"ERROR Ctype in KVCcache;"<<std::endl;
         }
     }
+    if (auto *spill = static_cast<CPUBackend *>(backend())->kvSpill()) {
+        spill->attend(&block.cache, block.cache_seq_len);
+    }
     return Op::execute(inputs, outputs);
 }
 
-ErrorCode CPUKVCache::free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUKVCache::free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     return Op::free(inputs, outputs);
 }
 
 
-ErrorCode CPUKVCache::setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+// bytes of the first `tokens` tokens of batch b, which are contiguous in a BSHD cache
+static size_t cachedBytes(Tensor &cache, int b, int tokens) {
+    return DataTypeSize(cache.dtype(), (size_t)cache.offset(b, 0, tokens, 0) - cache.offset(b, 0, 0, 0));
+}
+
+void CPUKVCache::saveState(SequenceState &state) {
+    auto &block = *blocks_;
+    state.position = std::max(block.cache_seq_len, 0);
+    state.data.clear();
+    if (state.position == 0) {
+        return;
+    }
+    if (block.cache.ctype() != BSHD) {
+        state.data.assign(block.cache.hostPtr<char>(), block.cache.hostPtr<char>() + block.cache.cntSize());
+        return;
+    }
+    for (int b = 0; b < block.cache.batch(); ++b) {
+        const char *start = block.cache.hostPtr<char>() + DataTypeSize(block.cache.dtype(), block.cache.offset(b, 0, 0, 0));
+        state.data.insert(state.data.end(), start, start + cachedBytes(block.cache, b, state.position));
+    }
+}
+
+void CPUKVCache::restoreState(const SequenceState &state) {
+    auto &block = *blocks_;
+    if (state.data.empty()) {
+        // a new sequence
+        block.cache_seq_len = block.cache_seq_len < 0 ? block.cache_seq_len : 0;
+        return;
+    }
+    assert(block.cache_seq_len >= 0);
+    block.cache_seq_len = state.position;
+    if (block.cache.ctype() != BSHD) {
+        memcpy(block.cache.hostPtr<char>(), state.data.data(), block.cache.cntSize());
+        return;
+    }
+    size_t copied = 0;
+    for (int b = 0; b < block.cache.batch(); ++b) {
+        char *start = block.cache.hostPtr<char>() + DataTypeSize(block.cache.dtype(), block.cache.offset(b, 0, 0, 0));
+        const size_t bytes = cachedBytes(block.cache, b, state.position);
+        memcpy(start, state.data.data() + copied, bytes);
+        copied += bytes;
+    }
+}
+
+ErrorCode CPUKVCache::setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    auto &block = *blocks_;
     assert(inputs.size() == 1);
     assert(outputs.size() == 1);
-    outputs[0]->setDtype(cache_.dtype());
-    outputs[0]->deepCopyFrom(cache_, false, {0,0,cache_seq_len_/cache_limit_,0});
-    if(inputs[0]->sequence() + cache_seq_len_ >cache_limit_) {
-        outputs[0]->deepCopyFrom(cache_, false, {0,0,cache_seq_len_%cache_limit_ +1,0});
-    }
-    if (inputs[0]->masterTensor() ==nullptr) {
-        inputs[0]->free();
+    outputs[0]->setDtype(block.cache.dtype());
+    outputs[0]->deepCopyFrom(block.cache, false, seqOffset(block.cache_seq_len/cache_limit_));
+    if(inputs[0]->sequence() + block.cache_seq_len >cache_limit_) {
+        outputs[0]->deepCopyFrom(block.cache, false, seqOffset(block.cache_seq_len%cache_limit_ +1));
     }
-    inputs[0]->deepCopyFrom(cache_, false, {0,0,cache_seq_len_%cache_limit_,0});
+    // the producer of the new rows writes them straight into their cache slot
+    block.input_in_cache = redirectInput(0, inputs[0], block.cache, seqOffset(block.cache_seq_len%cache_limit_));
     return MLLM_NO_ERROR;
 }
 } // namespace mllm
@@ -11,22 +11,41 @@ namespace mllm {
 class CPUKVCache final : public Op {
 public:
     CPUKVCache(Backend *bn, string opName, int n_rep, int cache_max=100, int threadCount=4);
-    virtual ~CPUKVCache() = default;
-    virtual ErrorCode reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
+    virtual ~CPUKVCache();
+    virtual ErrorCode reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
     virtual ErrorCode load(AbstructLoader &loader) override;
-    virtual ErrorCode execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-    virtual ErrorCode free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-    virtual ErrorCode setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-
-    Tensor cache_;
+    virtual ErrorCode execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual ErrorCode free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual ErrorCode setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual void saveState(SequenceState &state) override;
+    virtual void restoreState(const SequenceState &state) override;
+    int addBlock(const string &name) override;
+    void bindBlock(int block) override;
+
+    Tensor &cache() {
+        return blocks_->cache;
+    }
 
 private:
     int thread_count = 4;
 
-    int cache_seq_len_= -999;
+    // the cache of one block, see Op::addBlock
+    struct Block {
+        Tensor cache;
+        int cache_seq_len = -999;
+        bool input_in_cache = false;
+    };
+    BlockStates<Block> blocks_;
     int n_rep_ = 1;
 
     int cache_limit_ ;
+
+    // offset {0, 0, seq, 0} into the cache, reused so setUp does not allocate every token
+    vector<int> seq_offset_ = {0, 0, 0, 0};
+    const vector<int> &seqOffset(int seq) {
+        seq_offset_[2] = seq;
+        return seq_offset_;
+    }
 };
 
 class CPUKVCacheCreator : public CPUBackend::Creator {
@@ -0,0 +1,152 @@
+#include "CPUKVSpill.hpp"
+#include "compute/Numa.hpp"
+#include "memory/MmapMemoryManager.hpp"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+
+namespace mllm {
+
+// tokens are evicted in blocks of this many
+#define KV_SPILL_BLOCK 64
+// caches read back at a time: the K and V cache of one layer
+#define KV_SPILL_RESIDENT 2
+// cold tokens read ahead of the attention, the kernel's readahead follows its reads through the rest
+#define KV_SPILL_PREFETCH (4 * KV_SPILL_BLOCK)
+
+CPUKVSpill::CPUKVSpill(const string &dir, size_t ram_budget) :
+    mm_(std::make_shared<MmapMemoryManager>(dir)), ram_budget_(ram_budget) {
+}
+
+void CPUKVSpill::add(Tensor *cache) {
+    if (find(cache) == nullptr) {
+        caches_.push_back({cache, 0, 0});
+    }
+}
+
+void CPUKVSpill::remove(Tensor *cache) {
+    caches_.erase(std::remove_if(caches_.begin(), caches_.end(), [&](const Entry &e) { return e.cache == cache; }),
+                  caches_.end());
+    resident_.erase(std::remove(resident_.begin(), resident_.end(), cache), resident_.end());
+}
+
+CPUKVSpill::Entry *CPUKVSpill::find(Tensor *cache) {
+    for (auto &entry : caches_) {
+        if (entry.cache == cache) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+static size_t tokenBytes(const Tensor *cache) {
+    return DataTypeSize(cache->dtype(), (size_t)cache->batch() * cache->head() * cache->dimension());
+}
+
+int CPUKVSpill::hotTokens(int seq_len) const {
+    // the caches being attended are read back whole, the others share what the budget has left
+    size_t all_bytes = 0;
+    vector<size_t> sizes;
+    for (const auto &entry : caches_) {
+        sizes.push_back(tokenBytes(entry.cache));
+        all_bytes += sizes.back();
+    }
+    std::sort(sizes.begin(), sizes.end(), std::greater<size_t>());
+    size_t resident_bytes = 0;
+    for (size_t i = 0; i < sizes.size() && i < KV_SPILL_RESIDENT; ++i) {
+        resident_bytes += sizes[i];
+    }
+    const size_t attended = (size_t)seq_len * resident_bytes;
+    if (all_bytes == resident_bytes || attended >= ram_budget_) {
+        return 0;
+    }
+    return (int)std::min<size_t>((ram_budget_ - attended) / (all_bytes - resident_bytes), seq_len);
+}
+
+int CPUKVSpill::coldTokens(int seq_len, int hot) const {
+    const int cold = std::max(seq_len - hot, 0);
+    // whole blocks, rounded up so that the hot tokens stay within the budget
+    return std::min((cold + KV_SPILL_BLOCK - 1) / KV_SPILL_BLOCK * KV_SPILL_BLOCK, seq_len);
+}
+
+template <typename Fn>
+static void forEachRange(Tensor *cache, int tokens, Fn fn) {
+    if (tokens <= 0) {
+        return;
+    }
+    const DataType dtype = cache->dtype();
+    if (cache->ctype() == BSHD) {
+        // the first tokens of a batch are one range
+        for (int b = 0; b < cache->batch(); ++b) {
+            fn(cache->hostPtr<char>() + DataTypeSize(dtype, cache->offset(b, 0, 0, 0)),
+               DataTypeSize(dtype, (size_t)cache->offset(b, 0, tokens, 0) - cache->offset(b, 0, 0, 0)));
+        }
+    } else if (cache->ctype() == BHDS) {
+        if (DataTypeSize(dtype, cache->sequence()) >= pageSize()) {
+            // one range per (batch, head, dimension) row
+            for (int b = 0; b < cache->batch(); ++b) {
+                for (int h = 0; h < cache->head(); ++h) {
+                    for (int d = 0; d < cache->dimension(); ++d) {
+                        fn(cache->hostPtr<char>() + DataTypeSize(dtype, cache->offset(b, h, 0, d)),
+                           DataTypeSize(dtype, tokens));
+                    }
+                }
+            }
+        } else {
+            // the rows of a (batch, head) share their pages, the cold and hot tokens cannot be told apart: move as
+            // many bytes from the start of its rows, whole rows that the attention reads first
+            for (int b = 0; b < cache->batch(); ++b) {
+                for (int h = 0; h < cache->head(); ++h) {
+                    fn(cache->hostPtr<char>() + DataTypeSize(dtype, cache->offset(b, h, 0, 0)),
+                       DataTypeSize(dtype, (size_t)tokens * cache->dimension()));
+                }
+            }
+        }
+    }
+}
+
+void CPUKVSpill::evict(Entry &entry, int hot) {
+    entry.evicted = coldTokens(entry.seq_len, hot);
+    forEachRange(entry.cache, entry.evicted, [&](char *start, size_t bytes) {
+        MmapMemoryManager::evict(start, bytes);
+        stats_.evicted_bytes += bytes;
+    });
+}
+
+void CPUKVSpill::attend(Tensor *cache, int seq_len) {
+    auto *entry = find(cache);
+    if (entry == nullptr) {
+        return;
+    }
+    entry->seq_len = seq_len;
+    if (std::find(resident_.begin(), resident_.end(), cache) == resident_.end()) {
+        // evicted since its last step: read back the first cold tokens, the attention starts with them
+        forEachRange(cache, std::min(entry->evicted, KV_SPILL_PREFETCH), [&](char *start, size_t bytes) {
+            MmapMemoryManager::prefetch(start, bytes);
+            stats_.prefetched_bytes += bytes;
+        });
+        entry->evicted = 0;
+        resident_.push_back(cache);
+    }
+    while (resident_.size() > KV_SPILL_RESIDENT) {
+        auto *oldest = find(resident_.front());
+        if (oldest != nullptr) {
+            // as many as the budget leaves once the caches attended have `seq_len` tokens
+            evict(*oldest, hotTokens(seq_len));
+        }
+        resident_.pop_front();
+    }
+    // what the caches hold in RAM once this one is read back
+    size_t ram = 0;
+    for (const auto &e : caches_) {
+        ram += (size_t)(e.seq_len - e.evicted) * tokenBytes(e.cache);
+    }
+    stats_.peak_ram_bytes = std::max<uint64_t>(stats_.peak_ram_bytes, ram);
+    if (ram > ram_budget_ && !warned_) {
+        std::cerr << "The KV caches of one layer exceed the RAM budget of the spill: " << ram << " > " << ram_budget_
+                  << " bytes" << std::endl;
+        warned_ = true;
+    }
+}
+
+} // namespace mllm
@@ -0,0 +1,80 @@
+#ifndef MLLM_CPUKVSPILL_H
+#define MLLM_CPUKVSPILL_H
+
+#include "Backend.hpp"
+#include "Tensor.hpp"
+#include <deque>
+
+namespace mllm {
+/**
+ * \brief tiered storage for the KV caches of a session.
+ *
+ * The caches are allocated in memory-mapped scratch files (MmapMemoryManager). The most recent tokens of every
+ * cache stay in RAM; older tokens are written out to the file in blocks and read back as the attention needs
+ * them, the first ones ahead of it. Only the K and V caches of the layer being attended are read back at a time:
+ * they are evicted again once the next layers have taken their place. The RAM budget covers both: the caches
+ * being attended whole, and the recent tokens of the others.
+ * BSHD caches move a batch's cold tokens at once, BHDS caches each (batch, head, dimension) row's, or as many
+ * bytes from the start of each (batch, head) when its rows are shorter than a page.
+ */
+class CPUKVSpill {
+public:
+    /**
+     * \param dir         directory of the scratch files, preferably on a local SSD.
+     * \param ram_budget  bytes of recent tokens kept in RAM, over all caches.
+     */
+    CPUKVSpill(const string &dir, size_t ram_budget);
+
+    /**
+     * \brief the memory manager the caches are allocated from, see Tensor::setMemoryManager.
+     */
+    MemoryManager *memoryManager() {
+        return mm_.get();
+    }
+    void add(Tensor *cache);
+    void remove(Tensor *cache);
+    /**
+     * \brief called by a cache once the new tokens are appended, before the attention reads them.
+     * Reads the first cold tokens of `cache` ahead, unless it is still resident, and evicts the caches of the
+     * layers before it.
+     * \param seq_len  number of tokens in the cache.
+     */
+    void attend(Tensor *cache, int seq_len);
+    /**
+     * \return number of recent tokens every cache keeps in RAM while it is not attended.
+     * \param seq_len  number of tokens in the caches.
+     */
+    int hotTokens(int seq_len) const;
+
+    struct Stats {
+        uint64_t evicted_bytes = 0;
+        uint64_t prefetched_bytes = 0;
+        // most bytes of the caches held in RAM at once
+        uint64_t peak_ram_bytes = 0;
+    };
+    const Stats &stats() const {
+        return stats_;
+    }
+
+private:
+    struct Entry {
+        Tensor *cache;
+        int seq_len;
+        // tokens written out to the file
+        int evicted;
+    };
+    Entry *find(Tensor *cache);
+    // tokens of a cache of `seq_len` tokens written out so that at most `hot` stay in RAM
+    int coldTokens(int seq_len, int hot) const;
+    void evict(Entry &entry, int hot);
+
+    shared_ptr<MemoryManager> mm_;
+    size_t ram_budget_;
+    bool warned_ = false;
+    vector<Entry> caches_;
+    std::deque<Tensor *> resident_;
+    Stats stats_;
+};
+} // namespace mllm
+
+#endif // MLLM_CPUKVSPILL_H
@@ -3,91 +3,100 @@
 //
 
 #include "CPULayerNorm.hpp"
+#include "TensorAccessor.hpp"
+#include "compute/Reduce.hpp"
 
 namespace mllm {
 CPULayerNorm::CPULayerNorm(Backend *bn, string opName,int normSize,bool bias, float epsilon, int threadCount) : thread_count(threadCount),
-    Op(bn, std::move(opName)), epsilon_(epsilon),bias(bias) {
+    Op(bn, opName), epsilon_(epsilon), blocks_(opName), bias(bias) {
     normSize_ = normSize;
-    weight_.setBackend(bn);
+    blocks_->weight.setBackend(bn);
     if (bias) {
-        bias_.setBackend(bn);
+        blocks_->bias.setBackend(bn);
     }
 
 }
+int CPULayerNorm::addBlock(const string &name) {
+    const int block = blocks_.add(name);
+    blocks_[block].weight.setBackend(backend());
+    if (bias) {
+        blocks_[block].bias.setBackend(backend());
+    }
+    return block;
+}
+void CPULayerNorm::bindBlock(int block) {
+    blocks_.bind(block);
+    setName(blocks_.name(block));
+}
 ErrorCode CPULayerNorm::load(AbstructLoader &loader) {
-    weight_.setName(name() + ".weight");
-    weight_.reshape(1, 1, 1, normSize_); //
-     if (loader.getDataType(weight_.name()) != MLLM_TYPE_COUNT) {
-         weight_.setDtype(loader.getDataType(weight_.name()));
-         weight_.alloc();
-         loader.load(&weight_);
+    auto &block = *blocks_;
+    block.weight.setName(name() + ".weight");
+    block.weight.reshape(1, 1, 1, normSize_); //
+     if (loader.getDataType(block.weight.name()) != MLLM_TYPE_COUNT) {
+         block.weight.setDtype(loader.getDataType(block.weight.name()));
+         block.weight.alloc();
+         loader.load(&block.weight);
      } else {
-         weight_.setDtype(MLLM_TYPE_F32);
-         weight_.alloc();
+         block.weight.setDtype(MLLM_TYPE_F32);
+         block.weight.alloc();
      }
     if (bias) {
-        bias_.setName(name() + ".bias");
-        bias_.reshape(1, 1, 1, normSize_); //
-        if (loader.getDataType(bias_.name()) != MLLM_TYPE_COUNT) {
-            bias_.setDtype(loader.getDataType(bias_.name()));
-            bias_.alloc();
-            loader.load(&bias_);
+        block.bias.setName(name() + ".bias");
+        block.bias.reshape(1, 1, 1, normSize_); //
+        if (loader.getDataType(block.bias.name()) != MLLM_TYPE_COUNT) {
+            block.bias.setDtype(loader.getDataType(block.bias.name()));
+            block.bias.alloc();
+            loader.load(&block.bias);
         } else {
-            bias_.setDtype(MLLM_TYPE_F32);
-            bias_.alloc();
+            block.bias.setDtype(MLLM_TYPE_F32);
+            block.bias.alloc();
         }
     }
 
     return Op::load(loader);
 }
-ErrorCode CPULayerNorm::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPULayerNorm::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     assert(normSize_ == inputs[0]->dimension());
     outputs[0]->reshape(inputs[0]->batch(), inputs[0]->head(), inputs[0]->sequence(), inputs[0]->dimension());
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPULayerNorm::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
-    auto input = inputs[0];
-    auto output = outputs[0];
+ErrorCode CPULayerNorm::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    auto &input = inputs[0];
+    auto &output = outputs[0];
     int batch = input->batch();
     int dim = input->dimension();
     int seq = input->sequence();
     int head = input->head();
-    for (int h = 0; h < head; h++) {
-        for (int n = 0; n < batch; n++) {
-            for (int s = 0; s < seq; s++) {
-                float sum_squares = 0.0F;
-                float sum = 0.0F;
-// sum
-// #pragma omp parallel for reduction(+ : sum_squares) reduction(+ : sum) num_threads(thread_count)
-                for (int d = 0; d < dim; d++) {
-                    float value = input->dataAt<float>(n, h, s, d);
-                    sum += value;
-                }
-                float mean = sum / dim;
-// #pragma omp parallel for reduction(+ : sum_squares) num_threads(thread_count)
-                for (int d = 0; d < dim; d++) {
-                    float value = input->dataAt<float>(n, h, s, d);
-                    sum_squares += (value - mean) * (value - mean);
-                    output->setDataAt(n, h, s, d, value - mean);
-                }
-                float rms = std::sqrt(sum_squares / dim + epsilon_);
-#pragma omp parallel for num_threads(thread_count)
-                for (int d = 0; d < dim; d++) {
-                    float value = output->dataAt<float>(n, h, s, d);
-                    if (bias) {
-                        output->setDataAt<float>(n, h, s, d, weight_.dataAt<float>(0, 0, 0, d) * value / rms + bias_.dataAt<float>(0, 0, 0, d));
-                    } else {
-                        output->setDataAt<float>(n, h, s, d, weight_.dataAt<float>(0, 0, 0, d) * value / rms);
-                    }
-                }
-            }
+    const int rows = batch * head * seq;
+    const int threads = CPUBackend::threadsFor(4.0 * rows * dim, thread_count);
+    setThreadWidth(threads);
+    TensorAccessor<float> in(*input);
+    TensorAccessor<float> out(*output);
+    const bool contiguous = in.contiguousRows() && out.contiguousRows();
+    auto &block = *blocks_;
+#pragma omp parallel for num_threads(threads)
+    for (int row = 0; row < rows; row++) {
+        const int n = row / (head * seq);
+        const int h = row / seq % head;
+        const int s = row % seq;
+        const float mean = (contiguous ? reduce_row(REDUCE_SUM, dim, in.ptr(n, h, s, 0)) :
+                                         reduce_row(REDUCE_SUM, *input, n, h, s)) / dim;
+        for (int d = 0; d < dim; d++) {
+            out(n, h, s, d) = in(n, h, s, d) - mean;
+        }
+        const float norm = contiguous ? reduce_row(REDUCE_L2, dim, out.ptr(n, h, s, 0)) :
+                                        reduce_row(REDUCE_L2, *output, n, h, s);
+        const float rms = std::sqrt(norm * norm / dim + epsilon_);
+        for (int d = 0; d < dim; d++) {
+            const float value = block.weight.dataAt<float>(0, 0, 0, d) * out(n, h, s, d) / rms;
+            out(n, h, s, d) = bias ? value + block.bias.dataAt<float>(0, 0, 0, d) : value;
         }
     }
 
     return Op::execute(inputs, outputs);
 }
-ErrorCode CPULayerNorm::free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPULayerNorm::free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     return Op::free(inputs, outputs);
 }
 } // namespace mllm
\ No newline at end of file
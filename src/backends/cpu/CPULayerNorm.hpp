@@ -12,17 +12,22 @@ class CPULayerNorm:public Op {
 public:
     CPULayerNorm(Backend *bn, string opName, int normSize,bool bias= true,float epsilon = 1e-6, int threadCount=4);
     virtual ~CPULayerNorm() = default;
-    virtual ErrorCode reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-    virtual ErrorCode execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-    virtual ErrorCode free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
+    virtual ErrorCode reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual ErrorCode execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual ErrorCode free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
     ErrorCode load(AbstructLoader &loader) override;
+    int addBlock(const string &name) override;
+    void bindBlock(int block) override;
 
 private:
     int thread_count = 4;
     float epsilon_;
     int normSize_=0;
-    Tensor weight_;
-    Tensor bias_;
+    struct Block {
+        Tensor weight;
+        Tensor bias;
+    };
+    BlockStates<Block> blocks_;
     bool  bias;
 };
 class CPULayerNormCreator : public CPUBackend::Creator {
@@ -1,19 +1,42 @@
 
 #include "CPULinear.hpp"
+#include "CPUActivationStats.hpp"
+#include "quantize/QuantizeLUT.hpp"
 
 namespace mllm {
 
+// weights smaller than this are not worth splitting across NUMA nodes
+#define MLLM_TP_MIN_WEIGHTS (1 << 20)
+
 CPULinear::CPULinear(Backend *bn, string opName, int in_features, int out_features, bool bias, int threadCount) : thread_count(threadCount),
-    Op(bn, opName) {
+    Op(bn, opName), blocks_(opName) {
     in_features_ = in_features;
     out_features_ = out_features;
     support_bias_ = bias;
     thread_count = threadCount;
-    weight_.setBackend(bn);
-    bias_.setBackend(bn);
+    setBlockBackend(*blocks_);
+}
+
+void CPULinear::setBlockBackend(Block &block) {
+    block.weight.setBackend(backend());
+    block.bias.setBackend(backend());
+    block.scale.setBackend(backend());
+    block.smooth.setBackend(backend());
+    block.tiles.setBackend(backend());
 }
 
-ErrorCode CPULinear::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+int CPULinear::addBlock(const string &name) {
+    const int block = blocks_.add(name);
+    setBlockBackend(blocks_[block]);
+    return block;
+}
+
+void CPULinear::bindBlock(int block) {
+    blocks_.bind(block);
+    setName(blocks_.name(block));
+}
+
+ErrorCode CPULinear::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     //std::cout << name() << "  CPULinear  reshape" << std::endl;
     assert(inputs.size() == 1);
     assert(outputs.size() == 1);
@@ -39,64 +62,224 @@ ErrorCode CPULinear::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_pt
 }
 
 ErrorCode CPULinear::load(AbstructLoader &loader) {
+    auto &block = *blocks_;
     //std::cout << name() << "  CPULinear load" << std::endl;
-    weight_.setName(name() + ".weight");
-    weight_.reshape(1, 1, out_features_, in_features_);
-    if (loader.getDataType(weight_.name()) != MLLM_TYPE_COUNT) {
-        weight_.setDtype(loader.getDataType(weight_.name()));
-        weight_.alloc();
-        loader.load(&weight_);
+    block.weight.setName(name() + ".weight");
+    block.weight.reshape(1, 1, out_features_, in_features_);
+    if (static_cast<CPUBackend *>(backend())->loadTiedWeight(loader, block.weight)) {
+        // shared with the input embedding
+    } else if (loader.getDataType(block.weight.name()) != MLLM_TYPE_COUNT) {
+        block.weight.setDtype(loader.getDataType(block.weight.name()));
+        block.weight.alloc();
+        loader.load(&block.weight);
     } else {
-        weight_.setDtype(MLLM_TYPE_F32);
-        weight_.alloc();
+        block.weight.setDtype(MLLM_TYPE_F32);
+        block.weight.alloc();
     }
     if (support_bias_) {
-        bias_.setName(name() + ".bias");
-        bias_.reshape(1, 1, 1, out_features_);
-        if (loader.getDataType(bias_.name()) != MLLM_TYPE_COUNT) {
-            bias_.setDtype(loader.getDataType(bias_.name()));
-            bias_.alloc();
-            loader.load(&bias_);
+        block.bias.setName(name() + ".bias");
+        block.bias.reshape(1, 1, 1, out_features_);
+        if (loader.getDataType(block.bias.name()) != MLLM_TYPE_COUNT) {
+            block.bias.setDtype(loader.getDataType(block.bias.name()));
+            block.bias.alloc();
+            loader.load(&block.bias);
         } else {
-            bias_.setDtype(MLLM_TYPE_F32);
-            bias_.alloc();
+            block.bias.setDtype(MLLM_TYPE_F32);
+            block.bias.alloc();
+        }
+    }
+    // W8A8: the scale of every row of an I8 weight, and the factors of the input channels if the quantizer
+    // smoothed it, see ActivationStats
+    block.scale.setName(name() + ".scale");
+    if (block.weight.dtype() == MLLM_TYPE_I8) {
+        block.scale.reshape(1, 1, 1, out_features_);
+        block.scale.setDtype(MLLM_TYPE_F32);
+        block.scale.alloc();
+        loader.load(&block.scale);
+    }
+    block.smooth.setName(name() + ".smooth");
+    if (loader.getDataType(block.smooth.name()) != MLLM_TYPE_COUNT) {
+        block.smooth.reshape(1, 1, 1, in_features_);
+        block.smooth.setDtype(MLLM_TYPE_F32);
+        block.smooth.alloc();
+        loader.load(&block.smooth);
+    }
+    if (lut_bits(block.weight.dtype()) > 0) {
+        if (in_features_ % QK_LUT != 0) {
+            std::cerr << name() << ": " << DataTypeName(block.weight.dtype()) << " needs in_features % " << QK_LUT << " == 0" << std::endl;
+            return NOT_SUPPORT;
         }
+        block.tiles.setName(name() + ".tiles");
+        block.tiles.reshape(1, 1, (out_features_ + QR_LUT - 1) / QR_LUT * QR_LUT, in_features_);
+        block.tiles.setDtype(block.weight.dtype());
+        block.tiles.alloc();
+        pack_rows_lut(block.weight.dtype(), block.weight.hostPtr<void>(), block.tiles.hostPtr<void>(), out_features_, in_features_);
+        // a tied weight is still read by the embedding
+        if (block.weight.masterTensor() == nullptr) {
+            block.weight.free();
+        }
+        return Op::load(loader);
+    }
+    auto *numa = static_cast<CPUBackend *>(backend())->numaPool();
+    // a tied weight stays whole, its buffer is shared with other ops; the row scales of I8 are not split
+    if (numa != nullptr && block.weight.masterTensor() == nullptr && block.weight.dtype() != MLLM_TYPE_I8 && (int64_t)in_features_ * out_features_ >= MLLM_TP_MIN_WEIGHTS && out_features_ >= numa->nodes()) {
+        shardWeight(numa);
     }
     return Op::load(loader);
 }
 
-ErrorCode CPULinear::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
-    if(inputs[0]->count() == 0) {
-        return Op::execute(inputs, outputs);
+void CPULinear::shardWeight(NumaPool *numa) {
+    auto &block = *blocks_;
+    const int nodes = numa->nodes();
+    const size_t row_size = DataTypeSize(block.weight.dtype(), in_features_);
+    block.shards.clear();
+    for (int node = 0; node < nodes; ++node) {
+        auto shard = std::make_shared<Shard>();
+        shard->out_begin = (int)((int64_t)out_features_ * node / nodes);
+        shard->out_features = (int)((int64_t)out_features_ * (node + 1) / nodes) - shard->out_begin;
+        shard->weight.setBackend(backend());
+        shard->weight.setName(name() + ".weight.shard" + std::to_string(node));
+        shard->weight.reshape(1, 1, shard->out_features, in_features_);
+        shard->weight.setDtype(block.weight.dtype());
+        shard->weight.allocAligned(pageSize());
+        numaBind(shard->weight.hostPtr<void>(), shard->weight.cntSize(), numa->physicalNode(node));
+        shard->output.setBackend(backend());
+        block.shards.push_back(shard);
     }
-    // std::cout << name() << "  CPULinear()" << std::endl;
-    switch (weight_.dtype()) {
+    // every node copies its own rows, so that the pages are first touched on it
+    numa->run([&](int node) {
+        auto &shard = *block.shards[node];
+        memcpy(shard.weight.hostPtr<char>(), block.weight.hostPtr<char>() + row_size * shard.out_begin, row_size * shard.out_features);
+    });
+    block.weight.free();
+}
+
+void CPULinear::matmul(Tensor *input, Tensor *weight, Tensor *output, bool support_bias, int threads) {
+    auto &block = *blocks_;
+    switch (weight->dtype()) {
     case MLLM_TYPE_F32: {
-        mat_mul_fp32(inputs[0].get(), &weight_, outputs[0].get(), support_bias_, &bias_, false, true, thread_count);
+        mat_mul_fp32(input, weight, output, support_bias, &block.bias, false, true, threads);
         break;
     }
     case MLLM_TYPE_F16: break;
+    case MLLM_TYPE_BF16: {
+        mat_mul_fp32_bf16(input, weight, output, support_bias, &block.bias, threads);
+        break;
+    }
     case MLLM_TYPE_Q4_0: {
-        mat_mul_fp32_q4_0(inputs[0].get(), &weight_, outputs[0].get(), support_bias_, &bias_, thread_count);
+        mat_mul_fp32_q4_0(input, weight, output, support_bias, &block.bias, threads);
+        break;
+    }
+    case MLLM_TYPE_Q8_0: {
+        mat_mul_fp32_q8_0(input, weight, output, support_bias, &block.bias, threads);
+        break;
+    }
+    case MLLM_TYPE_I8: {
+        mat_mul_fp32_i8(input, weight, output, support_bias, &block.bias, &block.scale, block.smooth.hostPtr<float>() != nullptr ? &block.smooth : nullptr, threads);
+        break;
+    }
+    case MLLM_TYPE_Q4_0_24:
+    case MLLM_TYPE_Q8_0_24: {
+        mat_mul_fp32_sparse_24(input, weight, output, support_bias, &block.bias, threads);
+        break;
+    }
+    case MLLM_TYPE_Q2_LUT:
+    case MLLM_TYPE_Q3_LUT: {
+        mat_mul_fp32_lut(input, &block.tiles, output, support_bias, &block.bias, threads);
         break;
     }
     case MLLM_TYPE_Q4_K: {
-        mat_mul_fp32_q4_K(inputs[0].get(), &weight_, outputs[0].get(), support_bias_, &bias_, thread_count);
+        mat_mul_fp32_q4_K(input, weight, output, support_bias, &block.bias, threads);
         break;
     }
     case MLLM_TYPE_Q6_K: {
-        mat_mul_fp32_q6_K(inputs[0].get(), &weight_, outputs[0].get(), support_bias_, &bias_, thread_count);
+        mat_mul_fp32_q6_K(input, weight, output, support_bias, &block.bias, threads);
         break;
     }
     default:
         break;
     }
+}
+
+ErrorCode CPULinear::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    auto &block = *blocks_;
+    if(inputs[0]->count() == 0) {
+        return Op::execute(inputs, outputs);
+    }
+    // std::cout << name() << "  CPULinear()" << std::endl;
+    auto *stats = static_cast<CPUBackend *>(backend())->activationStats();
+    if (stats != nullptr) {
+        auto &input = inputs[0];
+        for (int b = 0; b < input->batch(); ++b) {
+            stats->record(name(), input->ptrAt<float>(b, 0, 0, 0), input->sequence(), in_features_,
+                          input->sequence() > 1 ? input->ptrAt<float>(b, 0, 1, 0) - input->ptrAt<float>(b, 0, 0, 0) : 0);
+        }
+    }
+    if (!block.shards.empty()) {
+        auto *numa = static_cast<CPUBackend *>(backend())->numaPool();
+        auto &input = inputs[0];
+        auto &output = outputs[0];
+        const int threads = CPUBackend::threadsFor((double)input->count() * block.shards[0]->out_features,
+                                                   std::max(1, thread_count / numa->nodes()));
+        setThreadWidth(threads);
+        numa->run([&](int node) {
+            auto &shard = *block.shards[node];
+            shard.output.reshape(input->batch(), input->head(), input->sequence(), shard.out_features);
+            shard.output.alloc();
+            matmul(input.get(), &shard.weight, &shard.output, false, threads);
+            // gather the columns of this shard into the output and add their bias, one row at a time
+            const float *bias = support_bias_ ? block.bias.hostPtr<float>() + shard.out_begin : nullptr;
+            for (int b = 0; b < input->batch(); ++b) {
+                for (int h = 0; h < input->head(); ++h) {
+                    for (int s = 0; s < input->sequence(); ++s) {
+                        const float *src = shard.output.ptrAt<float>(b, h, s, 0);
+                        if (output->dtype() == MLLM_TYPE_F16) {
+                            auto *dst = output->ptrAt<mllm_fp16_t>(b, h, s, shard.out_begin);
+                            for (int n = 0; n < shard.out_features; ++n) {
+                                dst[n] = MLLM_FP32_TO_FP16(src[n] + (bias != nullptr ? bias[n] : 0.0F));
+                            }
+                            continue;
+                        }
+                        auto *dst = output->ptrAt<float>(b, h, s, shard.out_begin);
+                        memcpy(dst, src, shard.out_features * sizeof(float));
+                        if (bias != nullptr) {
+                            for (int n = 0; n < shard.out_features; ++n) {
+                                dst[n] += bias[n];
+                            }
+                        }
+                    }
+                }
+            }
+        });
+        return Op::execute(inputs, outputs);
+    }
+    const int threads = CPUBackend::threadsFor((double)inputs[0]->count() * out_features_, thread_count);
+    setThreadWidth(threads);
+    matmul(inputs[0].get(), &block.weight, outputs[0].get(), support_bias_, threads);
     return Op::execute(inputs, outputs);
 }
-ErrorCode CPULinear::free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
-    weight_.free();
+vector<Tensor *> CPULinear::weights() {
+    auto &block = *blocks_;
+    // the shards are read by threads on other NUMA nodes, whose caches a prefetch here would not reach
+    if (!block.shards.empty()) {
+        return {};
+    }
+    Tensor *weight = block.tiles.hostPtr<void>() != nullptr ? &block.tiles : &block.weight;
+    if (support_bias_) {
+        return {weight, &block.bias};
+    }
+    return {weight};
+}
+
+ErrorCode CPULinear::free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    auto &block = *blocks_;
+    block.weight.free();
+    block.scale.free();
+    block.smooth.free();
+    block.tiles.free();
+    block.shards.clear();
     if (support_bias_) {
-        bias_.free();
+        block.bias.free();
     }
     return Op::free(inputs, outputs);
 }
@@ -12,25 +12,50 @@ class CPULinear final : public Op {
 public:
     CPULinear(Backend *bn, string opName, int in_features, int out_features, bool bias, int threadCount);
     virtual ~CPULinear() = default;
-    virtual ErrorCode reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
+    virtual ErrorCode reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
     virtual ErrorCode load(AbstructLoader &loader) override;
-    virtual ErrorCode execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-    virtual ErrorCode free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
+    virtual ErrorCode execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual ErrorCode free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    vector<Tensor *> weights() override;
+    int addBlock(const string &name) override;
+    void bindBlock(int block) override;
 
     Tensor &weight() {
-        return weight_;
+        return blocks_->weight;
     }
     Tensor &bias() {
-        return bias_;
+        return blocks_->bias;
     }
 
 private:
+    /*
+     * With tensor parallelism (CPUBackend::setNumaNodes) every NUMA node owns the rows of the weight that
+     * produce the output features [out_begin, out_begin + out_features), and computes them into `output`.
+     */
+    struct Shard {
+        int out_begin;
+        int out_features;
+        Tensor weight;
+        Tensor output;
+    };
+    // the weights of one block, see Op::addBlock
+    struct Block {
+        Tensor weight;
+        Tensor bias;
+        Tensor scale;  // W8A8: scales of the rows of an I8 weight, see mat_mul_fp32_i8
+        Tensor smooth; // W8A8: factors of the input channels
+        Tensor tiles;  // Q2_LUT / Q3_LUT: the weight repacked into tiles of QR_LUT rows, see pack_rows_lut
+        vector<shared_ptr<Shard>> shards;
+    };
+    void setBlockBackend(Block &block);
+    void shardWeight(NumaPool *numa);
+    void matmul(Tensor *input, Tensor *weight, Tensor *output, bool support_bias, int threads);
+
     int in_features_;
     int out_features_;
     bool support_bias_;
     int thread_count = 4;
-    Tensor weight_;
-    Tensor bias_;
+    BlockStates<Block> blocks_;
 };
 
 class CPULinearCreator : public CPUBackend::Creator {
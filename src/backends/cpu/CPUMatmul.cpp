@@ -10,7 +10,7 @@ CPUMatmul::CPUMatmul(Backend *bn, string opName, bool transpose0, bool transpose
     thread_count = threadCount;
 }
 
-ErrorCode CPUMatmul::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUMatmul::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     assert(inputs.size() == 2);
     assert(outputs.size() == 1);
@@ -61,17 +61,44 @@ ErrorCode CPUMatmul::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_pt
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPUMatmul::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUMatmul::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     assert(inputs[0]->dtype() == MLLM_TYPE_F32);
     // assert(inputs[1]->dtype() == MLLM_TYPE_F32);
+    auto *numa = static_cast<CPUBackend *>(backend())->numaPool();
+    if (numa != nullptr && inputs[0]->head() >= numa->nodes() && inputs[1]->head() == inputs[0]->head()) {
+        // attention: every NUMA node computes its own range of heads
+        const int nodes = numa->nodes();
+        const int heads = inputs[0]->head();
+        const int threads = CPUBackend::threadsFor((double)outputs[0]->count() / nodes * inputs[0]->dimension(),
+                                                   std::max(1, thread_count / nodes));
+        setThreadWidth(threads);
+        while ((int)src0_f16_.size() < nodes) {
+            src0_f16_.push_back(std::make_shared<Tensor>(backend()));
+        }
+        numa->run([&](int node) {
+            const int head_begin = heads * node / nodes;
+            const int head_end = heads * (node + 1) / nodes;
+            if (inputs[1]->dtype() == MLLM_TYPE_F16) {
+                mat_mul_fp32_fp16(inputs[0].get(), inputs[1].get(), outputs[0].get(), false, nullptr, transpose0_, transpose1_, threads, head_begin, head_end, src0_f16_[node].get());
+            } else if (inputs[1]->dtype() == MLLM_TYPE_F32) {
+                mat_mul_fp32(inputs[0].get(), inputs[1].get(), outputs[0].get(), false, nullptr, transpose0_, transpose1_, threads, head_begin, head_end);
+            }
+        });
+        return Op::execute(inputs, outputs);
+    }
+    const int threads = CPUBackend::threadsFor((double)outputs[0]->count() * inputs[0]->dimension(), thread_count);
+    setThreadWidth(threads);
     switch (inputs[1]->dtype()) {
     case MLLM_TYPE_F32: {
-        mat_mul_fp32(inputs[0].get(), inputs[1].get(), outputs[0].get(), false, nullptr, transpose0_, transpose1_, thread_count);
+        mat_mul_fp32(inputs[0].get(), inputs[1].get(), outputs[0].get(), false, nullptr, transpose0_, transpose1_, threads);
         break;
     }
     case MLLM_TYPE_F16: {
-        mat_mul_fp32_fp16(inputs[0].get(), inputs[1].get(), outputs[0].get(), false, nullptr, transpose0_, transpose1_, thread_count);
+        if (src0_f16_.empty()) {
+            src0_f16_.push_back(std::make_shared<Tensor>(backend()));
+        }
+        mat_mul_fp32_fp16(inputs[0].get(), inputs[1].get(), outputs[0].get(), false, nullptr, transpose0_, transpose1_, threads, 0, -1, src0_f16_[0].get());
         break;
     }
     default:
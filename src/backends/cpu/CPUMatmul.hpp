@@ -12,13 +12,15 @@ class CPUMatmul final : public Op {
 public:
     CPUMatmul(Backend *bn, string opName, bool transpose0, bool transpose1, int threadCount);
     virtual ~CPUMatmul() = default;
-    virtual ErrorCode reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-    virtual ErrorCode execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
+    virtual ErrorCode reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual ErrorCode execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
 
 private:
     bool transpose0_;
     bool transpose1_;
     int thread_count = 4;
+    // the F16 copy of inputs[0] against an F16 inputs[1], one per NUMA node, see mat_mul_fp32_fp16
+    vector<shared_ptr<Tensor>> src0_f16_;
 };
 
 class CPUMatmulCreator : public CPUBackend::Creator {
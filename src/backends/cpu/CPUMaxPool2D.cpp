@@ -13,7 +13,7 @@ Op(bn, opName) {
     padding_type_ = padding_type;
 }
 
-ErrorCode CPUMaxPool2D::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUMaxPool2D::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     //batch = batch
     //sequence = out_channel
     //head = height
@@ -40,7 +40,7 @@ ErrorCode CPUMaxPool2D::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared
 }
 
 
-ErrorCode CPUMaxPool2D::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUMaxPool2D::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     switch (padding_type_) {
     case SAME:{
@@ -56,7 +56,7 @@ ErrorCode CPUMaxPool2D::execute(vector<shared_ptr<Tensor>> inputs, vector<shared
 }
 
 
-ErrorCode CPUMaxPool2D::setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUMaxPool2D::setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     return Op::setUp(inputs, outputs);
 }
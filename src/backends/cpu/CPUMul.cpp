@@ -7,7 +7,7 @@ CPUMul::CPUMul(Backend *bn,  string opName, int threadCount) : thread_count(thre
     Op(bn, opName) {
 }
 
-ErrorCode CPUMul::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUMul::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     assert(inputs.size() == 2);
     assert(outputs.size() == 1);
@@ -20,7 +20,7 @@ ErrorCode CPUMul::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<T
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPUMul::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUMul::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     int N = inputs[0]->batch();
     int C = inputs[0]->head();
@@ -32,15 +32,19 @@ ErrorCode CPUMul::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<T
         auto in0_ptr = inputs[0]->hostPtr<float>();
         auto in1_ptr = inputs[1]->hostPtr<float>();
         auto out_ptr = outputs[0]->hostPtr<float>();
-#pragma omp parallel for num_threads(thread_count)
+        const int threads = CPUBackend::threadsFor(copy_size, thread_count);
+        setThreadWidth(threads);
+#pragma omp parallel for num_threads(threads)
         for (int is = 0; is < copy_size; ++is) {
             out_ptr[is] = in0_ptr[is] * in1_ptr[is];
         }
     }else {
+        const int threads = CPUBackend::threadsFor(4.0 * W, thread_count);
+        setThreadWidth(threads);
         for (int n = 0; n < N; ++n) {
             for (int c = 0; c < C; ++c) {
                 for (int h = 0; h < H; ++h) {
-#pragma omp parallel for num_threads(thread_count)
+#pragma omp parallel for num_threads(threads)
                     for (int w = 0; w < W; ++w) {
                         outputs[0]->setDataAt<float>(n, c, h, w, inputs[0]->dataAt<float>(n, c, h, w) * inputs[1]->dataAt<float>(n, c, h, w));
                     }
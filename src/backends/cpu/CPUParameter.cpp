@@ -12,7 +12,7 @@ CPUParameter::CPUParameter(Backend *bn,  string opName,int batch, int head, int
     weight_.setBackend(bn);
 }
 
-ErrorCode CPUParameter::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUParameter::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     outputs[0]->reshape(batch_, head_, seq_, dim_);
     return Op::reshape(inputs, outputs);
@@ -23,7 +23,8 @@ ErrorCode CPUParameter::load(AbstructLoader &loader) {
     weight_.setName(name());
     weight_.reshape(batch_, head_, seq_, dim_);
     if (loader.getDataType(weight_.name()) != MLLM_TYPE_COUNT) {
-        weight_.setDtype(loader.getDataType(weight_.name()));
+        // the value is read as fp32 by the ops it feeds, the loader widens bf16
+        weight_.setDtype(loader.getDataType(weight_.name()) == MLLM_TYPE_BF16 ? MLLM_TYPE_F32 : loader.getDataType(weight_.name()));
         weight_.alloc();
         loader.load(&weight_);
     } else {
@@ -33,7 +34,7 @@ ErrorCode CPUParameter::load(AbstructLoader &loader) {
     return Op::load(loader);
 }
 
-ErrorCode CPUParameter::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUParameter::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     if(outputs[0]->masterTensor()->name() != weight_.name()) {
         if(outputs[0]->masterTensor() == nullptr) {
@@ -69,13 +70,13 @@ ErrorCode CPUParameter::execute(vector<shared_ptr<Tensor>> inputs, vector<shared
     return Op::execute(inputs, outputs);
 }
 
-ErrorCode CPUParameter::free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUParameter::free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     weight_.free();
     return Op::free(inputs, outputs);
 }
 
-ErrorCode CPUParameter::setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUParameter::setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     outputs[0]->deepCopyFrom(&weight_, false);
     return MLLM_NO_ERROR;
@@ -0,0 +1,102 @@
+#include "CPUPrefetcher.hpp"
+#include <algorithm>
+
+#define MLLM_CACHE_LINE 64
+// bytes the calling thread asks for when there is no helper thread: beyond this the prefetch instructions
+// only queue up behind each other in the line fill buffers
+#define MLLM_PREFETCH_INLINE_BYTES (16 * 1024)
+
+namespace mllm {
+
+CPUPrefetcher::CPUPrefetcher(size_t head_bytes, bool threaded) :
+    head_bytes_(head_bytes) {
+    if (threaded) {
+        helper_ = std::thread(&CPUPrefetcher::run, this);
+    }
+}
+
+CPUPrefetcher::~CPUPrefetcher() {
+    if (helper_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        helper_.join();
+    }
+}
+
+void CPUPrefetcher::prefetch(const std::vector<std::pair<const char *, size_t>> &ranges) {
+    if (!helper_.joinable()) {
+        for (const auto &range : ranges) {
+            const size_t bytes = std::min(range.second, std::min(head_bytes_, (size_t)MLLM_PREFETCH_INLINE_BYTES));
+            for (size_t offset = 0; offset < bytes; offset += MLLM_CACHE_LINE) {
+                __builtin_prefetch(range.first + offset, 0, 3);
+            }
+            bytes_prefetched_ += bytes;
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = &ranges;
+        ++request_;
+    }
+    wake_.notify_one();
+}
+
+void CPUPrefetcher::stop() {
+    if (!helper_.joinable()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (pending_ == nullptr && !busy_) {
+        return;
+    }
+    pending_ = nullptr;
+    ++request_;
+    idle_.wait(lock, [&] { return !busy_; });
+}
+
+void CPUPrefetcher::run() {
+    unsigned done = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [&] { return stop_ || request_ != done; });
+        if (stop_) {
+            return;
+        }
+        done = request_;
+        if (pending_ == nullptr) {
+            continue;
+        }
+        const auto *ranges = pending_;
+        busy_ = true;
+        lock.unlock();
+        touch(*ranges, done);
+        lock.lock();
+        busy_ = false;
+        idle_.notify_all();
+    }
+}
+
+void CPUPrefetcher::touch(const std::vector<std::pair<const char *, size_t>> &ranges, unsigned request) {
+    unsigned char sink = 0;
+    for (const auto &range : ranges) {
+        const size_t bytes = std::min(range.second, head_bytes_);
+        size_t offset = 0;
+        for (; offset < bytes; offset += MLLM_CACHE_LINE) {
+            // the op before the weights is over, the op reading them pulls in the rest itself
+            if (offset % 4096 == 0 && request_ != request) {
+                break;
+            }
+            sink ^= *(volatile const unsigned char *)(range.first + offset);
+        }
+        bytes_prefetched_ += std::min(offset, bytes);
+        if (offset < bytes) {
+            break;
+        }
+    }
+    (void)sink;
+}
+} // namespace mllm
@@ -0,0 +1,74 @@
+#ifndef MLLM_CPUPREFETCHER_H
+#define MLLM_CPUPREFETCHER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mllm {
+/**
+ * \brief loads the head of the next op's weights into the caches while the current op runs.
+ *
+ * In decode a Linear streams its weights once, so its first blocks miss all the way to DRAM while the ops before
+ * it (norm, RoPE, softmax) left the memory system mostly idle. Graph hands the weights of the next op with
+ * weights to the prefetcher before it runs the current op.
+ * With more than one CPU a helper thread reads one byte per cache line of the first `head_bytes` of every
+ * weight, into the cache levels it shares with the op's threads; a newer request abandons the older one, and
+ * stop() returns once the helper no longer reads any weight, so that they may be freed.
+ * With one CPU the calling thread issues prefetch instructions for the first lines instead, which does not
+ * wait for the memory.
+ */
+class CPUPrefetcher {
+public:
+    /**
+     * \param head_bytes  bytes loaded at the start of every weight.
+     * \param threaded    load them on a helper thread, by default if there is more than one CPU.
+     */
+    explicit CPUPrefetcher(size_t head_bytes, bool threaded = std::thread::hardware_concurrency() > 1);
+    ~CPUPrefetcher();
+
+    /**
+     * \brief start loading the head of every range, returns without waiting.
+     * \param ranges  read until the next prefetch() or stop(), which must come before they change.
+     */
+    void prefetch(const std::vector<std::pair<const char *, size_t>> &ranges);
+    /**
+     * \brief abandon the current request and wait until the helper thread reads none of its ranges.
+     */
+    void stop();
+
+    /**
+     * \return bytes loaded ahead since the prefetcher was created.
+     */
+    uint64_t bytesPrefetched() const {
+        return bytes_prefetched_;
+    }
+    bool threaded() const {
+        return helper_.joinable();
+    }
+
+private:
+    void run();
+    // stops early if a newer request comes in
+    void touch(const std::vector<std::pair<const char *, size_t>> &ranges, unsigned request);
+
+    size_t head_bytes_;
+    std::atomic<uint64_t> bytes_prefetched_{0};
+    std::thread helper_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    const std::vector<std::pair<const char *, size_t>> *pending_ = nullptr;
+    std::atomic<unsigned> request_{0};
+    // the helper thread is reading the ranges of a request
+    bool busy_ = false;
+    bool stop_ = false;
+};
+} // namespace mllm
+
+#endif // MLLM_CPUPREFETCHER_H
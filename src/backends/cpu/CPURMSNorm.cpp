@@ -1,6 +1,6 @@
 #include <cmath>
 #include "CPURMSNorm.hpp"
-#include "Tensor.hpp"
+#include "TensorAccessor.hpp"
 
 namespace mllm {
 
@@ -8,14 +8,14 @@ namespace mllm {
 
 // int32_t op_params[1];
 CPURMSNorm::CPURMSNorm(Backend *bn, string opName, int normSize, float epsilon, int threadCount) : thread_count(threadCount),
-    Op(bn, opName), epsilon_(epsilon) {
+    Op(bn, opName), epsilon_(epsilon), blocks_(opName) {
     // op_params[0] = 897988541;s, sizeof(float));
     // memcpy(&epsilon_, op_param)
     normSize_ = normSize;
-    weight_.setBackend(bn);
+    blocks_->weight.setBackend(bn);
 }
 
-ErrorCode CPURMSNorm::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPURMSNorm::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     // RMSNorm is similar to LayerNorm which operates on the channel dimension.
     assert(normSize_ == inputs[0]->dimension());
     outputs[0]->reshape(inputs[0]->batch(), inputs[0]->head(), inputs[0]->sequence(), inputs[0]->dimension());
@@ -24,12 +24,18 @@ ErrorCode CPURMSNorm::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_p
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPURMSNorm::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
-    auto input = inputs[0];
+ErrorCode CPURMSNorm::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    auto &input = inputs[0];
     int batch = input->batch();
     int dim = input->dimension();
     int seq = input->sequence();
     int head = input->head();
+    // one team per row
+    const int threads = CPUBackend::threadsFor(4.0 * dim, thread_count);
+    setThreadWidth(threads);
+    TensorAccessor<float> in(*input);
+    TensorAccessor<float> out(*outputs[0]);
+    const float *weight = blocks_->weight.hostPtr<float>();
     for (int h = 0; h < head; h++) {
         for (int n = 0; n < batch; n++) {
             for (int s = 0; s < seq; s++) {
@@ -37,16 +43,15 @@ ErrorCode CPURMSNorm::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_p
                 // sum
                 // #pragma omp parallel for reduction(+ : sum_squares) num_threads(thread_count)
                 for (int d = 0; d < dim; d++) {
-                    float value = input->dataAt<float>(n, h, s, d);
+                    float value = in(n, h, s, d);
                     sum_squares += (double)value * value;
                 }
                 const float mean = sum_squares/dim;
                 const float rms = 1.0f/sqrtf(mean + epsilon_);
                 // use memset to set the value of the memory block
-                #pragma omp parallel for num_threads(thread_count)
+                #pragma omp parallel for num_threads(threads)
                 for (int d = 0; d < dim; d++) {
-                    float value = input->dataAt<float>(n, h, s, d);
-                    outputs[0]->setDataAt<float>(n, h, s, d, weight_.dataAt<float>(0, 0, 0, d) * value * rms);
+                    out(n, h, s, d) = weight[d] * in(n, h, s, d) * rms;
                 }
             }
         }
@@ -59,21 +64,31 @@ ErrorCode CPURMSNorm::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_p
     return Op::execute(inputs, outputs);
 }
 ErrorCode CPURMSNorm::load(AbstructLoader &loader) {
-    weight_.setName(name() + ".weight");
-    weight_.reshape(1, 1, 1, normSize_); //
-    if (loader.getDataType(weight_.name()) != MLLM_TYPE_COUNT) {
-        weight_.setDtype(loader.getDataType(weight_.name()));
-        weight_.alloc();
-        // auto l = loader.length(weight_.name());
-        loader.load(&weight_);
+    auto &weight = blocks_->weight;
+    weight.setName(name() + ".weight");
+    weight.reshape(1, 1, 1, normSize_); //
+    if (loader.getDataType(weight.name()) != MLLM_TYPE_COUNT) {
+        weight.setDtype(loader.getDataType(weight.name()));
+        weight.alloc();
+        // auto l = loader.length(weight.name());
+        loader.load(&weight);
     } else {
-        weight_.setDtype(MLLM_TYPE_F32);
-        weight_.alloc();
+        weight.setDtype(MLLM_TYPE_F32);
+        weight.alloc();
     }
     return Op::load(loader);
 }
-ErrorCode CPURMSNorm::free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
-    weight_.free();
+ErrorCode CPURMSNorm::free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    blocks_->weight.free();
     return Op::free(inputs, outputs);
 }
+int CPURMSNorm::addBlock(const string &name) {
+    const int block = blocks_.add(name);
+    blocks_[block].weight.setBackend(backend());
+    return block;
+}
+void CPURMSNorm::bindBlock(int block) {
+    blocks_.bind(block);
+    setName(blocks_.name(block));
+}
 } // namespace mllm
\ No newline at end of file
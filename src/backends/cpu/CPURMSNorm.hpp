@@ -10,20 +10,25 @@ class CPURMSNorm final : public Op {
 public:
     CPURMSNorm(Backend *bn, string opName,int normSize, float epsilon = 1e-6,  int threadCount=4);
     virtual ~CPURMSNorm() = default;
-    virtual ErrorCode reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
+    virtual ErrorCode reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
     virtual ErrorCode load(AbstructLoader &loader) override;
-    virtual ErrorCode execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-    virtual ErrorCode free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
+    virtual ErrorCode execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual ErrorCode free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual int addBlock(const string &name) override;
+    virtual void bindBlock(int block) override;
 
     Tensor &weight() {
-        return weight_;
+        return blocks_->weight;
     }
 
 private:
     int thread_count = 4;
     float epsilon_;
     int axis_ = 1;
-    Tensor weight_;
+    struct Block {
+        Tensor weight;
+    };
+    BlockStates<Block> blocks_;
     int normSize_;
     // Tensor bias_;
 };
@@ -9,12 +9,12 @@ CPURange::CPURange(Backend *bn,  string opName, int start, int end, int threadCo
     end_ =  end;
 }
 
-ErrorCode CPURange::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPURange::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     outputs[0]->reshape(1, 1,  end_- start_, 1);
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPURange::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPURange::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     for (int i = 0; i < end_-start_; ++i) {
         outputs[0]->setDataAt<float>(0, 0, i+start_,0, (float)i);
     }
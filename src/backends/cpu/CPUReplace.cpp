@@ -1,5 +1,6 @@
 
 #include "CPUReplace.hpp"
+#include <algorithm>
 
 namespace mllm {
 
@@ -7,15 +8,15 @@ CPUReplace::CPUReplace(Backend *bn,  string opName, int threadCount) : thread_co
     Op(bn, opName) {
 }
 
-ErrorCode CPUReplace::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUReplace::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     if(inputs[1]->batch() == 0) {
         outputs[0]->reshape(inputs[0]->batch(), 1, inputs[0]->sequence(), inputs[0]->dimension());
         return Op::execute(inputs, outputs);
     }
     assert(inputs.size() == 3);
     assert(outputs.size() == 1);
-    auto dest_input = inputs[0];
-    auto src_input = inputs[1];
+    auto &dest_input = inputs[0];
+    auto &src_input = inputs[1];
     // auto replace_idx = inputs[2];
     assert(dest_input->batch()==1);
     assert(dest_input->head()==1);
@@ -29,7 +30,7 @@ ErrorCode CPUReplace::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_p
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPUReplace::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUReplace::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     if (inputs[1]->batch() == 0) {
         auto dst_ptr = outputs[0]->ptrAt<float>(0, 0, 0, 0);
         auto src_ptr = inputs[0]->ptrAt<float>(0, 0, 0, 0);
@@ -38,15 +39,35 @@ ErrorCode CPUReplace::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_p
     }
     assert(inputs.size() == 3);
     assert(outputs.size() == 1);
-    auto dest_input = inputs[0];
-    auto src_input = inputs[1];
-    auto replace_idx = inputs[2];
+    auto &dest_input = inputs[0];
+    auto &src_input = inputs[1];
+    auto &replace_idx = inputs[2];
     assert(replace_idx->batch()==1);
     assert(replace_idx->sequence()==1);
     assert(replace_idx->head()==1);
     assert(replace_idx->dimension() == src_input->batch());
     int replace_s = src_input->sequence();
     int replace_size = src_input->batch();
+    setBytesSaved(0);
+    if (replace_size == 1) {
+        const int placeholder = (int)replace_idx->dataAt<float>(0, 0, 0, 0);
+        last_placeholder_ = placeholder;
+        if (image_at_ >= 0) {
+            const size_t row_size = sizeof(float) * dest_input->dimension();
+            if (placeholder != image_at_) {
+                memmove(outputs[0]->ptrAt<float>(0, 0, placeholder, 0), outputs[0]->ptrAt<float>(0, 0, image_at_, 0),
+                        row_size * replace_s);
+                image_at_ = placeholder;
+            } else {
+                setBytesSaved(row_size * replace_s);
+            }
+            // only the text rows around the image move
+            memcpy(outputs[0]->ptrAt<float>(0, 0, 0, 0), dest_input->ptrAt<float>(0, 0, 0, 0), row_size * placeholder);
+            memcpy(outputs[0]->ptrAt<float>(0, 0, placeholder + replace_s, 0), dest_input->ptrAt<float>(0, 0, placeholder + 1, 0),
+                   row_size * (dest_input->sequence() - placeholder - 1));
+            return Op::execute(inputs, outputs);
+        }
+    }
     auto start_dest_seq = 0;
     int in0_d = 0;
     int in1_batch = 0;
@@ -74,5 +95,21 @@ ErrorCode CPUReplace::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_p
     memcpy(dst_ptr, src_ptr, sizeof(float)*dest_input->dimension()*(outputs[0]->sequence()-start_dest_seq));
     return Op::execute(inputs, outputs);
 }
+
+ErrorCode CPUReplace::setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    outputs[0]->setDtype(activation_dtype());
+    outputs[0]->alloc();
+    image_at_ = -1;
+    if (inputs.size() == 3 && inputs[1]->batch() == 1 && inputs[0]->sequence() > 0) {
+        auto &image = inputs[1];
+        if ((image->masterTensor() == nullptr || image->masterTensor() == outputs[0].get()) && image->dtype() == outputs[0]->dtype()) {
+            const int at = std::min(last_placeholder_, inputs[0]->sequence() - 1);
+            if (redirectInput(1, image, *outputs[0], {0, 0, at, 0})) {
+                image_at_ = at;
+            }
+        }
+    }
+    return MLLM_NO_ERROR;
+}
 } // namespace mllm
 
@@ -11,11 +11,17 @@ class CPUReplace final : public Op {
 public:
     CPUReplace(Backend *bn, string opName, int threadCount);
     ~CPUReplace() override = default;
-    ErrorCode reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-    ErrorCode execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
+    ErrorCode reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    ErrorCode execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    ErrorCode setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
 
 private:
     int thread_count = 4;
+    // With a single image, the image rows are written straight into the output at image_at_, -1 if they are not.
+    // The placeholder position is only known in execute(), so image_at_ is the one of the previous call; a
+    // different position costs a memmove of the image rows.
+    int image_at_ = -1;
+    int last_placeholder_ = 0;
 };
 
 class CPUReplaceCreator : public CPUBackend::Creator {
@@ -1,5 +1,6 @@
 
 #include "CPURoPE.hpp"
+#include "TensorAccessor.hpp"
 #include <cmath>
 
 namespace mllm {
@@ -63,11 +64,11 @@ void sinusoidal_position_embedding_huggingface(int seq_len, int output_dim, vect
 
 CPURoPE::CPURoPE(Backend *bn, string opName, int pose_type, int threadCount) :
     thread_count(threadCount),
-    Op(bn, opName) {
+    Op(bn, opName), blocks_(opName) {
     pose_type_ = pose_type;
 }
 
-ErrorCode CPURoPE::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPURoPE::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     // std::cout << name() << "  CPURoPE  reshape" << std::endl;
     assert(inputs.size() == 1);
     assert(outputs.size() == 1);
@@ -89,74 +90,70 @@ ErrorCode CPURoPE::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPURoPE::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPURoPE::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    auto &block = *blocks_;
     auto &input = inputs[0];
     auto &output = outputs[0];
+    // one team per row, each element reads its pair, sin and cos
+    const int threads = CPUBackend::threadsFor(8.0 * input->dimension(), thread_count);
+    setThreadWidth(threads);
+    TensorAccessor<float> in(*input);
+    TensorAccessor<float> out_f32(*output);
+    TensorAccessor<mllm_fp16_t> out_f16(*output);
+    const bool aggregated = output->aggregated();
+    auto store = [&](int n, int h, int s, int d, float value) {
+        const auto type = aggregated ? output->dtypeAt(n, h, s, d) : output->dtype();
+        if (type == MLLM_TYPE_F32) {
+            out_f32(n, h, s, d) = value;
+        } else if (type == MLLM_TYPE_F16) {
+            out_f16(n, h, s, d) = MLLM_FP32_TO_FP16(value);
+        }
+    };
     for (int n = 0; n < input->batch(); ++n) {
         for (int h = 0; h < input->head(); ++h) {
             for (int s = 0; s < input->sequence(); ++s) { // sequance
-#pragma omp parallel for num_threads(thread_count)
+#pragma omp parallel for num_threads(threads)
                 for (int d = 0; d < input->dimension(); ++d) {
                     if (pose_type_ == LLAMAROPE) {
-                        float in_value = input->dataAt<float>(n, h, s, d);
+                        float in_value = in(n, h, s, d);
                         float in_value_2;
                         if (d % 2 == 0) { // if is even number: 0,2,4
-                            in_value_2 = -input->dataAt<float>(n, h, s, d + 1);
+                            in_value_2 = -in(n, h, s, d + 1);
                         } else {
-                            in_value_2 = input->dataAt<float>(n, h, s, d - 1);
+                            in_value_2 = in(n, h, s, d - 1);
                         }
-                        float sin_value = sin_[s + h_cnt_][d];
-                        float cos_value = cos_[s + h_cnt_][d];
+                        float sin_value = sin_[s + block.h_cnt][d];
+                        float cos_value = cos_[s + block.h_cnt][d];
                         auto value = in_value * cos_value + in_value_2 * sin_value;
-                        if (output->dtypeAt(n, h, s, d) == MLLM_TYPE_F32) {
-                            output->setDataAt<float>(n, h, s, d, value);
-                        } else if (output->dtypeAt(n, h, s, d) == MLLM_TYPE_F16) {
-                            output->setDataAt<mllm_fp16_t>(n, h, s, d, MLLM_FP32_TO_FP16(value));
-                        }
+                        store(n, h, s, d, value);
                     } else if (pose_type_ == PERSIMMONROPE) {
-                        float in_value = input->dataAt<float>(n, h, s, d);
+                        float in_value = in(n, h, s, d);
                         float in_value_2;
-                        float sin_value = sin_[s + h_cnt_][d];
-                        float cos_value = cos_[s + h_cnt_][d];
+                        float sin_value = sin_[s + block.h_cnt][d];
+                        float cos_value = cos_[s + block.h_cnt][d];
                         if (d < input->dimension() / 4) {
-                            in_value_2 = -input->dataAt<float>(n, h, s, d + input->dimension() / 4);
+                            in_value_2 = -in(n, h, s, d + input->dimension() / 4);
                             auto value = in_value * cos_value + in_value_2 * sin_value;
-                            if (output->dtypeAt(n, h, s, d) == MLLM_TYPE_F32) {
-                                output->setDataAt<float>(n, h, s, d, value);
-                            } else if (output->dtypeAt(n, h, s, d) == MLLM_TYPE_F16) {
-                                output->setDataAt<mllm_fp16_t>(n, h, s, d, MLLM_FP32_TO_FP16(value));
-                            }
+                            store(n, h, s, d, value);
                         } else if (d < input->dimension() / 2) {
-                            in_value_2 = input->dataAt<float>(n, h, s, d - input->dimension() / 4);
+                            in_value_2 = in(n, h, s, d - input->dimension() / 4);
                             auto value = in_value * cos_value + in_value_2 * sin_value;
-                            if (output->dtypeAt(n, h, s, d) == MLLM_TYPE_F32) {
-                                output->setDataAt<float>(n, h, s, d, value);
-                            } else if (output->dtypeAt(n, h, s, d) == MLLM_TYPE_F16) {
-                                output->setDataAt<mllm_fp16_t>(n, h, s, d, MLLM_FP32_TO_FP16(value));
-                            }
+                            store(n, h, s, d, value);
                         } else {
-                            if (output->dtypeAt(n, h, s, d) == MLLM_TYPE_F32) {
-                                output->setDataAt<float>(n, h, s, d, in_value);
-                            } else if (output->dtypeAt(n, h, s, d) == MLLM_TYPE_F16) {
-                                output->setDataAt<mllm_fp16_t>(n, h, s, d, MLLM_FP32_TO_FP16(in_value));
-                            }
+                            store(n, h, s, d, in_value);
                         }
                     } else if (pose_type_ == HFHUBROPE) {
-                        float in_value = input->dataAt<float>(n, h, s, d);
+                        float in_value = in(n, h, s, d);
                         float in_value_2;
                         if (d < input->dimension() / 2) {
-                            in_value_2 = -input->dataAt<float>(n, h, s, d + input->dimension() / 2);
+                            in_value_2 = -in(n, h, s, d + input->dimension() / 2);
                         } else {
-                            in_value_2 = input->dataAt<float>(n, h, s, d - input->dimension() / 2);
+                            in_value_2 = in(n, h, s, d - input->dimension() / 2);
                         }
-                        float sin_value = sin_[s + h_cnt_][d];
-                        float cos_value = cos_[s + h_cnt_][d];
+                        float sin_value = sin_[s + block.h_cnt][d];
+                        float cos_value = cos_[s + block.h_cnt][d];
                         auto value = in_value * cos_value + in_value_2 * sin_value;
-                        if (output->dtypeAt(n, h, s, d) == MLLM_TYPE_F32) {
-                            output->setDataAt<float>(n, h, s, d, value);
-                        } else if (output->dtypeAt(n, h, s, d) == MLLM_TYPE_F16) {
-                            output->setDataAt<mllm_fp16_t>(n, h, s, d, MLLM_FP32_TO_FP16(value));
-                        }
+                        store(n, h, s, d, value);
                     } else {
                         std::cerr << "RoPE type error" << std::endl;
                     }
@@ -164,9 +161,9 @@ ErrorCode CPURoPE::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<
             }
         }
     }
-    h_cnt_ += input->sequence();
-    if (h_cnt_ > pos_max_) {
-        h_cnt_ = 0;
+    block.h_cnt += input->sequence();
+    if (block.h_cnt > pos_max_) {
+        block.h_cnt = 0;
     }
     return Op::execute(inputs, outputs);
 }
@@ -174,7 +171,7 @@ ErrorCode CPURoPE::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<
 ErrorCode CPURoPE::load(AbstructLoader &loader) {
     return Op::load(loader);
 }
-ErrorCode CPURoPE::free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPURoPE::free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     return Op::free(inputs, outputs);
 }
 } // namespace mllm
@@ -10,10 +10,23 @@ class CPURoPE final : public Op {
 public:
     CPURoPE(Backend *bn, string opName, int pose_type, int threadCount);
     virtual ~CPURoPE() = default;
-    virtual ErrorCode reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
+    virtual ErrorCode reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
     virtual ErrorCode load(AbstructLoader &loader) override;
-    virtual ErrorCode execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
-    virtual ErrorCode free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) override;
+    virtual ErrorCode execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual ErrorCode free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) override;
+    virtual void saveState(SequenceState &state) override {
+        state.position = blocks_->h_cnt;
+    }
+    virtual void restoreState(const SequenceState &state) override {
+        blocks_->h_cnt = state.position;
+    }
+    int addBlock(const string &name) override {
+        return blocks_.add(name);
+    }
+    void bindBlock(int block) override {
+        blocks_.bind(block);
+        setName(blocks_.name(block));
+    }
 
 
 private:
@@ -24,7 +37,11 @@ private:
     static vector<vector<float>> cos_;
     static int global_pose_type_;
     static int ishape_old;
-    int h_cnt_ = 0;
+    // the position of one block, see Op::addBlock
+    struct Block {
+        int h_cnt = 0;
+    };
+    BlockStates<Block> blocks_;
     int pos_max_ ;
     int pose_type_ =4;
     int ishape;
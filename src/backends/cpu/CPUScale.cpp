@@ -1,5 +1,6 @@
 
 #include "CPUScale.hpp"
+#include "TensorAccessor.hpp"
 
 namespace mllm {
 
@@ -13,7 +14,7 @@ CPUScale::CPUScale(Backend *bn, string opName, float scale, float bias, bool bia
     thread_count = threadCount;
 }
 
-ErrorCode CPUScale::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUScale::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     assert(inputs.size() == 1);
     assert(outputs.size() == 1);
@@ -22,7 +23,7 @@ ErrorCode CPUScale::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPUScale::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUScale::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     auto & input = inputs[0];
     auto & output = outputs[0];
@@ -30,7 +31,9 @@ ErrorCode CPUScale::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr
         auto copy_size = input->batch() * input->head() * input->sequence() * input->dimension();
         auto in_ptr = inputs[0]->hostPtr<float>();
         auto out_ptr = outputs[0]->hostPtr<float>();
-#pragma omp parallel for num_threads(thread_count)
+        const int threads = CPUBackend::threadsFor(copy_size, thread_count);
+        setThreadWidth(threads);
+#pragma omp parallel for num_threads(threads)
         for (int is = 0; is < copy_size; ++is) {
             if(bias_after_scale_) {
                 out_ptr[is] = in_ptr[is] * scale_ + bias_;
@@ -39,18 +42,22 @@ ErrorCode CPUScale::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr
             }
         }
     }else {
+        const int threads = CPUBackend::threadsFor(4.0 * input->dimension(), thread_count);
+        setThreadWidth(threads);
+        TensorAccessor<float> in(*input);
+        TensorAccessor<float> out(*output);
         for(int n = 0; n<input->batch(); ++n){
             for(int c = 0; c<input->head(); ++c){
                 for(int h = 0; h<input->sequence(); ++h){
-#pragma omp parallel for num_threads(thread_count)
+#pragma omp parallel for num_threads(threads)
                     for(int w = 0; w<input->dimension(); ++w){
-                        float value = input->dataAt<float>(n, c, h, w);
+                        float value = in(n, c, h, w);
                         if(bias_after_scale_){
                             value = value * scale_ + bias_;
                         }else{
                             value = (value + bias_) * scale_;
                         }
-                        output->setDataAt<float>(n, c, h, w, value);
+                        out(n, c, h, w) = value;
                     }
                 }
             }
@@ -59,7 +66,7 @@ ErrorCode CPUScale::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr
     return Op::execute(inputs, outputs);
 }
 
-ErrorCode CPUScale::setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUScale::setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     assert(inputs.size() == 1);
     assert(outputs.size() == 1);
     // outputs[0]->deepCopyFrom(inputs[0]);
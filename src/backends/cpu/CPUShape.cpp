@@ -8,7 +8,7 @@ CPUShape::CPUShape(Backend *bn,  string opName,Chl axis, int threadCount) : thre
     axis_ = axis;
 }
 
-ErrorCode CPUShape::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUShape::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     int dim = 1;
     if (inputs[0]->ctype() == BTHWC || inputs[0]->ctype() == BCTHW) {
         switch (axis_) {
@@ -63,7 +63,7 @@ ErrorCode CPUShape::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPUShape::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUShape::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     outputs[0]->setDataAt<float>(0,0,0,0, outputs[0]->sequence());
     return Op::execute(inputs, outputs);
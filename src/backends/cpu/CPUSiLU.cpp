@@ -7,26 +7,26 @@ namespace mllm {
 
 CPUSiLU::CPUSiLU(Backend *bn, string opName, int threadCount) : thread_count(threadCount),
     Op(bn, opName) {
-    if (!init_table_silu_f16_flag) {
-        init_table_silu_f16();
-        init_table_silu_f16_flag = true;
-    }
+    init_table_silu_f16();
 }
 
-ErrorCode CPUSiLU::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUSiLU::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     outputs[0]->reshape(inputs[0]->batch(), inputs[0]->head(), inputs[0]->sequence(), inputs[0]->dimension());
     //outputs[0]->setDtype(activationDtype());
 
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPUSiLU::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
-    auto input = inputs[0];
+ErrorCode CPUSiLU::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    auto &input = inputs[0];
     int batch = input->batch();
     int n1 = input->head();
     int n2 = input->sequence();
     int n3 = input->dimension();
-#pragma omp parallel for collapse(3) num_threads(thread_count)
+    // table lookups: about two operations per element
+    const int threads = CPUBackend::threadsFor(2.0 * input->count(), thread_count);
+    setThreadWidth(threads);
+#pragma omp parallel for collapse(3) num_threads(threads)
     for (int n = 0; n < batch; n++) {
         for (int h = 0; h < n2; h++) {
             for (int c = 0; c < n1; c++) {
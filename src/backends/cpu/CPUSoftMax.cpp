@@ -1,35 +1,19 @@
 
 #include "CPUSoftMax.hpp"
+#include "TensorAccessor.hpp"
 #include <cmath>
 #include "quantize/Quantize.hpp"
 #include "compute/VecDot.hpp"
+#include "compute/Tuning.hpp"
 namespace mllm {
 
-//static mllm_fp16_t table_exp_f16[1 << 16];
-//static bool init_table_exp_f16_flag = false;
-//void init_table_exp_f16() {
-//    mllm_fp16_t ii;
-//    for (int i = 0; i < (1 << 16); ++i) {
-//        uint16_t ui = i;
-//        memcpy(&ii, &ui, sizeof(ii));
-//        const float f = MLLM_COMPUTE_FP16_TO_FP32(ii);
-//        table_exp_f16[i] = MLLM_FP32_TO_FP16(expf(f));
-//        //        float val = MLLM_FP16_TO_FP32(expf(f));
-//        //        std::cout<<i<<"  "<<f<<" "<<expf(f)<<"  "<<val<<std::endl;
-//        //        printf("%d  %f %f  %f\n", i, f, expf(f), val);
-//    }
-//}
-
 CPUSoftMax::CPUSoftMax(Backend *bn, string opName, int axis, int threadCount) : thread_count(threadCount),
     Op(bn, opName) {
     axis_ = axis;
-    if (!init_table_exp_f16_flag) {
-        init_table_exp_f16();
-        init_table_exp_f16_flag = true;
-    }
+    init_table_exp_f16();
 }
 
-ErrorCode CPUSoftMax::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUSoftMax::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     // std::cout << name() << "  CPUSoftMax  reshape" << std::endl;
     assert(inputs.size() == 1);
     outputs[0]->reshape(inputs[0]->batch(), inputs[0]->head(), inputs[0]->sequence(), inputs[0]->dimension());
@@ -62,30 +46,37 @@ inline static void vec_scale_f32(const int n, float *y, const float v) {
     //    }
 }
 
-ErrorCode CPUSoftMax::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUSoftMax::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     // std::cout << name() << "  CPUSoftMax()" << std::endl;
     auto &input = inputs[0];
     auto &output = outputs[0];
 
     if (axis_ == DIMENSION) {
+        // max, exp lookup and scale: about eight operations per element
+        const int threads = CPUBackend::threadsFor(8.0 * input->head() * input->sequence() * input->dimension(), thread_count);
+        setThreadWidth(threads);
+        const int chunk = kernelParams().softmax_chunk;
+        TensorAccessor<float> in(*input);
+        TensorAccessor<float> out(*output);
         for (int n = 0; n < input->batch(); ++n) {
-            #pragma omp parallel for num_threads(thread_count)
+            #pragma omp parallel for collapse(2) num_threads(threads) schedule(static, chunk)
             for (int h = 0; h < input->head(); ++h) {
                 for (int s = 0; s < input->sequence(); ++s) {
                     int num_classes = input->dimension(); // 获取类别数量
                     float max = -INFINITY;
                     // #pragma omp parallel for num_threads(thread_count)
                     for (int j = 0; j < num_classes; ++j) {
-                        max = MAX(max, input->dataAt<float>(n, h, s, j));
+                        max = MAX(max, in(n, h, s, j));
                     }
-                    float *dp = output->ptrAt<float>(n, h, s, 0);
+                    float *dp = out.ptr(n, h, s, 0);
                     double sum = 0.0;
                     uint16_t scvt;
                     for (int i = 0; i < num_classes; i++) {
-                        if (input->dataAt<float>(n, h, s, i) == -INFINITY) {
+                        const float x = in(n, h, s, i);
+                        if (x == -INFINITY) {
                             dp[i] = 0.0F;
                         } else {
-                            mllm_fp16_t tmp = MLLM_FP32_TO_FP16(input->dataAt<float>(n, h, s, i) - max);
+                            mllm_fp16_t tmp = MLLM_FP32_TO_FP16(x - max);
                             memcpy(&scvt, &tmp, sizeof(scvt));
                             const float val = MLLM_FP16_TO_FP32(table_exp_f16[scvt]);
                             sum += (double)val;
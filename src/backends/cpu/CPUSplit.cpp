@@ -9,7 +9,7 @@ CPUSplit::CPUSplit(Backend *bn,  string opName,  int splitNum, Chl splitDim, int
     split_dim_size_ =  splitDimSize;
 }
 
-ErrorCode CPUSplit::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUSplit::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     assert(split_num_ == outputs.size());
     assert(inputs.size() == 1);
@@ -57,12 +57,12 @@ ErrorCode CPUSplit::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPUSplit::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUSplit::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     return Op::execute(inputs, outputs);
 }
 
-ErrorCode CPUSplit::setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUSplit::setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     return Op::setUp(inputs, outputs);
 }
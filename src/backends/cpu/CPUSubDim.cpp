@@ -11,9 +11,9 @@ CPUSubDim::CPUSubDim(Backend *bn,  string opName,Chl dim, vector<int> interval,
     end_d_ = interval[1];
 }
 
-ErrorCode CPUSubDim::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUSubDim::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
-    auto input = inputs[0];
+    auto &input = inputs[0];
     switch (dim_) {
     case BATCH: {
         if(inputs.size() == 2) {
@@ -85,10 +85,10 @@ ErrorCode CPUSubDim::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_pt
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPUSubDim::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUSubDim::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
-    auto input = inputs[0];
-    auto output = outputs[0];
+    auto &input = inputs[0];
+    auto &output = outputs[0];
     switch (dim_) {
     case BATCH: {
         std::cout<<"Nor Support"<<std::endl;
@@ -9,7 +9,7 @@ CPUTranspose::CPUTranspose(Backend *bn,  string opName, int axis0, int axis1, in
     axis1_ = (Chl)axis1;
 }
 
-ErrorCode CPUTranspose::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUTranspose::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     // inputs[0]->transShape(SEQUENCE, DIMENSION);
     if(axis0_ == SEQUENCE && axis1_ == DIMENSION) {
@@ -35,17 +35,17 @@ ErrorCode CPUTranspose::load(AbstructLoader &loader) {
     return Op::load(loader);
 }
 
-ErrorCode CPUTranspose::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUTranspose::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     return Op::execute(inputs, outputs);
 }
 
-ErrorCode CPUTranspose::free(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUTranspose::free(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     return Op::free(inputs, outputs);
 }
 
-ErrorCode CPUTranspose::setUp(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUTranspose::setUp(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
 
     // return Op::setUp(inputs, outputs);
     if(inputs[0]->masterTensor() == nullptr) {
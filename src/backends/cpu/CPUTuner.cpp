@@ -0,0 +1,198 @@
+#include "CPUTuner.hpp"
+#include "CPUSoftMax.hpp"
+#include "compute/Matmul.hpp"
+#include "quantize/QuantizeQ4.hpp"
+#include "quantize/QuantizeQ6.hpp"
+#include "quantize/QuantizeQ8.hpp"
+#include <chrono>
+#include <random>
+#include <set>
+
+namespace mllm {
+
+// the benchmark weights keep the real in_features but are cut to this many rows
+#define TUNE_MAX_ROWS 2048
+// distinct Linear shapes benchmarked per weight type
+#define TUNE_MAX_SHAPES 4
+
+static double bestTimeMs(const std::function<void()> &fn, int reps = 3) {
+    double best = 0;
+    for (int r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (r == 0 || ms < best) {
+            best = ms;
+        }
+    }
+    return best;
+}
+
+static void fillRandom(float *x, int64_t n, std::mt19937 &rng) {
+    std::uniform_real_distribution<float> dist(-1.0F, 1.0F);
+    for (int64_t i = 0; i < n; ++i) {
+        x[i] = dist(rng);
+    }
+}
+
+static void fillWeight(Tensor &w, int K, int N, std::mt19937 &rng) {
+    vector<float> row(K);
+    const size_t row_size = DataTypeSize(w.dtype(), K);
+    for (int n = 0; n < N; ++n) {
+        fillRandom(row.data(), K, rng);
+        char *dst = w.hostPtr<char>() + row_size * n;
+        switch (w.dtype()) {
+        case MLLM_TYPE_F32:
+            memcpy(dst, row.data(), row_size);
+            break;
+        case MLLM_TYPE_Q4_0:
+            quantize_row_q4_0(row.data(), dst, K);
+            break;
+        case MLLM_TYPE_Q4_K:
+            quantize_row_q4_K(row.data(), dst, K);
+            break;
+        case MLLM_TYPE_Q6_K:
+            quantize_row_q6_K(row.data(), dst, K);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static void linear(Tensor *x, Tensor *w, Tensor *y, int thread_count) {
+    switch (w->dtype()) {
+    case MLLM_TYPE_F32:
+        mat_mul_fp32(x, w, y, false, nullptr, false, true, thread_count);
+        break;
+    case MLLM_TYPE_Q4_0:
+        mat_mul_fp32_q4_0(x, w, y, false, nullptr, thread_count);
+        break;
+    case MLLM_TYPE_Q4_K:
+        mat_mul_fp32_q4_K(x, w, y, false, nullptr, thread_count);
+        break;
+    case MLLM_TYPE_Q6_K:
+        mat_mul_fp32_q6_K(x, w, y, false, nullptr, thread_count);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * \brief time `run` with every candidate value of `param` and keep the fastest one.
+ * \param gflop work of one run, 0 if a throughput is not meaningful.
+ */
+static void sweep(const string &name, int &param, const vector<int> &candidates, const std::function<void()> &run, double gflop) {
+    const int default_value = param;
+    run(); // warm up caches and the thread pool
+    const double default_ms = bestTimeMs(run);
+    int best = default_value;
+    double best_ms = default_ms;
+    for (int candidate : candidates) {
+        if (candidate == default_value) {
+            continue;
+        }
+        param = candidate;
+        const double ms = bestTimeMs(run);
+        if (ms < best_ms) {
+            best = candidate;
+            best_ms = ms;
+        }
+    }
+    param = best;
+    std::cout << "[tune] " << name << ": default " << default_value << " " << default_ms << " ms";
+    if (gflop > 0) {
+        std::cout << " (" << gflop / default_ms * 1e3 << " GFLOP/s)";
+    }
+    std::cout << ", tuned " << best << " " << best_ms << " ms";
+    if (gflop > 0) {
+        std::cout << " (" << gflop / best_ms * 1e3 << " GFLOP/s)";
+    }
+    std::cout << ", x" << default_ms / best_ms << std::endl;
+}
+
+void CPUTuner::tune(Backend *bn, const vector<LinearShape> &shapes, int seq, int thread_count) {
+    std::mt19937 rng(0);
+    auto &params = kernelParams();
+    int max_k = 0;
+
+    // mat_mul_*: dst columns per OpenMP task, for every weight type of the model
+    for (auto type : {MLLM_TYPE_F32, MLLM_TYPE_Q4_0, MLLM_TYPE_Q4_K, MLLM_TYPE_Q6_K}) {
+        std::set<std::pair<int, int>> kn;
+        for (const auto &shape : shapes) {
+            if (shape.type == type && kn.size() < TUNE_MAX_SHAPES) {
+                kn.insert({shape.in_features, std::min(shape.out_features, TUNE_MAX_ROWS)});
+            }
+        }
+        if (kn.empty()) {
+            continue;
+        }
+        vector<shared_ptr<Tensor>> xs, ws, ys;
+        double gflop = 0;
+        for (const auto &s : kn) {
+            const int K = s.first;
+            const int N = s.second;
+            max_k = std::max(max_k, K);
+            auto x = std::make_shared<Tensor>(bn);
+            x->reshape(1, 1, seq, K);
+            x->setDtype(MLLM_TYPE_F32);
+            x->alloc();
+            fillRandom(x->hostPtr<float>(), x->count(), rng);
+            auto w = std::make_shared<Tensor>(bn);
+            w->reshape(1, 1, N, K);
+            w->setDtype(type);
+            w->alloc();
+            fillWeight(*w, K, N, rng);
+            auto y = std::make_shared<Tensor>(bn);
+            y->reshape(1, 1, seq, N);
+            y->setDtype(MLLM_TYPE_F32);
+            y->alloc();
+            xs.push_back(x);
+            ws.push_back(w);
+            ys.push_back(y);
+            gflop += 2.0 * seq * K * N / 1e9;
+        }
+        auto run = [&]() {
+            for (size_t i = 0; i < xs.size(); ++i) {
+                linear(xs[i].get(), ws[i].get(), ys[i].get(), thread_count);
+            }
+        };
+        sweep("matmul_blck_0." + DataTypeName(type), params.matmul_blck_0[type], {4, 8, 16, 32, 64, 128}, run, gflop);
+    }
+
+    // activation rows quantized to Q8 per OpenMP task
+    if (max_k > 0 && max_k % QK_K == 0) {
+        vector<float> x((size_t)seq * max_k);
+        fillRandom(x.data(), x.size(), rng);
+        const size_t row_size = DataTypeSize(MLLM_TYPE_Q8_K, max_k);
+        vector<char> q(row_size * seq);
+        auto run = [&]() {
+            for (int rep = 0; rep < 16; ++rep) {
+#pragma omp parallel for num_threads(thread_count) schedule(static, kernelParams().quantize_chunk)
+                for (int s = 0; s < seq; s++) {
+                    quantize_row_q8_K(x.data() + (size_t)s * max_k, q.data() + row_size * s, max_k);
+                }
+            }
+        };
+        sweep("quantize_chunk", params.quantize_chunk, {1, 2, 4, 8, 16}, run, 0);
+    }
+
+    // rows of an attention SoftMax per OpenMP task
+    auto scores = std::make_shared<Tensor>(bn);
+    auto probs = std::make_shared<Tensor>(bn);
+    scores->reshape(1, 32, seq, seq);
+    scores->setDtype(MLLM_TYPE_F32);
+    scores->alloc();
+    fillRandom(scores->hostPtr<float>(), scores->count(), rng);
+    CPUSoftMax softmax(bn, "tune.softmax", DIMENSION, thread_count);
+    softmax.reshape({scores}, {probs});
+    softmax.setUp({scores}, {probs});
+    auto run = [&]() {
+        for (int rep = 0; rep < 16; ++rep) {
+            softmax.execute({scores}, {probs});
+        }
+    };
+    sweep("softmax_chunk", params.softmax_chunk, {1, 2, 4, 8, 16}, run, 0);
+}
+} // namespace mllm
@@ -0,0 +1,31 @@
+#ifndef MLLM_CPUTUNER_H
+#define MLLM_CPUTUNER_H
+
+#include "Backend.hpp"
+#include "Types.hpp"
+#include "compute/Tuning.hpp"
+
+namespace mllm {
+/**
+ * \brief finds the kernel parameters of compute/Tuning.hpp that are fastest on this machine.
+ */
+class CPUTuner {
+public:
+    struct LinearShape {
+        int in_features;
+        int out_features;
+        DataType type; // weight type
+    };
+    /**
+     * \brief sweep the tunable parameters and keep the fastest values in kernelParams().
+     * The default and the tuned time of every parameter are printed.
+     * \param bn            backend the benchmark tensors are allocated on.
+     * \param shapes        the Linear layers of the model; their weights are replaced with random data.
+     * \param seq           number of tokens the layers are benchmarked with (a prefill chunk).
+     * \param thread_count  number of threads the model runs with.
+     */
+    static void tune(Backend *bn, const vector<LinearShape> &shapes, int seq, int thread_count);
+};
+} // namespace mllm
+
+#endif // MLLM_CPUTUNER_H
@@ -1,5 +1,7 @@
 
 #include "CPUWhere.hpp"
+#include "TensorAccessor.hpp"
+#include "compute/Reduce.hpp"
 
 namespace mllm {
 
@@ -10,74 +12,61 @@ CPUWhere::CPUWhere(Backend *bn, string opName, float data, int axis, int threadC
     axis_ = (Chl)axis;
 }
 
-ErrorCode CPUWhere::reshape(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
+ErrorCode CPUWhere::reshape(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
     return Op::reshape(inputs, outputs);
 }
 
-ErrorCode CPUWhere::execute(vector<shared_ptr<Tensor>> inputs, vector<shared_ptr<Tensor>> outputs) {
-    vector<float> b_vec = {};
-    vector<float> s_vec = {};
-    vector<float> h_vec = {};
-    vector<float> d_vec = {};
-#pragma omp parallel for collapse(4) num_threads(thread_count)
-    for (int b = 0; b < inputs[0]->batch(); b++) {
-        for (auto s = 0; s < inputs[0]->sequence(); s++) {
-            for (auto h = 0; h < inputs[0]->head(); h++) {
-                for (auto d = 0; d < inputs[0]->dimension(); d++) {
-                    if (inputs[0]->dataAt<float>(b, h, h, s) == data_) {
-                        b_vec.push_back(b);
-                        s_vec.push_back(s);
-                        h_vec.push_back(h);
-                        d_vec.push_back(d);
-                    }
-                }
-            }
-        }
+ErrorCode CPUWhere::execute(const vector<shared_ptr<Tensor>> &inputs, const vector<shared_ptr<Tensor>> &outputs) {
+    auto &input = inputs[0];
+    auto &output = outputs[0];
+    const int batch = input->batch();
+    const int head = input->head();
+    const int seq = input->sequence();
+    const int dim = input->dimension();
+    // the positions are reported batch first, then sequence, head and dimension
+    const int rows = batch * seq * head;
+    const int threads = CPUBackend::threadsFor((double)rows * dim, thread_count);
+    setThreadWidth(threads);
+    TensorAccessor<float> in(*input);
+    // first[row]: index in the output of the first match of the row
+    vector<int> first(rows + 1, 0);
+#pragma omp parallel for num_threads(threads)
+    for (int row = 0; row < rows; ++row) {
+        const int b = row / (seq * head);
+        const int s = row / head % seq;
+        const int h = row % head;
+        const float count = in.contiguousRows() ? reduce_row(REDUCE_COUNT, dim, in.ptr(b, h, s, 0), data_) :
+                                                  reduce_row(REDUCE_COUNT, *input, b, h, s, data_);
+        first[row + 1] = (int)count;
+    }
+    for (int row = 0; row < rows; ++row) {
+        first[row + 1] += first[row];
     }
-    int num = b_vec.size();
-    if ((int)axis_ == -1) {
-        outputs[0]->reshape(1, 1, 4, num);
-        outputs[0]->setDtype(activation_dtype());
-        outputs[0]->alloc();
-        for (int i = 0; i < 4; ++i) {
-            auto dest_ptr = outputs[0]->hostPtr<float>() + outputs[0]->offset(0, 0, i, 0);
-            switch (i) {
-            case 0:
-                memcpy(dest_ptr, b_vec.data(), num * sizeof(float));
-                break;
-            case 1:
-                memcpy(dest_ptr, h_vec.data(), num * sizeof(float));
-                break;
-            case 2:
-                memcpy(dest_ptr, s_vec.data(), num * sizeof(float));
-                break;
-            case 3:
-                memcpy(dest_ptr, d_vec.data(), num * sizeof(float));
-                break;
-            default:
-                break;
+    const int num = first[rows];
+    const bool all_axes = (int)axis_ == -1;
+    output->reshape(1, 1, all_axes ? 4 : 1, num);
+    output->setDtype(activation_dtype());
+    output->alloc();
+    TensorAccessor<float> out(*output);
+#pragma omp parallel for num_threads(threads)
+    for (int row = 0; row < rows; ++row) {
+        const int b = row / (seq * head);
+        const int s = row / head % seq;
+        const int h = row % head;
+        int k = first[row];
+        for (int d = 0; k < first[row + 1]; d++) {
+            if (in(b, h, s, d) != data_) {
+                continue;
             }
-        }
-    } else {
-        outputs[0]->reshape(1, 1, 1, num);
-        outputs[0]->setDtype(activation_dtype());
-        outputs[0]->alloc();
-        auto dest_ptr = outputs[0]->hostPtr<float>();
-        switch (axis_) {
-        case BATCH:
-            memcpy(dest_ptr, b_vec.data(), num * sizeof(float));
-            break;
-        case HEAD:
-            memcpy(dest_ptr, h_vec.data(), num * sizeof(float));
-            break;
-        case SEQUENCE:
-            memcpy(dest_ptr, s_vec.data(), num * sizeof(float));
-            break;
-        case DIMENSION:
-            memcpy(dest_ptr, d_vec.data(), num * sizeof(float));
-            break;
-        default:
-            break;
+            const float position[4] = {(float)b, (float)h, (float)s, (float)d};
+            if (all_axes) {
+                for (int i = 0; i < 4; ++i) {
+                    out(0, 0, i, k) = position[i];
+                }
+            } else {
+                out(0, 0, 0, k) = position[axis_];
+            }
+            ++k;
         }
     }
     return Op::execute(inputs, outputs);
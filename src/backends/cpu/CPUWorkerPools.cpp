@@ -0,0 +1,301 @@
+#include "CPUWorkerPools.hpp"
+#include "compute/Numa.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <omp.h>
+#include <string>
+#include <thread>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace mllm {
+
+static std::mutex config_mutex;
+// the CPUs of the process when first configured
+static std::vector<int> machine_cpus;
+// the ones of its power mode
+static std::vector<int> process_cpus;
+static std::atomic<int> process_cpu_count(0);
+static std::atomic<int> power_mode(BackendConfig::Power_Normal);
+static std::vector<int> phase_cpus[CPUWorkerPools::PHASE_COUNT];
+static std::atomic<bool> split_enabled(false);
+// what configure() was last asked for, checked by require()
+static bool configured = false;
+static int configured_decode_cpus = 0;
+static BackendConfig::PowerMode configured_power = BackendConfig::Power_Normal;
+// threads currently in a Scope of each phase, changed under config_mutex
+static std::atomic<int> phase_active[CPUWorkerPools::PHASE_COUNT];
+// bumped whenever the CPUs a busy phase may use change, so that its threads re-pin
+static std::atomic<unsigned> generation(0);
+static std::atomic<unsigned long> pin_count(0);
+
+struct ThreadPhase {
+    bool in_scope = false;
+    // limit and generation are up to date
+    bool known = false;
+    CPUWorkerPools::Phase phase = CPUWorkerPools::PREFILL;
+    unsigned generation = 0;
+    int limit = 0;
+    // the CPUs the thread and its team were last pinned to, sorted, and the width of that team
+    std::vector<int> pinned;
+    int pinned_width = 0;
+    // reused for the CPUs of the phase, so that entering a Scope does not allocate
+    std::vector<int> scratch;
+};
+static thread_local ThreadPhase current;
+
+static std::vector<int> processCpus() {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        for (int cpu = 0; cpu < (int)std::thread::hardware_concurrency(); ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// relative performance of a CPU on big.LITTLE kernels, else its top frequency; 0 if unknown
+static long cpuCapacity(int cpu) {
+#ifdef __linux__
+    const std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    for (const char *file : {"/cpu_capacity", "/cpufreq/cpuinfo_max_freq"}) {
+        std::ifstream in(dir + file);
+        long value = 0;
+        if (in >> value) {
+            return value;
+        }
+    }
+#endif
+    return 0;
+}
+
+std::vector<int> CPUWorkerPools::powerCpus(const std::vector<int> &cpus, const std::vector<long> &capacity,
+                                           BackendConfig::PowerMode power) {
+    if (power == BackendConfig::Power_Normal) {
+        return cpus;
+    }
+    std::vector<size_t> order(cpus.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return capacity[a] < capacity[b]; });
+    std::vector<int> sorted;
+    for (auto i : order) {
+        sorted.push_back(cpus[i]);
+    }
+    if (power == BackendConfig::Power_Low && !sorted.empty()) {
+        const long smallest = capacity[order.front()];
+        size_t little = 0;
+        while (little < order.size() && capacity[order[little]] == smallest) {
+            ++little;
+        }
+        // all alike: half of them
+        sorted.resize(little == sorted.size() ? std::max<size_t>(1, sorted.size() / 2) : little);
+    }
+    return sorted;
+}
+
+static bool sameCpus(std::vector<int> a, std::vector<int> b) {
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    return a == b;
+}
+
+// pins the calling thread and every thread of its OpenMP team, including the ones beyond `width` that a wider
+// region started before
+static void pinTeam(const std::vector<int> &cpus, int width) {
+    pinCurrentThread(cpus);
+#pragma omp parallel num_threads(std::max(omp_get_max_threads(), width))
+    pinCurrentThread(cpus);
+    current.pinned.assign(cpus.begin(), cpus.end());
+    std::sort(current.pinned.begin(), current.pinned.end());
+    current.pinned_width = std::max(omp_get_max_threads(), width);
+    ++pin_count;
+}
+
+// pinTeam, unless the thread and its team are already on `cpus`; sorts `cpus`
+static void repinTeam(std::vector<int> &cpus) {
+    std::sort(cpus.begin(), cpus.end());
+    const int width = (int)cpus.size();
+    if (cpus == current.pinned && std::max(omp_get_max_threads(), width) <= current.pinned_width) {
+        return;
+    }
+    pinTeam(cpus, width);
+}
+
+// the CPUs `phase` may use right now into `cpus`, see CPUWorkerPools::cpus(); called under config_mutex
+static void phaseCpusLocked(CPUWorkerPools::Phase phase, std::vector<int> &cpus) {
+    using Phase = CPUWorkerPools::Phase;
+    cpus.assign(phase_cpus[phase].begin(), phase_cpus[phase].end());
+    const Phase other = phase == Phase::PREFILL ? Phase::DECODE : Phase::PREFILL;
+    if (phase_active[other] == 0) {
+        cpus.insert(cpus.end(), phase_cpus[other].begin(), phase_cpus[other].end());
+    }
+}
+
+static void configureLocked(int decode_cpus, BackendConfig::PowerMode power, const std::vector<int> &process) {
+    using Phase = CPUWorkerPools::Phase;
+    configured = true;
+    configured_decode_cpus = decode_cpus;
+    configured_power = power;
+    if (machine_cpus.empty()) {
+        machine_cpus = processCpus();
+    }
+    const auto &candidates = process.empty() ? machine_cpus : process;
+    std::vector<long> capacity(candidates.size());
+    for (size_t i = 0; i < candidates.size() && power != BackendConfig::Power_Normal; ++i) {
+        capacity[i] = cpuCapacity(candidates[i]);
+    }
+    auto cpus = CPUWorkerPools::powerCpus(candidates, capacity, power);
+    if (!sameCpus(cpus, process_cpus.empty() ? machine_cpus : process_cpus)) {
+        // the threads started from now on inherit the CPUs of this one
+        pinTeam(cpus, (int)cpus.size());
+    }
+#ifdef KMP_VERSION_MAJOR
+    // ms an idle worker spins before it sleeps, 200 by default (or KMP_BLOCKTIME, left alone in Power_Normal)
+    if (power != BackendConfig::Power_Normal || power_mode != BackendConfig::Power_Normal) {
+        kmp_set_blocktime(power == BackendConfig::Power_Low ? 0 : (power == BackendConfig::Power_High ? 1000 : 200));
+    }
+#else
+    static bool warned = false;
+    if (power == BackendConfig::Power_Low && std::getenv("OMP_WAIT_POLICY") == nullptr && !warned) {
+        std::cerr << "Power_Low: set OMP_WAIT_POLICY=passive so that idle OpenMP workers sleep" << std::endl;
+        warned = true;
+    }
+#endif
+    process_cpus = cpus;
+    process_cpu_count = (int)cpus.size();
+    power_mode = power;
+    // prefill keeps at least one CPU
+    if (decode_cpus <= 0 || cpus.size() < 2) {
+        split_enabled = false;
+        return;
+    }
+    if (decode_cpus > (int)cpus.size() - 1) {
+        std::cerr << "Only " << cpus.size() << " CPUs, " << cpus.size() - 1 << " of them are reserved for decode" << std::endl;
+        decode_cpus = (int)cpus.size() - 1;
+    }
+    const int prefill_cpus = (int)cpus.size() - decode_cpus;
+    phase_cpus[Phase::PREFILL].assign(cpus.begin(), cpus.begin() + prefill_cpus);
+    phase_cpus[Phase::DECODE].assign(cpus.begin() + prefill_cpus, cpus.end());
+    split_enabled = true;
+    ++generation;
+}
+
+void CPUWorkerPools::configure(int decode_cpus, BackendConfig::PowerMode power, const std::vector<int> &cpus) {
+    std::lock_guard<std::mutex> lock(config_mutex);
+    configureLocked(decode_cpus, power, cpus);
+}
+
+bool CPUWorkerPools::require(int decode_cpus, BackendConfig::PowerMode power) {
+    std::lock_guard<std::mutex> lock(config_mutex);
+    if (!configured) {
+        configureLocked(decode_cpus, power, {});
+        return true;
+    }
+    if (std::max(decode_cpus, 0) != std::max(configured_decode_cpus, 0) || power != configured_power) {
+        std::cerr << "The process already runs with " << configured_decode_cpus << " decode CPUs in power mode "
+                  << configured_power << ", keeping them over " << decode_cpus << " in power mode " << power << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool CPUWorkerPools::enabled() {
+    return split_enabled;
+}
+
+BackendConfig::PowerMode CPUWorkerPools::power() {
+    return (BackendConfig::PowerMode)power_mode.load();
+}
+
+int CPUWorkerPools::cpuCount() {
+    const int count = process_cpu_count;
+    return count > 0 ? count : (int)processCpus().size();
+}
+
+std::vector<int> CPUWorkerPools::cpus(Phase phase) {
+    std::lock_guard<std::mutex> lock(config_mutex);
+    std::vector<int> cpus;
+    phaseCpusLocked(phase, cpus);
+    return cpus;
+}
+
+unsigned long CPUWorkerPools::pinCount() {
+    return pin_count;
+}
+
+int CPUWorkerPools::threadLimit() {
+    if (!current.in_scope) {
+        return 0;
+    }
+    const unsigned now = generation;
+    if (!current.known || current.generation != now) {
+        {
+            std::lock_guard<std::mutex> lock(config_mutex);
+            phaseCpusLocked(current.phase, current.scratch);
+        }
+        current.known = true;
+        current.generation = now;
+        current.limit = (int)current.scratch.size();
+        // the team of this thread is reused by its next parallel regions, pin all of it
+        repinTeam(current.scratch);
+    }
+    return current.limit;
+}
+
+// a phase becoming busy or idle only changes what the other phase may use if that one is busy too
+static void setActive(CPUWorkerPools::Phase phase, int delta) {
+    using Phase = CPUWorkerPools::Phase;
+    std::lock_guard<std::mutex> lock(config_mutex);
+    const int before = phase_active[phase];
+    phase_active[phase] += delta;
+    const Phase other = phase == Phase::PREFILL ? Phase::DECODE : Phase::PREFILL;
+    if ((before == 0) != (phase_active[phase] == 0) && phase_active[other] > 0) {
+        ++generation;
+    }
+}
+
+CPUWorkerPools::Scope::Scope(Phase phase) :
+    active_(enabled() && !current.in_scope), phase_(phase) {
+    if (!active_) {
+        return;
+    }
+    setActive(phase, 1);
+    current.in_scope = true;
+    current.known = false;
+    current.phase = phase;
+    threadLimit();
+}
+
+CPUWorkerPools::Scope::~Scope() {
+    if (!active_) {
+        return;
+    }
+    current.in_scope = false;
+    setActive(phase_, -1);
+    {
+        std::lock_guard<std::mutex> lock(config_mutex);
+        current.scratch.assign(process_cpus.begin(), process_cpus.end());
+    }
+    // the team keeps running the thread's regions after the Scope
+    repinTeam(current.scratch);
+}
+
+} // namespace mllm
@@ -0,0 +1,90 @@
+#ifndef MLLM_CPUWORKERPOOLS_H
+#define MLLM_CPUWORKERPOOLS_H
+
+#include "Types.hpp"
+#include <vector>
+
+namespace mllm {
+/**
+ * \brief splits the CPUs between prefill and decode, so that a long prefill does not stall the decode steps
+ *        of other sessions running in the same process.
+ *
+ * Each phase owns a set of CPUs. A thread that runs a graph enters the phase of its input (Scope); it and its
+ * OpenMP team are pinned to the CPUs of the phase, and CPUBackend::threadsFor caps every op at their number.
+ * A phase with no running thread lends its CPUs to the other one: the borrowed CPUs are handed back at the
+ * next op once the owner becomes busy again.
+ */
+class CPUWorkerPools {
+public:
+    enum Phase {
+        PREFILL = 0,
+        DECODE,
+        PHASE_COUNT
+    };
+    /**
+     * \brief reserve CPUs for decode, the other CPUs the process may run on are left to prefill.
+     * The decode CPUs are the last ones, the big cores on most big.LITTLE SoCs.
+     *
+     * Outside Power_Normal, the CPUs are ordered by capacity, so that the decode CPUs are the biggest ones.
+     * Power_Low then keeps the smallest cores only (half of the CPUs if they are all alike): the calling thread
+     * and its OpenMP team are pinned to them, the threads it starts afterwards inherit them, and the teams of
+     * CPUBackend::threadsFor never get wider. It also lets idle OpenMP workers sleep at once, where the runtime
+     * allows it (libomp; libgomp only reads OMP_WAIT_POLICY at startup).
+     * The configuration is process-wide: configure() replaces it, see require() for the one of a Net.
+     * \param decode_cpus  number of CPUs for decode; 0 disables the split, so both phases use every CPU.
+     * \param power        the power mode of the process
+     * \param cpus         the CPUs to share out, the ones the process may run on if empty
+     */
+    static void configure(int decode_cpus, BackendConfig::PowerMode power = BackendConfig::Power_Normal,
+                          const std::vector<int> &cpus = {});
+    /**
+     * \brief configure() on the first call, unless configure() was called before; later calls must ask for the
+     *        configuration in place. Used by every Net, so that a second Net does not reset the first one's.
+     * \return false, leaving the configuration alone, if it differs from the one in place.
+     */
+    static bool require(int decode_cpus, BackendConfig::PowerMode power);
+    /**
+     * \brief the CPUs a power mode runs on, see configure().
+     * \param cpus      the CPUs of the process
+     * \param capacity  the capacity of each of them, as read from sysfs: cpu_capacity or cpuinfo_max_freq
+     * \return the CPUs in ascending capacity, the smallest ones only for Power_Low; `cpus` for Power_Normal.
+     */
+    static std::vector<int> powerCpus(const std::vector<int> &cpus, const std::vector<long> &capacity,
+                                      BackendConfig::PowerMode power);
+    static bool enabled();
+    static BackendConfig::PowerMode power();
+    /**
+     * \brief number of CPUs the process runs on under its power mode.
+     */
+    static int cpuCount();
+    /**
+     * \brief the CPUs a phase may use right now, its own and the ones it borrows.
+     */
+    static std::vector<int> cpus(Phase phase);
+    /**
+     * \brief number of threads the calling thread may use, 0 if it is not in a Scope.
+     * Re-pins the thread and its OpenMP team if the CPUs of its phase changed since they were last pinned.
+     */
+    static int threadLimit();
+    /**
+     * \brief number of times a thread and its OpenMP team were pinned, over all threads.
+     */
+    static unsigned long pinCount();
+
+    /**
+     * \brief the calling thread runs work of `phase` while the Scope lives. Does nothing if the split is
+     *        disabled.
+     */
+    class Scope {
+    public:
+        explicit Scope(Phase phase);
+        ~Scope();
+
+    private:
+        bool active_;
+        Phase phase_;
+    };
+};
+} // namespace mllm
+
+#endif // MLLM_CPUWORKERPOOLS_H
@@ -0,0 +1,628 @@
+#include "GEMV.hpp"
+
+#define MLLM_PREFETCH(p) __builtin_prefetch((const void *)(p), 0, 0)
+// how many Q4_0 blocks ahead of the current one are prefetched in each row
+#define GEMV_PREFETCH_BLOCKS 16
+// and how many K-quant super-blocks, a few cache lines each; not beyond the end of the row, where the other
+// rows of the pass are already streamed
+#define GEMV_K_PREFETCH_BLOCKS 8
+#define GEMV_CACHE_LINE 64
+
+#ifdef __AVX2__
+static void vec_dot_q4_0_q8_0_x4_avx(const int n, float *__restrict s, const void *__restrict vx, size_t row_size, const void *__restrict vy) {
+    const int nb = n / QK8_0;
+    assert(n % QK8_0 == 0);
+
+    const block_q8_0 *__restrict y = (const block_q8_0 *)vy;
+    const block_q4_0 *x[MLLM_GEMV_ROWS];
+    __m256 acc[MLLM_GEMV_ROWS];
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        x[r] = (const block_q4_0 *)((const char *)vx + r * row_size);
+        acc[r] = _mm256_setzero_ps();
+    }
+    const __m256i ones_u8 = _mm256_set1_epi8(1);
+    const __m256i ones_i16 = _mm256_set1_epi16(1);
+
+    for (int i = 0; i < nb; ++i) {
+        // The activation block is loaded once per pass. Weights are kept as unsigned nibbles [0, 15], so
+        // dot(x - 8, y) = dot(x, y) - 8 * sum(y), and sum(y) is shared by all the rows of the pass.
+        const __m256i by = _mm256_loadu_si256((const __m256i *)y[i].qs);
+        const __m256i ysum = _mm256_madd_epi16(_mm256_maddubs_epi16(ones_u8, by), ones_i16);
+        const __m256i ysum8 = _mm256_slli_epi32(ysum, 3);
+        const float dy = MLLM_FP16_TO_FP32(y[i].d);
+        for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+            MLLM_PREFETCH(x[r] + i + GEMV_PREFETCH_BLOCKS);
+            const __m256i bx = bytes_from_nibbles_32(x[r][i].qs);
+            const __m256i dot = _mm256_madd_epi16(_mm256_maddubs_epi16(bx, by), ones_i16);
+            const __m256 q = _mm256_cvtepi32_ps(_mm256_sub_epi32(dot, ysum8));
+            const __m256 d = _mm256_set1_ps(MLLM_FP16_TO_FP32(x[r][i].d) * dy);
+            acc[r] = _mm256_fmadd_ps(d, q, acc[r]);
+        }
+    }
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        s[r] = hsum_float_8(acc[r]);
+    }
+}
+#endif
+
+#ifdef __ARM_NEON
+static void vec_dot_q4_0_q8_0_x4_arm(const int n, float *__restrict s, const void *__restrict vx, size_t row_size, const void *__restrict vy) {
+    const int nb = n / QK8_0;
+    assert(n % QK8_0 == 0);
+
+    const block_q8_0 *__restrict y = (const block_q8_0 *)vy;
+    const block_q4_0 *x[MLLM_GEMV_ROWS];
+    float32x4_t acc[MLLM_GEMV_ROWS];
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        x[r] = (const block_q4_0 *)((const char *)vx + r * row_size);
+        acc[r] = vdupq_n_f32(0.0F);
+    }
+    const uint8x16_t m4b = vdupq_n_u8(0x0F);
+    const int8x16_t s8b = vdupq_n_s8(0x8);
+
+    for (int i = 0; i < nb; ++i) {
+        const int8x16_t y_l = vld1q_s8(y[i].qs);
+        const int8x16_t y_h = vld1q_s8(y[i].qs + 16);
+        const float dy = MLLM_FP16_TO_FP32(y[i].d);
+        for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+            MLLM_PREFETCH(x[r] + i + GEMV_PREFETCH_BLOCKS);
+            const uint8x16_t v = vld1q_u8(x[r][i].qs);
+            const int8x16_t x_l = vsubq_s8(vreinterpretq_s8_u8(vandq_u8(v, m4b)), s8b);
+            const int8x16_t x_h = vsubq_s8(vreinterpretq_s8_u8(vshrq_n_u8(v, 4)), s8b);
+#if defined(__ARM_FEATURE_DOTPROD)
+            const int32x4_t p = vdotq_s32(vdotq_s32(vdupq_n_s32(0), x_l, y_l), x_h, y_h);
+#else
+            const int16x8_t pll = vmull_s8(vget_low_s8(x_l), vget_low_s8(y_l));
+            const int16x8_t plh = vmull_s8(vget_high_s8(x_l), vget_high_s8(y_l));
+            const int16x8_t phl = vmull_s8(vget_low_s8(x_h), vget_low_s8(y_h));
+            const int16x8_t phh = vmull_s8(vget_high_s8(x_h), vget_high_s8(y_h));
+            const int32x4_t p = vaddq_s32(vaddq_s32(vpaddlq_s16(pll), vpaddlq_s16(plh)),
+                                          vaddq_s32(vpaddlq_s16(phl), vpaddlq_s16(phh)));
+#endif
+            acc[r] = vmlaq_n_f32(acc[r], vcvtq_f32_s32(p), MLLM_FP16_TO_FP32(x[r][i].d) * dy);
+        }
+    }
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        s[r] = vaddvq_f32(acc[r]);
+    }
+}
+#endif
+
+void vec_dot_q4_0_q8_0_x4(const int n, float *__restrict s, const void *__restrict vx, size_t row_size, const void *__restrict vy) {
+#ifdef __AVX2__
+    vec_dot_q4_0_q8_0_x4_avx(n, s, vx, row_size, vy);
+#elif defined(__ARM_NEON)
+    vec_dot_q4_0_q8_0_x4_arm(n, s, vx, row_size, vy);
+#else
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        vec_dot_q4_0_q8_0(n, s + r, (const char *)vx + r * row_size, vy);
+    }
+#endif
+}
+
+// MLLM_GEMV_ROWS rows per pass with vec_dot_x4, the rows left over one by one with vec_dot
+template <void (*vec_dot_x4)(const int, float *__restrict, const void *__restrict, size_t, const void *__restrict),
+          void (*vec_dot)(const int, float *__restrict, const void *__restrict, const void *__restrict)>
+static void gemv_rows(const int n, const int nr, float *__restrict s, const void *__restrict vx, size_t row_size,
+                      const void *__restrict vy, const float *__restrict bias, int thread_count) {
+    const int ngroups = nr / MLLM_GEMV_ROWS;
+    // static schedule: every thread streams one contiguous slice of the weight.
+#pragma omp parallel for num_threads(thread_count) schedule(static)
+    for (int g = 0; g < ngroups; ++g) {
+        const int r0 = g * MLLM_GEMV_ROWS;
+        vec_dot_x4(n, s + r0, (const char *)vx + r0 * row_size, row_size, vy);
+        if (bias != nullptr) {
+            for (int r = r0; r < r0 + MLLM_GEMV_ROWS; ++r) {
+                s[r] += bias[r];
+            }
+        }
+    }
+    for (int r = ngroups * MLLM_GEMV_ROWS; r < nr; ++r) {
+        vec_dot(n, s + r, (const char *)vx + r * row_size, vy);
+        if (bias != nullptr) {
+            s[r] += bias[r];
+        }
+    }
+}
+
+void gemv_q4_0_q8_0(const int n, const int nr, float *__restrict s, const void *__restrict vx, size_t row_size,
+                    const void *__restrict vy, const float *__restrict bias, int thread_count) {
+    gemv_rows<vec_dot_q4_0_q8_0_x4, vec_dot_q4_0_q8_0>(n, nr, s, vx, row_size, vy, bias, thread_count);
+}
+
+/*
+ * K-quant kernels. The Q8_K super-block of the activation is loaded once per pass and kept in registers for all
+ * the rows, with what only depends on it: the sums of its sub-blocks paired for the Q4_K mins, and for Q6_K the
+ * products with the 32 offset of the weights. Each row then only unpacks its own scales and quants.
+ */
+#if QK_K == 256
+
+static inline void prefetch_block(const void *p, size_t bytes) {
+    for (size_t off = 0; off < bytes; off += GEMV_CACHE_LINE) {
+        MLLM_PREFETCH((const char *)p + off);
+    }
+}
+
+#ifdef __AVX2__
+static void vec_dot_q4_K_q8_K_x4_avx(const int n, float *__restrict s, const void *__restrict vx, size_t row_size, const void *__restrict vy) {
+    const int nb = n / QK_K;
+    assert(n % QK_K == 0);
+
+    static const uint32_t kmask1 = 0x3f3f3f3f;
+    static const uint32_t kmask2 = 0x0f0f0f0f;
+    static const uint32_t kmask3 = 0x03030303;
+
+    const block_q8_K *__restrict y = (const block_q8_K *)vy;
+    const block_q4_K *x[MLLM_GEMV_ROWS];
+    __m256 acc[MLLM_GEMV_ROWS];
+    __m128 acc_m[MLLM_GEMV_ROWS];
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        x[r] = (const block_q4_K *)((const char *)vx + r * row_size);
+        acc[r] = _mm256_setzero_ps();
+        acc_m[r] = _mm_setzero_ps();
+    }
+    const __m256i m4 = _mm256_set1_epi8(0xF);
+    uint32_t utmp[4];
+
+    for (int i = 0; i < nb; ++i) {
+        __m256i q8[QK_K / 32];
+        for (int k = 0; k < QK_K / 32; ++k) {
+            q8[k] = _mm256_loadu_si256((const __m256i *)(y[i].qs + 32 * k));
+        }
+        const __m256i q8sums = _mm256_loadu_si256((const __m256i *)y[i].bsums);
+        const __m128i q8s = _mm_hadd_epi16(_mm256_extracti128_si256(q8sums, 0), _mm256_extracti128_si256(q8sums, 1));
+
+        for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+            if (i + GEMV_K_PREFETCH_BLOCKS < nb) {
+                prefetch_block(x[r] + i + GEMV_K_PREFETCH_BLOCKS, sizeof(block_q4_K));
+            }
+            const float d = y[i].d * MLLM_FP16_TO_FP32(x[r][i].d);
+            const float dmin = -y[i].d * MLLM_FP16_TO_FP32(x[r][i].dmin);
+
+            memcpy(utmp, x[r][i].scales, 12);
+            utmp[3] = ((utmp[2] >> 4) & kmask2) | (((utmp[1] >> 6) & kmask3) << 4);
+            const uint32_t uaux = utmp[1] & kmask1;
+            utmp[1] = (utmp[2] & kmask2) | (((utmp[0] >> 6) & kmask3) << 4);
+            utmp[2] = uaux;
+            utmp[0] &= kmask1;
+
+            const __m256i mins_and_scales = _mm256_cvtepu8_epi16(_mm_set_epi32(utmp[3], utmp[2], utmp[1], utmp[0]));
+            const __m128i prod = _mm_madd_epi16(_mm256_extracti128_si256(mins_and_scales, 1), q8s);
+            acc_m[r] = _mm_fmadd_ps(_mm_set1_ps(dmin), _mm_cvtepi32_ps(prod), acc_m[r]);
+
+            const __m128i sc128 = _mm256_extracti128_si256(mins_and_scales, 0);
+            const __m256i scales = MM256_SET_M128I(sc128, sc128);
+
+            const uint8_t *__restrict q4 = x[r][i].qs;
+            __m256i sumi = _mm256_setzero_si256();
+            for (int j = 0; j < QK_K / 64; ++j) {
+                const __m256i scale_l = _mm256_shuffle_epi8(scales, get_scale_shuffle_k4(2 * j + 0));
+                const __m256i scale_h = _mm256_shuffle_epi8(scales, get_scale_shuffle_k4(2 * j + 1));
+
+                const __m256i q4bits = _mm256_loadu_si256((const __m256i *)(q4 + 32 * j));
+                const __m256i q4l = _mm256_and_si256(q4bits, m4);
+                const __m256i q4h = _mm256_and_si256(_mm256_srli_epi16(q4bits, 4), m4);
+
+                const __m256i p16l = _mm256_madd_epi16(scale_l, _mm256_maddubs_epi16(q4l, q8[2 * j + 0]));
+                const __m256i p16h = _mm256_madd_epi16(scale_h, _mm256_maddubs_epi16(q4h, q8[2 * j + 1]));
+                sumi = _mm256_add_epi32(sumi, _mm256_add_epi32(p16l, p16h));
+            }
+            acc[r] = _mm256_fmadd_ps(_mm256_set1_ps(d), _mm256_cvtepi32_ps(sumi), acc[r]);
+        }
+    }
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        __m128 m = _mm_add_ps(acc_m[r], _mm_movehl_ps(acc_m[r], acc_m[r]));
+        m = _mm_add_ss(m, _mm_movehdup_ps(m));
+        s[r] = hsum_float_8(acc[r]) + _mm_cvtss_f32(m);
+    }
+}
+
+static void vec_dot_q6_K_q8_K_x4_avx(const int n, float *__restrict s, const void *__restrict vx, size_t row_size, const void *__restrict vy) {
+    const int nb = n / QK_K;
+    assert(n % QK_K == 0);
+
+    const block_q8_K *__restrict y = (const block_q8_K *)vy;
+    const block_q6_K *x[MLLM_GEMV_ROWS];
+    __m256 acc[MLLM_GEMV_ROWS];
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        x[r] = (const block_q6_K *)((const char *)vx + r * row_size);
+        acc[r] = _mm256_setzero_ps();
+    }
+    const __m256i m4 = _mm256_set1_epi8(0xF);
+    const __m256i m2 = _mm256_set1_epi8(3);
+    const __m256i m32s = _mm256_set1_epi8(32);
+
+    for (int i = 0; i < nb; ++i) {
+        // the weights are stored as q + 32 with q in [-32, 31]: dot(q, y) = dot(q + 32, y) - 32 * y per pair
+        __m256i q8[QK_K / 32];
+        __m256i q8s[QK_K / 32];
+        for (int k = 0; k < QK_K / 32; ++k) {
+            q8[k] = _mm256_loadu_si256((const __m256i *)(y[i].qs + 32 * k));
+            q8s[k] = _mm256_maddubs_epi16(m32s, q8[k]);
+        }
+
+        for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+            if (i + GEMV_K_PREFETCH_BLOCKS < nb) {
+                prefetch_block(x[r] + i + GEMV_K_PREFETCH_BLOCKS, sizeof(block_q6_K));
+            }
+            const float d = y[i].d * MLLM_FP16_TO_FP32(x[r][i].d);
+
+            const uint8_t *__restrict q4 = x[r][i].ql;
+            const uint8_t *__restrict qh = x[r][i].qh;
+            const __m128i scales = _mm_loadu_si128((const __m128i *)x[r][i].scales);
+
+            __m256i sumi = _mm256_setzero_si256();
+            for (int j = 0; j < QK_K / 128; ++j) {
+                const __m256i q4bits1 = _mm256_loadu_si256((const __m256i *)(q4 + 64 * j));
+                const __m256i q4bits2 = _mm256_loadu_si256((const __m256i *)(q4 + 64 * j + 32));
+                const __m256i q4bitsH = _mm256_loadu_si256((const __m256i *)(qh + 32 * j));
+
+                const __m256i q4h_0 = _mm256_slli_epi16(_mm256_and_si256(q4bitsH, m2), 4);
+                const __m256i q4h_1 = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(q4bitsH, 2), m2), 4);
+                const __m256i q4h_2 = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(q4bitsH, 4), m2), 4);
+                const __m256i q4h_3 = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(q4bitsH, 6), m2), 4);
+
+                const __m256i q6[4] = {
+                    _mm256_or_si256(_mm256_and_si256(q4bits1, m4), q4h_0),
+                    _mm256_or_si256(_mm256_and_si256(q4bits2, m4), q4h_1),
+                    _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(q4bits1, 4), m4), q4h_2),
+                    _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(q4bits2, 4), m4), q4h_3),
+                };
+                for (int k = 0; k < 4; ++k) {
+                    const __m128i scale = _mm_shuffle_epi8(scales, get_scale_shuffle(4 * j + k));
+                    const __m256i p16 = _mm256_sub_epi16(_mm256_maddubs_epi16(q6[k], q8[4 * j + k]), q8s[4 * j + k]);
+                    sumi = _mm256_add_epi32(sumi, _mm256_madd_epi16(_mm256_cvtepi8_epi16(scale), p16));
+                }
+            }
+            acc[r] = _mm256_fmadd_ps(_mm256_set1_ps(d), _mm256_cvtepi32_ps(sumi), acc[r]);
+        }
+    }
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        s[r] = hsum_float_8(acc[r]);
+    }
+}
+#endif
+
+#ifdef __ARM_NEON
+// acc + the dot products of a and b, four lanes of partial sums
+static inline int32x4_t dot_s8(int32x4_t acc, int8x16_t a, int8x16_t b) {
+#if defined(__ARM_FEATURE_DOTPROD)
+    return vdotq_s32(acc, a, b);
+#else
+    acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(a), vget_low_s8(b)));
+    return vpadalq_s16(acc, vmull_s8(vget_high_s8(a), vget_high_s8(b)));
+#endif
+}
+
+static void vec_dot_q4_K_q8_K_x4_arm(const int n, float *__restrict s, const void *__restrict vx, size_t row_size, const void *__restrict vy) {
+    const int nb = n / QK_K;
+    assert(n % QK_K == 0);
+
+    static const uint32_t kmask1 = 0x3f3f3f3f;
+    static const uint32_t kmask2 = 0x0f0f0f0f;
+    static const uint32_t kmask3 = 0x03030303;
+
+    const block_q8_K *__restrict y = (const block_q8_K *)vy;
+    const block_q4_K *x[MLLM_GEMV_ROWS];
+    float sumf[MLLM_GEMV_ROWS];
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        x[r] = (const block_q4_K *)((const char *)vx + r * row_size);
+        sumf[r] = 0.0F;
+    }
+    const uint8x16_t m4b = vdupq_n_u8(0xF);
+    const int32x4_t mzero = vdupq_n_s32(0);
+    uint32_t utmp[4];
+
+    for (int i = 0; i < nb; ++i) {
+        int8x16_t q8[QK_K / 16];
+        for (int k = 0; k < QK_K / 16; ++k) {
+            q8[k] = vld1q_s8(y[i].qs + 16 * k);
+        }
+        const int16x8_t q8sums = vpaddq_s16(vld1q_s16(y[i].bsums), vld1q_s16(y[i].bsums + 8));
+
+        for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+            if (i + GEMV_K_PREFETCH_BLOCKS < nb) {
+                prefetch_block(x[r] + i + GEMV_K_PREFETCH_BLOCKS, sizeof(block_q4_K));
+            }
+            const float d = y[i].d * MLLM_FP16_TO_FP32(x[r][i].d);
+            const float dmin = y[i].d * MLLM_FP16_TO_FP32(x[r][i].dmin);
+
+            memcpy(utmp, x[r][i].scales, 12);
+            const uint32x2_t mins8 = {utmp[1] & kmask1, ((utmp[2] >> 4) & kmask2) | (((utmp[1] >> 6) & kmask3) << 4)};
+            utmp[1] = (utmp[2] & kmask2) | (((utmp[0] >> 6) & kmask3) << 4);
+            utmp[0] &= kmask1;
+
+            const int16x8_t mins = vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(mins8)));
+            const int32x4_t prod = vaddq_s32(vmull_s16(vget_low_s16(q8sums), vget_low_s16(mins)),
+                                             vmull_s16(vget_high_s16(q8sums), vget_high_s16(mins)));
+            sumf[r] -= dmin * vaddvq_s32(prod);
+
+            const uint8_t *scales = (const uint8_t *)utmp;
+            const uint8_t *__restrict q4 = x[r][i].qs;
+            int32_t sumi = 0;
+            for (int j = 0; j < QK_K / 64; ++j) {
+                const uint8x16x2_t q4bits = vld1q_u8_x2(q4 + 32 * j);
+                const int8x16_t q4l_0 = vreinterpretq_s8_u8(vandq_u8(q4bits.val[0], m4b));
+                const int8x16_t q4l_1 = vreinterpretq_s8_u8(vandq_u8(q4bits.val[1], m4b));
+                const int8x16_t q4h_0 = vreinterpretq_s8_u8(vshrq_n_u8(q4bits.val[0], 4));
+                const int8x16_t q4h_1 = vreinterpretq_s8_u8(vshrq_n_u8(q4bits.val[1], 4));
+                const int32x4_t pl = dot_s8(dot_s8(mzero, q4l_0, q8[4 * j + 0]), q4l_1, q8[4 * j + 1]);
+                const int32x4_t ph = dot_s8(dot_s8(mzero, q4h_0, q8[4 * j + 2]), q4h_1, q8[4 * j + 3]);
+                sumi += vaddvq_s32(pl) * scales[2 * j + 0] + vaddvq_s32(ph) * scales[2 * j + 1];
+            }
+            sumf[r] += d * sumi;
+        }
+    }
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        s[r] = sumf[r];
+    }
+}
+
+static void vec_dot_q6_K_q8_K_x4_arm(const int n, float *__restrict s, const void *__restrict vx, size_t row_size, const void *__restrict vy) {
+    const int nb = n / QK_K;
+    assert(n % QK_K == 0);
+
+    const block_q8_K *__restrict y = (const block_q8_K *)vy;
+    const block_q6_K *x[MLLM_GEMV_ROWS];
+    float sumf[MLLM_GEMV_ROWS];
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        x[r] = (const block_q6_K *)((const char *)vx + r * row_size);
+        sumf[r] = 0.0F;
+    }
+    const uint8x16_t m4b = vdupq_n_u8(0xF);
+    const uint8x16_t mone = vdupq_n_u8(3);
+    const int32x4_t mzero = vdupq_n_s32(0);
+
+    for (int i = 0; i < nb; ++i) {
+        int8x16_t q8[QK_K / 16];
+        for (int k = 0; k < QK_K / 16; ++k) {
+            q8[k] = vld1q_s8(y[i].qs + 16 * k);
+        }
+        const int16x8x2_t q8sums = vld1q_s16_x2(y[i].bsums);
+
+        for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+            if (i + GEMV_K_PREFETCH_BLOCKS < nb) {
+                prefetch_block(x[r] + i + GEMV_K_PREFETCH_BLOCKS, sizeof(block_q6_K));
+            }
+            const int8_t *__restrict scale = x[r][i].scales;
+            const int8x16_t scales = vld1q_s8(scale);
+            const int16x8_t q6scales_l = vmovl_s8(vget_low_s8(scales));
+            const int16x8_t q6scales_h = vmovl_s8(vget_high_s8(scales));
+            // the 32 offset of the weights, weighted by the scales
+            const int32x4_t prod = vaddq_s32(vaddq_s32(vmull_s16(vget_low_s16(q8sums.val[0]), vget_low_s16(q6scales_l)),
+                                                       vmull_s16(vget_high_s16(q8sums.val[0]), vget_high_s16(q6scales_l))),
+                                             vaddq_s32(vmull_s16(vget_low_s16(q8sums.val[1]), vget_low_s16(q6scales_h)),
+                                                       vmull_s16(vget_high_s16(q8sums.val[1]), vget_high_s16(q6scales_h))));
+            const int32_t isum_mins = vaddvq_s32(prod);
+
+            const uint8_t *__restrict ql = x[r][i].ql;
+            const uint8_t *__restrict qh = x[r][i].qh;
+            int32_t isum = 0;
+            for (int j = 0; j < QK_K / 128; ++j) {
+                const uint8x16x2_t qhbits = vld1q_u8_x2(qh + 32 * j);
+                const uint8x16x4_t q6bits = vld1q_u8_x4(ql + 64 * j);
+                const int8x16_t q6[8] = {
+                    vreinterpretq_s8_u8(vorrq_u8(vandq_u8(q6bits.val[0], m4b), vshlq_n_u8(vandq_u8(mone, qhbits.val[0]), 4))),
+                    vreinterpretq_s8_u8(vorrq_u8(vandq_u8(q6bits.val[1], m4b), vshlq_n_u8(vandq_u8(mone, qhbits.val[1]), 4))),
+                    vreinterpretq_s8_u8(vorrq_u8(vandq_u8(q6bits.val[2], m4b), vshlq_n_u8(vandq_u8(mone, vshrq_n_u8(qhbits.val[0], 2)), 4))),
+                    vreinterpretq_s8_u8(vorrq_u8(vandq_u8(q6bits.val[3], m4b), vshlq_n_u8(vandq_u8(mone, vshrq_n_u8(qhbits.val[1], 2)), 4))),
+                    vreinterpretq_s8_u8(vorrq_u8(vshrq_n_u8(q6bits.val[0], 4), vshlq_n_u8(vandq_u8(mone, vshrq_n_u8(qhbits.val[0], 4)), 4))),
+                    vreinterpretq_s8_u8(vorrq_u8(vshrq_n_u8(q6bits.val[1], 4), vshlq_n_u8(vandq_u8(mone, vshrq_n_u8(qhbits.val[1], 4)), 4))),
+                    vreinterpretq_s8_u8(vorrq_u8(vshrq_n_u8(q6bits.val[2], 4), vshlq_n_u8(vandq_u8(mone, vshrq_n_u8(qhbits.val[0], 6)), 4))),
+                    vreinterpretq_s8_u8(vorrq_u8(vshrq_n_u8(q6bits.val[3], 4), vshlq_n_u8(vandq_u8(mone, vshrq_n_u8(qhbits.val[1], 6)), 4))),
+                };
+                for (int k = 0; k < 8; ++k) {
+                    isum += vaddvq_s32(dot_s8(mzero, q6[k], q8[8 * j + k])) * scale[8 * j + k];
+                }
+            }
+            sumf[r] += MLLM_FP16_TO_FP32(x[r][i].d) * y[i].d * (isum - 32 * isum_mins);
+        }
+    }
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        s[r] = sumf[r];
+    }
+}
+#endif
+
+#endif // QK_K == 256
+
+void vec_dot_q4_K_q8_K_x4(const int n, float *__restrict s, const void *__restrict vx, size_t row_size, const void *__restrict vy) {
+#if QK_K == 256 && defined(__AVX2__)
+    vec_dot_q4_K_q8_K_x4_avx(n, s, vx, row_size, vy);
+#elif QK_K == 256 && defined(__ARM_NEON)
+    vec_dot_q4_K_q8_K_x4_arm(n, s, vx, row_size, vy);
+#else
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        vec_dot_q4_K_q8_K(n, s + r, (const char *)vx + r * row_size, vy);
+    }
+#endif
+}
+
+void vec_dot_q6_K_q8_K_x4(const int n, float *__restrict s, const void *__restrict vx, size_t row_size, const void *__restrict vy) {
+#if QK_K == 256 && defined(__AVX2__)
+    vec_dot_q6_K_q8_K_x4_avx(n, s, vx, row_size, vy);
+#elif QK_K == 256 && defined(__ARM_NEON)
+    vec_dot_q6_K_q8_K_x4_arm(n, s, vx, row_size, vy);
+#else
+    for (int r = 0; r < MLLM_GEMV_ROWS; ++r) {
+        vec_dot_q6_K_q8_K(n, s + r, (const char *)vx + r * row_size, vy);
+    }
+#endif
+}
+
+void gemv_q4_K_q8_K(const int n, const int nr, float *__restrict s, const void *__restrict vx, size_t row_size,
+                    const void *__restrict vy, const float *__restrict bias, int thread_count) {
+    gemv_rows<vec_dot_q4_K_q8_K_x4, vec_dot_q4_K_q8_K>(n, nr, s, vx, row_size, vy, bias, thread_count);
+}
+
+void gemv_q6_K_q8_K(const int n, const int nr, float *__restrict s, const void *__restrict vx, size_t row_size,
+                    const void *__restrict vy, const float *__restrict bias, int thread_count) {
+    gemv_rows<vec_dot_q6_K_q8_K_x4, vec_dot_q6_K_q8_K>(n, nr, s, vx, row_size, vy, bias, thread_count);
+}
+
+/*
+ * Lookup-table kernel for Q2_LUT / Q3_LUT. For each group pair of a block and each plane, one 16-byte load holds
+ * the nibbles of the QR_LUT rows for both groups; two shuffles pick the low and high bytes of their partial sums
+ * from the tables of the pair. The int16 sums of a plane cannot overflow within a block (QK_LUT / 4 groups of
+ * |sum| <= 4 * 127), they are widened and weighted by 2^p once per block.
+ */
+#ifdef __AVX2__
+template <int bits>
+static void vec_dot_lut_x16_avx(const int n, float *__restrict s, const void *__restrict vx, const block_lut_table *__restrict y) {
+    const int nb = n / QK_LUT;
+    const size_t tile_size = lut_tile_size(bits);
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (int i = 0; i < nb; ++i) {
+        const uint8_t *tile = (const uint8_t *)vx + i * tile_size;
+        const uint8_t *qs = tile + 2 * sizeof(mllm_fp16_t) * QR_LUT;
+        // lane 0: rows of the even group, lane 1: rows of the odd group
+        __m256i sum0[bits];
+        __m256i sum1[bits];
+        for (int p = 0; p < bits; ++p) {
+            sum0[p] = _mm256_setzero_si256();
+            sum1[p] = _mm256_setzero_si256();
+        }
+        for (int j = 0; j < QK_LUT / 8; ++j) {
+            const __m256i lo_table = _mm256_loadu_si256((const __m256i *)y[i].t[j][0]);
+            const __m256i hi_table = _mm256_loadu_si256((const __m256i *)y[i].t[j][1]);
+            for (int p = 0; p < bits; ++p) {
+                const __m128i raw = _mm_loadu_si128((const __m128i *)(qs + (j * bits + p) * QR_LUT));
+                const __m256i idx = _mm256_and_si256(_mm256_set_m128i(_mm_srli_epi16(raw, 4), raw), mask);
+                const __m256i lo = _mm256_shuffle_epi8(lo_table, idx);
+                const __m256i hi = _mm256_shuffle_epi8(hi_table, idx);
+                sum0[p] = _mm256_add_epi16(sum0[p], _mm256_unpacklo_epi8(lo, hi));
+                sum1[p] = _mm256_add_epi16(sum1[p], _mm256_unpackhi_epi8(lo, hi));
+            }
+        }
+        __m256i dot0 = _mm256_setzero_si256();
+        __m256i dot1 = _mm256_setzero_si256();
+        for (int p = 0; p < bits; ++p) {
+            const __m128i rows0 = _mm_add_epi16(_mm256_castsi256_si128(sum0[p]), _mm256_extracti128_si256(sum0[p], 1));
+            const __m128i rows1 = _mm_add_epi16(_mm256_castsi256_si128(sum1[p]), _mm256_extracti128_si256(sum1[p], 1));
+            dot0 = _mm256_add_epi32(dot0, _mm256_slli_epi32(_mm256_cvtepi16_epi32(rows0), p));
+            dot1 = _mm256_add_epi32(dot1, _mm256_slli_epi32(_mm256_cvtepi16_epi32(rows1), p));
+        }
+        const auto *d = (const mllm_fp16_t *)tile;
+        const __m256 yd = _mm256_set1_ps(y[i].d);
+        const __m256 ysum = _mm256_set1_ps(y[i].sum);
+        acc0 = _mm256_fmadd_ps(_mm256_mul_ps(MLLM_F32Cx8_LOAD(d), yd), _mm256_cvtepi32_ps(dot0), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_mul_ps(MLLM_F32Cx8_LOAD(d + 8), yd), _mm256_cvtepi32_ps(dot1), acc1);
+        acc0 = _mm256_fmadd_ps(MLLM_F32Cx8_LOAD(d + QR_LUT), ysum, acc0);
+        acc1 = _mm256_fmadd_ps(MLLM_F32Cx8_LOAD(d + QR_LUT + 8), ysum, acc1);
+    }
+    _mm256_storeu_ps(s, acc0);
+    _mm256_storeu_ps(s + 8, acc1);
+}
+#endif
+
+#ifdef __ARM_NEON
+template <int bits>
+static void vec_dot_lut_x16_arm(const int n, float *__restrict s, const void *__restrict vx, const block_lut_table *__restrict y) {
+    const int nb = n / QK_LUT;
+    const size_t tile_size = lut_tile_size(bits);
+    const uint8x16_t mask = vdupq_n_u8(0x0F);
+    float32x4_t acc[QR_LUT / 4];
+    for (auto &a : acc) {
+        a = vdupq_n_f32(0.0F);
+    }
+    for (int i = 0; i < nb; ++i) {
+        const uint8_t *tile = (const uint8_t *)vx + i * tile_size;
+        const uint8_t *qs = tile + 2 * sizeof(mllm_fp16_t) * QR_LUT;
+        // rows 0-7 and 8-15, both groups of a pair
+        int16x8_t sum0[bits];
+        int16x8_t sum1[bits];
+        for (int p = 0; p < bits; ++p) {
+            sum0[p] = vdupq_n_s16(0);
+            sum1[p] = vdupq_n_s16(0);
+        }
+        for (int j = 0; j < QK_LUT / 8; ++j) {
+            const uint8x16_t lo_even = vld1q_u8(y[i].t[j][0]);
+            const uint8x16_t lo_odd = vld1q_u8(y[i].t[j][0] + 16);
+            const uint8x16_t hi_even = vld1q_u8(y[i].t[j][1]);
+            const uint8x16_t hi_odd = vld1q_u8(y[i].t[j][1] + 16);
+            for (int p = 0; p < bits; ++p) {
+                const uint8x16_t raw = vld1q_u8(qs + (j * bits + p) * QR_LUT);
+                const uint8x16_t even = vandq_u8(raw, mask);
+                const uint8x16_t odd = vshrq_n_u8(raw, 4);
+                const uint8x16_t lo0 = vqtbl1q_u8(lo_even, even);
+                const uint8x16_t hi0 = vqtbl1q_u8(hi_even, even);
+                const uint8x16_t lo1 = vqtbl1q_u8(lo_odd, odd);
+                const uint8x16_t hi1 = vqtbl1q_u8(hi_odd, odd);
+                sum0[p] = vaddq_s16(sum0[p], vaddq_s16(vreinterpretq_s16_u8(vzip1q_u8(lo0, hi0)), vreinterpretq_s16_u8(vzip1q_u8(lo1, hi1))));
+                sum1[p] = vaddq_s16(sum1[p], vaddq_s16(vreinterpretq_s16_u8(vzip2q_u8(lo0, hi0)), vreinterpretq_s16_u8(vzip2q_u8(lo1, hi1))));
+            }
+        }
+        int32x4_t dot[QR_LUT / 4];
+        for (auto &v : dot) {
+            v = vdupq_n_s32(0);
+        }
+        for (int p = 0; p < bits; ++p) {
+            const int32x4_t shift = vdupq_n_s32(p);
+            dot[0] = vaddq_s32(dot[0], vshlq_s32(vmovl_s16(vget_low_s16(sum0[p])), shift));
+            dot[1] = vaddq_s32(dot[1], vshlq_s32(vmovl_high_s16(sum0[p]), shift));
+            dot[2] = vaddq_s32(dot[2], vshlq_s32(vmovl_s16(vget_low_s16(sum1[p])), shift));
+            dot[3] = vaddq_s32(dot[3], vshlq_s32(vmovl_high_s16(sum1[p]), shift));
+        }
+        const auto *d = (const mllm_fp16_t *)tile;
+        float dm[2 * QR_LUT];
+        for (int r = 0; r < 2 * QR_LUT; ++r) {
+            dm[r] = MLLM_FP16_TO_FP32(d[r]);
+        }
+        for (int r = 0; r < QR_LUT / 4; ++r) {
+            acc[r] = vmlaq_n_f32(acc[r], vmulq_f32(vld1q_f32(dm + 4 * r), vcvtq_f32_s32(dot[r])), y[i].d);
+            acc[r] = vmlaq_n_f32(acc[r], vld1q_f32(dm + QR_LUT + 4 * r), y[i].sum);
+        }
+    }
+    for (int r = 0; r < QR_LUT / 4; ++r) {
+        vst1q_f32(s + 4 * r, acc[r]);
+    }
+}
+#endif
+
+// the partial sum at `e` of group g of the tables of a block
+static inline int lut_entry(const block_lut_table *y, int g, int e) {
+    const int j = g / 2;
+    const int at = (g % 2) * 16 + e;
+    return (int16_t)(y->t[j][0][at] | y->t[j][1][at] << 8);
+}
+
+void vec_dot_lut_x16(const int n, const int bits, float *__restrict s, const void *__restrict vx, const void *__restrict vy) {
+    assert(n % QK_LUT == 0);
+    assert(bits == 2 || bits == 3);
+    const auto *y = (const block_lut_table *)vy;
+#if defined(__AVX2__)
+    if (bits == 2) {
+        vec_dot_lut_x16_avx<2>(n, s, vx, y);
+    } else {
+        vec_dot_lut_x16_avx<3>(n, s, vx, y);
+    }
+#elif defined(__ARM_NEON)
+    if (bits == 2) {
+        vec_dot_lut_x16_arm<2>(n, s, vx, y);
+    } else {
+        vec_dot_lut_x16_arm<3>(n, s, vx, y);
+    }
+#else
+    const size_t tile_size = lut_tile_size(bits);
+    for (int r = 0; r < QR_LUT; ++r) {
+        s[r] = 0.0F;
+    }
+    for (int i = 0; i < n / QK_LUT; ++i) {
+        const uint8_t *tile = (const uint8_t *)vx + i * tile_size;
+        const auto *d = (const mllm_fp16_t *)tile;
+        const uint8_t *qs = tile + 2 * sizeof(mllm_fp16_t) * QR_LUT;
+        for (int r = 0; r < QR_LUT; ++r) {
+            int dot = 0;
+            for (int j = 0; j < QK_LUT / 8; ++j) {
+                for (int p = 0; p < bits; ++p) {
+                    const uint8_t nibbles = qs[(j * bits + p) * QR_LUT + r];
+                    dot += (lut_entry(y + i, 2 * j, nibbles & 0x0F) + lut_entry(y + i, 2 * j + 1, nibbles >> 4)) * (1 << p);
+                }
+            }
+            s[r] += MLLM_FP16_TO_FP32(d[r]) * y[i].d * dot + MLLM_FP16_TO_FP32(d[QR_LUT + r]) * y[i].sum;
+        }
+    }
+#endif
+}
@@ -0,0 +1,59 @@
+#ifndef MLLM_GEMV_HPP
+#define MLLM_GEMV_HPP
+
+#include "VecDot.hpp"
+#include "../quantize/QuantizeLUT.hpp"
+
+/*
+ * Decode-time (M == 1) matrix-vector kernels.
+ *
+ * During decode the activation is a single row, so a Linear layer is a GEMV that is bound by the
+ * bandwidth of streaming the weights. These kernels:
+ * - split the N output columns into contiguous chunks, one chunk per thread;
+ * - compute MLLM_GEMV_ROWS output columns per pass, so every activation block is loaded/widened once
+ *   and reused for all the weight rows of the pass;
+ * - issue software prefetches for the weight blocks that will be consumed next.
+ *
+ * Layout: the weight is row-major, row n starting at `(char *)vx + n * row_size`, i.e. the same
+ * [out_features, in_features] layout used by CPULinear. `vy` is the activation row already quantized to
+ * the matching Q8 type. `bias` may be nullptr.
+ */
+
+#define MLLM_GEMV_ROWS 4
+
+void gemv_q4_0_q8_0(const int n, const int nr, float *__restrict s, const void *__restrict vx, size_t row_size,
+                    const void *__restrict vy, const float *__restrict bias, int thread_count);
+
+/**
+ * \brief dot products of MLLM_GEMV_ROWS consecutive Q4_0 rows with the same Q8_0 row.
+ * \param n          length of each row, must be a multiple of QK8_0.
+ * \param s          MLLM_GEMV_ROWS results.
+ * \param vx         first Q4_0 row.
+ * \param row_size   bytes between two Q4_0 rows.
+ * \param vy         Q8_0 row.
+ */
+void vec_dot_q4_0_q8_0_x4(const int n, float *__restrict s, const void *__restrict vx, size_t row_size, const void *__restrict vy);
+
+void gemv_q4_K_q8_K(const int n, const int nr, float *__restrict s, const void *__restrict vx, size_t row_size,
+                    const void *__restrict vy, const float *__restrict bias, int thread_count);
+void gemv_q6_K_q8_K(const int n, const int nr, float *__restrict s, const void *__restrict vx, size_t row_size,
+                    const void *__restrict vy, const float *__restrict bias, int thread_count);
+
+/**
+ * \brief dot products of MLLM_GEMV_ROWS consecutive Q4_K (Q6_K) rows with the same Q8_K row, see
+ *        vec_dot_q4_0_q8_0_x4; n must be a multiple of QK_K.
+ */
+void vec_dot_q4_K_q8_K_x4(const int n, float *__restrict s, const void *__restrict vx, size_t row_size, const void *__restrict vy);
+void vec_dot_q6_K_q8_K_x4(const int n, float *__restrict s, const void *__restrict vx, size_t row_size, const void *__restrict vy);
+
+/**
+ * \brief dot products of the QR_LUT rows of a tile row of Q2_LUT / Q3_LUT weights with one activation row.
+ * \param n     length of each row, must be a multiple of QK_LUT.
+ * \param bits  2 or 3, see lut_bits.
+ * \param s     QR_LUT results.
+ * \param vx    the n / QK_LUT tiles of the rows, see pack_rows_lut.
+ * \param vy    the tables of the activation row, n / QK_LUT block_lut_table.
+ */
+void vec_dot_lut_x16(const int n, const int bits, float *__restrict s, const void *__restrict vx, const void *__restrict vy);
+
+#endif // MLLM_GEMV_HPP
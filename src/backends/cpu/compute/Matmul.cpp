@@ -3,17 +3,39 @@
 //
 
 #include "Matmul.hpp"
+#include "GEMV.hpp"
+#include "Tuning.hpp"
 #include <pthread.h>
 
-ErrorCode mat_mul_fp32(Tensor *src0, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias, bool transpose0, bool transpose1, int thread_count) {
+/*
+ * Whether a quantized Linear with a single activation row can take the decode GEMV path:
+ * dst rows must be plain contiguous F32 and the weight a plain [N, K] matrix.
+ */
+static bool use_gemv(Tensor *src0, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias) {
+    if (src0->sequence() != 1) {
+        return false;
+    }
+    if (dst->dtype() != MLLM_TYPE_F32 || dst->aggregated() || dst->masterTensor() != nullptr || dst->ctype() != BSHD) {
+        return false;
+    }
+    if (src1->masterTensor() != nullptr || src1->batch() != 1 || src1->head() != 1) {
+        return false;
+    }
+    return !support_bias || bias->dtype() == MLLM_TYPE_F32;
+}
+
+ErrorCode mat_mul_fp32(Tensor *src0, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias, bool transpose0, bool transpose1, int thread_count, int head_begin, int head_end) {
+    if (head_end < 0) {
+        head_end = src0->head();
+    }
     const int M = transpose0 ? src0->dimension() : src0->sequence();
     const int K = transpose0 ? src0->sequence() : src0->dimension();
     const int N = transpose1 ? src1->sequence() : src1->dimension();
     Tensor *src0_cal = src0;
     Tensor *src1_cal = src1;
-    const int64_t blck_0 = 16;
+    const int64_t blck_0 = kernelParams().matmul_blck_0[src1->dtype()];
     for (int b = 0; b < src0->batch(); b++) {
-        for (int h = 0; h < src0->head(); h++) {
+        for (int h = head_begin; h < head_end; h++) {
             const int b_1 = (src1->batch() == 1 && src1->head() == 1) ? 0 : b;
             const int h_1 = (src1->batch() == 1 && src1->head() == 1) ? 0 : h;
             for (int m = 0; m < M; m++) {
@@ -57,24 +79,28 @@ ErrorCode mat_mul_fp32(Tensor *src0, Tensor *src1, Tensor *dst, bool support_bia
     return MLLM_NO_ERROR;
 }
 
-ErrorCode mat_mul_fp32_fp16(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias, bool transpose0, bool transpose1, int thread_count) {
+ErrorCode mat_mul_fp32_fp16(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias, bool transpose0, bool transpose1, int thread_count, int head_begin, int head_end, Tensor *src0_f16) {
+    if (head_end < 0) {
+        head_end = src0_->head();
+    }
     assert(src1->dtype() == MLLM_TYPE_F16);
     assert(src0_->dtype() == MLLM_TYPE_F32);
-    Tensor src0_qf16(src0_->shape());
-    src0_qf16.setBackend(src0_->backend());
-    src0_qf16.setDtype(MLLM_TYPE_F16);
-    src0_qf16.alloc();
+    // head h of src0_ is head h - head_begin of src0
+    Tensor temp;
+    auto *src0 = src0_f16 != nullptr ? src0_f16 : &temp;
+    src0->setBackend(src0_->backend());
+    src0->reshape(src0_->batch(), head_end - head_begin, src0_->sequence(), src0_->dimension());
+    src0->alloc(MLLM_TYPE_F16);
         for (int b = 0; b < src0_->batch(); b++) {
-            for (int h = 0; h < src0_->head(); h++) {
-#pragma omp parallel for num_threads(thread_count)
+            for (int h = head_begin; h < head_end; h++) {
+#pragma omp parallel for num_threads(thread_count) schedule(static, kernelParams().quantize_chunk)
                 for (int s = 0; s < src0_->sequence(); s++) {
                     mllm_fp32_to_fp16_row(src0_->hostPtr<float>() + src0_->offset(b, h, s, 0),
-                                      src0_qf16.hostPtr<mllm_fp16_t>() + src0_qf16.offset(b, h, s, 0),
+                                      src0->hostPtr<mllm_fp16_t>() + src0->offset(b, h - head_begin, s, 0),
                                       src0_->dimension());
                 }
             }
         }
-    auto *src0 = &src0_qf16;
     // for(int b=0; b<src0->dimension(); b++) {
     //     std::cout<<MLLM_COMPUTE_FP16_TO_FP32(*src0->ptrAt<mllm_fp16_t>(0, 0, 0, b))<<" ";
     // }
@@ -88,9 +114,9 @@ ErrorCode mat_mul_fp32_fp16(Tensor *src0_, Tensor *src1, Tensor *dst, bool suppo
     const int N = transpose1 ? src1->sequence() : src1->dimension();
     Tensor *src0_cal = src0;
     Tensor *src1_cal = src1;
-    const int64_t blck_0 = 16;
+    const int64_t blck_0 = kernelParams().matmul_blck_0[src1->dtype()];
     for (int b = 0; b < src0->batch(); b++) {
-        for (int h = 0; h < src0->head(); h++) {
+        for (int h = head_begin; h < head_end; h++) {
             const int b_1 = (src1->batch() == 1 && src1->head() == 1) ? 0 : b;
             const int h_1 = (src1->batch() == 1 && src1->head() == 1) ? 0 : h;
             for (int m = 0; m < M; m++) {
@@ -110,7 +136,7 @@ ErrorCode mat_mul_fp32_fp16(Tensor *src0_, Tensor *src1, Tensor *dst, bool suppo
                         }
                         vec_dot_fp16(K, dst->ptrAt<float>(b, h, m, n),
                                      src1_cal->hostPtr<mllm_fp16_t>() + src1_cal->offset(b_1, h_1, s_1, d_1),
-                                     src0_cal->hostPtr<mllm_fp16_t>() + src0_cal->offset(b, h, s_0, d_0));
+                                     src0_cal->hostPtr<mllm_fp16_t>() + src0_cal->offset(b, h - head_begin, s_0, d_0));
                         if (support_bias) {
                             *dst->ptrAt<float>(b, h, m, n) += bias->dataAt<float>(0, 0, 0, n);
                         }
@@ -122,6 +148,55 @@ ErrorCode mat_mul_fp32_fp16(Tensor *src0_, Tensor *src1, Tensor *dst, bool suppo
     return MLLM_NO_ERROR;
 }
 
+ErrorCode mat_mul_fp32_bf16(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias, int thread_count) {
+    assert(src1->dtype() == MLLM_TYPE_BF16);
+    assert(src0_->dtype() == MLLM_TYPE_F32);
+    const int M = src0_->sequence();
+    const int K = src0_->dimension();
+    const int N = src1->sequence();
+#ifdef MLLM_BF16_DOT
+    Tensor src0_bf16(src0_->shape());
+    src0_bf16.setBackend(src0_->backend());
+    src0_bf16.setDtype(MLLM_TYPE_BF16);
+    src0_bf16.alloc();
+    for (int b = 0; b < src0_->batch(); b++) {
+        for (int h = 0; h < src0_->head(); h++) {
+#pragma omp parallel for num_threads(thread_count) schedule(static, kernelParams().quantize_chunk)
+            for (int s = 0; s < M; s++) {
+                mllm_fp32_to_bf16_row(src0_->ptrAt<float>(b, h, s, 0), src0_bf16.ptrAt<mllm_bf16_t>(b, h, s, 0), K);
+            }
+        }
+    }
+#endif
+    // every task keeps blck_0 rows of the weight in the cache while all the activation rows go past them
+    const int blck_0 = kernelParams().matmul_blck_0[MLLM_TYPE_BF16];
+    const int num_blocks = (N + blck_0 - 1) / blck_0;
+    for (int b = 0; b < src0_->batch(); b++) {
+        for (int h = 0; h < src0_->head(); h++) {
+            const int b_1 = (src1->batch() == 1 && src1->head() == 1) ? 0 : b;
+            const int h_1 = (src1->batch() == 1 && src1->head() == 1) ? 0 : h;
+#pragma omp parallel for num_threads(thread_count)
+            for (int block = 0; block < num_blocks; block++) {
+                const int n_end = std::min(N, (block + 1) * blck_0);
+                for (int m = 0; m < M; m++) {
+                    float *out = dst->ptrAt<float>(b, h, m, 0);
+                    for (int n = block * blck_0; n < n_end; n++) {
+#ifdef MLLM_BF16_DOT
+                        vec_dot_bf16(K, out + n, src1->ptrAt<mllm_bf16_t>(b_1, h_1, n, 0), src0_bf16.ptrAt<mllm_bf16_t>(b, h, m, 0));
+#else
+                        vec_dot_fp32_bf16(K, out + n, src1->ptrAt<mllm_bf16_t>(b_1, h_1, n, 0), src0_->ptrAt<float>(b, h, m, 0));
+#endif
+                        if (support_bias) {
+                            out[n] += bias->dataAt<float>(0, 0, 0, n);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return MLLM_NO_ERROR;
+}
+
 ErrorCode mat_mul_fp32_q4_0(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias, int thread_count) {
     assert(src1->dtype() == MLLM_TYPE_Q4_0);
     assert(src0_->dtype() == MLLM_TYPE_F32);
@@ -132,7 +207,7 @@ ErrorCode mat_mul_fp32_q4_0(Tensor *src0_, Tensor *src1, Tensor *dst, bool suppo
     if (src0_->dimension() % QK8_0 == 0) {
         for (int b = 0; b < src0_->batch(); b++) {
             for (int h = 0; h < src0_->head(); h++) {
-#pragma omp parallel for num_threads(thread_count)
+#pragma omp parallel for num_threads(thread_count) schedule(static, kernelParams().quantize_chunk)
                 for (int s = 0; s < src0_->sequence(); s++) {
                     quantize_row_q8_0(src0_->hostPtr<float>() + src0_->offset(b, h, s, 0),
                                       src0_q8.hostPtr<block_q8_0>() + src0_q8.offset(b, h, s, 0) / QK8_0,
@@ -149,9 +224,20 @@ ErrorCode mat_mul_fp32_q4_0(Tensor *src0_, Tensor *src1, Tensor *dst, bool suppo
     int M = src0->sequence();
     int K = src0->dimension();
     int N = src1->sequence();
+    if (use_gemv(src0, src1, dst, support_bias, bias)) {
+        const size_t row_size = DataTypeSize(src1->dtype(), K);
+        for (int b = 0; b < src0->batch(); b++) {
+            for (int h = 0; h < src0->head(); h++) {
+                gemv_q4_0_q8_0(K, N, dst->ptrAt<float>(b, h, 0, 0), src1->hostPtr<block_q4_0>(), row_size,
+                               src0->hostPtr<block_q8_0>() + src0->offset(b, h, 0, 0) / QK8_0,
+                               support_bias ? bias->hostPtr<float>() : nullptr, thread_count);
+            }
+        }
+        return MLLM_NO_ERROR;
+    }
     Tensor *src0_cal = src0;
     Tensor *src1_cal = src1;
-    const int64_t blck_0 = 16;
+    const int64_t blck_0 = kernelParams().matmul_blck_0[src1->dtype()];
     for (int b = 0; b < src0->batch(); b++) {
         for (int h = 0; h < src0->head(); h++) {
             const int b_1 = (src1->batch() == 1 && src1->head() == 1) ? 0 : b;
@@ -176,6 +262,235 @@ ErrorCode mat_mul_fp32_q4_0(Tensor *src0_, Tensor *src1, Tensor *dst, bool suppo
     return MLLM_NO_ERROR;
 }
 
+ErrorCode mat_mul_fp32_q8_0(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias, int thread_count) {
+    assert(src1->dtype() == MLLM_TYPE_Q8_0);
+    assert(src0_->dtype() == MLLM_TYPE_F32);
+    const int K = src0_->dimension();
+    if (K % QK8_0 != 0) {
+        std::cout << "[ERROR]: " << K << "%" << QK8_0 << "!=0" << std::endl;
+        assert(K % QK8_0 == 0);
+        return NOT_SUPPORT;
+    }
+    Tensor src0_q8(src0_->shape());
+    src0_q8.setBackend(src0_->backend());
+    src0_q8.setDtype(MLLM_TYPE_Q8_0);
+    src0_q8.alloc();
+    for (int b = 0; b < src0_->batch(); b++) {
+        for (int h = 0; h < src0_->head(); h++) {
+#pragma omp parallel for num_threads(thread_count) schedule(static, kernelParams().quantize_chunk)
+            for (int s = 0; s < src0_->sequence(); s++) {
+                quantize_row_q8_0(src0_->ptrAt<float>(b, h, s, 0), src0_q8.hostPtr<block_q8_0>() + src0_q8.offset(b, h, s, 0) / QK8_0, K);
+            }
+        }
+    }
+    const int M = src0_->sequence();
+    const int N = src1->sequence();
+    const size_t row_size = DataTypeSize(MLLM_TYPE_Q8_0, K);
+    // every task keeps blck_0 rows of the weight in the cache while all the activation rows go past them
+    const int blck_0 = (kernelParams().matmul_blck_0[MLLM_TYPE_Q8_0] + 3) / 4 * 4;
+    const int num_blocks = (N + blck_0 - 1) / blck_0;
+    for (int b = 0; b < src0_->batch(); b++) {
+        for (int h = 0; h < src0_->head(); h++) {
+            const int b_1 = (src1->batch() == 1 && src1->head() == 1) ? 0 : b;
+            const int h_1 = (src1->batch() == 1 && src1->head() == 1) ? 0 : h;
+            const char *weight = (const char *)(src1->hostPtr<block_q8_0>() + src1->offset(b_1, h_1, 0, 0) / QK8_0);
+#pragma omp parallel for num_threads(thread_count)
+            for (int block = 0; block < num_blocks; block++) {
+                const int n_end = std::min(N, (block + 1) * blck_0);
+                for (int m = 0; m < M; m++) {
+                    const block_q8_0 *x = src0_q8.hostPtr<block_q8_0>() + src0_q8.offset(b, h, m, 0) / QK8_0;
+                    float *out = dst->ptrAt<float>(b, h, m, 0);
+                    int n = block * blck_0;
+                    for (; n + 4 <= n_end; n += 4) {
+                        vec_dot_q8_0_q8_0_x4(K, out + n, weight + n * row_size, row_size, x);
+                    }
+                    for (; n < n_end; n++) {
+                        vec_dot_q8_0_q8_0(K, out + n, weight + n * row_size, x);
+                    }
+                    if (support_bias) {
+                        for (n = block * blck_0; n < n_end; n++) {
+                            out[n] += bias->dataAt<float>(0, 0, 0, n);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return MLLM_NO_ERROR;
+}
+
+ErrorCode mat_mul_fp32_i8(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias, Tensor *scale, Tensor *smooth, int thread_count) {
+    assert(src1->dtype() == MLLM_TYPE_I8);
+    assert(src0_->dtype() == MLLM_TYPE_F32);
+    assert(src1->batch() == 1 && src1->head() == 1);
+    const int K = src0_->dimension();
+    if (K % 32 != 0) {
+        std::cout << "[ERROR]: " << K << "%" << 32 << "!=0" << std::endl;
+        assert(K % 32 == 0);
+        return NOT_SUPPORT;
+    }
+    const int M = src0_->sequence();
+    const int N = src1->sequence();
+    const int8_t *weight = src1->hostPtr<int8_t>();
+    const float *weight_scale = scale->hostPtr<float>();
+    vector<int8_t> x((size_t)M * K);
+    vector<float> x_scale(M);
+    // every task keeps blck_0 rows of the weight in the cache while all the activation rows go past them
+    const int blck_0 = (kernelParams().matmul_blck_0[MLLM_TYPE_I8] + 3) / 4 * 4;
+    const int num_blocks = (N + blck_0 - 1) / blck_0;
+    for (int b = 0; b < src0_->batch(); b++) {
+        for (int h = 0; h < src0_->head(); h++) {
+#pragma omp parallel num_threads(thread_count)
+            {
+                vector<float> smoothed(smooth != nullptr ? K : 0);
+#pragma omp for schedule(static, kernelParams().quantize_chunk)
+                for (int m = 0; m < M; m++) {
+                    const float *row = src0_->ptrAt<float>(b, h, m, 0);
+                    if (smooth != nullptr) {
+                        const float *factor = smooth->hostPtr<float>();
+                        for (int k = 0; k < K; ++k) {
+                            smoothed[k] = row[k] * factor[k];
+                        }
+                        row = smoothed.data();
+                    }
+                    x_scale[m] = quantize_row_i8(row, x.data() + (size_t)m * K, K);
+                }
+            }
+#pragma omp parallel for num_threads(thread_count)
+            for (int block = 0; block < num_blocks; block++) {
+                const int n_begin = block * blck_0;
+                const int n_end = std::min(N, n_begin + blck_0);
+                int32_t sums[8];
+                for (int m = 0; m < M; m += 2) {
+                    const int ny = std::min(2, M - m);
+                    const int8_t *y = x.data() + (size_t)m * K;
+                    int n = n_begin;
+                    for (; n + 4 <= n_end; n += 4) {
+                        vec_dot_i8_i8_4xn(K, sums, weight + (size_t)n * K, K, y, K, ny);
+                        for (int j = 0; j < ny; ++j) {
+                            float *out = dst->ptrAt<float>(b, h, m + j, 0);
+                            for (int r = 0; r < 4; ++r) {
+                                out[n + r] = (float)sums[j * 4 + r] * x_scale[m + j] * weight_scale[n + r];
+                            }
+                        }
+                    }
+                    for (; n < n_end; n++) {
+                        for (int j = 0; j < ny; ++j) {
+                            dst->ptrAt<float>(b, h, m + j, 0)[n] = (float)vec_dot_i8_i8(K, weight + (size_t)n * K, y + (size_t)j * K) * x_scale[m + j] * weight_scale[n];
+                        }
+                    }
+                    if (support_bias) {
+                        for (int j = 0; j < ny; ++j) {
+                            float *out = dst->ptrAt<float>(b, h, m + j, 0);
+                            for (n = n_begin; n < n_end; n++) {
+                                out[n] += bias->dataAt<float>(0, 0, 0, n);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return MLLM_NO_ERROR;
+}
+
+ErrorCode mat_mul_fp32_sparse_24(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias, int thread_count) {
+    assert(src1->dtype() == MLLM_TYPE_Q4_0_24 || src1->dtype() == MLLM_TYPE_Q8_0_24);
+    assert(src0_->dtype() == MLLM_TYPE_F32);
+    const int K = src0_->dimension();
+    if (K % QK_24 != 0) {
+        std::cout << "[ERROR]: " << K << "%" << QK_24 << "!=0" << std::endl;
+        assert(K % QK_24 == 0);
+        return NOT_SUPPORT;
+    }
+    auto vec_dot = src1->dtype() == MLLM_TYPE_Q4_0_24 ? vec_dot_q4_0_24_q8_0 : vec_dot_q8_0_24_q8_0;
+    Tensor src0_q8(src0_->shape());
+    src0_q8.setBackend(src0_->backend());
+    src0_q8.setDtype(MLLM_TYPE_Q8_0);
+    src0_q8.alloc();
+    for (int b = 0; b < src0_->batch(); b++) {
+        for (int h = 0; h < src0_->head(); h++) {
+#pragma omp parallel for num_threads(thread_count) schedule(static, kernelParams().quantize_chunk)
+            for (int s = 0; s < src0_->sequence(); s++) {
+                quantize_row_q8_0(src0_->ptrAt<float>(b, h, s, 0), src0_q8.hostPtr<block_q8_0>() + src0_q8.offset(b, h, s, 0) / QK8_0, K);
+            }
+        }
+    }
+    const int M = src0_->sequence();
+    const int N = src1->sequence();
+    const size_t row_size = DataTypeSize(src1->dtype(), K);
+    const int blck_0 = kernelParams().matmul_blck_0[src1->dtype()];
+    const int num_blocks = (N + blck_0 - 1) / blck_0;
+    for (int b = 0; b < src0_->batch(); b++) {
+        for (int h = 0; h < src0_->head(); h++) {
+            const int b_1 = (src1->batch() == 1 && src1->head() == 1) ? 0 : b;
+            const int h_1 = (src1->batch() == 1 && src1->head() == 1) ? 0 : h;
+            const char *weight = src1->hostPtr<char>() + row_size * (src1->offset(b_1, h_1, 0, 0) / K);
+#pragma omp parallel for num_threads(thread_count)
+            for (int block = 0; block < num_blocks; block++) {
+                const int n_end = std::min(N, (block + 1) * blck_0);
+                for (int m = 0; m < M; m++) {
+                    const block_q8_0 *x = src0_q8.hostPtr<block_q8_0>() + src0_q8.offset(b, h, m, 0) / QK8_0;
+                    float *out = dst->ptrAt<float>(b, h, m, 0);
+                    for (int n = block * blck_0; n < n_end; n++) {
+                        vec_dot(K, out + n, weight + n * row_size, x);
+                        if (support_bias) {
+                            out[n] += bias->dataAt<float>(0, 0, 0, n);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return MLLM_NO_ERROR;
+}
+
+// activation rows whose tables are built together, then read by every tile while they are in cache
+#define MLLM_LUT_ROWS 8
+
+ErrorCode mat_mul_fp32_lut(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias, int thread_count) {
+    const int bits = lut_bits(src1->dtype());
+    assert(bits > 0);
+    assert(src0_->dtype() == MLLM_TYPE_F32);
+    const int K = src0_->dimension();
+    if (K % QK_LUT != 0) {
+        std::cout << "[ERROR]: " << K << "%" << QK_LUT << "!=0" << std::endl;
+        assert(K % QK_LUT == 0);
+        return NOT_SUPPORT;
+    }
+    const int M = src0_->sequence();
+    const int N = dst->dimension();
+    const int nb = K / QK_LUT;
+    const int ntiles = (N + QR_LUT - 1) / QR_LUT;
+    const size_t tiles_size = lut_tile_size(bits) * nb;
+    std::vector<block_lut_table> tables((size_t)MIN(M, MLLM_LUT_ROWS) * nb);
+    for (int b = 0; b < src0_->batch(); b++) {
+        for (int h = 0; h < src0_->head(); h++) {
+            for (int m0 = 0; m0 < M; m0 += MLLM_LUT_ROWS) {
+                const int m1 = MIN(M, m0 + MLLM_LUT_ROWS);
+#pragma omp parallel for num_threads(thread_count) schedule(static, kernelParams().quantize_chunk)
+                for (int m = m0; m < m1; m++) {
+                    quantize_row_lut_table(src0_->ptrAt<float>(b, h, m, 0), tables.data() + (size_t)(m - m0) * nb, K);
+                }
+#pragma omp parallel for num_threads(thread_count)
+                for (int t = 0; t < ntiles; t++) {
+                    const char *weight = src1->hostPtr<char>() + tiles_size * t;
+                    const int rows = MIN(QR_LUT, N - t * QR_LUT);
+                    for (int m = m0; m < m1; m++) {
+                        float s[QR_LUT];
+                        vec_dot_lut_x16(K, bits, s, weight, tables.data() + (size_t)(m - m0) * nb);
+                        float *out = dst->ptrAt<float>(b, h, m, t * QR_LUT);
+                        for (int r = 0; r < rows; r++) {
+                            out[r] = s[r] + (support_bias ? bias->dataAt<float>(0, 0, 0, t * QR_LUT + r) : 0.0F);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return MLLM_NO_ERROR;
+}
+
 ErrorCode mat_mul_fp32_q4_K(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias, int thread_count) {
     assert(src1->dtype() == MLLM_TYPE_Q4_K);
     assert(src0_->dtype() == MLLM_TYPE_F32);
@@ -186,7 +501,7 @@ ErrorCode mat_mul_fp32_q4_K(Tensor *src0_, Tensor *src1, Tensor *dst, bool suppo
     if (src0_->dimension() % QK_K == 0) {
         for (int b = 0; b < src0_->batch(); b++) {
             for (int h = 0; h < src0_->head(); h++) {
-#pragma omp parallel for num_threads(thread_count)
+#pragma omp parallel for num_threads(thread_count) schedule(static, kernelParams().quantize_chunk)
                 for (int s = 0; s < src0_->sequence(); s++) {
                     quantize_row_q8_K(src0_->hostPtr<float>() + src0_->offset(b, h, s, 0),
                                       src0_q8.hostPtr<block_q8_K>() + src0_q8.offset(b, h, s, 0) / QK_K,
@@ -203,9 +518,20 @@ ErrorCode mat_mul_fp32_q4_K(Tensor *src0_, Tensor *src1, Tensor *dst, bool suppo
     int M = src0->sequence();
     int K = src0->dimension();
     int N = src1->sequence();
+    if (use_gemv(src0, src1, dst, support_bias, bias)) {
+        const size_t row_size = DataTypeSize(src1->dtype(), K);
+        for (int b = 0; b < src0->batch(); b++) {
+            for (int h = 0; h < src0->head(); h++) {
+                gemv_q4_K_q8_K(K, N, dst->ptrAt<float>(b, h, 0, 0), src1->hostPtr<block_q4_K>(), row_size,
+                               src0->hostPtr<block_q8_K>() + src0->offset(b, h, 0, 0) / QK_K,
+                               support_bias ? bias->hostPtr<float>() : nullptr, thread_count);
+            }
+        }
+        return MLLM_NO_ERROR;
+    }
     Tensor *src0_cal = src0;
     Tensor *src1_cal = src1;
-    const int64_t blck_0 = 16;
+    const int64_t blck_0 = kernelParams().matmul_blck_0[src1->dtype()];
 
     for (int b = 0; b < src0->batch(); b++) {
         for (int h = 0; h < src0->head(); h++) {
@@ -253,7 +579,7 @@ ErrorCode mat_mul_fp32_q6_K(Tensor *src0_, Tensor *src1, Tensor *dst, bool suppo
     if (src0_->dimension() % QK_K == 0) {
         for (int b = 0; b < src0_->batch(); b++) {
             for (int h = 0; h < src0_->head(); h++) {
-#pragma omp parallel for num_threads(thread_count)
+#pragma omp parallel for num_threads(thread_count) schedule(static, kernelParams().quantize_chunk)
                 for (int s = 0; s < src0_->sequence(); s++) {
                     quantize_row_q8_K(src0_->hostPtr<float>() + src0_->offset(b, h, s, 0),
                                       src0_q8.hostPtr<block_q8_K>() + src0_q8.offset(b, h, s, 0) / QK_K,
@@ -270,9 +596,20 @@ ErrorCode mat_mul_fp32_q6_K(Tensor *src0_, Tensor *src1, Tensor *dst, bool suppo
     int M = src0->sequence();
     int K = src0->dimension();
     int N = src1->sequence();
+    if (use_gemv(src0, src1, dst, support_bias, bias)) {
+        const size_t row_size = DataTypeSize(src1->dtype(), K);
+        for (int b = 0; b < src0->batch(); b++) {
+            for (int h = 0; h < src0->head(); h++) {
+                gemv_q6_K_q8_K(K, N, dst->ptrAt<float>(b, h, 0, 0), src1->hostPtr<block_q6_K>(), row_size,
+                               src0->hostPtr<block_q8_K>() + src0->offset(b, h, 0, 0) / QK_K,
+                               support_bias ? bias->hostPtr<float>() : nullptr, thread_count);
+            }
+        }
+        return MLLM_NO_ERROR;
+    }
     Tensor *src0_cal = src0;
     Tensor *src1_cal = src1;
-    const int64_t blck_0 = 16;
+    const int64_t blck_0 = kernelParams().matmul_blck_0[src1->dtype()];
     for (int b = 0; b < src0->batch(); b++) {
         for (int h = 0; h < src0->head(); h++) {
             const int b_1 = (src1->batch() == 1 && src1->head() == 1) ? 0 : b;
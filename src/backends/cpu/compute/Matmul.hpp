@@ -9,9 +9,27 @@
 #include "VecDot.hpp"
 using namespace mllm;
 
-ErrorCode mat_mul_fp32(Tensor *src0, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias = nullptr, bool transpose0 = false, bool transpose1 = false, int thread_count=4);
-ErrorCode mat_mul_fp32_fp16(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias = nullptr, bool transpose0 = false, bool transpose1 = false, int thread_count=4);
+// head_begin/head_end restrict the product to the heads [head_begin, head_end), head_end = -1 for all heads
+ErrorCode mat_mul_fp32(Tensor *src0, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias = nullptr, bool transpose0 = false, bool transpose1 = false, int thread_count=4, int head_begin = 0, int head_end = -1);
+// src0_f16 holds the F16 copy of the heads [head_begin, head_end) of src0_; kept by the caller, it is only
+// reallocated when their shape changes. A temporary if null.
+ErrorCode mat_mul_fp32_fp16(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias = nullptr, bool transpose0 = false, bool transpose1 = false, int thread_count=4, int head_begin = 0, int head_end = -1, Tensor *src0_f16 = nullptr);
+// BF16 weights [N, K] (Linear layout), see MLLM_BF16_DOT
+ErrorCode mat_mul_fp32_bf16(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias = nullptr, int thread_count=4);
 ErrorCode mat_mul_fp32_q4_0(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias = nullptr, int thread_count=4);
+ErrorCode mat_mul_fp32_q8_0(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias = nullptr, int thread_count=4);
+/**
+ * \brief W8A8: int8 weights with one scale per output row, multiplied by activations quantized to int8 per token,
+ *        with int32 sums over the whole row.
+ * \param scale   F32, the scale of every weight row.
+ * \param smooth  F32 factors the activations are multiplied by before being quantized (one per input channel, see
+ *                ActivationStats::smoothing), or nullptr.
+ */
+ErrorCode mat_mul_fp32_i8(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias, Tensor *scale, Tensor *smooth = nullptr, int thread_count=4);
+// 2:4 sparse weights, Q4_0_24 or Q8_0_24: half the weight bytes are read and multiplied
+ErrorCode mat_mul_fp32_sparse_24(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias = nullptr, int thread_count=4);
+// Q2_LUT or Q3_LUT weights repacked into tiles (pack_rows_lut), dst->dimension() rows of them
+ErrorCode mat_mul_fp32_lut(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias = nullptr, int thread_count=4);
 ErrorCode mat_mul_fp32_q4_K(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias = nullptr, int thread_count=4);
 ErrorCode mat_mul_fp32_q6_K(Tensor *src0_, Tensor *src1, Tensor *dst, bool support_bias, Tensor *bias = nullptr, int thread_count=4);
 
@@ -0,0 +1,156 @@
+#include "Numa.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// from linux/mempolicy.h
+#define MLLM_MPOL_BIND 2
+#define MLLM_MPOL_MF_MOVE (1 << 1)
+
+static std::vector<int> parseCpuList(const std::string &list) {
+    // e.g. "0-3,8-11"
+    std::vector<int> cpus;
+    std::stringstream ranges(list);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        auto dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+static std::vector<std::vector<int>> readNodeCpus() {
+    std::vector<std::vector<int>> nodes;
+    for (int node = 0;; ++node) {
+        std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!cpulist.is_open()) {
+            break;
+        }
+        std::string list;
+        std::getline(cpulist, list);
+        auto cpus = parseCpuList(list);
+        if (!cpus.empty()) {
+            nodes.push_back(cpus);
+        }
+    }
+    if (nodes.empty()) {
+        std::vector<int> cpus(std::max(1U, std::thread::hardware_concurrency()));
+        for (int cpu = 0; cpu < (int)cpus.size(); ++cpu) {
+            cpus[cpu] = cpu;
+        }
+        nodes.push_back(cpus);
+    }
+    return nodes;
+}
+
+const std::vector<std::vector<int>> &numaNodeCpus() {
+    static const std::vector<std::vector<int>> nodes = readNodeCpus();
+    return nodes;
+}
+
+size_t pageSize() {
+#ifdef __linux__
+    static const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return page;
+#else
+    return 4096;
+#endif
+}
+
+bool numaBind(void *ptr, size_t size, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+    if (numaNodeCpus().size() < 2 || size == 0) {
+        return false;
+    }
+    const size_t page = pageSize();
+    if ((uintptr_t)ptr % page != 0) {
+        return false;
+    }
+    unsigned long mask = 1UL << node;
+    return syscall(SYS_mbind, ptr, (size + page - 1) / page * page, MLLM_MPOL_BIND, &mask, sizeof(mask) * 8, MLLM_MPOL_MF_MOVE) == 0;
+#else
+    return false;
+#endif
+}
+
+bool pinCurrentThread(const std::vector<int> &cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+NumaPool::NumaPool(int nodes) {
+    for (int node = 0; node < nodes; ++node) {
+        workers_.emplace_back(&NumaPool::work, this, node);
+    }
+}
+
+NumaPool::~NumaPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+int NumaPool::physicalNode(int node) const {
+    return node % (int)numaNodeCpus().size();
+}
+
+void NumaPool::run(const std::function<void(int)> &fn) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_ = &fn;
+    running_ = nodes();
+    ++generation_;
+    start_.notify_all();
+    done_.wait(lock, [this] { return running_ == 0; });
+    task_ = nullptr;
+}
+
+void NumaPool::work(int node) {
+    pinCurrentThread(numaNodeCpus()[physicalNode(node)]);
+    unsigned seen = 0;
+    while (true) {
+        const std::function<void(int)> *task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+            task = task_;
+        }
+        (*task)(node);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--running_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+}
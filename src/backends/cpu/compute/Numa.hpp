@@ -0,0 +1,73 @@
+#ifndef MLLM_NUMA_HPP
+#define MLLM_NUMA_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief the CPUs of every NUMA node, read from /sys/devices/system/node.
+ * A machine without NUMA information is reported as a single node with all CPUs.
+ */
+const std::vector<std::vector<int>> &numaNodeCpus();
+
+/**
+ * \brief restrict the calling thread to the given CPUs.
+ * \return false if the platform does not support it.
+ */
+bool pinCurrentThread(const std::vector<int> &cpus);
+
+/**
+ * \brief size of a memory page, the alignment numaBind needs.
+ */
+size_t pageSize();
+
+/**
+ * \brief place the pages of [ptr, ptr + size) on a NUMA node.
+ * Pages that are not touched yet are allocated on the node when first written, touched pages are migrated.
+ * `ptr` must be page aligned and the allocation must cover whole pages (see Tensor::allocAligned), so that no
+ * other buffer moves with it.
+ * \return false if the kernel does not support it or `ptr` is not page aligned; the memory then stays where the
+ *         allocator put it.
+ */
+bool numaBind(void *ptr, size_t size, int node);
+
+/**
+ * \brief one worker thread per NUMA node, pinned to the CPUs of that node.
+ * The OpenMP teams a worker forks inherit its CPU mask, so everything a task computes stays on the node.
+ * If more nodes are requested than the machine has, the workers wrap around the real nodes.
+ */
+class NumaPool {
+public:
+    explicit NumaPool(int nodes);
+    ~NumaPool();
+
+    int nodes() const {
+        return (int)workers_.size();
+    }
+    /**
+     * \brief the real node that logical node `node` of the pool is pinned to.
+     */
+    int physicalNode(int node) const;
+    /**
+     * \brief run fn(node) on the worker of every node and wait until all of them have finished.
+     */
+    void run(const std::function<void(int)> &fn);
+
+private:
+    void work(int node);
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    const std::function<void(int)> *task_ = nullptr;
+    unsigned generation_ = 0;
+    int running_ = 0;
+    bool stop_ = false;
+};
+
+#endif // MLLM_NUMA_HPP
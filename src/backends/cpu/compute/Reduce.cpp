@@ -0,0 +1,351 @@
+#include "Reduce.hpp"
+#include "TensorAccessor.hpp"
+#include <cmath>
+#include <cstring>
+
+// elements of the dimension combined per task when reducing over BATCH, HEAD or SEQUENCE
+#define MLLM_REDUCE_CHUNK 1024
+
+template <ReduceOp OP>
+static inline float reduce_init() {
+    return OP == REDUCE_MAX ? -INFINITY : 0.0F;
+}
+template <ReduceOp OP>
+static inline float reduce_step(float acc, float x, float value) {
+    switch (OP) {
+    case REDUCE_MAX:
+        return acc < x ? x : acc;
+    case REDUCE_L1:
+        return acc + std::fabs(x);
+    case REDUCE_L2:
+        return acc + x * x;
+    case REDUCE_COUNT:
+        return acc + (x == value ? 1.0F : 0.0F);
+    default:
+        return acc + x;
+    }
+}
+// combine two partial results
+template <ReduceOp OP>
+static inline float reduce_merge(float a, float b) {
+    return OP == REDUCE_MAX ? (a < b ? b : a) : a + b;
+}
+static inline float reduce_finish(ReduceOp op, float acc, int n) {
+    switch (op) {
+    case REDUCE_MEAN:
+        return acc / (float)n;
+    case REDUCE_L2:
+        return std::sqrt(acc);
+    default:
+        return acc;
+    }
+}
+
+#ifdef __AVX2__
+template <ReduceOp OP>
+static inline __m256 reduce_step_avx(__m256 acc, __m256 x, __m256 value) {
+    switch (OP) {
+    case REDUCE_MAX:
+        return _mm256_max_ps(acc, x);
+    case REDUCE_L1:
+        return _mm256_add_ps(acc, _mm256_andnot_ps(_mm256_set1_ps(-0.0F), x));
+    case REDUCE_L2:
+        return _mm256_fmadd_ps(x, x, acc);
+    case REDUCE_COUNT:
+        return _mm256_add_ps(acc, _mm256_and_ps(_mm256_cmp_ps(x, value, _CMP_EQ_OQ), _mm256_set1_ps(1.0F)));
+    default:
+        return _mm256_add_ps(acc, x);
+    }
+}
+#elif defined(__ARM_NEON)
+template <ReduceOp OP>
+static inline float32x4_t reduce_step_neon(float32x4_t acc, float32x4_t x, float32x4_t value) {
+    switch (OP) {
+    case REDUCE_MAX:
+        return vmaxq_f32(acc, x);
+    case REDUCE_L1:
+        return vaddq_f32(acc, vabsq_f32(x));
+    case REDUCE_L2:
+        return vfmaq_f32(acc, x, x);
+    case REDUCE_COUNT:
+        return vaddq_f32(acc, vreinterpretq_f32_u32(vandq_u32(vceqq_f32(x, value), vreinterpretq_u32_f32(vdupq_n_f32(1.0F)))));
+    default:
+        return vaddq_f32(acc, x);
+    }
+}
+#endif
+
+// the accumulated (unfinished) reduction of a row
+template <ReduceOp OP>
+static float reduce_row_acc(const int n, const float *__restrict x, float value) {
+    int i = 0;
+    float acc = reduce_init<OP>();
+#ifdef __AVX2__
+    // four independent accumulators keep the loads in flight
+    const __m256 v = _mm256_set1_ps(value);
+    __m256 acc0 = _mm256_set1_ps(reduce_init<OP>());
+    __m256 acc1 = acc0;
+    __m256 acc2 = acc0;
+    __m256 acc3 = acc0;
+    for (; i + 31 < n; i += 32) {
+        acc0 = reduce_step_avx<OP>(acc0, _mm256_loadu_ps(x + i), v);
+        acc1 = reduce_step_avx<OP>(acc1, _mm256_loadu_ps(x + i + 8), v);
+        acc2 = reduce_step_avx<OP>(acc2, _mm256_loadu_ps(x + i + 16), v);
+        acc3 = reduce_step_avx<OP>(acc3, _mm256_loadu_ps(x + i + 24), v);
+    }
+    for (; i + 7 < n; i += 8) {
+        acc0 = reduce_step_avx<OP>(acc0, _mm256_loadu_ps(x + i), v);
+    }
+    float lanes[4][8];
+    _mm256_storeu_ps(lanes[0], acc0);
+    _mm256_storeu_ps(lanes[1], acc1);
+    _mm256_storeu_ps(lanes[2], acc2);
+    _mm256_storeu_ps(lanes[3], acc3);
+    for (auto &lane : lanes) {
+        for (float l : lane) {
+            acc = reduce_merge<OP>(acc, l);
+        }
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t v = vdupq_n_f32(value);
+    float32x4_t acc0 = vdupq_n_f32(reduce_init<OP>());
+    float32x4_t acc1 = acc0;
+    float32x4_t acc2 = acc0;
+    float32x4_t acc3 = acc0;
+    for (; i + 15 < n; i += 16) {
+        acc0 = reduce_step_neon<OP>(acc0, vld1q_f32(x + i), v);
+        acc1 = reduce_step_neon<OP>(acc1, vld1q_f32(x + i + 4), v);
+        acc2 = reduce_step_neon<OP>(acc2, vld1q_f32(x + i + 8), v);
+        acc3 = reduce_step_neon<OP>(acc3, vld1q_f32(x + i + 12), v);
+    }
+    for (; i + 3 < n; i += 4) {
+        acc0 = reduce_step_neon<OP>(acc0, vld1q_f32(x + i), v);
+    }
+    float lanes[4][4];
+    vst1q_f32(lanes[0], acc0);
+    vst1q_f32(lanes[1], acc1);
+    vst1q_f32(lanes[2], acc2);
+    vst1q_f32(lanes[3], acc3);
+    for (auto &lane : lanes) {
+        for (float l : lane) {
+            acc = reduce_merge<OP>(acc, l);
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        acc = reduce_step<OP>(acc, x[i], value);
+    }
+    return acc;
+}
+
+static int argmax_row(const int n, const float *__restrict x) {
+    const float max = reduce_row_acc<REDUCE_MAX>(n, x, 0.0F);
+    int i = 0;
+#ifdef __AVX2__
+    const __m256 m = _mm256_set1_ps(max);
+    for (; i + 7 < n; i += 8) {
+        const int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(x + i), m, _CMP_EQ_OQ));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        if (x[i] == max) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+float reduce_row(ReduceOp op, const int n, const float *__restrict x, float value) {
+    switch (op) {
+    case REDUCE_SUM:
+        return reduce_row_acc<REDUCE_SUM>(n, x, value);
+    case REDUCE_MEAN:
+        return reduce_finish(op, reduce_row_acc<REDUCE_SUM>(n, x, value), n);
+    case REDUCE_MAX:
+        return reduce_row_acc<REDUCE_MAX>(n, x, value);
+    case REDUCE_ARGMAX:
+        return (float)argmax_row(n, x);
+    case REDUCE_L1:
+        return reduce_row_acc<REDUCE_L1>(n, x, value);
+    case REDUCE_L2:
+        return reduce_finish(op, reduce_row_acc<REDUCE_L2>(n, x, value), n);
+    case REDUCE_COUNT:
+        return reduce_row_acc<REDUCE_COUNT>(n, x, value);
+    }
+    return 0.0F;
+}
+
+// acc[i] = step(acc[i], x[i]) for n elements
+template <ReduceOp OP>
+static void reduce_rows_acc(const int n, float *__restrict acc, const float *__restrict x, float value) {
+    int i = 0;
+#ifdef __AVX2__
+    const __m256 v = _mm256_set1_ps(value);
+    for (; i + 7 < n; i += 8) {
+        _mm256_storeu_ps(acc + i, reduce_step_avx<OP>(_mm256_loadu_ps(acc + i), _mm256_loadu_ps(x + i), v));
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t v = vdupq_n_f32(value);
+    for (; i + 3 < n; i += 4) {
+        vst1q_f32(acc + i, reduce_step_neon<OP>(vld1q_f32(acc + i), vld1q_f32(x + i), v));
+    }
+#endif
+    for (; i < n; ++i) {
+        acc[i] = reduce_step<OP>(acc[i], x[i], value);
+    }
+}
+
+// best[i], index[i] = x[i], r where x[i] > best[i]
+static void argmax_rows_acc(const int n, float *__restrict best, float *__restrict index, const float *__restrict x, int r) {
+    int i = 0;
+#ifdef __AVX2__
+    const __m256 rv = _mm256_set1_ps((float)r);
+    for (; i + 7 < n; i += 8) {
+        const __m256 xv = _mm256_loadu_ps(x + i);
+        const __m256 bv = _mm256_loadu_ps(best + i);
+        const __m256 greater = _mm256_cmp_ps(xv, bv, _CMP_GT_OQ);
+        _mm256_storeu_ps(best + i, _mm256_blendv_ps(bv, xv, greater));
+        _mm256_storeu_ps(index + i, _mm256_blendv_ps(_mm256_loadu_ps(index + i), rv, greater));
+    }
+#endif
+    for (; i < n; ++i) {
+        if (x[i] > best[i]) {
+            best[i] = x[i];
+            index[i] = (float)r;
+        }
+    }
+}
+
+static void reduce_rows_acc(ReduceOp op, const int n, float *acc, float *index, const float *x, int r, float value) {
+    switch (op) {
+    case REDUCE_MAX:
+        reduce_rows_acc<REDUCE_MAX>(n, acc, x, value);
+        break;
+    case REDUCE_ARGMAX:
+        argmax_rows_acc(n, acc, index, x, r);
+        break;
+    case REDUCE_L1:
+        reduce_rows_acc<REDUCE_L1>(n, acc, x, value);
+        break;
+    case REDUCE_L2:
+        reduce_rows_acc<REDUCE_L2>(n, acc, x, value);
+        break;
+    case REDUCE_COUNT:
+        reduce_rows_acc<REDUCE_COUNT>(n, acc, x, value);
+        break;
+    default:
+        reduce_rows_acc<REDUCE_SUM>(n, acc, x, value);
+        break;
+    }
+}
+
+// F32 or F16 rows of a tensor, read and written as floats
+struct RowView {
+    explicit RowView(Tensor &tensor) :
+        f32(tensor.dtype() == MLLM_TYPE_F32), a32(tensor), a16(tensor) {
+        assert(f32 || tensor.dtype() == MLLM_TYPE_F16);
+    }
+    // `n` elements from (b, h, s, d): in place when possible, else converted into `buffer`
+    const float *load(int b, int h, int s, int d, int n, float *buffer) const {
+        if (f32) {
+            if (a32.contiguousRows()) {
+                return a32.ptr(b, h, s, d);
+            }
+            for (int i = 0; i < n; ++i) {
+                buffer[i] = a32(b, h, s, d + i);
+            }
+        } else if (a16.contiguousRows()) {
+            mllm_fp16_to_fp32_row(a16.ptr(b, h, s, d), buffer, n);
+        } else {
+            for (int i = 0; i < n; ++i) {
+                buffer[i] = MLLM_FP16_TO_FP32(a16(b, h, s, d + i));
+            }
+        }
+        return buffer;
+    }
+    void store(int b, int h, int s, int d, int n, const float *values) const {
+        if (f32 && a32.contiguousRows()) {
+            memcpy(a32.ptr(b, h, s, d), values, n * sizeof(float));
+        } else if (f32) {
+            for (int i = 0; i < n; ++i) {
+                a32(b, h, s, d + i) = values[i];
+            }
+        } else {
+            for (int i = 0; i < n; ++i) {
+                a16(b, h, s, d + i) = MLLM_FP32_TO_FP16(values[i]);
+            }
+        }
+    }
+
+    bool f32;
+    TensorAccessor<float> a32;
+    TensorAccessor<mllm_fp16_t> a16;
+};
+
+float reduce_row(ReduceOp op, Tensor &tensor, int b, int h, int s, float value) {
+    const int n = tensor.dimension();
+    vector<float> buffer(n);
+    return reduce_row(op, n, RowView(tensor).load(b, h, s, 0, n, buffer.data()), value);
+}
+
+void reduce_axis(ReduceOp op, Tensor &input, Chl axis, Tensor &output, int thread_count, float value) {
+    const int extent[4] = {input.batch(), input.head(), input.sequence(), input.dimension()};
+    const int dim = extent[3];
+    assert(axis >= BATCH && axis <= DIMENSION);
+    const RowView in(input);
+    const RowView out(output);
+    if (axis == DIMENSION) {
+        const int rows = extent[0] * extent[1] * extent[2];
+#pragma omp parallel num_threads(thread_count)
+        {
+            vector<float> buffer(dim);
+#pragma omp for
+            for (int row = 0; row < rows; ++row) {
+                const int s = row % extent[2];
+                const int h = row / extent[2] % extent[1];
+                const int b = row / extent[2] / extent[1];
+                const float result = reduce_row(op, dim, in.load(b, h, s, 0, dim, buffer.data()), value);
+                out.store(b, h, s, 0, 1, &result);
+            }
+        }
+        return;
+    }
+    // the output rows (b, h, s with `axis` at 0), each cut in chunks of the dimension
+    const int length = extent[axis];
+    int out_extent[3] = {extent[0], extent[1], extent[2]};
+    out_extent[axis] = 1;
+    const int rows = out_extent[0] * out_extent[1] * out_extent[2];
+    const int chunks = (dim + MLLM_REDUCE_CHUNK - 1) / MLLM_REDUCE_CHUNK;
+#pragma omp parallel num_threads(thread_count)
+    {
+        vector<float> buffer(MLLM_REDUCE_CHUNK);
+        vector<float> acc(MLLM_REDUCE_CHUNK);
+        vector<float> index(op == REDUCE_ARGMAX ? MLLM_REDUCE_CHUNK : 0);
+#pragma omp for
+        for (int task = 0; task < rows * chunks; ++task) {
+            const int row = task / chunks;
+            const int d = task % chunks * MLLM_REDUCE_CHUNK;
+            const int n = std::min(MLLM_REDUCE_CHUNK, dim - d);
+            int pos[3] = {row / out_extent[2] / out_extent[1], row / out_extent[2] % out_extent[1], row % out_extent[2]};
+            std::fill(acc.begin(), acc.begin() + n, op == REDUCE_MAX || op == REDUCE_ARGMAX ? -INFINITY : 0.0F);
+            std::fill(index.begin(), index.end(), 0.0F);
+            for (int r = 0; r < length; ++r) {
+                pos[axis] = r;
+                const float *x = in.load(pos[0], pos[1], pos[2], d, n, buffer.data());
+                reduce_rows_acc(op, n, acc.data(), index.data(), x, r, value);
+            }
+            if (op == REDUCE_ARGMAX) {
+                acc.swap(index);
+            } else {
+                for (int i = 0; i < n; ++i) {
+                    acc[i] = reduce_finish(op, acc[i], length);
+                }
+            }
+            pos[axis] = 0;
+            out.store(pos[0], pos[1], pos[2], d, n, acc.data());
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef MLLM_REDUCE_HPP
+#define MLLM_REDUCE_HPP
+
+#include "VecDot.hpp"
+
+/*
+ * Reductions over one axis of a Tensor.
+ *
+ * reduce_row() reduces a contiguous row of floats with AVX2/NEON accumulators.
+ * reduce_axis() reduces any of BATCH, HEAD, SEQUENCE or DIMENSION of an F32 or F16 tensor:
+ * - over DIMENSION every (b, h, s) row is reduced by reduce_row();
+ * - over another axis the rows met along that axis are combined element-wise into a row of accumulators,
+ *   which keeps the inner loop contiguous whatever the axis.
+ * The work is split across threads over the output rows, and over chunks of the dimension when there are
+ * few rows.
+ */
+
+enum ReduceOp {
+    REDUCE_SUM,
+    REDUCE_MEAN,
+    REDUCE_MAX,
+    REDUCE_ARGMAX, // index of the first maximum
+    REDUCE_L1,     // sum of |x|
+    REDUCE_L2,     // square root of the sum of squares
+    REDUCE_COUNT,  // number of elements equal to `value`
+};
+
+/**
+ * \brief reduce `n` contiguous floats.
+ * \param value  the value counted by REDUCE_COUNT.
+ */
+float reduce_row(ReduceOp op, const int n, const float *__restrict x, float value = 0.0F);
+/**
+ * \brief reduce the row (b, h, s) of `tensor` over its dimension. F32 or F16.
+ */
+float reduce_row(ReduceOp op, Tensor &tensor, int b, int h, int s, float value = 0.0F);
+/**
+ * \brief reduce `input` over `axis` into `output`, which has the shape of `input` with 1 along `axis`.
+ *        F32 or F16 input and output; REDUCE_ARGMAX writes the index as a float.
+ */
+void reduce_axis(ReduceOp op, Tensor &input, Chl axis, Tensor &output, int thread_count, float value = 0.0F);
+
+#endif // MLLM_REDUCE_HPP
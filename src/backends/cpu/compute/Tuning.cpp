@@ -0,0 +1,159 @@
+#include "Tuning.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+KernelParams defaultKernelParams() {
+    KernelParams params{};
+    for (int &blck : params.matmul_blck_0) {
+        blck = 16;
+    }
+    params.softmax_chunk = 1;
+    params.quantize_chunk = 1;
+    return params;
+}
+
+KernelParams &kernelParams() {
+    static KernelParams params = defaultKernelParams();
+    return params;
+}
+
+static std::string cpuModel() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    std::string model;
+    std::string part;
+    while (std::getline(cpuinfo, line)) {
+        auto pos = line.find(':');
+        if (pos == std::string::npos) {
+            continue;
+        }
+        // x86 reports a "model name", ARM a "Hardware" name and/or the "CPU part" of each core
+        if (line.rfind("model name", 0) == 0 || line.rfind("Hardware", 0) == 0) {
+            model = line.substr(pos + 1);
+            break;
+        }
+        if (part.empty() && line.rfind("CPU part", 0) == 0) {
+            part = "CPU_part" + line.substr(pos + 1);
+        }
+    }
+    if (model.empty()) {
+        model = part;
+    }
+    std::string key;
+    for (char c : model) {
+        if (c == ' ' || c == '\t') {
+            if (!key.empty() && key.back() != '_') {
+                key += '_';
+            }
+        } else {
+            key += c;
+        }
+    }
+    while (!key.empty() && key.back() == '_') {
+        key.pop_back();
+    }
+    return key.empty() ? "unknown" : key;
+}
+
+static std::string isaFeatures() {
+    std::vector<std::string> features;
+#ifdef __AVX512F__
+    features.emplace_back("avx512f");
+#endif
+#ifdef __AVX2__
+    features.emplace_back("avx2");
+#endif
+#ifdef __FMA__
+    features.emplace_back("fma");
+#endif
+#ifdef __F16C__
+    features.emplace_back("f16c");
+#endif
+#ifdef __ARM_NEON
+    features.emplace_back("neon");
+#endif
+#ifdef __ARM_FEATURE_DOTPROD
+    features.emplace_back("dotprod");
+#endif
+#ifdef __ARM_FEATURE_FP16_VECTOR_ARITHMETIC
+    features.emplace_back("fp16");
+#endif
+    std::string isa;
+    for (const auto &f : features) {
+        isa += (isa.empty() ? "" : ",") + f;
+    }
+    return isa.empty() ? "scalar" : isa;
+}
+
+std::string tuningMachineKey(int thread_count) {
+    return cpuModel() + "|" + isaFeatures() + "|t" + std::to_string(thread_count);
+}
+
+static const DataType tuned_types[] = {MLLM_TYPE_F32, MLLM_TYPE_F16, MLLM_TYPE_Q4_0, MLLM_TYPE_Q4_K, MLLM_TYPE_Q6_K};
+
+bool loadKernelParams(const std::string &path, int thread_count) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        return false;
+    }
+    const std::string machine = tuningMachineKey(thread_count);
+    KernelParams params = kernelParams();
+    bool found = false;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string key, name;
+        int value;
+        if (!(fields >> key >> name >> value) || key != machine || value <= 0) {
+            continue;
+        }
+        found = true;
+        if (name == "softmax_chunk") {
+            params.softmax_chunk = value;
+        } else if (name == "quantize_chunk") {
+            params.quantize_chunk = value;
+        } else {
+            for (auto type : tuned_types) {
+                if (name == "matmul_blck_0." + DataTypeName(type)) {
+                    params.matmul_blck_0[type] = value;
+                }
+            }
+        }
+    }
+    if (found) {
+        kernelParams() = params;
+    }
+    return found;
+}
+
+bool saveKernelParams(const std::string &path, int thread_count) {
+    const std::string machine = tuningMachineKey(thread_count);
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.rfind(machine + " ", 0) != 0) {
+                lines.push_back(line);
+            }
+        }
+    }
+    const auto &params = kernelParams();
+    for (auto type : tuned_types) {
+        lines.push_back(machine + " matmul_blck_0." + DataTypeName(type) + " " + std::to_string(params.matmul_blck_0[type]));
+    }
+    lines.push_back(machine + " softmax_chunk " + std::to_string(params.softmax_chunk));
+    lines.push_back(machine + " quantize_chunk " + std::to_string(params.quantize_chunk));
+
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Cannot write tuning cache " << path << std::endl;
+        return false;
+    }
+    for (const auto &line : lines) {
+        out << line << "\n";
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+#ifndef MLLM_TUNING_HPP
+#define MLLM_TUNING_HPP
+
+#include "Types.hpp"
+#include <string>
+
+/*
+ * Kernel parameters whose best value depends on the machine (cache sizes, core count, SIMD width).
+ * Kernels read them through kernelParams(). They hold the built-in defaults until tuned values are loaded
+ * from a tuning cache (loadKernelParams) or found by CPUTuner.
+ *
+ * The tuning cache is a text file with one "<machine key> <parameter> <value>" entry per line, so one file
+ * can hold the tuned values of several machines.
+ */
+
+struct KernelParams {
+    int matmul_blck_0[MLLM_TYPE_COUNT]; // dst columns per OpenMP task in mat_mul_*, by weight type
+    int softmax_chunk;                  // rows per OpenMP task in CPUSoftMax
+    int quantize_chunk;                 // rows per OpenMP task when activations are quantized to Q8
+};
+
+/**
+ * \brief the built-in parameters.
+ */
+KernelParams defaultKernelParams();
+/**
+ * \brief the parameters used by the kernels.
+ */
+KernelParams &kernelParams();
+
+/**
+ * \brief key of this machine in the tuning cache: CPU model, the ISA extensions mllm was built with and the
+ *        thread count, e.g. "AMD_Ryzen_9_7950X|avx2,fma,f16c|t8".
+ */
+std::string tuningMachineKey(int thread_count);
+/**
+ * \brief load the entries of this machine from a tuning cache into kernelParams().
+ * \return false if the file does not exist or has no entry for this machine.
+ */
+bool loadKernelParams(const std::string &path, int thread_count);
+/**
+ * \brief write kernelParams() as the entries of this machine, keeping the entries of other machines.
+ */
+bool saveKernelParams(const std::string &path, int thread_count);
+
+#endif // MLLM_TUNING_HPP
@@ -114,6 +114,63 @@ void vec_dot_fp32(const float * __restrict src0, const float * __restrict src1,
     dst->setDataAt<float>({batch, head, src0_inf, sec1_outf}, value);
 }
 
+void vec_dot_bf16(const int n, float *__restrict s, const mllm_bf16_t *__restrict vx, const mllm_bf16_t *__restrict vy) {
+    float sumf = 0.0F;
+    int i = 0;
+#if defined(__AVX512BF16__)
+    __m512 sum0 = _mm512_setzero_ps();
+    __m512 sum1 = _mm512_setzero_ps();
+    for (; i + 64 <= n; i += 64) {
+        sum0 = _mm512_dpbf16_ps(sum0, (__m512bh)_mm512_loadu_si512(vx + i), (__m512bh)_mm512_loadu_si512(vy + i));
+        sum1 = _mm512_dpbf16_ps(sum1, (__m512bh)_mm512_loadu_si512(vx + i + 32), (__m512bh)_mm512_loadu_si512(vy + i + 32));
+    }
+    for (; i + 32 <= n; i += 32) {
+        sum0 = _mm512_dpbf16_ps(sum0, (__m512bh)_mm512_loadu_si512(vx + i), (__m512bh)_mm512_loadu_si512(vy + i));
+    }
+    sumf = _mm512_reduce_add_ps(_mm512_add_ps(sum0, sum1));
+#elif defined(__ARM_FEATURE_BF16_VECTOR_ARITHMETIC)
+    float32x4_t sum0 = vdupq_n_f32(0.0F);
+    float32x4_t sum1 = vdupq_n_f32(0.0F);
+    for (; i + 16 <= n; i += 16) {
+        sum0 = vbfdotq_f32(sum0, vld1q_bf16((const bfloat16_t *)(vx + i)), vld1q_bf16((const bfloat16_t *)(vy + i)));
+        sum1 = vbfdotq_f32(sum1, vld1q_bf16((const bfloat16_t *)(vx + i + 8)), vld1q_bf16((const bfloat16_t *)(vy + i + 8)));
+    }
+    sumf = vaddvq_f32(vaddq_f32(sum0, sum1));
+#endif
+    for (; i < n; ++i) {
+        sumf += mllm_bf16_to_fp32(vx[i]) * mllm_bf16_to_fp32(vy[i]);
+    }
+    *s = sumf;
+}
+
+void vec_dot_fp32_bf16(const int n, float *__restrict s, const mllm_bf16_t *__restrict vx, const float *__restrict vy) {
+    float sumf = 0.0F;
+    int i = 0;
+#if defined(__AVX2__)
+    __m256 sum[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+    for (; i + 32 <= n; i += 32) {
+        for (int j = 0; j < 4; ++j) {
+            const __m256i w = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(vx + i + j * 8)));
+            sum[j] = _mm256_fmadd_ps(_mm256_castsi256_ps(_mm256_slli_epi32(w, 16)), _mm256_loadu_ps(vy + i + j * 8), sum[j]);
+        }
+    }
+    sumf = hsum_float_8(_mm256_add_ps(_mm256_add_ps(sum[0], sum[1]), _mm256_add_ps(sum[2], sum[3])));
+#elif defined(__ARM_NEON)
+    float32x4_t sum[4] = {vdupq_n_f32(0.0F), vdupq_n_f32(0.0F), vdupq_n_f32(0.0F), vdupq_n_f32(0.0F)};
+    for (; i + 16 <= n; i += 16) {
+        for (int j = 0; j < 4; ++j) {
+            const float32x4_t w = vreinterpretq_f32_u32(vshll_n_u16(vld1_u16(vx + i + j * 4), 16));
+            sum[j] = vfmaq_f32(sum[j], w, vld1q_f32(vy + i + j * 4));
+        }
+    }
+    sumf = vaddvq_f32(vaddq_f32(vaddq_f32(sum[0], sum[1]), vaddq_f32(sum[2], sum[3])));
+#endif
+    for (; i < n; ++i) {
+        sumf += mllm_bf16_to_fp32(vx[i]) * vy[i];
+    }
+    *s = sumf;
+}
+
 void vec_dot_fp16(const int n, float * __restrict s, const mllm_fp16_t * __restrict vx, const mllm_fp16_t * __restrict vy) {
     float sumf = 0.0;
 
@@ -282,6 +339,341 @@ void vec_dot_q4_0_q8_0(const void * __restrict src0, const void * __restrict src
     dst->setDataAt<float>({batch, head, src0_inf, sec1_outf}, value);
 }
 
+void vec_dot_q8_0_q8_0(const int n, float * __restrict s, const void * __restrict vx, const void * __restrict vy) {
+    const int qk = QK8_0;
+    const int nb = n / qk;
+
+    assert(n % qk == 0);
+
+    const block_q8_0 *__restrict x = (block_q8_0 *)vx;
+    const block_q8_0 *__restrict y = (block_q8_0 *)vy;
+#ifdef __AVX2__
+    __m256 acc = _mm256_setzero_ps();
+    for (int i = 0; i < nb; ++i) {
+        const __m256 d = _mm256_set1_ps(MLLM_FP16_TO_FP32(x[i].d) * MLLM_FP16_TO_FP32(y[i].d));
+        const __m256i bx = _mm256_loadu_si256((const __m256i *)x[i].qs);
+        const __m256i by = _mm256_loadu_si256((const __m256i *)y[i].qs);
+        acc = _mm256_fmadd_ps(d, mul_sum_i8_pairs_float(bx, by), acc);
+    }
+    *s = hsum_float_8(acc);
+#elif defined(__ARM_NEON)
+    float32x4_t sumv = vdupq_n_f32(0.0F);
+    for (int i = 0; i < nb; ++i) {
+        const int8x16_t x0 = vld1q_s8(x[i].qs);
+        const int8x16_t x1 = vld1q_s8(x[i].qs + 16);
+        const int8x16_t y0 = vld1q_s8(y[i].qs);
+        const int8x16_t y1 = vld1q_s8(y[i].qs + 16);
+        const int16x8_t p0 = vaddq_s16(vmull_s8(vget_low_s8(x0), vget_low_s8(y0)), vmull_s8(vget_high_s8(x0), vget_high_s8(y0)));
+        const int16x8_t p1 = vaddq_s16(vmull_s8(vget_low_s8(x1), vget_low_s8(y1)), vmull_s8(vget_high_s8(x1), vget_high_s8(y1)));
+        const int32x4_t sumi = vaddq_s32(vpaddlq_s16(p0), vpaddlq_s16(p1));
+        sumv = vmlaq_n_f32(sumv, vcvtq_f32_s32(sumi), MLLM_FP16_TO_FP32(x[i].d) * MLLM_FP16_TO_FP32(y[i].d));
+    }
+    *s = vaddvq_f32(sumv);
+#else
+    float sumf = 0;
+    for (int i = 0; i < nb; ++i) {
+        int sumi = 0;
+        for (int j = 0; j < qk; ++j) {
+            sumi += x[i].qs[j] * y[i].qs[j];
+        }
+        sumf += sumi * MLLM_FP16_TO_FP32(x[i].d) * MLLM_FP16_TO_FP32(y[i].d);
+    }
+    *s = sumf;
+#endif
+}
+
+void vec_dot_q8_0_q8_0_x4(const int n, float * __restrict s, const void * __restrict vx, size_t row_size, const void * __restrict vy) {
+    assert(n % QK8_0 == 0);
+#ifdef __AVX2__
+    const int nb = n / QK8_0;
+    const block_q8_0 *__restrict x[4];
+    for (int r = 0; r < 4; ++r) {
+        x[r] = (const block_q8_0 *)((const char *)vx + r * row_size);
+    }
+    const block_q8_0 *__restrict y = (const block_q8_0 *)vy;
+    __m256 acc[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+    for (int i = 0; i < nb; ++i) {
+        const float dy = MLLM_FP16_TO_FP32(y[i].d);
+        const __m256i by = _mm256_loadu_si256((const __m256i *)y[i].qs);
+        for (int r = 0; r < 4; ++r) {
+            const __m256 d = _mm256_set1_ps(MLLM_FP16_TO_FP32(x[r][i].d) * dy);
+            const __m256i bx = _mm256_loadu_si256((const __m256i *)x[r][i].qs);
+            acc[r] = _mm256_fmadd_ps(d, mul_sum_i8_pairs_float(bx, by), acc[r]);
+        }
+    }
+    for (int r = 0; r < 4; ++r) {
+        s[r] = hsum_float_8(acc[r]);
+    }
+#else
+    for (int r = 0; r < 4; ++r) {
+        vec_dot_q8_0_q8_0(n, s + r, (const char *)vx + r * row_size, vy);
+    }
+#endif
+}
+
+#ifdef __AVX2__
+static inline int32_t hsum_i32_8(const __m256i a) {
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+    sum = _mm_add_epi32(sum, _mm_unpackhi_epi64(sum, sum));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+// acc += products of the 32 int8 pairs of x and y, summed by 4: |x| is made unsigned and its sign moved to y
+static inline __m256i dot_i8_32(__m256i acc, const __m256i x, const __m256i y) {
+    const __m256i ax = _mm256_sign_epi8(x, x);
+    const __m256i sy = _mm256_sign_epi8(y, x);
+#if defined(__AVXVNNI__)
+    return _mm256_dpbusd_avx_epi32(acc, ax, sy);
+#elif defined(__AVX512VNNI__) && defined(__AVX512VL__)
+    return _mm256_dpbusd_epi32(acc, ax, sy);
+#else
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_maddubs_epi16(ax, sy), _mm256_set1_epi16(1)));
+#endif
+}
+#elif defined(__ARM_NEON)
+static inline int32x4_t dot_i8_16(int32x4_t acc, const int8x16_t x, const int8x16_t y) {
+#if defined(__ARM_FEATURE_DOTPROD)
+    return vdotq_s32(acc, x, y);
+#else
+    const int16x8_t p = vmull_s8(vget_low_s8(x), vget_low_s8(y));
+    return vpadalq_s16(vpadalq_s16(acc, p), vmull_s8(vget_high_s8(x), vget_high_s8(y)));
+#endif
+}
+#endif
+
+int32_t vec_dot_i8_i8(const int n, const int8_t *__restrict x, const int8_t *__restrict y) {
+    assert(n % 32 == 0);
+#ifdef __AVX2__
+    __m256i acc = _mm256_setzero_si256();
+    for (int i = 0; i < n; i += 32) {
+        acc = dot_i8_32(acc, _mm256_loadu_si256((const __m256i *)(x + i)), _mm256_loadu_si256((const __m256i *)(y + i)));
+    }
+    return hsum_i32_8(acc);
+#elif defined(__ARM_NEON)
+    int32x4_t acc = vdupq_n_s32(0);
+    for (int i = 0; i < n; i += 16) {
+        acc = dot_i8_16(acc, vld1q_s8(x + i), vld1q_s8(y + i));
+    }
+    return vaddvq_s32(acc);
+#else
+    int32_t sum = 0;
+    for (int i = 0; i < n; ++i) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+#endif
+}
+
+void vec_dot_i8_i8_4xn(const int n, int32_t *__restrict s, const int8_t *__restrict x, size_t x_stride, const int8_t *__restrict y, size_t y_stride, int ny) {
+    assert(n % 32 == 0);
+    assert(ny == 1 || ny == 2);
+#ifdef __AVX2__
+    // every weight register is used for both activation rows, 8 accumulators stay in registers
+    __m256i acc[2][4];
+    for (int r = 0; r < 4; ++r) {
+        acc[0][r] = _mm256_setzero_si256();
+        acc[1][r] = _mm256_setzero_si256();
+    }
+    if (ny == 2) {
+        for (int i = 0; i < n; i += 32) {
+            const __m256i y0 = _mm256_loadu_si256((const __m256i *)(y + i));
+            const __m256i y1 = _mm256_loadu_si256((const __m256i *)(y + y_stride + i));
+            for (int r = 0; r < 4; ++r) {
+                const __m256i xr = _mm256_loadu_si256((const __m256i *)(x + r * x_stride + i));
+                acc[0][r] = dot_i8_32(acc[0][r], xr, y0);
+                acc[1][r] = dot_i8_32(acc[1][r], xr, y1);
+            }
+        }
+    } else {
+        for (int i = 0; i < n; i += 32) {
+            const __m256i y0 = _mm256_loadu_si256((const __m256i *)(y + i));
+            for (int r = 0; r < 4; ++r) {
+                acc[0][r] = dot_i8_32(acc[0][r], _mm256_loadu_si256((const __m256i *)(x + r * x_stride + i)), y0);
+            }
+        }
+    }
+    for (int j = 0; j < ny; ++j) {
+        for (int r = 0; r < 4; ++r) {
+            s[j * 4 + r] = hsum_i32_8(acc[j][r]);
+        }
+    }
+#elif defined(__ARM_NEON)
+    int32x4_t acc[2][4];
+    for (int r = 0; r < 4; ++r) {
+        acc[0][r] = vdupq_n_s32(0);
+        acc[1][r] = vdupq_n_s32(0);
+    }
+    for (int i = 0; i < n; i += 16) {
+        const int8x16_t y0 = vld1q_s8(y + i);
+        const int8x16_t y1 = vld1q_s8(y + (ny == 2 ? y_stride : 0) + i);
+        for (int r = 0; r < 4; ++r) {
+            const int8x16_t xr = vld1q_s8(x + r * x_stride + i);
+            acc[0][r] = dot_i8_16(acc[0][r], xr, y0);
+            acc[1][r] = dot_i8_16(acc[1][r], xr, y1);
+        }
+    }
+    for (int j = 0; j < ny; ++j) {
+        for (int r = 0; r < 4; ++r) {
+            s[j * 4 + r] = vaddvq_s32(acc[j][r]);
+        }
+    }
+#else
+    for (int j = 0; j < ny; ++j) {
+        for (int r = 0; r < 4; ++r) {
+            s[j * 4 + r] = vec_dot_i8_i8(n, x + r * x_stride, y + j * y_stride);
+        }
+    }
+#endif
+}
+
+/*
+ * The activations a 2:4 block is multiplied by: for the idx byte of 2 groups, the offsets of the 4 kept
+ * weights in those 8 activations, one per byte.
+ */
+static const uint32_t *sparse_24_offsets() {
+    static uint32_t offsets[256];
+    static const bool ready = [] {
+        for (uint32_t b = 0; b < 256; ++b) {
+            offsets[b] = (b & 3) | ((b >> 2) & 3) << 8 | (4 + ((b >> 4) & 3)) << 16 | (4 + (b >> 6)) << 24;
+        }
+        return true;
+    }();
+    (void)ready;
+    return offsets;
+}
+
+#if defined(__AVX2__)
+// the QK_24 / 2 activations of a Q8_0 block facing the kept weights of a 2:4 block
+static inline __m128i gather_24(const uint32_t *__restrict offsets, const uint8_t *__restrict idx, const int8_t *__restrict y) {
+    // bytes 0-7 index the first 16 activations, bytes 8-15 the last 16
+    const __m128i ctrl = _mm_setr_epi32(offsets[idx[0]], offsets[idx[1]] + 0x08080808, offsets[idx[2]], offsets[idx[3]] + 0x08080808);
+    const __m128i lo = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)y), ctrl);
+    const __m128i hi = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(y + 16)), ctrl);
+    return _mm_blend_epi16(lo, hi, 0xF0);
+}
+
+static inline __m128i unpack_q4_0_24(const uint8_t *__restrict qs) {
+    const __m128i m4 = _mm_set1_epi8(0x0F);
+    const __m128i v = _mm_loadl_epi64((const __m128i *)qs);
+    const __m128i q = _mm_unpacklo_epi8(_mm_and_si128(v, m4), _mm_and_si128(_mm_srli_epi16(v, 4), m4));
+    return _mm_sub_epi8(q, _mm_set1_epi8(8));
+}
+#elif defined(__ARM_NEON)
+static inline int8x16_t gather_24(const uint32_t *__restrict offsets, const uint8_t *__restrict idx, const int8_t *__restrict y) {
+    const uint32_t ctrl[4] = {offsets[idx[0]], offsets[idx[1]] + 0x08080808, offsets[idx[2]] + 0x10101010, offsets[idx[3]] + 0x18181818};
+    const int8x16x2_t table = {vld1q_s8(y), vld1q_s8(y + 16)};
+    return vqtbl2q_s8(table, vld1q_u8((const uint8_t *)ctrl));
+}
+
+static inline int32x4_t dot_i8_16x16(const int8x16_t x, const int8x16_t y) {
+#if defined(__ARM_FEATURE_DOTPROD)
+    return vdotq_s32(vdupq_n_s32(0), x, y);
+#else
+    return vpaddlq_s16(vaddq_s16(vmull_s8(vget_low_s8(x), vget_low_s8(y)), vmull_s8(vget_high_s8(x), vget_high_s8(y))));
+#endif
+}
+#endif
+
+void vec_dot_q4_0_24_q8_0(const int n, float *__restrict s, const void *__restrict vx, const void *__restrict vy) {
+    assert(n % QK_24 == 0);
+    static_assert(QK_24 == QK8_0, "a 2:4 block faces one Q8_0 block");
+    const int nb = n / QK_24;
+    const block_q4_0_24 *__restrict x = (const block_q4_0_24 *)vx;
+    const block_q8_0 *__restrict y = (const block_q8_0 *)vy;
+    const uint32_t *offsets = sparse_24_offsets();
+#if defined(__AVX2__)
+    __m256 acc = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 1 < nb; i += 2) {
+        const __m256i qx = _mm256_set_m128i(unpack_q4_0_24(x[i + 1].qs), unpack_q4_0_24(x[i].qs));
+        const __m256i qy = _mm256_set_m128i(gather_24(offsets, x[i + 1].idx, y[i + 1].qs), gather_24(offsets, x[i].idx, y[i].qs));
+        const __m256 d = _mm256_set_m128(_mm_set1_ps(MLLM_FP16_TO_FP32(x[i + 1].d) * MLLM_FP16_TO_FP32(y[i + 1].d)),
+                                         _mm_set1_ps(MLLM_FP16_TO_FP32(x[i].d) * MLLM_FP16_TO_FP32(y[i].d)));
+        acc = _mm256_fmadd_ps(d, mul_sum_i8_pairs_float(qx, qy), acc);
+    }
+    float sumf = hsum_float_8(acc);
+    for (; i < nb; ++i) {
+        const __m128i qx = unpack_q4_0_24(x[i].qs);
+        const __m128i qy = gather_24(offsets, x[i].idx, y[i].qs);
+        const __m128i p = _mm_madd_epi16(_mm_maddubs_epi16(_mm_sign_epi8(qx, qx), _mm_sign_epi8(qy, qx)), _mm_set1_epi16(1));
+        __m128i sum = _mm_add_epi32(p, _mm_unpackhi_epi64(p, p));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        sumf += _mm_cvtsi128_si32(sum) * MLLM_FP16_TO_FP32(x[i].d) * MLLM_FP16_TO_FP32(y[i].d);
+    }
+    *s = sumf;
+#elif defined(__ARM_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0F);
+    for (int i = 0; i < nb; ++i) {
+        const uint8x8_t v = vld1_u8(x[i].qs);
+        const uint8x8x2_t nibbles = vzip_u8(vand_u8(v, vdup_n_u8(0x0F)), vshr_n_u8(v, 4));
+        const int8x16_t qx = vsubq_s8(vreinterpretq_s8_u8(vcombine_u8(nibbles.val[0], nibbles.val[1])), vdupq_n_s8(8));
+        const int32x4_t p = dot_i8_16x16(qx, gather_24(offsets, x[i].idx, y[i].qs));
+        acc = vmlaq_n_f32(acc, vcvtq_f32_s32(p), MLLM_FP16_TO_FP32(x[i].d) * MLLM_FP16_TO_FP32(y[i].d));
+    }
+    *s = vaddvq_f32(acc);
+#else
+    float sumf = 0;
+    for (int i = 0; i < nb; ++i) {
+        int sumi = 0;
+        for (int j = 0; j < QK_24 / 2; ++j) {
+            const uint32_t offset = offsets[x[i].idx[j / 4]] >> ((j % 4) * 8) & 0xFF;
+            const int q = (j % 2 == 0 ? x[i].qs[j / 2] & 0x0F : x[i].qs[j / 2] >> 4) - 8;
+            sumi += q * y[i].qs[(j / 4) * 8 + offset];
+        }
+        sumf += sumi * MLLM_FP16_TO_FP32(x[i].d) * MLLM_FP16_TO_FP32(y[i].d);
+    }
+    *s = sumf;
+#endif
+}
+
+void vec_dot_q8_0_24_q8_0(const int n, float *__restrict s, const void *__restrict vx, const void *__restrict vy) {
+    assert(n % QK_24 == 0);
+    const int nb = n / QK_24;
+    const block_q8_0_24 *__restrict x = (const block_q8_0_24 *)vx;
+    const block_q8_0 *__restrict y = (const block_q8_0 *)vy;
+    const uint32_t *offsets = sparse_24_offsets();
+#if defined(__AVX2__)
+    __m256 acc = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 1 < nb; i += 2) {
+        const __m256i qx = _mm256_set_m128i(_mm_loadu_si128((const __m128i *)x[i + 1].qs), _mm_loadu_si128((const __m128i *)x[i].qs));
+        const __m256i qy = _mm256_set_m128i(gather_24(offsets, x[i + 1].idx, y[i + 1].qs), gather_24(offsets, x[i].idx, y[i].qs));
+        const __m256 d = _mm256_set_m128(_mm_set1_ps(MLLM_FP16_TO_FP32(x[i + 1].d) * MLLM_FP16_TO_FP32(y[i + 1].d)),
+                                         _mm_set1_ps(MLLM_FP16_TO_FP32(x[i].d) * MLLM_FP16_TO_FP32(y[i].d)));
+        acc = _mm256_fmadd_ps(d, mul_sum_i8_pairs_float(qx, qy), acc);
+    }
+    float sumf = hsum_float_8(acc);
+    for (; i < nb; ++i) {
+        const __m128i qx = _mm_loadu_si128((const __m128i *)x[i].qs);
+        const __m128i qy = gather_24(offsets, x[i].idx, y[i].qs);
+        const __m128i p = _mm_madd_epi16(_mm_maddubs_epi16(_mm_sign_epi8(qx, qx), _mm_sign_epi8(qy, qx)), _mm_set1_epi16(1));
+        __m128i sum = _mm_add_epi32(p, _mm_unpackhi_epi64(p, p));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        sumf += _mm_cvtsi128_si32(sum) * MLLM_FP16_TO_FP32(x[i].d) * MLLM_FP16_TO_FP32(y[i].d);
+    }
+    *s = sumf;
+#elif defined(__ARM_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0F);
+    for (int i = 0; i < nb; ++i) {
+        const int32x4_t p = dot_i8_16x16(vld1q_s8(x[i].qs), gather_24(offsets, x[i].idx, y[i].qs));
+        acc = vmlaq_n_f32(acc, vcvtq_f32_s32(p), MLLM_FP16_TO_FP32(x[i].d) * MLLM_FP16_TO_FP32(y[i].d));
+    }
+    *s = vaddvq_f32(acc);
+#else
+    float sumf = 0;
+    for (int i = 0; i < nb; ++i) {
+        int sumi = 0;
+        for (int j = 0; j < QK_24 / 2; ++j) {
+            const uint32_t offset = offsets[x[i].idx[j / 4]] >> ((j % 4) * 8) & 0xFF;
+            sumi += x[i].qs[j] * y[i].qs[(j / 4) * 8 + offset];
+        }
+        sumf += sumi * MLLM_FP16_TO_FP32(x[i].d) * MLLM_FP16_TO_FP32(y[i].d);
+    }
+    *s = sumf;
+#endif
+}
+
 #if QK_K == 256
 void vec_dot_q4_K_q8_K(const int n, float * __restrict s, const void * __restrict vx, const void * __restrict vy) {
     assert(n % QK_K == 0);
@@ -33,6 +33,7 @@
 #include "ParamLoader.hpp"
 #include "../quantize/QuantizeQ8.hpp"
 #include "../quantize/QuantizeQ4.hpp"
+#include "../quantize/QuantizeSparse.hpp"
 
 
 #include <chrono>
@@ -348,7 +349,24 @@ void vec_dot_q6_K_q8_K(const void * __restrict src0, const void * __restrict src
 void vec_dot_q4_K_q8_K(const int n, float * __restrict s, const void * __restrict vx, const void * __restrict vy);
 void vec_dot_q6_K_q8_K(const int n, float * __restrict s, const void * __restrict vx, const void * __restrict vy);
 void vec_dot_q4_0_q8_0(const int n, float * __restrict s, const void * __restrict vx, const void * __restrict vy);
+void vec_dot_q8_0_q8_0(const int n, float * __restrict s, const void * __restrict vx, const void * __restrict vy);
+// 2:4 sparse weights (vx) with a Q8_0 row (vy): the activations facing the kept weights are gathered, the others skipped
+void vec_dot_q4_0_24_q8_0(const int n, float * __restrict s, const void * __restrict vx, const void * __restrict vy);
+void vec_dot_q8_0_24_q8_0(const int n, float * __restrict s, const void * __restrict vx, const void * __restrict vy);
+// s[r] = dot(row r of vx, vy) for the 4 rows of vx, `row_size` bytes apart: the blocks of vy are loaded once
+void vec_dot_q8_0_q8_0_x4(const int n, float * __restrict s, const void * __restrict vx, size_t row_size, const void * __restrict vy);
+// int8 rows with one scale each (quantize_row_i8), n a multiple of 32
+int32_t vec_dot_i8_i8(const int n, const int8_t * __restrict x, const int8_t * __restrict y);
+// s[j * 4 + r] = dot(row r of x, row j of y) for the 4 rows of x and the `ny` (1 or 2) rows of y
+void vec_dot_i8_i8_4xn(const int n, int32_t * __restrict s, const int8_t * __restrict x, size_t x_stride, const int8_t * __restrict y, size_t y_stride, int ny);
 void vec_dot_fp32(const int n, float * __restrict s, const float * __restrict vx, const float * __restrict vy);
+// bf16 dot products in hardware (AVX512-BF16, ARMv8.6 BF16): activations are narrowed to bf16 and use vec_dot_bf16,
+// otherwise they stay fp32 and the weights are widened by a shift in vec_dot_fp32_bf16
+#if defined(__AVX512BF16__) || defined(__ARM_FEATURE_BF16_VECTOR_ARITHMETIC)
+#define MLLM_BF16_DOT
+#endif
+void vec_dot_bf16(const int n, float * __restrict s, const mllm_bf16_t * __restrict vx, const mllm_bf16_t * __restrict vy);
+void vec_dot_fp32_bf16(const int n, float * __restrict s, const mllm_bf16_t * __restrict vx, const float * __restrict vy);
 void vec_dot_fp16(const int n, float * __restrict s, const mllm_fp16_t * __restrict vx, const mllm_fp16_t * __restrict vy);
 
 #endif // MLLM_VECDOT_HPP
@@ -0,0 +1,86 @@
+/*
+ * This code is based on ggml(https://github.com/ggerganov/ggml),
+ * please see https://github.com/ggerganov/ggml/blob/master/src/ggml.c
+ * ggml is licensed under MIT Copyright (c) 2022 Georgi Gerganov:
+ *
+ * MIT License
+ * Copyright (c) 2022 Georgi Gerganov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Quantize.hpp"
+#include <mutex>
+
+#ifdef MLLM_FP16_TABLE
+const float *mllm_table_f32_f16() {
+    static float table[1 << 16];
+    // built by the first caller, the others wait for it
+    static const bool built = [] {
+        uint16_t ii;
+        for (int i = 0; i < (1 << 16); ++i) {
+            uint16_t ui = i;
+            memcpy(&ii, &ui, sizeof(ii));
+            table[i] = MLLM_COMPUTE_FP16_TO_FP32(ii);
+        }
+        return true;
+    }();
+    (void)built;
+    return table;
+}
+#endif
+
+mllm_fp16_t table_exp_f16[1 << 16];
+mllm_fp16_t mllm_table_gelu_f16[1 << 16];
+mllm_fp16_t mllm_table_gelu_quick_f16[1 << 16];
+mllm_fp16_t mllm_table_silu_f16[1 << 16];
+
+static void fill_table_f16(mllm_fp16_t *table, float (*fn)(float)) {
+    mllm_fp16_t ii;
+    for (int i = 0; i < (1 << 16); ++i) {
+        uint16_t ui = i;
+        memcpy(&ii, &ui, sizeof(ii));
+        const float f = MLLM_COMPUTE_FP16_TO_FP32(ii);
+        table[i] = MLLM_FP32_TO_FP16(fn(f));
+    }
+}
+
+static float exp_f32(float x) {
+    return expf(x);
+}
+
+void init_table_exp_f16() {
+    static std::once_flag flag;
+    std::call_once(flag, fill_table_f16, table_exp_f16, exp_f32);
+}
+
+void init_table_gelu_f16() {
+    static std::once_flag flag;
+    std::call_once(flag, fill_table_f16, mllm_table_gelu_f16, mllm_gelu_f32);
+}
+
+void init_table_gelu_quick_f16() {
+    static std::once_flag flag;
+    std::call_once(flag, fill_table_f16, mllm_table_gelu_quick_f16, mllm_gelu_quick_f32);
+}
+
+void init_table_silu_f16() {
+    static std::once_flag flag;
+    std::call_once(flag, fill_table_f16, mllm_table_silu_f16, mllm_silu_f32);
+}
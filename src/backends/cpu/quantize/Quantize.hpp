@@ -79,81 +79,30 @@
 #define MLLM_FP16_TO_FP32(x) ((float)(x))
 #define MLLM_FP32_TO_FP16(x) (x)
 
-#elif defined _MSC_VER
+#else
+#if defined _MSC_VER
 #define MLLM_COMPUTE_FP16_TO_FP32(x) _mm_cvtss_f32(_mm_cvtph_ps(_mm_cvtsi32_si128(x)))
 #define MLLM_COMPUTE_FP32_TO_FP16(x) _mm_extract_epi16(_mm_cvtps_ph(_mm_set_ss(x), 0), 0)
-
-static float table_f32_f16[1 << 16];
-static bool table_f32_f16_init = false;
-
-inline static float lookup_fp16_to_fp32(uint16_t f) {
-    if (!table_f32_f16_init) {
-        uint16_t ii;
-        for (int i = 0; i < (1 << 16); ++i) {
-            uint16_t ui = i;
-            memcpy(&ii, &ui, sizeof(ii));
-            table_f32_f16[i] = MLLM_COMPUTE_FP16_TO_FP32(ii);
-        }
-        table_f32_f16_init = true;
-    }
-    uint16_t s;
-    memcpy(&s, &f, sizeof(uint16_t));
-    return table_f32_f16[s];
-}
-
-#define MLLM_FP16_TO_FP32(x) lookup_fp16_to_fp32(x)
-#define MLLM_FP32_TO_FP16(x) MLLM_COMPUTE_FP32_TO_FP16(x)
-
 #else
 #define MLLM_COMPUTE_FP16_TO_FP32(x) _cvtsh_ss(x)
 #define MLLM_COMPUTE_FP32_TO_FP16(x) _cvtss_sh(x, 0)
+#endif
 
-static float table_f32_f16[1 << 16];
-static bool table_f32_f16_init = false;
+#define MLLM_FP16_TABLE
+// fp16 -> fp32 for every bit pattern, built on first use (see Quantize.cpp).
+const float *mllm_table_f32_f16();
 
 inline static float lookup_fp16_to_fp32(uint16_t f) {
-    if (!table_f32_f16_init) {
-        uint16_t ii;
-        for (int i = 0; i < (1 << 16); ++i) {
-            uint16_t ui = i;
-            memcpy(&ii, &ui, sizeof(ii));
-            table_f32_f16[i] = MLLM_COMPUTE_FP16_TO_FP32(ii);
-        }
-        table_f32_f16_init = true;
-    }
+    static const float *const table = mllm_table_f32_f16();
     uint16_t s;
     memcpy(&s, &f, sizeof(uint16_t));
-    return table_f32_f16[s];
+    return table[s];
 }
 
 #define MLLM_FP16_TO_FP32(x) lookup_fp16_to_fp32(x)
 #define MLLM_FP32_TO_FP16(x) MLLM_COMPUTE_FP32_TO_FP16(x)
 #endif
 
-static mllm_fp16_t table_exp_f16[1 << 16];
-static bool init_table_exp_f16_flag = false;
-inline void init_table_exp_f16() {
-    mllm_fp16_t ii;
-    for (int i = 0; i < (1 << 16); ++i) {
-        uint16_t ui = i;
-        memcpy(&ii, &ui, sizeof(ii));
-        const float f = MLLM_COMPUTE_FP16_TO_FP32(ii);
-        table_exp_f16[i] = MLLM_FP32_TO_FP16(expf(f));
-        //        float val = MLLM_FP16_TO_FP32(expf(f));
-        //        std::cout<<i<<"  "<<f<<" "<<expf(f)<<"  "<<val<<std::endl;
-        //        printf("%d  %f %f  %f\n", i, f, expf(f), val);
-    }
-}
-/*
-inline double mllm_table_exp(float input){
-    uint16_t scvt;
-    mllm_fp16_t tmp = MLLM_FP32_TO_FP16(input);
-    memcpy(&scvt, &tmp, sizeof(scvt));
-    const float val = MLLM_FP16_TO_FP32(table_exp_f16[scvt]);
-    return (double)val ;
-}
-*/
-
 static const float GELU_COEF_A     = 0.044715f;
 static const float GELU_QUICK_COEF = -1.702f;
 static const float SQRT_2_OVER_PI  = 0.79788456080286535587989211986876f;
@@ -171,18 +120,22 @@ inline static float mllm_silu_f32(float x) {
     return x/(1.0f + expf(-x));
 }
 
+/*
+ * fp16-indexed lookup tables of exp/GELU/QuickGELU/SiLU.
+ * There is one copy of each table per process, defined in Quantize.cpp. The init_table_* functions are
+ * thread-safe and only build their table the first time they are called, so ops simply call them from
+ * their constructors.
+ */
+extern mllm_fp16_t table_exp_f16[1 << 16];
+extern mllm_fp16_t mllm_table_gelu_f16[1 << 16];
+extern mllm_fp16_t mllm_table_gelu_quick_f16[1 << 16];
+extern mllm_fp16_t mllm_table_silu_f16[1 << 16];
+void init_table_exp_f16();
+void init_table_gelu_f16();
+void init_table_gelu_quick_f16();
+void init_table_silu_f16();
+
 //GELU
-static mllm_fp16_t mllm_table_gelu_f16[1 << 16];
-static bool init_table_gelu_f16_flag = false;
-inline void init_table_gelu_f16() {
-    mllm_fp16_t ii;
-    for (int i = 0; i < (1 << 16); ++i) {
-        uint16_t ui = i;
-        memcpy(&ii, &ui, sizeof(ii));
-        const float f = MLLM_COMPUTE_FP16_TO_FP32(ii);
-        mllm_table_gelu_f16[i] = MLLM_FP32_TO_FP16(mllm_gelu_f32(f));
-    }
-}
 inline static void mllm_vec_gelu_f32(const int n, float * y, const float * x) {
     uint16_t t;
 //#pragma omp parallel for num_threads(thread_count)
@@ -194,17 +147,6 @@ inline static void mllm_vec_gelu_f32(const int n, float * y, const float * x) {
 }
 
 //QuickGELU
-static mllm_fp16_t mllm_table_gelu_quick_f16[1 << 16];
-static bool init_table_gelu_quick_f16_flag = false;
-inline void init_table_gelu_quick_f16() {
-    mllm_fp16_t ii;
-    for (int i = 0; i < (1 << 16); ++i) {
-        uint16_t ui = i;
-        memcpy(&ii, &ui, sizeof(ii));
-        const float f = MLLM_COMPUTE_FP16_TO_FP32(ii);
-        mllm_table_gelu_quick_f16[i] = MLLM_FP32_TO_FP16(mllm_gelu_quick_f32(f));
-    }
-}
 inline static void mllm_vec_gelu_quick_f32(const int n, float * y, const float * x) {
     uint16_t t;
 //#pragma omp parallel for num_threads(thread_count)
@@ -215,17 +157,6 @@ inline static void mllm_vec_gelu_quick_f32(const int n, float * y, const float *
     }
 }
 //SiLU
-static mllm_fp16_t mllm_table_silu_f16[1 << 16];
-static bool init_table_silu_f16_flag = false;
-inline void init_table_silu_f16() {
-    mllm_fp16_t ii;
-    for (int i = 0; i < (1 << 16); ++i) {
-        uint16_t ui = i;
-        memcpy(&ii, &ui, sizeof(ii));
-        const float f = MLLM_COMPUTE_FP16_TO_FP32(ii);
-        mllm_table_silu_f16[i] = MLLM_FP32_TO_FP16(mllm_silu_f32(f));
-    }
-}
 inline static void mllm_vec_silu_f32(const int n, float * y, const float * x) {
     uint16_t t;
 //#pragma omp parallel for num_threads(thread_count)
@@ -237,7 +168,6 @@ inline static void mllm_vec_silu_f32(const int n, float * y, const float * x) {
 }
 
 
-
 #if __AVX__ || __AVX2__ || defined(__AVX512F__)
 static inline __m256i get_scale_shuffle_k4(int i) {
     static const uint8_t KShuffle[256] = {
@@ -353,7 +283,22 @@ inline float mllm_fp16_to_fp32(mllm_fp16_t x) {
 }
 
 inline void mllm_fp16_to_fp32_row(const mllm_fp16_t *x, float *y, int n) {
-    for (int i = 0; i < n; i++) {
+    int i = 0;
+#if defined(__F16C__)
+    for (; i + 7 < n; i += 8) {
+        __m128i x_vec = _mm_loadu_si128((const __m128i *)(x + i));
+        _mm256_storeu_ps(y + i, _mm256_cvtph_ps(x_vec));
+    }
+    for (; i + 3 < n; i += 4) {
+        __m128i x_vec = _mm_loadl_epi64((const __m128i *)(x + i));
+        _mm_storeu_ps(y + i, _mm_cvtph_ps(x_vec));
+    }
+#elif defined(__ARM_NEON) && !defined(_MSC_VER)
+    for (; i + 3 < n; i += 4) {
+        vst1q_f32(y + i, vcvt_f32_f16(vld1_f16((const float16_t *)(x + i))));
+    }
+#endif
+    for (; i < n; i++) {
         y[i] = MLLM_FP16_TO_FP32(x[i]);
     }
 }
@@ -371,10 +316,63 @@ inline void mllm_fp32_to_fp16_row(const float *x, mllm_fp16_t *y, int n) {
         __m128i y_vec = _mm_cvtps_ph(x_vec, _MM_FROUND_TO_NEAREST_INT);
         _mm_storel_epi64((__m128i *)(y + i), y_vec);
     }
+#elif defined(__ARM_NEON) && !defined(_MSC_VER)
+    for (; i + 3 < n; i += 4) {
+        vst1_f16((float16_t *)(y + i), vcvt_f16_f32(vld1q_f32(x + i)));
+    }
 #endif
     for (; i < n; i++) {
         y[i] = MLLM_FP32_TO_FP16(x[i]);
     }
 }
 
+// FP32_BF16
+
+// bf16 is the high half of an fp32: widening is a shift, narrowing rounds to nearest even and keeps NaNs quiet
+inline float mllm_bf16_to_fp32(mllm_bf16_t x) {
+    const uint32_t bits = (uint32_t)x << 16;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+inline mllm_bf16_t mllm_fp32_to_bf16(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    if ((bits & 0x7fffffff) > 0x7f800000) {
+        return (mllm_bf16_t)((bits >> 16) | 0x40);
+    }
+    return (mllm_bf16_t)((bits + 0x7fff + ((bits >> 16) & 1)) >> 16);
+}
+
+inline void mllm_bf16_to_fp32_row(const mllm_bf16_t *x, float *y, int n) {
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 7 < n; i += 8) {
+        const __m256i w = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(x + i)));
+        _mm256_storeu_ps(y + i, _mm256_castsi256_ps(_mm256_slli_epi32(w, 16)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 3 < n; i += 4) {
+        vst1q_f32(y + i, vreinterpretq_f32_u32(vshll_n_u16(vld1_u16(x + i), 16)));
+    }
+#endif
+    for (; i < n; i++) {
+        y[i] = mllm_bf16_to_fp32(x[i]);
+    }
+}
+
+inline void mllm_fp32_to_bf16_row(const float *x, mllm_bf16_t *y, int n) {
+    int i = 0;
+#if defined(__AVX512BF16__) && defined(__AVX512VL__)
+    for (; i + 7 < n; i += 8) {
+        const __m128bh y_vec = _mm256_cvtneps_pbh(_mm256_loadu_ps(x + i));
+        memcpy(y + i, &y_vec, sizeof(y_vec));
+    }
+#endif
+    for (; i < n; i++) {
+        y[i] = mllm_fp32_to_bf16(x[i]);
+    }
+}
+
 #endif // MLLM_QUANTIZE_HPP
@@ -0,0 +1,223 @@
+#include "QuantizeLUT.hpp"
+
+int lut_bits(DataType type) {
+    switch (type) {
+    case MLLM_TYPE_Q2_LUT: return 2;
+    case MLLM_TYPE_Q3_LUT: return 3;
+    default: return 0;
+    }
+}
+
+// the largest |weight| of a block if it only holds 0, a and -a, else -1
+static float ternary_lut(const float *__restrict x) {
+    float amax = 0.0F;
+    for (int i = 0; i < QK_LUT; ++i) {
+        amax = MAX(amax, fabsf(x[i]));
+    }
+    for (int i = 0; i < QK_LUT; ++i) {
+        if (x[i] != 0 && fabsf(x[i]) != amax) {
+            return -1.0F;
+        }
+    }
+    return amax;
+}
+
+bool is_ternary_lut(const float *__restrict x, int64_t k) {
+    if (k % QK_LUT != 0) {
+        return false;
+    }
+    for (int64_t i = 0; i < k; i += QK_LUT) {
+        if (ternary_lut(x + i) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// q of every weight of a block for a given d and m; returns the squared error
+static float levels_lut(const float *__restrict x, uint8_t *__restrict q, int nmax, float d, float m) {
+    const float id = d ? 1.0F / d : 0.0F;
+    float err = 0.0F;
+    for (int i = 0; i < QK_LUT; ++i) {
+        const int l = nearest_int((x[i] - m) * id);
+        q[i] = (uint8_t)MAX(0, MIN(nmax, l));
+        const float diff = d * q[i] + m - x[i];
+        err += diff * diff;
+    }
+    return err;
+}
+
+/*
+ * d and m of a block of QK_LUT weights with 2^bits levels: the range of the block, shrunk a little to clip
+ * outliers, then refined by least squares on the levels it gives. The best of a few shrink factors is kept.
+ */
+static void quantize_block_lut(const float *__restrict x, mllm_fp16_t *d_out, mllm_fp16_t *m_out,
+                               uint8_t (*__restrict qs)[QK_LUT / 8], int bits) {
+    const int nmax = (1 << bits) - 1;
+    float min = x[0];
+    float max = x[0];
+    for (int i = 0; i < QK_LUT; ++i) {
+        min = MIN(min, x[i]);
+        max = MAX(max, x[i]);
+    }
+    const float ternary = bits == 2 ? ternary_lut(x) : -1.0F;
+    uint8_t q[QK_LUT];
+    float best_d = 0.0F;
+    float best_m = min;
+    if (ternary > 0) {
+        best_d = ternary;
+        best_m = -ternary;
+    } else if (max > min) {
+        float best_err = INFINITY;
+        for (int step = 0; step < 7; ++step) {
+            const float shrink = 1.0F - 0.05F * step;
+            float m = min * shrink;
+            float d = (max - min) * shrink / nmax;
+            for (int iter = 0; iter < 3; ++iter) {
+                const float err = levels_lut(x, q, nmax, d, m);
+                if (err < best_err) {
+                    best_err = err;
+                    best_d = d;
+                    best_m = m;
+                }
+                // minimize sum (d * q + m - x)^2 over d and m
+                float sq = 0, sq2 = 0, sx = 0, sqx = 0;
+                for (int i = 0; i < QK_LUT; ++i) {
+                    sq += q[i];
+                    sq2 += (float)q[i] * q[i];
+                    sx += x[i];
+                    sqx += q[i] * x[i];
+                }
+                const float det = QK_LUT * sq2 - sq * sq;
+                if (det <= 0) {
+                    break;
+                }
+                d = (QK_LUT * sqx - sq * sx) / det;
+                m = (sq2 * sx - sq * sqx) / det;
+            }
+        }
+    }
+    *d_out = MLLM_FP32_TO_FP16(best_d);
+    *m_out = MLLM_FP32_TO_FP16(best_m);
+    // the levels of the stored, rounded d and m
+    levels_lut(x, q, nmax, MLLM_FP16_TO_FP32(*d_out), MLLM_FP16_TO_FP32(*m_out));
+    for (int p = 0; p < bits; ++p) {
+        memset(qs[p], 0, QK_LUT / 8);
+        for (int i = 0; i < QK_LUT; ++i) {
+            qs[p][i / 8] |= ((q[i] >> p) & 1) << (i % 8);
+        }
+    }
+}
+
+static void dequantize_block_lut(mllm_fp16_t d_in, mllm_fp16_t m_in, const uint8_t (*__restrict qs)[QK_LUT / 8],
+                                 float *__restrict y, int bits) {
+    const float d = MLLM_FP16_TO_FP32(d_in);
+    const float m = MLLM_FP16_TO_FP32(m_in);
+    for (int i = 0; i < QK_LUT; ++i) {
+        int q = 0;
+        for (int p = 0; p < bits; ++p) {
+            q |= ((qs[p][i / 8] >> (i % 8)) & 1) << p;
+        }
+        y[i] = d * q + m;
+    }
+}
+
+void quantize_row_q2_lut(const float *__restrict x, void *__restrict vy, int k) {
+    assert(k % QK_LUT == 0);
+    auto *y = (block_q2_lut *)vy;
+    for (int i = 0; i < k / QK_LUT; i++) {
+        quantize_block_lut(x + i * QK_LUT, &y[i].d, &y[i].m, y[i].qs, 2);
+    }
+}
+
+void dequantize_row_q2_lut(const void *__restrict vx, float *__restrict y, int k) {
+    assert(k % QK_LUT == 0);
+    const auto *x = (const block_q2_lut *)vx;
+    for (int i = 0; i < k / QK_LUT; i++) {
+        dequantize_block_lut(x[i].d, x[i].m, x[i].qs, y + i * QK_LUT, 2);
+    }
+}
+
+void quantize_row_q3_lut(const float *__restrict x, void *__restrict vy, int k) {
+    assert(k % QK_LUT == 0);
+    auto *y = (block_q3_lut *)vy;
+    for (int i = 0; i < k / QK_LUT; i++) {
+        quantize_block_lut(x + i * QK_LUT, &y[i].d, &y[i].m, y[i].qs, 3);
+    }
+}
+
+void dequantize_row_q3_lut(const void *__restrict vx, float *__restrict y, int k) {
+    assert(k % QK_LUT == 0);
+    const auto *x = (const block_q3_lut *)vx;
+    for (int i = 0; i < k / QK_LUT; i++) {
+        dequantize_block_lut(x[i].d, x[i].m, x[i].qs, y + i * QK_LUT, 3);
+    }
+}
+
+void quantize_row_lut_table(const float *__restrict x, block_lut_table *__restrict y, int k) {
+    assert(k % QK_LUT == 0);
+    for (int i = 0; i < k / QK_LUT; i++) {
+        const float *xb = x + i * QK_LUT;
+        float amax = 0.0F;
+        for (int j = 0; j < QK_LUT; ++j) {
+            amax = MAX(amax, fabsf(xb[j]));
+        }
+        const float d = amax / 127;
+        const float id = d ? 1.0F / d : 0.0F;
+        int sum = 0;
+        for (int g = 0; g < QK_LUT / 4; ++g) {
+            int16_t table[16];
+            table[0] = 0;
+            // entry e is the sum of the activations of the set bits of e
+            for (int j = 0; j < 4; ++j) {
+                const int q = nearest_int(xb[g * 4 + j] * id);
+                sum += q;
+                for (int e = 0; e < (1 << j); ++e) {
+                    table[(1 << j) + e] = (int16_t)(table[e] + q);
+                }
+            }
+            uint8_t *lo = y[i].t[g / 2][0] + (g % 2) * 16;
+            uint8_t *hi = y[i].t[g / 2][1] + (g % 2) * 16;
+            for (int e = 0; e < 16; ++e) {
+                lo[e] = (uint8_t)(table[e] & 0xFF);
+                hi[e] = (uint8_t)((uint16_t)table[e] >> 8);
+            }
+        }
+        y[i].d = d;
+        y[i].sum = d * sum;
+    }
+}
+
+size_t lut_tile_size(int bits) {
+    return QR_LUT * (2 * sizeof(mllm_fp16_t) + bits * QK_LUT / 8);
+}
+
+void pack_rows_lut(DataType type, const void *__restrict rows, void *__restrict tiles, int n, int k) {
+    const int bits = lut_bits(type);
+    assert(bits > 0 && k % QK_LUT == 0);
+    const int nb = k / QK_LUT;
+    const size_t block_size = DataTypeSize(type, QK_LUT);
+    const size_t row_size = block_size * nb;
+    const int ntiles = (n + QR_LUT - 1) / QR_LUT;
+    memset(tiles, 0, lut_tile_size(bits) * ntiles * nb);
+    for (int t = 0; t < ntiles; ++t) {
+        for (int i = 0; i < nb; ++i) {
+            auto *tile = (uint8_t *)tiles + (t * nb + i) * lut_tile_size(bits);
+            auto *d = (mllm_fp16_t *)tile;
+            auto *m = d + QR_LUT;
+            uint8_t *qs = tile + 2 * sizeof(mllm_fp16_t) * QR_LUT;
+            for (int r = 0; r < QR_LUT && t * QR_LUT + r < n; ++r) {
+                // d, m and then the planes, in both block types
+                const auto *block = (const uint8_t *)rows + (size_t)(t * QR_LUT + r) * row_size + i * block_size;
+                memcpy(d + r, block, sizeof(mllm_fp16_t));
+                memcpy(m + r, block + sizeof(mllm_fp16_t), sizeof(mllm_fp16_t));
+                const uint8_t *planes = block + 2 * sizeof(mllm_fp16_t);
+                for (int j = 0; j < QK_LUT / 8; ++j) {
+                    for (int p = 0; p < bits; ++p) {
+                        qs[(j * bits + p) * QR_LUT + r] = planes[p * QK_LUT / 8 + j];
+                    }
+                }
+            }
+        }
+    }
+}
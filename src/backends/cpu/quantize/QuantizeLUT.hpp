@@ -0,0 +1,54 @@
+#ifndef MLLM_QUANTIZELUT_HPP
+#define MLLM_QUANTIZELUT_HPP
+
+#include "Quantize.hpp"
+
+/*
+ * Q2_LUT / Q3_LUT, see block_q2_lut. The dot product of a row with the activations is
+ *     sum_i (d * q_i + m) * x_i = d * sum_p 2^p * sum_i bit_p(q_i) * x_i + m * sum_i x_i
+ * and the 4 bits of a plane over a group of 4 weights select one of the 16 partial sums of the group's 4
+ * activations. Those tables are built once per token (quantize_row_lut_table) and read with byte shuffles
+ * (pshufb / tbl), 16 rows at a time: CPULinear repacks the rows into tiles of QR_LUT rows (pack_rows_lut) in
+ * which the nibbles of the 16 rows for the same groups are adjacent.
+ *
+ * Ternary weights ({-a, 0, a} in every block) are stored exactly as Q2_LUT, q = w / a + 1.
+ */
+
+#define QR_LUT 16
+
+/*
+ * the tables of a block of QK_LUT activations, quantized to int8 with scale d. A partial sum of 4 int8 does
+ * not fit in a byte: t[j][0] holds the low bytes and t[j][1] the high bytes of the 16 sums of group 2j, then
+ * of group 2j + 1.
+ */
+typedef struct {
+    float d;                      // scale of the activations
+    float sum;                    // sum of the quantized activations, times d
+    uint8_t t[QK_LUT / 8][2][32]; // tables of the group pairs
+} block_lut_table;
+
+// bits per weight of a LUT type, 0 for any other type
+int lut_bits(DataType type);
+// whether every block of QK_LUT weights only holds 0, a and -a, which Q2_LUT stores exactly
+bool is_ternary_lut(const float *__restrict x, int64_t k);
+
+void quantize_row_q2_lut(const float *__restrict x, void *__restrict y, int k);
+void dequantize_row_q2_lut(const void *__restrict vx, float *__restrict y, int k);
+void quantize_row_q3_lut(const float *__restrict x, void *__restrict y, int k);
+void dequantize_row_q3_lut(const void *__restrict vx, float *__restrict y, int k);
+
+void quantize_row_lut_table(const float *__restrict x, block_lut_table *__restrict y, int k);
+
+/**
+ * \brief bytes of a tile: QR_LUT rows of one block, their d, then their m, then qs[QK_LUT / 8][bits][QR_LUT],
+ *        byte r of qs[j][p] being byte j of plane p of row r (groups 2j and 2j + 1).
+ */
+size_t lut_tile_size(int bits);
+/**
+ * \brief repack `n` rows of `k` weights of a LUT type into tiles, the tiles of the first QR_LUT rows first.
+ *        The last tile is padded with zero rows; `tiles` holds lut_tile_size(bits) * ceil(n / QR_LUT) * k / QK_LUT
+ *        bytes.
+ */
+void pack_rows_lut(DataType type, const void *__restrict rows, void *__restrict tiles, int n, int k);
+
+#endif // MLLM_QUANTIZELUT_HPP
@@ -255,3 +255,16 @@ void dequantize_row_q8_K(const block_q8_K * __restrict x, float * __restrict y,
 void quantize_row_q8_K(const float * __restrict x, void * __restrict y, int k) {
     quantize_row_q8_K_reference(x, (block_q8_K  *)y, k);
 }
+
+float quantize_row_i8(const float * __restrict x, int8_t * __restrict y, int k) {
+    float amax = 0.0F;
+    for (int i = 0; i < k; ++i) {
+        amax = MAX(amax, fabsf(x[i]));
+    }
+    const float scale = amax / 127.0F;
+    const float iscale = scale != 0.0F ? 1.0F / scale : 0.0F;
+    for (int i = 0; i < k; ++i) {
+        y[i] = (int8_t)MAX(-127, MIN(127, nearest_int(iscale * x[i])));
+    }
+    return scale;
+}
@@ -36,4 +36,7 @@ void dequantize_row_q8_0(const void * __restrict vx, float * __restrict y, int k
 void quantize_row_q8_K(const float * __restrict x, void * __restrict y, int k);
 void dequantize_row_q8_K(const block_q8_K * __restrict x, float * __restrict y, int k);
 
+// symmetric int8 with one scale for the whole row, returned: x[i] ~= y[i] * scale
+float quantize_row_i8(const float * __restrict x, int8_t * __restrict y, int k);
+
 #endif // MLLM_QUANTIZEQ8_HPP
@@ -0,0 +1,123 @@
+#include "QuantizeSparse.hpp"
+#include <utility>
+
+bool is_sparse_24(const float *__restrict x, int64_t k) {
+    if (k % 4 != 0) {
+        return false;
+    }
+    for (int64_t i = 0; i < k; i += 4) {
+        if ((x[i] != 0) + (x[i + 1] != 0) + (x[i + 2] != 0) + (x[i + 3] != 0) > 2) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// keeps the 2 largest weights of every group of a block, in order: fills kept[QK_24 / 2] and idx
+static void select_24(const float *__restrict x, float *__restrict kept, uint8_t *__restrict idx) {
+    for (int g = 0; g < QK_24 / 4; ++g) {
+        const float *group = x + g * 4;
+        int first = 0;
+        int second = 1;
+        if (fabsf(group[second]) > fabsf(group[first])) {
+            std::swap(first, second);
+        }
+        for (int j = 2; j < 4; ++j) {
+            if (fabsf(group[j]) > fabsf(group[first])) {
+                second = first;
+                first = j;
+            } else if (fabsf(group[j]) > fabsf(group[second])) {
+                second = j;
+            }
+        }
+        if (first > second) {
+            std::swap(first, second);
+        }
+        kept[g * 2] = group[first];
+        kept[g * 2 + 1] = group[second];
+        const uint8_t positions = (uint8_t)(first | second << 2);
+        if (g % 2 == 0) {
+            idx[g / 2] = positions;
+        } else {
+            idx[g / 2] |= positions << 4;
+        }
+    }
+}
+
+// the dense position in its block of kept weight j
+static inline int position_24(const uint8_t *__restrict idx, int j) {
+    const int g = j / 2;
+    return g * 4 + ((idx[g / 2] >> ((g % 2) * 4 + (j % 2) * 2)) & 3);
+}
+
+void quantize_row_q4_0_24(const float *__restrict x, void *__restrict vy, int k) {
+    assert(k % QK_24 == 0);
+    auto *y = (block_q4_0_24 *)vy;
+    float kept[QK_24 / 2];
+    for (int i = 0; i < k / QK_24; i++) {
+        select_24(x + i * QK_24, kept, y[i].idx);
+        // as Q4_0: the largest weight maps to -8
+        float amax = 0.0F;
+        float max = 0.0F;
+        for (float v : kept) {
+            if (amax < fabsf(v)) {
+                amax = fabsf(v);
+                max = v;
+            }
+        }
+        const float d = max / -8;
+        const float id = d ? 1.0F / d : 0.0F;
+        y[i].d = MLLM_FP32_TO_FP16(d);
+        for (int j = 0; j < QK_24 / 4; ++j) {
+            const uint8_t xi0 = MIN(15, (int8_t)(kept[2 * j] * id + 8.5F));
+            const uint8_t xi1 = MIN(15, (int8_t)(kept[2 * j + 1] * id + 8.5F));
+            y[i].qs[j] = xi0 | xi1 << 4;
+        }
+    }
+}
+
+void dequantize_row_q4_0_24(const void *__restrict vx, float *__restrict y, int k) {
+    assert(k % QK_24 == 0);
+    const auto *x = (const block_q4_0_24 *)vx;
+    for (int i = 0; i < k / QK_24; i++) {
+        const float d = MLLM_FP16_TO_FP32(x[i].d);
+        float *out = y + i * QK_24;
+        memset(out, 0, QK_24 * sizeof(float));
+        for (int j = 0; j < QK_24 / 2; ++j) {
+            const int q = (j % 2 == 0 ? x[i].qs[j / 2] & 0x0F : x[i].qs[j / 2] >> 4) - 8;
+            out[position_24(x[i].idx, j)] = q * d;
+        }
+    }
+}
+
+void quantize_row_q8_0_24(const float *__restrict x, void *__restrict vy, int k) {
+    assert(k % QK_24 == 0);
+    auto *y = (block_q8_0_24 *)vy;
+    float kept[QK_24 / 2];
+    for (int i = 0; i < k / QK_24; i++) {
+        select_24(x + i * QK_24, kept, y[i].idx);
+        float amax = 0.0F;
+        for (float v : kept) {
+            amax = MAX(amax, fabsf(v));
+        }
+        const float d = amax / 127;
+        const float id = d ? 1.0F / d : 0.0F;
+        y[i].d = MLLM_FP32_TO_FP16(d);
+        for (int j = 0; j < QK_24 / 2; ++j) {
+            y[i].qs[j] = (int8_t)roundf(kept[j] * id);
+        }
+    }
+}
+
+void dequantize_row_q8_0_24(const void *__restrict vx, float *__restrict y, int k) {
+    assert(k % QK_24 == 0);
+    const auto *x = (const block_q8_0_24 *)vx;
+    for (int i = 0; i < k / QK_24; i++) {
+        const float d = MLLM_FP16_TO_FP32(x[i].d);
+        float *out = y + i * QK_24;
+        memset(out, 0, QK_24 * sizeof(float));
+        for (int j = 0; j < QK_24 / 2; ++j) {
+            out[position_24(x[i].idx, j)] = x[i].qs[j] * d;
+        }
+    }
+}
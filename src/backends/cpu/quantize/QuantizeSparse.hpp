@@ -0,0 +1,17 @@
+#ifndef MLLM_QUANTIZESPARSE_HPP
+#define MLLM_QUANTIZESPARSE_HPP
+
+#include "Quantize.hpp"
+
+/*
+ * 2:4 sparse Q4_0 / Q8_0, see block_q4_0_24. A group with more than 2 weights that are not zero keeps its 2
+ * largest; is_sparse_24 tells whether a weight loses nothing that way.
+ */
+bool is_sparse_24(const float *__restrict x, int64_t k);
+
+void quantize_row_q4_0_24(const float *__restrict x, void *__restrict y, int k);
+void dequantize_row_q4_0_24(const void *__restrict vx, float *__restrict y, int k);
+void quantize_row_q8_0_24(const float *__restrict x, void *__restrict y, int k);
+void dequantize_row_q8_0_24(const void *__restrict vx, float *__restrict y, int k);
+
+#endif // MLLM_QUANTIZESPARSE_HPP
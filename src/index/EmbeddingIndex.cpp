@@ -0,0 +1,357 @@
+//
+// In-process nearest-neighbour search over embeddings (CLIP, ImageBind, ...).
+//
+
+#include "EmbeddingIndex.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "backends/cpu/compute/VecDot.hpp"
+#include "backends/cpu/quantize/Quantize.hpp"
+#include "backends/cpu/quantize/QuantizeQ8.hpp"
+
+namespace mllm {
+
+/*
+ * File layout, every section starting on an ALIGNMENT boundary so that it can be used in place once mapped:
+ *   header
+ *   centroids   float[lists x dimension]
+ *   list sizes  int64[max(lists, 1)]
+ *   codes       the vectors, list after list
+ *   ids         int64, list after list
+ */
+static const int32_t INDEX_MAGIC = 0x58444E49; // "INDX"
+static const int32_t INDEX_VERSION = 1;
+static const size_t ALIGNMENT = 64;
+struct IndexHeader {
+    int32_t magic;
+    int32_t version;
+    int32_t dimension;
+    int32_t type;
+    int32_t lists;
+    int32_t reserved;
+    int64_t size;
+};
+
+static size_t alignUp(size_t offset) {
+    return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+static void dotF32(int n, float *s, const void *x, const void *y) {
+    vec_dot_fp32(n, s, (const float *)x, (const float *)y);
+}
+static void dotF16(int n, float *s, const void *x, const void *y) {
+    vec_dot_fp16(n, s, (const mllm_fp16_t *)x, (const mllm_fp16_t *)y);
+}
+
+EmbeddingIndex::EmbeddingIndex(int dimension, DataType type, int lists, int threads) :
+    dimension_(dimension), type_(type), lists_count_(lists), threads_(threads), probes_(std::min(std::max(lists, 1), 16)),
+    lists_(std::max(lists, 1)) {
+    switch (type) {
+    case MLLM_TYPE_F32:
+        dot_ = dotF32;
+        break;
+    case MLLM_TYPE_F16:
+        dot_ = dotF16;
+        break;
+    case MLLM_TYPE_Q8_0:
+        assert(dimension % QK8_0 == 0);
+        dot_ = vec_dot_q8_0_q8_0;
+        break;
+    default:
+        std::cerr << "EmbeddingIndex does not support " << DataTypeName(type) << std::endl;
+        exit(1);
+    }
+    code_size_ = DataTypeSize(type, dimension);
+}
+
+EmbeddingIndex::~EmbeddingIndex() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mapping_size_);
+    }
+}
+
+int64_t EmbeddingIndex::size() const {
+    int64_t size = 0;
+    for (const auto &list : lists_) {
+        size += list.size;
+    }
+    return size;
+}
+
+void EmbeddingIndex::encode(const float *vector, uint8_t *code) const {
+    switch (type_) {
+    case MLLM_TYPE_F32:
+        memcpy(code, vector, code_size_);
+        break;
+    case MLLM_TYPE_F16:
+        mllm_fp32_to_fp16_row(vector, (mllm_fp16_t *)code, dimension_);
+        break;
+    default:
+        quantize_row_q8_0(vector, code, dimension_);
+        break;
+    }
+}
+
+int EmbeddingIndex::nearestCentroid(const float *vector) const {
+    int best = 0;
+    float best_score = -INFINITY;
+    for (int c = 0; c < lists_count_; ++c) {
+        float score;
+        vec_dot_fp32(dimension_, &score, centroids_.data() + (size_t)c * dimension_, vector);
+        if (score > best_score) {
+            best_score = score;
+            best = c;
+        }
+    }
+    return best;
+}
+
+void EmbeddingIndex::train(const float *vectors, int64_t count, int iterations) {
+    if (lists_count_ == 0) {
+        return;
+    }
+    assert(count >= lists_count_);
+    assert(size() == 0);
+    const size_t dim = dimension_;
+    std::mt19937_64 rng(42);
+    // initial centroids: distinct random sample vectors
+    vector<int64_t> picks(count);
+    for (int64_t i = 0; i < count; ++i) {
+        picks[i] = i;
+    }
+    std::shuffle(picks.begin(), picks.end(), rng);
+    centroids_.assign((size_t)lists_count_ * dim, 0.0F);
+    for (int c = 0; c < lists_count_; ++c) {
+        memcpy(centroids_.data() + c * dim, vectors + picks[c] * dim, dim * sizeof(float));
+    }
+    vector<int> assignment(count);
+    vector<double> sums((size_t)lists_count_ * dim);
+    vector<int64_t> members(lists_count_);
+    for (int it = 0; it < iterations; ++it) {
+#pragma omp parallel for num_threads(threads_)
+        for (int64_t i = 0; i < count; ++i) {
+            assignment[i] = nearestCentroid(vectors + i * dim);
+        }
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(members.begin(), members.end(), 0);
+        for (int64_t i = 0; i < count; ++i) {
+            double *sum = sums.data() + (size_t)assignment[i] * dim;
+            const float *v = vectors + i * dim;
+            for (size_t d = 0; d < dim; ++d) {
+                sum[d] += v[d];
+            }
+            ++members[assignment[i]];
+        }
+        for (int c = 0; c < lists_count_; ++c) {
+            float *centroid = centroids_.data() + c * dim;
+            if (members[c] == 0) {
+                // an empty cluster restarts from a random vector
+                memcpy(centroid, vectors + (rng() % count) * dim, dim * sizeof(float));
+                continue;
+            }
+            double norm = 0;
+            for (size_t d = 0; d < dim; ++d) {
+                norm += sums[c * dim + d] * sums[c * dim + d];
+            }
+            const double scale = norm > 0 ? 1.0 / std::sqrt(norm) : 0.0;
+            for (size_t d = 0; d < dim; ++d) {
+                centroid[d] = (float)(sums[c * dim + d] * scale);
+            }
+        }
+    }
+}
+
+void EmbeddingIndex::detach() {
+    if (mapping_ == nullptr) {
+        return;
+    }
+    for (auto &list : lists_) {
+        list.codes.assign(list.code_data, list.code_data + list.size * code_size_);
+        list.ids.assign(list.id_data, list.id_data + list.size);
+        list.code_data = list.codes.data();
+        list.id_data = list.ids.data();
+    }
+    munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+}
+
+void EmbeddingIndex::add(const float *vectors, int64_t count, const int64_t *ids) {
+    assert(trained());
+    detach();
+    const int64_t first_id = size();
+    vector<uint8_t> codes(count * code_size_);
+    vector<int> assignment(count, 0);
+#pragma omp parallel for num_threads(threads_)
+    for (int64_t i = 0; i < count; ++i) {
+        encode(vectors + i * dimension_, codes.data() + i * code_size_);
+        if (lists_count_ > 0) {
+            assignment[i] = nearestCentroid(vectors + i * dimension_);
+        }
+    }
+    for (int64_t i = 0; i < count; ++i) {
+        auto &list = lists_[assignment[i]];
+        list.codes.insert(list.codes.end(), codes.data() + i * code_size_, codes.data() + (i + 1) * code_size_);
+        list.ids.push_back(ids != nullptr ? ids[i] : first_id + i);
+    }
+    for (auto &list : lists_) {
+        list.code_data = list.codes.data();
+        list.id_data = list.ids.data();
+        list.size = (int64_t)list.ids.size();
+    }
+}
+
+void EmbeddingIndex::search(const float *queries, int64_t count, int k, int64_t *ids, float *scores) const {
+    const int probes = lists_count_ == 0 ? 1 : std::min(std::max(probes_, 1), lists_count_);
+#pragma omp parallel for num_threads(threads_)
+    for (int64_t q = 0; q < count; ++q) {
+        const float *query = queries + q * dimension_;
+        vector<uint8_t> code(code_size_);
+        encode(query, code.data());
+        // lists to scan
+        vector<int> scan(1, 0);
+        if (lists_count_ > 0) {
+            vector<float> closeness(lists_count_);
+            scan.resize(lists_count_);
+            for (int c = 0; c < lists_count_; ++c) {
+                vec_dot_fp32(dimension_, &closeness[c], centroids_.data() + (size_t)c * dimension_, query);
+                scan[c] = c;
+            }
+            std::partial_sort(scan.begin(), scan.begin() + probes, scan.end(), [&closeness](int a, int b) {
+                return closeness[a] > closeness[b];
+            });
+            scan.resize(probes);
+        }
+        // min-heap of the best k so far
+        std::priority_queue<std::pair<float, int64_t>, vector<std::pair<float, int64_t>>, std::greater<>> best;
+        for (int l : scan) {
+            const auto &list = lists_[l];
+            const uint8_t *row = list.code_data;
+            for (int64_t i = 0; i < list.size; ++i, row += code_size_) {
+                float score;
+                dot_(dimension_, &score, row, code.data());
+                if ((int)best.size() < k) {
+                    best.emplace(score, list.id_data[i]);
+                } else if (score > best.top().first) {
+                    best.pop();
+                    best.emplace(score, list.id_data[i]);
+                }
+            }
+        }
+        for (int i = k - 1; i >= 0; --i) {
+            if (i < (int)best.size()) {
+                ids[q * k + i] = best.top().second;
+                scores[q * k + i] = best.top().first;
+                best.pop();
+            } else {
+                ids[q * k + i] = -1;
+                scores[q * k + i] = -INFINITY;
+            }
+        }
+    }
+}
+
+static bool writePadded(FILE *fp, const void *data, size_t size) {
+    static const char zeros[ALIGNMENT] = {0};
+    if (size > 0 && fwrite(data, size, 1, fp) != 1) {
+        return false;
+    }
+    const size_t pad = alignUp(ftell(fp)) - ftell(fp);
+    return pad == 0 || fwrite(zeros, pad, 1, fp) == 1;
+}
+
+bool EmbeddingIndex::save(const string &path) const {
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr) {
+        return false;
+    }
+    const IndexHeader header = {INDEX_MAGIC, INDEX_VERSION, dimension_, (int32_t)type_, lists_count_, 0, size()};
+    vector<int64_t> sizes;
+    for (const auto &list : lists_) {
+        sizes.push_back(list.size);
+    }
+    bool ok = writePadded(fp, &header, sizeof(header));
+    ok = ok && writePadded(fp, centroids_.data(), centroids_.size() * sizeof(float));
+    ok = ok && writePadded(fp, sizes.data(), sizes.size() * sizeof(int64_t));
+    for (const auto &list : lists_) {
+        ok = ok && (list.size == 0 || fwrite(list.code_data, list.size * code_size_, 1, fp) == 1);
+    }
+    ok = ok && writePadded(fp, nullptr, 0);
+    for (const auto &list : lists_) {
+        ok = ok && (list.size == 0 || fwrite(list.id_data, list.size * sizeof(int64_t), 1, fp) == 1);
+    }
+    ok = fclose(fp) == 0 && ok;
+    return ok;
+}
+
+std::unique_ptr<EmbeddingIndex> EmbeddingIndex::open(const string &path, int threads) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st {};
+    void *mapping = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(IndexHeader)) {
+        mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Cannot map index " << path << std::endl;
+        return nullptr;
+    }
+    const size_t file_size = st.st_size;
+    const auto *base = (const uint8_t *)mapping;
+    const auto *header = (const IndexHeader *)base;
+    const auto type = (DataType)header->type;
+    if (header->magic != INDEX_MAGIC || header->version != INDEX_VERSION || header->dimension <= 0 || header->lists < 0
+        || (type != MLLM_TYPE_F32 && type != MLLM_TYPE_F16 && type != MLLM_TYPE_Q8_0)) {
+        std::cerr << "Invalid index " << path << std::endl;
+        munmap(mapping, file_size);
+        return nullptr;
+    }
+    std::unique_ptr<EmbeddingIndex> index(new EmbeddingIndex(header->dimension, type, header->lists, threads));
+    index->mapping_ = mapping;
+    index->mapping_size_ = file_size;
+    const size_t n_lists = index->lists_.size();
+    size_t offset = alignUp(sizeof(IndexHeader));
+    const size_t centroid_offset = offset;
+    offset = alignUp(offset + (size_t)header->lists * header->dimension * sizeof(float));
+    const auto *sizes = (const int64_t *)(base + offset);
+    offset = alignUp(offset + n_lists * sizeof(int64_t));
+    if (offset > file_size) {
+        std::cerr << "Truncated index " << path << std::endl;
+        return nullptr;
+    }
+    int64_t total = 0;
+    for (size_t l = 0; l < n_lists; ++l) {
+        total += sizes[l] >= 0 ? sizes[l] : header->size + 1;
+    }
+    size_t code_offset = offset;
+    size_t id_offset = alignUp(offset + header->size * index->code_size_);
+    if (total != header->size || id_offset + header->size * sizeof(int64_t) > file_size) {
+        std::cerr << "Truncated index " << path << std::endl;
+        return nullptr;
+    }
+    index->centroids_.assign((const float *)(base + centroid_offset),
+                             (const float *)(base + centroid_offset) + (size_t)header->lists * header->dimension);
+    for (auto &list : index->lists_) {
+        list.size = *sizes++;
+        list.code_data = base + code_offset;
+        list.id_data = (const int64_t *)(base + id_offset);
+        code_offset += list.size * index->code_size_;
+        id_offset += list.size * sizeof(int64_t);
+    }
+    return index;
+}
+} // namespace mllm
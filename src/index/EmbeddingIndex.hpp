@@ -0,0 +1,114 @@
+//
+// In-process nearest-neighbour search over embeddings (CLIP, ImageBind, ...).
+//
+
+#ifndef MLLM_EMBEDDINGINDEX_HPP
+#define MLLM_EMBEDDINGINDEX_HPP
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Types.hpp"
+
+namespace mllm {
+using std::string;
+using std::vector;
+
+/**
+ * \brief an index of embeddings searched by inner product (cosine similarity for normalised embeddings).
+ *
+ * The vectors are stored as MLLM_TYPE_F32, MLLM_TYPE_F16 or MLLM_TYPE_Q8_0 (int8 blocks of QK8_0 values with one
+ * scale each) and compared with the SIMD vec_dot kernels of the CPU backend.
+ * With `lists` == 0 the index is exact: every query scans every vector.
+ * With `lists` > 0 it is an IVF index: train() clusters a sample into `lists` centroids (spherical k-means),
+ * add() files every vector under its closest centroid, and a query only scans the lists of its `probes` closest
+ * centroids. Embeddings should then be normalised.
+ *
+ * save() writes a file that open() maps read-only, so a large index is paged in on demand instead of being read
+ * and copied. An index returned by open() can still be added to; its data is then copied to memory first.
+ *
+ * e.g.
+ *   EmbeddingIndex index(512, MLLM_TYPE_F16, 1024);
+ *   index.train(sample, sample_count);
+ *   index.add(embeddings, count);
+ *   index.search(queries, query_count, 10, ids, scores);
+ */
+class EmbeddingIndex {
+public:
+    EmbeddingIndex(int dimension, DataType type = MLLM_TYPE_F32, int lists = 0, int threads = 4);
+    ~EmbeddingIndex();
+    EmbeddingIndex(const EmbeddingIndex &) = delete;
+    EmbeddingIndex &operator=(const EmbeddingIndex &) = delete;
+
+    /**
+     * \brief cluster `count` vectors into the IVF centroids. Does nothing for an exact index.
+     *        Must be called before the first add().
+     */
+    void train(const float *vectors, int64_t count, int iterations = 10);
+    bool trained() const {
+        return lists_count_ == 0 || !centroids_.empty();
+    }
+    /**
+     * \brief add `count` vectors of dimension() floats.
+     * \param ids  the id reported by search() for each vector; nullptr numbers them from size()
+     */
+    void add(const float *vectors, int64_t count, const int64_t *ids = nullptr);
+    /**
+     * \brief the `k` vectors with the largest inner product with each of `count` queries, best first.
+     *        The queries of a batch are searched in parallel.
+     * \param ids     count x k ids, -1 where fewer than k vectors were scanned
+     * \param scores  count x k inner products
+     */
+    void search(const float *queries, int64_t count, int k, int64_t *ids, float *scores) const;
+    /**
+     * \brief number of IVF lists scanned per query; more is slower and closer to the exact result.
+     */
+    void setProbes(int probes) {
+        probes_ = probes;
+    }
+
+    bool save(const string &path) const;
+    /**
+     * \brief map an index written by save(). Returns nullptr if the file is missing or invalid.
+     */
+    static std::unique_ptr<EmbeddingIndex> open(const string &path, int threads = 4);
+
+    int64_t size() const;
+    int dimension() const {
+        return dimension_;
+    }
+    DataType type() const {
+        return type_;
+    }
+
+private:
+    // the vectors filed under one centroid, stored in `codes`/`ids` or in the mapped file
+    struct List {
+        vector<uint8_t> codes;
+        vector<int64_t> ids;
+        const uint8_t *code_data = nullptr;
+        const int64_t *id_data = nullptr;
+        int64_t size = 0;
+    };
+    using DotFunc = void (*)(int n, float *s, const void *x, const void *y);
+
+    void encode(const float *vector, uint8_t *code) const;
+    int nearestCentroid(const float *vector) const;
+    // copy the mapped lists to memory before they are modified
+    void detach();
+
+    int dimension_;
+    DataType type_;
+    int lists_count_;
+    int threads_;
+    int probes_;
+    size_t code_size_;
+    DotFunc dot_;
+    vector<float> centroids_; // lists_count_ x dimension_, normalised
+    vector<List> lists_;
+    void *mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+};
+} // namespace mllm
+
+#endif // MLLM_EMBEDDINGINDEX_HPP
@@ -0,0 +1,93 @@
+#include "memory/MmapMemoryManager.hpp"
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mllm {
+
+MmapMemoryManager::MmapMemoryManager(std::string dir) :
+    dir_(std::move(dir)) {
+}
+
+MmapMemoryManager::~MmapMemoryManager() {
+    for (auto &mapping : mappings_) {
+        munmap(mapping.first, mapping.second.size);
+        close(mapping.second.fd);
+    }
+}
+
+void MmapMemoryManager::alloc(void **ptr, size_t size, size_t alignment) {
+    assert(size > 0);
+    // mappings are page aligned, which covers any alignment a Tensor asks for
+    std::string path = dir_ + "/mllm-XXXXXX";
+    std::vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+    int fd = mkstemp(name.data());
+    if (fd < 0 || ftruncate(fd, (off_t)size) != 0) {
+        std::cerr << "Cannot create scratch file in " << dir_ << std::endl;
+        if (fd >= 0) {
+            close(fd);
+            unlink(name.data());
+        }
+        *ptr = nullptr;
+        return;
+    }
+    unlink(name.data());
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Cannot map scratch file of " << size << " bytes" << std::endl;
+        close(fd);
+        *ptr = nullptr;
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    mappings_[addr] = {fd, size};
+    *ptr = addr;
+}
+
+void MmapMemoryManager::free(void *ptr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = mappings_.find(ptr);
+    assert(it != mappings_.end());
+    munmap(it->first, it->second.size);
+    close(it->second.fd);
+    mappings_.erase(it);
+}
+
+// page-aligned [begin, end) inside [ptr, ptr + size), partial pages at the edges are left alone
+static bool innerPages(void *ptr, size_t size, uintptr_t &begin, uintptr_t &end) {
+    const auto page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    begin = ((uintptr_t)ptr + page - 1) & ~(page - 1);
+    end = ((uintptr_t)ptr + size) & ~(page - 1);
+    return end > begin;
+}
+
+void MmapMemoryManager::evict(void *ptr, size_t size) {
+    uintptr_t begin, end;
+    if (!innerPages(ptr, size, begin, end)) {
+        return;
+    }
+    msync((void *)begin, end - begin, MS_ASYNC);
+#ifdef MADV_PAGEOUT
+    if (madvise((void *)begin, end - begin, MADV_PAGEOUT) == 0) {
+        return;
+    }
+#endif
+    // older kernels: unmap the pages from the process, the page cache drops them once they are written back
+    madvise((void *)begin, end - begin, MADV_DONTNEED);
+}
+
+void MmapMemoryManager::prefetch(void *ptr, size_t size) {
+    uintptr_t begin, end;
+    if (!innerPages(ptr, size, begin, end)) {
+        return;
+    }
+    madvise((void *)begin, end - begin, MADV_WILLNEED);
+}
+
+} // namespace mllm
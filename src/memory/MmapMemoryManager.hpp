@@ -0,0 +1,44 @@
+#ifndef MLLM_MEMORY_MMAP_H
+#define MLLM_MEMORY_MMAP_H
+
+#include "MemoryManager.hpp"
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace mllm {
+/**
+ * \brief The MmapMemoryManager backs every allocation with a scratch file mapped into memory.
+ * The pages of a file-backed mapping can be written out and dropped from RAM (evict) and read back on demand,
+ * which lets data that is rarely touched live on local storage instead of in RAM.
+ * The files are unlinked as soon as they are created, so nothing is left behind if the process dies.
+ */
+class MmapMemoryManager : public MemoryManager {
+public:
+    explicit MmapMemoryManager(std::string dir);
+    ~MmapMemoryManager() override;
+
+    void alloc(void **ptr, size_t size, size_t alignment) override;
+
+    void free(void *ptr) override;
+
+    /**
+     * \brief write the pages of [ptr, ptr + size) back to the file and release them from RAM.
+     */
+    static void evict(void *ptr, size_t size);
+    /**
+     * \brief start reading the pages of [ptr, ptr + size) back in the background.
+     */
+    static void prefetch(void *ptr, size_t size);
+
+private:
+    struct Mapping {
+        int fd;
+        size_t size;
+    };
+    std::string dir_;
+    std::mutex mutex_;
+    std::map<void *, Mapping> mappings_;
+};
+} // namespace mllm
+#endif
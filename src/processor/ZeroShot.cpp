@@ -0,0 +1,178 @@
+//
+// Zero-shot classification against a fixed label set, with the label embeddings cached on disk.
+//
+
+#include "ZeroShot.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/stat.h>
+#include "backends/cpu/compute/VecDot.hpp"
+#include "backends/cpu/quantize/Quantize.hpp"
+
+namespace mllm {
+
+// cache file: magic, version, dimension, label count, the model as (length, bytes), then each label as
+// (length, bytes), then the F16 matrix
+static const int32_t ZERO_SHOT_MAGIC = 0x5A534C4D; // "MLSZ"
+static const int32_t ZERO_SHOT_VERSION = 2;
+
+static bool writeString(FILE *fp, const string &str) {
+    const int32_t length = (int32_t)str.size();
+    return fwrite(&length, sizeof(length), 1, fp) == 1 && (length == 0 || fwrite(str.data(), length, 1, fp) == 1);
+}
+
+static bool readString(FILE *fp, string &str) {
+    int32_t length = 0;
+    if (fread(&length, sizeof(length), 1, fp) != 1 || length < 0) {
+        return false;
+    }
+    str.assign(length, '\0');
+    return length == 0 || fread(&str[0], length, 1, fp) == 1;
+}
+
+static void normalizeRow(const float *src, mllm_fp16_t *dst, int dimension) {
+    double sum = 0;
+    for (int d = 0; d < dimension; ++d) {
+        sum += (double)src[d] * src[d];
+    }
+    const float scale = sum > 0 ? (float)(1.0 / std::sqrt(sum)) : 0.0F;
+    vector<float> row(dimension);
+    for (int d = 0; d < dimension; ++d) {
+        row[d] = src[d] * scale;
+    }
+    mllm_fp32_to_fp16_row(row.data(), dst, dimension);
+}
+
+void ZeroShotClassifier::setLabels(const vector<string> &labels, const float *embeddings, int dimension, const string &model) {
+    labels_ = labels;
+    dimension_ = dimension;
+    model_ = model;
+    embeddings_.resize(labels.size() * dimension);
+    for (size_t l = 0; l < labels.size(); ++l) {
+        normalizeRow(embeddings + l * dimension, embeddings_.data() + l * dimension, dimension);
+    }
+}
+
+string ZeroShotClassifier::modelIdentity(const string &model_path) {
+    struct stat st;
+    if (stat(model_path.c_str(), &st) != 0) {
+        return model_path;
+    }
+    return model_path + " " + std::to_string((long long)st.st_size) + " " + std::to_string((long long)st.st_mtime);
+}
+
+bool ZeroShotClassifier::prepare(const vector<string> &labels, const TextEncoder &encode, const string &cache_path,
+                                 const string &model, int dimension) {
+    if (!cache_path.empty() && load(cache_path)) {
+        if (labels_ == labels && model_ == model && dimension_ == dimension) {
+            return true;
+        }
+        std::cout << "Label cache " << cache_path << " was written for other labels or another model, rebuilding it" << std::endl;
+    }
+    vector<float> embeddings;
+    embeddings.reserve(labels.size() * dimension);
+    for (const auto &label : labels) {
+        auto embedding = encode(label);
+        if ((int)embedding.size() != dimension) {
+            std::cerr << "Label embedding of width " << embedding.size() << ", expected " << dimension << std::endl;
+        }
+        assert((int)embedding.size() == dimension);
+        embeddings.insert(embeddings.end(), embedding.begin(), embedding.end());
+    }
+    setLabels(labels, embeddings.data(), dimension, model);
+    if (!cache_path.empty() && !save(cache_path)) {
+        std::cerr << "Cannot write label cache " << cache_path << std::endl;
+    }
+    return false;
+}
+
+bool ZeroShotClassifier::save(const string &path) const {
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr) {
+        return false;
+    }
+    const int32_t header[4] = {ZERO_SHOT_MAGIC, ZERO_SHOT_VERSION, dimension_, (int32_t)labels_.size()};
+    bool ok = fwrite(header, sizeof(header), 1, fp) == 1 && writeString(fp, model_);
+    for (const auto &label : labels_) {
+        ok = ok && writeString(fp, label);
+    }
+    ok = ok && (embeddings_.empty() || fwrite(embeddings_.data(), sizeof(mllm_fp16_t) * embeddings_.size(), 1, fp) == 1);
+    ok = fclose(fp) == 0 && ok;
+    return ok;
+}
+
+bool ZeroShotClassifier::load(const string &path) {
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp == nullptr) {
+        return false;
+    }
+    int32_t header[4];
+    bool ok = fread(header, sizeof(header), 1, fp) == 1 && header[0] == ZERO_SHOT_MAGIC
+              && header[1] == ZERO_SHOT_VERSION && header[2] > 0 && header[3] >= 0;
+    string model;
+    ok = ok && readString(fp, model);
+    vector<string> labels;
+    for (int32_t l = 0; ok && l < header[3]; ++l) {
+        string label;
+        ok = readString(fp, label);
+        labels.push_back(std::move(label));
+    }
+    vector<mllm_fp16_t> embeddings;
+    if (ok) {
+        embeddings.resize((size_t)header[2] * header[3]);
+        ok = embeddings.empty() || fread(embeddings.data(), sizeof(mllm_fp16_t) * embeddings.size(), 1, fp) == 1;
+    }
+    fclose(fp);
+    if (!ok) {
+        return false;
+    }
+    labels_ = std::move(labels);
+    dimension_ = header[2];
+    model_ = std::move(model);
+    embeddings_ = std::move(embeddings);
+    return true;
+}
+
+vector<vector<ZeroShotClassifier::Match>> ZeroShotClassifier::classify(const float *embeddings, int count, int k, float logit_scale) const {
+    const int n_labels = (int)labels_.size();
+    k = std::min(k, n_labels);
+    vector<mllm_fp16_t> queries(count * dimension_);
+    for (int q = 0; q < count; ++q) {
+        normalizeRow(embeddings + q * dimension_, queries.data() + q * dimension_, dimension_);
+    }
+    // scores[q * n_labels + l]; each label row is read once for all the queries
+    vector<float> scores((size_t)count * n_labels);
+#pragma omp parallel for num_threads(threads_)
+    for (int l = 0; l < n_labels; ++l) {
+        const mllm_fp16_t *row = embeddings_.data() + (size_t)l * dimension_;
+        for (int q = 0; q < count; ++q) {
+            vec_dot_fp16(dimension_, &scores[(size_t)q * n_labels + l], row, queries.data() + q * dimension_);
+        }
+    }
+    vector<vector<Match>> results(count);
+    vector<int> order(n_labels);
+    for (int q = 0; q < count; ++q) {
+        const float *score = scores.data() + (size_t)q * n_labels;
+        for (int l = 0; l < n_labels; ++l) {
+            order[l] = l;
+        }
+        std::partial_sort(order.begin(), order.begin() + k, order.end(), [score](int a, int b) {
+            return score[a] > score[b];
+        });
+        double sum = 0;
+        const float max_score = n_labels > 0 ? *std::max_element(score, score + n_labels) : 0.0F;
+        for (int l = 0; l < n_labels; ++l) {
+            sum += std::exp(logit_scale * (score[l] - max_score));
+        }
+        for (int i = 0; i < k; ++i) {
+            const int l = order[i];
+            results[q].push_back({l, score[l], (float)(std::exp(logit_scale * (score[l] - max_score)) / sum)});
+        }
+    }
+    return results;
+}
+} // namespace mllm
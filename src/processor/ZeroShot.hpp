@@ -0,0 +1,85 @@
+//
+// Zero-shot classification against a fixed label set, with the label embeddings cached on disk.
+//
+
+#ifndef ZEROSHOT_HPP
+#define ZEROSHOT_HPP
+#include <functional>
+#include <string>
+#include <vector>
+#include "Types.hpp"
+
+namespace mllm {
+using std::string;
+using std::vector;
+
+/**
+ * \brief classifies embeddings (e.g. CLIP image features) against a fixed set of labels.
+ *
+ * The text tower only runs once per label: the label embeddings are normalised, stored as one F16 matrix
+ * (labels x dimension) and written to a cache file, so that later runs with the same labels skip the text side.
+ * Classifying an embedding is then one similarity GEMV against that matrix followed by a top-k selection.
+ */
+class ZeroShotClassifier {
+public:
+    struct Match {
+        int label;         // index into labels()
+        float similarity;  // cosine similarity
+        float probability; // softmax of logit_scale * similarity over all the labels
+    };
+    // returns the (not necessarily normalised) embedding of one label text
+    using TextEncoder = std::function<vector<float>(const string &label)>;
+
+    explicit ZeroShotClassifier(int threads = 4) :
+        threads_(threads) {
+    }
+
+    /**
+     * \brief load the label embeddings from `cache_path`, or compute them with `encode` and write the cache.
+     *        The cache is only reused if it was written for exactly `labels`, in the same order, by the same model
+     *        and with the same embedding width.
+     * \param cache_path  may be empty, in which case nothing is read or written
+     * \param model       identity of the model behind `encode`, see modelIdentity()
+     * \param dimension   width of the embeddings classify() will be given
+     * \return true if the embeddings came from the cache
+     */
+    bool prepare(const vector<string> &labels, const TextEncoder &encode, const string &cache_path,
+                 const string &model, int dimension);
+    /**
+     * \brief identifies a model file by its path, size and modification time, for prepare().
+     */
+    static string modelIdentity(const string &model_path);
+    /**
+     * \brief set the label embeddings directly; `embeddings` holds labels.size() rows of `dimension` floats.
+     */
+    void setLabels(const vector<string> &labels, const float *embeddings, int dimension, const string &model = "");
+    bool load(const string &path);
+    bool save(const string &path) const;
+
+    /**
+     * \brief the `k` labels closest to each of `count` embeddings, best first.
+     * \param embeddings  `count` rows of dimension() floats, need not be normalised
+     * \param logit_scale the temperature of the probabilities, 100 for CLIP
+     */
+    vector<vector<Match>> classify(const float *embeddings, int count, int k, float logit_scale = 100.0F) const;
+
+    const vector<string> &labels() const {
+        return labels_;
+    }
+    int dimension() const {
+        return dimension_;
+    }
+    const string &model() const {
+        return model_;
+    }
+
+private:
+    int threads_;
+    vector<string> labels_;
+    int dimension_ = 0;
+    string model_;
+    vector<mllm_fp16_t> embeddings_; // labels_.size() x dimension_, each row of unit length
+};
+} // namespace mllm
+
+#endif // ZEROSHOT_HPP
@@ -54,6 +54,17 @@ void ParamWriter::writeParam(string name, DataType type, void *data, uint64_t si
     param.size = foff_size;
     index_++;
 }
+bool ParamWriter::tieParam(string name, const string &target) {
+    for (uint64_t i = 0; i < index_; ++i) {
+        if (param_info_[i].name == target) {
+            param_info_[index_] = param_info_[i];
+            param_info_[index_].name = std::move(name);
+            index_++;
+            return true;
+        }
+    }
+    return false;
+}
 void ParamWriter::paddingIndex(const vector<string> names) {
     param_info_.resize(names.size());
     // write 0 padding to preserve space for index
@@ -33,6 +33,8 @@ public:
     int calcIndexSize(vector<string> names);
     void writeIndex();
     virtual void writeParam(string name, DataType type, void *data, uint64_t size);
+    // index `name` on the data already written for `target`; false if `target` is not written yet
+    bool tieParam(string name, const string &target);
     void paddingIndex(vector<string> names);
 
 private:
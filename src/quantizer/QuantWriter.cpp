@@ -20,19 +20,53 @@ QuantWriter::~QuantWriter() {
     }
 #endif
 };
+void QuantWriter::setSmoothing(const ActivationStats *stats, float alpha) {
+    smoothing_stats_ = stats;
+    smoothing_alpha_ = alpha;
+}
+string QuantWriter::smoothedLayer(const string &name) const {
+    const string suffix = ".weight";
+    if (smoothing_stats_ == nullptr || name.size() <= suffix.size()
+        || name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        return "";
+    }
+    const string layer = name.substr(0, name.size() - suffix.size());
+    return smoothing_stats_->find(layer) != nullptr ? layer : "";
+}
 int QuantWriter::readParams() {
     param_names_ = param_loader_->getParamNames();
+    // the row scales and the factors of the smoothed layers are written with their weights
+    const auto names = param_names_;
+    for (const auto &name : names) {
+        const auto layer = smoothedLayer(name);
+        if (!layer.empty()) {
+            param_names_.push_back(layer + ".scale");
+            param_names_.push_back(layer + ".smooth");
+        }
+    }
     paddingIndex(param_names_);
     return param_names_.size();
 }
 float *QuantWriter::getParam(std::string param_name) {
     auto type = param_loader_->data_type_[param_name];
-    if (type != DataType::MLLM_TYPE_F32) {
+    if (type != DataType::MLLM_TYPE_F32 && type != DataType::MLLM_TYPE_BF16) {
         return nullptr;
     }
     auto [data, size] = param_loader_->load(param_name);
+    if (type == DataType::MLLM_TYPE_BF16) {
+        // bf16 checkpoints are quantized from their exact fp32 values
+        const auto count = size / sizeof(mllm_bf16_t);
+        auto *widened = new float[count];
+        mllm_bf16_to_fp32_row((const mllm_bf16_t *)data, widened, (int)count);
+        delete[] data;
+        return widened;
+    }
     return static_cast<float *>((void *)data);
 }
+uint64_t QuantWriter::paramCount(const std::string &param_name) {
+    const auto type = (DataType)param_loader_->data_type_[param_name];
+    return param_loader_->offsets_[param_name].second / DataTypeSize(type);
+}
 
 vector<string> fp32_layers = {"norm", "rope", "bias","rotary_emb",
                                 "vision_embed_tokens",
@@ -49,23 +83,100 @@ bool find_names(const string &name, const vector<string> &layer_names) {
     return false;
 }
 
+DataType QuantWriter::sparseType(const string &name, DataType dataType, const float *param, uint64_t size) {
+    if (size % QK_24 != 0 || !is_sparse_24(param, (int64_t)size)) {
+        return MLLM_TYPE_COUNT;
+    }
+    switch (dataType) {
+    case MLLM_TYPE_Q4_0:
+    case MLLM_TYPE_Q4_K:
+        // the layers kept at 6 bits in dense models get 8
+        return find_names(name, q6_layers) ? MLLM_TYPE_Q8_0_24 : MLLM_TYPE_Q4_0_24;
+    case MLLM_TYPE_Q6_K:
+    case MLLM_TYPE_Q8_0:
+    case MLLM_TYPE_Q8_K:
+        return MLLM_TYPE_Q8_0_24;
+    default:
+        return MLLM_TYPE_COUNT;
+    }
+}
+
 void QuantWriter::quantParams(DataType dataType) {
     quant_type_ = dataType;
     for (const auto &name : param_names_) {
+        // tied weights stay stored once
+        const auto tied = param_loader_->tiedTo(name);
+        if (!tied.empty() && tied != name && tieParam(name, tied)) {
+            std::cout << "Tie param " << name << " to " << tied << std::endl;
+            continue;
+        }
+        // written with the weight of their layer
+        if (name.find('.') != string::npos && !smoothedLayer(name.substr(0, name.rfind('.')) + ".weight").empty()) {
+            const auto suffix = name.substr(name.rfind('.'));
+            if (suffix == ".scale" || suffix == ".smooth") {
+                continue;
+            }
+        }
         //        int force_quant_type = -1;
         auto *param = getParam(name);
         if (param == nullptr) {
             __exit(-1);
         }
-        auto size = param_loader_->offsets_[name].second / sizeof(float);
-        void *quant_ptr = nullptr;
+        auto size = paramCount(name);
         std::pair<void *, uint64_t> block_t;
+        const auto layer = smoothedLayer(name);
+        if (!layer.empty()) {
+            const int cols = (int)smoothing_stats_->find(layer)->size();
+            const int rows = (int)(size / cols);
+            const auto factors = smoothing_stats_->smoothing(layer, param, rows, cols, smoothing_alpha_);
+            if (factors.empty() || (size_t)rows * cols != size) {
+                std::cout << "Cannot smooth " << name << std::endl;
+                __exit(-1);
+            }
+            std::cout << "Quantize param " << name << " to " << DataTypeName(MLLM_TYPE_I8) << " (smoothed)\t";
+            block_t = alloc_quant_block(size, MLLM_TYPE_I8);
+            vector<float> scales(rows);
+            for (int r = 0; r < rows; ++r) {
+                scales[r] = quantize_row_i8(param + (size_t)r * cols, (int8_t *)block_t.first + (size_t)r * cols, cols);
+            }
+            writeParam(name, MLLM_TYPE_I8, block_t.first, block_t.second);
+            std::cout << "  size:" << block_t.second << std::endl;
+            writeParam(layer + ".scale", MLLM_TYPE_F32, (void *)scales.data(), scales.size() * sizeof(float));
+            writeParam(layer + ".smooth", MLLM_TYPE_F32, (void *)factors.data(), factors.size() * sizeof(float));
+#ifndef TEST
+            delete[] (char *)block_t.first;
+#endif
+            continue;
+        }
+        void *quant_ptr = nullptr;
         if(find_names(name, fp32_layers)) {
             std::cout << "Quantize param " << name << " to " << DataTypeName(MLLM_TYPE_F32) << "\t";
-            const auto s = param_loader_->offsets_[name].second / sizeof(float);
+            const auto s = paramCount(name);
             const auto tsize = alloc_quant_block(s, MLLM_TYPE_F32).second;
             writeParam(name, MLLM_TYPE_F32, param, tsize);
             std::cout << "  size:" << tsize << std::endl;
+        } else if (const auto sparse_type = sparseType(name, dataType, param, size); sparse_type != MLLM_TYPE_COUNT) {
+            std::cout << "Quantize param " << name << " to " << DataTypeName(sparse_type) << " (2:4 sparse)\t";
+            block_t = alloc_quant_block(size, sparse_type);
+            if (sparse_type == MLLM_TYPE_Q4_0_24) {
+                quantize_row_q4_0_24(param, block_t.first, size);
+            } else {
+                quantize_row_q8_0_24(param, block_t.first, size);
+            }
+            writeParam(name, sparse_type, block_t.first, block_t.second);
+            std::cout << "  size:" << block_t.second << std::endl;
+#ifndef TEST
+            delete[] (char *)block_t.first;
+#endif
+        } else if (lut_bits(dataType) > 0 && is_ternary_lut(param, (int64_t)size)) {
+            std::cout << "Quantize param " << name << " to " << DataTypeName(MLLM_TYPE_Q2_LUT) << " (ternary)\t";
+            block_t = alloc_quant_block(size, MLLM_TYPE_Q2_LUT);
+            quantize_row_q2_lut(param, block_t.first, size);
+            writeParam(name, MLLM_TYPE_Q2_LUT, block_t.first, block_t.second);
+            std::cout << "  size:" << block_t.second << std::endl;
+#ifndef TEST
+            delete[] (char *)block_t.first;
+#endif
         }else if (find_names(name, q6_layers)) {
             switch (dataType) {
             case MLLM_TYPE_F32:
@@ -88,6 +199,13 @@ void QuantWriter::quantParams(DataType dataType) {
                 quantize_row_q8_0(param, quant_ptr, size);
                 size = block_t.second;
                 break;
+            case MLLM_TYPE_BF16:
+                std::cout << "Quantize param " << name << " to " << DataTypeName(dataType) << "\t";
+                block_t = alloc_quant_block(size, dataType);
+                quant_ptr = block_t.first;
+                mllm_fp32_to_bf16_row(param, (mllm_bf16_t *)quant_ptr, size);
+                size = block_t.second;
+                break;
             case MLLM_TYPE_Q8_K:
                 std::cout << "Quantize param " << name << " to " << DataTypeName(dataType) << "\t";
                 block_t = alloc_quant_block(size, dataType);
@@ -95,6 +213,15 @@ void QuantWriter::quantParams(DataType dataType) {
                 quantize_row_q8_K(param, quant_ptr, size);
                 size = block_t.second;
                 break;
+            case MLLM_TYPE_Q2_LUT:
+            case MLLM_TYPE_Q3_LUT:
+                // one more bit for the 2-bit models
+                std::cout << "Quantize param " << name << " to " << DataTypeName(MLLM_TYPE_Q3_LUT) << "\t";
+                block_t = alloc_quant_block(size, MLLM_TYPE_Q3_LUT);
+                quant_ptr = block_t.first;
+                quantize_row_q3_lut(param, quant_ptr, size);
+                size = block_t.second;
+                break;
             default:
                 break;
             }
@@ -102,6 +229,9 @@ void QuantWriter::quantParams(DataType dataType) {
                 if ((dataType == MLLM_TYPE_Q4_0) |(dataType ==MLLM_TYPE_Q4_K)|dataType ==MLLM_TYPE_Q6_K) {
                     writeParam(name, MLLM_TYPE_Q6_K, quant_ptr, size);
                     std::cout << "  size:" << size <<" type:"<< DataTypeName(MLLM_TYPE_Q6_K)<< std::endl;
+                } else if (lut_bits(dataType) > 0) {
+                    writeParam(name, MLLM_TYPE_Q3_LUT, quant_ptr, size);
+                    std::cout << "  size:" << size <<" type:"<< DataTypeName(MLLM_TYPE_Q3_LUT)<< std::endl;
                 } else {
                     writeParam(name, quant_type_, quant_ptr, size);
                     std::cout << "  size:" << size <<" type:"<< DataTypeName(quant_type_)<< std::endl;
@@ -126,6 +256,12 @@ void QuantWriter::quantParams(DataType dataType) {
                 quantize_row_q8_0(param, quant_ptr, size);
                 size = block_t.second;
                 break;
+            case MLLM_TYPE_BF16:
+                block_t = alloc_quant_block(size, dataType);
+                quant_ptr = block_t.first;
+                mllm_fp32_to_bf16_row(param, (mllm_bf16_t *)quant_ptr, size);
+                size = block_t.second;
+                break;
             case MLLM_TYPE_Q4_K:
                 block_t = alloc_quant_block(size, dataType);
                 quant_ptr = block_t.first;
@@ -144,6 +280,18 @@ void QuantWriter::quantParams(DataType dataType) {
                 quantize_row_q8_K(param, quant_ptr, size);
                 size = block_t.second;
                 break;
+            case MLLM_TYPE_Q2_LUT:
+                block_t = alloc_quant_block(size, dataType);
+                quant_ptr = block_t.first;
+                quantize_row_q2_lut(param, quant_ptr, size);
+                size = block_t.second;
+                break;
+            case MLLM_TYPE_Q3_LUT:
+                block_t = alloc_quant_block(size, dataType);
+                quant_ptr = block_t.first;
+                quantize_row_q3_lut(param, quant_ptr, size);
+                size = block_t.second;
+                break;
             case MLLM_TYPE_I8:
             case MLLM_TYPE_Q4_1:
             case MLLM_TYPE_Q8_1:
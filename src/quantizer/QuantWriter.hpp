@@ -2,6 +2,9 @@
 #include "ParamLoader.hpp"
 #include "backends/cpu/quantize/QuantizeQ4.hpp"
 #include "backends/cpu/quantize/QuantizeQ8.hpp"
+#include "backends/cpu/quantize/QuantizeSparse.hpp"
+#include "backends/cpu/quantize/QuantizeLUT.hpp"
+#include "backends/cpu/CPUActivationStats.hpp"
 #include <string>
 #include <unordered_map>
 #ifndef MLLM_QUANTWRITER_HPP
@@ -35,6 +38,13 @@ public:
     explicit QuantWriter(std::string output_path, std::string input_path);
     int readParams();
     void quantParams(DataType dataType);
+    /**
+     * \brief W8A8: smooth the weights of the Linears recorded in `stats` and store them as I8, with the scales
+     *        of their rows as "<layer>.scale" and their factors as "<layer>.smooth". Must be called before
+     *        readParams(). The other params are quantized to the type given to quantParams().
+     * \param alpha  see ActivationStats::smoothing
+     */
+    void setSmoothing(const ActivationStats *stats, float alpha);
 
 #ifdef TEST
     std::unordered_map<string, char *> data_;
@@ -45,7 +55,15 @@ private:
     mllm::ParamLoader *param_loader_;
     DataType quant_type_;
     std::vector<std::string> param_names_;
+    const ActivationStats *smoothing_stats_ = nullptr;
+    float smoothing_alpha_ = 0.5F;
     float *getParam(std::string param_name);
+    // number of values of a param, whatever its stored type
+    uint64_t paramCount(const std::string &param_name);
+    // the 2:4 sparse type a pruned weight is stored as instead of `dataType`, MLLM_TYPE_COUNT if it is dense
+    DataType sparseType(const string &name, DataType dataType, const float *param, uint64_t size);
+    // the layer of a weight smoothed for W8A8, empty if `name` is not one
+    string smoothedLayer(const string &name) const;
     void writeParam(string name, DataType type, void *data, uint64_t size) override;
 };
 } // namespace mllm
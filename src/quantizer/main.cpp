@@ -10,14 +10,23 @@
 
 
 int main(int argc, char **argv) {
-    if (argc != 4) {
-        std::cout << "Usage: ./quantize <input_path> <output_path> <quant_type>\n";
+    if (argc < 4 || (std::string(argv[3]) == "W8A8") != (argc >= 5) || argc > 6) {
+        std::cout << "Usage: ./quantize <input_path> <output_path> <quant_type>\n"
+                     "       ./quantize <input_path> <output_path> W8A8 <activation_stats> [alpha]\n";
         return -1;
     }
     auto input_path = std::string(argv[1]);
     auto output_path = std::string(argv[2]);
     auto quant_type = std::string(argv[3]);
+    mllm::ActivationStats stats;
     mllm::QuantWriter quant_writer(output_path, input_path);
+    if (quant_type == "W8A8") {
+        // activation stats recorded by main_llama --calibrate
+        if (!stats.load(argv[4])) {
+            return -1;
+        }
+        quant_writer.setSmoothing(&stats, argc == 6 ? std::stof(argv[5]) : 0.5F);
+    }
     int param_count = quant_writer.readParams();
     if (param_count <= 0) {
         std::cout << "No params to quantize\n";
@@ -26,7 +35,7 @@ int main(int argc, char **argv) {
     std::cout << "Quantize " << param_count << " params to " << quant_type << "\n";
     if (quant_type == "Q4_0") {
         quant_writer.quantParams(MLLM_TYPE_Q4_0);
-    } else if (quant_type == "Q8_0") {
+    } else if (quant_type == "Q8_0" || quant_type == "W8A8") {
         quant_writer.quantParams(MLLM_TYPE_Q8_0);
     } else if (quant_type == "Q4_K") {
         quant_writer.quantParams(MLLM_TYPE_Q4_K);
@@ -34,6 +43,12 @@ int main(int argc, char **argv) {
         quant_writer.quantParams(MLLM_TYPE_Q6_K);
     } else if (quant_type == "Q8_K") {
         quant_writer.quantParams(MLLM_TYPE_Q8_K);
+    } else if (quant_type == "BF16") {
+        quant_writer.quantParams(MLLM_TYPE_BF16);
+    } else if (quant_type == "Q2_LUT") {
+        quant_writer.quantParams(MLLM_TYPE_Q2_LUT);
+    } else if (quant_type == "Q3_LUT") {
+        quant_writer.quantParams(MLLM_TYPE_Q3_LUT);
     } else {
         std::cout << "Quant type " << quant_type << " is not supported\n";
         return -1;
@@ -145,12 +145,15 @@ void mllm::BPETokenizer::tokenize(const std::string &text, std::vector<token_id_
         }
         return;
     }
+    symbols_.reserve(text.size());
     while (offset < text.size()) {
         CharSymbol symbol;
         symbol.ch = text.c_str() + offset;
         symbol.length = std::min(text.size() - offset, utf8_len(text[offset]));
         symbol.last = idx - 1;
         symbol.next = text.size() - offset - symbol.length > 0 ? idx + 1 : -1;
+        auto result = this->vocab_view_.find(std::string_view(symbol.ch, symbol.length));
+        symbol.id = result != this->vocab_view_.end() ? (int)result->second : -1;
         offset += symbol.length;
         symbols_.emplace_back(symbol);
         idx++;
@@ -172,6 +175,7 @@ void mllm::BPETokenizer::tokenize(const std::string &text, std::vector<token_id_
         }
         // Merge the symbol，make the first symbol as the merged symbol.
         first.length += last.length;
+        first.id = item.id;
         last.length = 0;
         first.next = last.next;
         if (last.next != -1) {
@@ -185,10 +189,8 @@ void mllm::BPETokenizer::tokenize(const std::string &text, std::vector<token_id_
     // auto t = result->second;
     for (int i = 0; i < symbols_.size(); ++i) {
         if (symbols_[i].length > 0) {
-            auto token_text = std::string(symbols_[i].ch, symbols_[i].length);
-            auto result = this->vocab_map_.find(token_text);
-            if (result != this->vocab_map_.end()) {
-                tokens.emplace_back(result->second);
+            if (symbols_[i].id >= 0) {
+                tokens.emplace_back(symbols_[i].id);
             } else {
                 if (!byte_fallback) {
                     tokens.emplace_back(mllm::BPETokenizer::TokenUnk);
@@ -211,15 +213,24 @@ void mllm::BPETokenizer::tryMergeSymbol(size_t start, size_t end) {
     if (start == -1 || end == -1) {
         return;
     }
-    std::string merge_str = std::string(symbols_[start].ch, symbols_[end].ch + symbols_[end].length);
-    auto result = this->vocab_map_.find(merge_str);
-    if (result != this->vocab_map_.end() && result->second < id_token_.size()) {
-        auto token = this->id_token_[result->second];
+    const auto &left = symbols_[start];
+    const auto &right = symbols_[end];
+    int id = -1;
+    if (left.id >= 0 && right.id >= 0) {
+        auto result = merge_pairs_.find((uint64_t)left.id << 32 | (uint64_t)right.id);
+        id = result != merge_pairs_.end() ? (int)result->second : -1;
+    } else {
+        // a symbol outside the vocab can still be part of a token
+        auto result = this->vocab_view_.find(std::string_view(left.ch, right.ch + right.length - left.ch));
+        id = result != this->vocab_view_.end() && result->second < id_token_.size() ? (int)result->second : -1;
+    }
+    if (id >= 0) {
         TokenItem item;
         item.start = start;
         item.end = end;
-        item.score = token.score;
-        item.length = merge_str.size();
+        item.score = this->id_token_[id].score;
+        item.length = right.ch + right.length - left.ch;
+        item.id = id;
         queue_.emplace(item);
     }
 }
@@ -301,4 +312,22 @@ static std::unordered_map<unsigned char, string> bytes_to_unicode() {
 mllm::BPETokenizer::BPETokenizer(const std::string &vocab_file) :
     Tokenizer(vocab_file) {
     bytes_to_unicode_ = bytes_to_unicode();
+    // the keys of an unordered_map stay in place as it grows, so the views remain valid
+    vocab_view_.reserve(vocab_map_.size());
+    for (const auto &entry : vocab_map_) {
+        vocab_view_.emplace(entry.first, entry.second);
+    }
+    for (const auto &entry : vocab_map_) {
+        if (entry.second >= id_token_.size()) {
+            continue;
+        }
+        const std::string_view token(entry.first);
+        for (size_t split = 1; split < token.size(); ++split) {
+            auto left = vocab_view_.find(token.substr(0, split));
+            auto right = vocab_view_.find(token.substr(split));
+            if (left != vocab_view_.end() && right != vocab_view_.end()) {
+                merge_pairs_.emplace((uint64_t)left->second << 32 | (uint64_t)right->second, entry.second);
+            }
+        }
+    }
 }
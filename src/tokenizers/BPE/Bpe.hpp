@@ -6,6 +6,7 @@
 #define MLLM_BPE_HPP
 #include <queue>
 #include "tokenizers/Tokenizer.hpp"
+#include <string_view>
 #include <unordered_map>
 namespace mllm {
 class BPETokenizer final : public Tokenizer {
@@ -19,14 +20,20 @@ class BPETokenizer final : public Tokenizer {
         size_t end;
         float score;
         size_t length;
+        int id; // token of the merged symbol
     };
     struct CharSymbol {
         const char *ch;
         int length;
         int last;
         int next;
+        int id; // token of the symbol, -1 if it is not in the vocab
     };
     std::unordered_map<string,unsigned> merge_rank;
+    // vocab_map_ keyed by views of its own keys, so that a symbol is looked up without building a string
+    std::unordered_map<std::string_view, token_id_t> vocab_view_;
+    // (left token << 32 | right token) -> token of their concatenation, for every such pair in the vocab
+    std::unordered_map<uint64_t, token_id_t> merge_pairs_;
     std::vector<CharSymbol> symbols_;
     std::priority_queue<TokenItem, std::vector<TokenItem>, TokenItem::Compare> queue_;
     void tryMergeSymbol(size_t start, size_t end);
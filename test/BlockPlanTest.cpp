@@ -0,0 +1,200 @@
+//
+// Block plans: a llama-like model gives the same logits with its layers run by one set of ops and reusing each
+// other's activation buffers as without, over a prefill and a few decode steps. Reports the time to build the
+// graph and the bytes of activations held after the prefill with and without the plan.
+//
+
+#include "gtest/gtest.h"
+#include "Executor.hpp"
+#include "ParamWriter.hpp"
+#include "Timing.hpp"
+#include "express/Express.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+using namespace mllm;
+
+static const int vocab = 16;
+static const int hidden = 32;
+static const int heads = 2;
+static const int ffn_hidden = 64;
+static const int layers = 8;
+static const int prompt = 64;
+
+static NetTensor *attention(NetTensor *x, const string &name) {
+    auto *q = _Linear({x}, hidden, hidden, false, name + ".wq");
+    auto *k = _Linear({x}, hidden, hidden, false, name + ".wk");
+    auto *v = _Linear({x}, hidden, hidden, false, name + ".wv");
+    q = q->view(-1, heads, -1, hidden / heads);
+    k = k->view(-1, heads, -1, hidden / heads);
+    v = v->view(-1, heads, -1, hidden / heads);
+    q = _RoPE({q}, LLAMAROPE, name + ".q_rope");
+    k = _RoPE({k}, LLAMAROPE, name + ".k_rope");
+    k = _KVCache({k}, 2 * prompt, name + ".k_cache");
+    v = _KVCache({v}, 2 * prompt, name + ".v_cache");
+    auto *qk = _Matmul({q, k}, false, true, name + ".qk");
+    qk = *qk / std::sqrt(hidden / heads);
+    qk = _Causalmask({qk}, name + ".mask");
+    qk = _Softmax({qk}, DIMENSION, name + ".softmax");
+    auto *o = _Matmul({qk, v}, false, false, name + ".qkv");
+    o = o->view(-1, 1, -1, hidden);
+    return _Linear({o}, hidden, hidden, false, name + ".wo");
+}
+
+static NetTensor *ffn(NetTensor *i, const string &name) {
+    auto *x = _Linear({i}, hidden, ffn_hidden, false, name + ".w1");
+    x = _SiLU({x}, name + ".silu");
+    auto *y = _Linear({i}, hidden, ffn_hidden, false, name + ".w3");
+    x = *x * y;
+    return _Linear({x}, ffn_hidden, hidden, false, name + ".w2");
+}
+
+static void writeModel(const string &path) {
+    std::mt19937 rng(31);
+    std::normal_distribution<float> normal(0.0F, 0.2F);
+    std::map<string, vector<float>> weights;
+    auto random = [&](const string &name, size_t size) {
+        weights[name].resize(size);
+        for (auto &w : weights[name]) {
+            w = normal(rng);
+        }
+    };
+    random("tok_embeddings.weight", vocab * hidden);
+    for (int layer = 0; layer < layers; ++layer) {
+        const string name = "layers." + std::to_string(layer);
+        weights[name + ".attention_norm.weight"].assign(hidden, 1.0F);
+        weights[name + ".ffn_norm.weight"].assign(hidden, 1.0F);
+        for (const char *w : {"wq", "wk", "wv", "wo"}) {
+            random(name + ".attention." + w + ".weight", hidden * hidden);
+        }
+        random(name + ".feed_forward.w1.weight", ffn_hidden * hidden);
+        random(name + ".feed_forward.w3.weight", ffn_hidden * hidden);
+        random(name + ".feed_forward.w2.weight", hidden * ffn_hidden);
+    }
+    weights["norm.weight"].assign(hidden, 1.0F);
+    random("output.weight", vocab * hidden);
+    vector<string> names;
+    for (const auto &w : weights) {
+        names.push_back(w.first);
+    }
+    auto *writer = new ParamWriter(path);
+    writer->paddingIndex(names);
+    for (const auto &w : weights) {
+        writer->writeParam(w.first, MLLM_TYPE_F32, (void *)w.second.data(), w.second.size() * sizeof(float));
+    }
+    writer->writeIndex();
+    delete writer;
+}
+
+struct Run {
+    vector<vector<float>> logits;
+    int block_ops = 0;
+    int shared_ops = 0;
+    int shared_tensors = 0;
+    size_t prefill_activations = 0;
+};
+
+// the logits of the last token of every step: a prompt, then the argmax of each step
+static Run generate(vector<NetParameter> &params, const string &path, bool plan) {
+    Run run;
+    BackendConfig config;
+    config.block_plan = plan;
+    Net net(config);
+    net.convert(params, MLLM_CPU, 1);
+    ParamLoader loader(path);
+    Executor ex(&loader);
+    ex.setup(&net);
+    for (const auto &blocks : net.subGraph()["G0"]->blockPlans()) {
+        run.block_ops += blocks.ops;
+        run.shared_ops += blocks.shared_ops;
+        run.shared_tensors += blocks.shared_tensors;
+        std::cout << "block plan " << blocks.prefix << ": " << blocks.layers << " blocks of " << blocks.ops
+                  << " ops, " << blocks.shared_ops << " ops and " << blocks.shared_tensors << " activations shared"
+                  << std::endl;
+    }
+    vector<int> tokens;
+    for (int s = 0; s < prompt; ++s) {
+        tokens.push_back((s * 7 + 1) % vocab);
+    }
+    auto &logits = run.logits;
+    for (int step = 0; step < 5; ++step) {
+        auto input = std::make_shared<Tensor>();
+        input->setBackend(net.backends()[MLLM_CPU].get());
+        input->reshape(1, 1, (int)tokens.size(), 1);
+        input->alloc();
+        for (int s = 0; s < (int)tokens.size(); ++s) {
+            input->setDataAt<float>(0, 0, s, 0, (float)tokens[s]);
+        }
+        ex.run(&net, {input});
+        if (step == 0) {
+            run.prefill_activations = net.subGraph()["G0"]->activationBytes();
+        }
+        auto result = ex.result()[0];
+        const int last = result->sequence() - 1;
+        logits.emplace_back();
+        int best = 0;
+        for (int v = 0; v < vocab; ++v) {
+            logits.back().push_back(result->dataAt<float>(0, 0, last, v));
+            if (logits.back()[v] > logits.back()[best]) {
+                best = v;
+            }
+        }
+        tokens = {best};
+    }
+    return run;
+}
+
+// the time to build the graph, the best of a few runs
+static uint64_t convertUs(vector<NetParameter> &params, bool plan) {
+    uint64_t best = UINT64_MAX;
+    for (int rep = 0; rep < 5; ++rep) {
+        BackendConfig config;
+        config.block_plan = plan;
+        Net net(config);
+        const uint64_t start = mllm_time_us();
+        net.convert(params, MLLM_CPU, 1);
+        best = std::min(best, mllm_time_us() - start);
+    }
+    return best;
+}
+
+TEST(BlockPlanTest, SameLogits) {
+    std::unique_ptr<Context> c(new Context());
+    auto *i = _Input(c.get());
+    i = _Embedding({i}, vocab, hidden, "tok_embeddings");
+    for (int layer = 0; layer < layers; ++layer) {
+        const string name = "layers." + std::to_string(layer);
+        auto *x = _RMSNorm({i}, hidden, 1e-6, name + ".attention_norm");
+        i = *attention(x, name + ".attention") + i;
+        x = _RMSNorm({i}, hidden, 1e-6, name + ".ffn_norm");
+        i = *ffn(x, name + ".feed_forward") + i;
+    }
+    i = _RMSNorm({i}, hidden, 1e-6, "norm");
+    i = _Linear({i}, hidden, vocab, false, "output");
+    const string path = "/tmp/mllm_block_plan.mllm";
+    writeModel(path);
+
+    const auto expected = generate(c->sub_param_, path, false);
+    const auto planned = generate(c->sub_param_, path, true);
+    EXPECT_EQ(expected.shared_ops, 0);
+    EXPECT_EQ(expected.shared_tensors, 0);
+    // every op of the layers after the first is run by an op of the first layer
+    EXPECT_EQ(planned.shared_ops, (layers - 1) * planned.block_ops);
+    EXPECT_GT(planned.shared_tensors, 0);
+    const uint64_t convert_us = convertUs(c->sub_param_, false);
+    const uint64_t planned_convert_us = convertUs(c->sub_param_, true);
+    std::cout << layers << " layers, prefill of " << prompt << " tokens: graph built in " << convert_us << " us, "
+              << expected.prefill_activations / 1024 << " KB of activations; with the block plan "
+              << planned_convert_us << " us, " << planned.prefill_activations / 1024 << " KB" << std::endl;
+    EXPECT_LT(planned.prefill_activations, expected.prefill_activations);
+    ASSERT_EQ(planned.logits.size(), expected.logits.size());
+    for (size_t step = 0; step < planned.logits.size(); ++step) {
+        for (int v = 0; v < vocab; ++v) {
+            EXPECT_FLOAT_EQ(planned.logits[step][v], expected.logits[step][v]) << "step " << step << " token " << v;
+        }
+    }
+    std::remove(path.c_str());
+}
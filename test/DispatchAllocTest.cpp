@@ -0,0 +1,117 @@
+//
+// Decode steps do not allocate in the dispatch: Executor::run, Graph::setUpTensors and the KVCache views reuse
+// what the previous token set up. Counts operator new across steady decode steps of a small attention model.
+//
+
+#include "gtest/gtest.h"
+#include "Executor.hpp"
+#include "ParamWriter.hpp"
+#include "express/Express.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+using namespace mllm;
+
+static std::atomic<bool> counting{false};
+static std::atomic<int> allocations{0};
+
+void *operator new(size_t size) {
+    if (counting) {
+        allocations++;
+    }
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void operator delete(void *p) noexcept {
+    free(p);
+}
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+static const int vocab = 16;
+static const int hidden = 32;
+static const int heads = 2;
+static const int layers = 2;
+
+TEST(DispatchAllocTest, Decode) {
+    std::unique_ptr<Context> c(new Context());
+    auto *i = _Input(c.get());
+    i = _Embedding({i}, vocab, hidden, "tok_embeddings");
+    for (int layer = 0; layer < layers; ++layer) {
+        const string name = "layers." + std::to_string(layer) + ".attention";
+        auto *x = _RMSNorm({i}, hidden, 1e-6, "layers." + std::to_string(layer) + ".attention_norm");
+        auto *q = _Linear({x}, hidden, hidden, false, name + ".wq");
+        auto *k = _Linear({x}, hidden, hidden, false, name + ".wk");
+        auto *v = _Linear({x}, hidden, hidden, false, name + ".wv");
+        q = q->view(-1, heads, -1, hidden / heads);
+        k = k->view(-1, heads, -1, hidden / heads);
+        v = v->view(-1, heads, -1, hidden / heads);
+        q = _RoPE({q}, LLAMAROPE, name + ".q_rope");
+        k = _RoPE({k}, LLAMAROPE, name + ".k_rope");
+        k = _KVCache({k}, 64, name + ".k_cache");
+        v = _KVCache({v}, 64, name + ".v_cache");
+        auto *qk = _Matmul({q, k}, false, true, name + ".qk");
+        qk = *qk / 4.0F;
+        qk = _Causalmask({qk}, name + ".mask");
+        qk = _Softmax({qk}, DIMENSION, name + ".softmax");
+        auto *o = _Matmul({qk, v}, false, false, name + ".qkv");
+        o = o->view(-1, 1, -1, hidden);
+        o = _Linear({o}, hidden, hidden, false, name + ".wo");
+        i = *o + i;
+        x = _SiLU({i}, "layers." + std::to_string(layer) + ".silu");
+        i = *x * i;
+    }
+    i = _Linear({i}, hidden, vocab, false, "output");
+    vector<string> names = {"tok_embeddings.weight", "output.weight"};
+    for (int layer = 0; layer < layers; ++layer) {
+        names.push_back("layers." + std::to_string(layer) + ".attention_norm.weight");
+        for (const char *w : {"wq", "wk", "wv", "wo"}) {
+            names.push_back("layers." + std::to_string(layer) + ".attention." + w + ".weight");
+        }
+    }
+    const string path = "/tmp/mllm_dispatch_alloc.mllm";
+    {
+        vector<float> data(vocab * hidden + hidden * hidden, 0.01F);
+        ParamWriter writer(path);
+        writer.paddingIndex(names);
+        for (const auto &name : names) {
+            size_t n = name == "tok_embeddings.weight" || name == "output.weight" ? vocab * hidden : name.find("norm") != string::npos ? hidden : hidden * hidden;
+            writer.writeParam(name, MLLM_TYPE_F32, data.data(), n * sizeof(float));
+        }
+        writer.writeIndex();
+    }
+    Net net(BackendConfig{});
+    net.convert(c->sub_param_, MLLM_CPU, 1);
+    ParamLoader loader(path);
+    Executor ex(&loader);
+    ex.setup(&net);
+    auto input = std::make_shared<Tensor>(net.backends()[MLLM_CPU].get());
+    input->reshape(1, 1, 4, 1);
+    input->alloc();
+    ex.run(&net, {input});
+    input->reshape(1, 1, 1, 1);
+    input->alloc();
+    const vector<shared_ptr<Tensor>> inputs = {input};
+    // the first decode steps resize buffers from the prompt's shapes
+    const int warmup = 4;
+    const int steps = 20;
+    int total = 0;
+    for (int step = 0; step < warmup + steps; ++step) {
+        input->setDataAt<float>(0, 0, 0, 0, (float)(step % vocab));
+        allocations = 0;
+        counting = step >= warmup;
+        ex.run(&net, inputs);
+        counting = false;
+        total += allocations;
+    }
+    std::cout << "allocations per decode step: " << (float)total / steps << std::endl;
+    // Executor's per-token run and cpu times grow by doubling, two allocations at each of tokens 8, 16 and 32
+    EXPECT_LE(total, 3 * 2);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,135 @@
+//
+// Hot reload: requests keep the version they started on while new ones go to the new version, old versions
+// are freed when drained, and the overlap budget holds. Reports the latency of the steps served while a version
+// loads, and of the steps that switch to it and retire the old one.
+//
+
+#include "gtest/gtest.h"
+#include "ModelHost.hpp"
+#include "ParamWriter.hpp"
+#include "Timing.hpp"
+#include "express/Express.hpp"
+#include <algorithm>
+#include <cstdio>
+
+using namespace mllm;
+
+static const int vocab = 8;
+static const int hidden = 16;
+
+// a model answering `token` whatever its input
+static string writeModel(const string &path, int token) {
+    vector<float> embed(vocab * hidden, 1.0F);
+    vector<float> head(vocab * hidden, 0.0F);
+    for (int d = 0; d < hidden; ++d) {
+        head[token * hidden + d] = 1.0F;
+    }
+    auto *writer = new ParamWriter(path);
+    writer->paddingIndex({"embed.weight", "head.weight"});
+    writer->writeParam("embed.weight", MLLM_TYPE_F32, embed.data(), embed.size() * sizeof(float));
+    writer->writeParam("head.weight", MLLM_TYPE_F32, head.data(), head.size() * sizeof(float));
+    writer->writeIndex();
+    delete writer;
+    return path;
+}
+
+TEST(ModelHostTest, Reload) {
+    std::unique_ptr<Context> c(new Context());
+    auto *i = _Input(c.get());
+    i = _Embedding({i}, vocab, hidden, "embed");
+    i = _Linear({i}, hidden, vocab, false, "head");
+    const string a = writeModel("/tmp/mllm_host_a.mllm", 3);
+    const string b = writeModel("/tmp/mllm_host_b.mllm", 5);
+    const string d = writeModel("/tmp/mllm_host_c.mllm", 6);
+    const uint64_t bytes = 2 * vocab * hidden * sizeof(float);
+
+    // room for two versions
+    ModelHost host(c->sub_param_, BackendConfig(), 1, 2 * bytes);
+    ASSERT_TRUE(host.load(a));
+    EXPECT_EQ(host.version(), 0);
+    EXPECT_EQ(host.weightBytes(), bytes);
+    std::map<int, vector<token_id_t>> tokens;
+    auto request = [&](int max_new_tokens) {
+        GenerationRequest r;
+        r.prompt = {1, 2};
+        r.max_new_tokens = max_new_tokens;
+        r.on_token = [&](int id, token_id_t token) { tokens[id].push_back(token); };
+        return host.submit(r);
+    };
+    auto timedStep = [&](uint64_t &us) {
+        const uint64_t start = mllm_time_us();
+        const bool ran = host.step();
+        us = mllm_time_us() - start;
+        return ran;
+    };
+    const int r0 = request(500);
+    ASSERT_TRUE(host.step());
+    const uint64_t reload_start = mllm_time_us();
+    ASSERT_TRUE(host.reload(b));
+    EXPECT_FALSE(host.reload(d));
+    // the live version keeps serving while the new one loads; at most 250 steps, so that r0 is still running
+    vector<uint64_t> loading_us;
+    uint64_t us = 0;
+    for (int s = 0; s < 250 && host.version() == 0; ++s) {
+        ASSERT_TRUE(timedStep(us));
+        loading_us.push_back(us);
+    }
+    uint64_t switch_us = 0;
+    if (host.version() == 0) {
+        host.waitIdle();
+        ASSERT_TRUE(timedStep(switch_us));
+    } else {
+        switch_us = loading_us.back();
+        loading_us.pop_back();
+    }
+    const uint64_t reload_us = mllm_time_us() - reload_start;
+    EXPECT_EQ(host.version(), 1);
+    EXPECT_EQ(host.loadedVersions(), 2);
+    EXPECT_EQ(host.weightBytes(), 2 * bytes);
+    const int r1 = request(3);
+
+    // fits next to the current version, but waits for the first one to drain
+    ASSERT_TRUE(host.reload(d));
+    EXPECT_TRUE(host.loading());
+    EXPECT_EQ(host.weightBytes(), 2 * bytes);
+    // the first version is retired by the step that ends r0, freed in the background, then the third one loads
+    uint64_t retire_us = 0;
+    while (host.loadedVersions() == 2) {
+        ASSERT_TRUE(timedStep(retire_us));
+    }
+    host.run();
+    host.waitIdle();
+    EXPECT_FALSE(host.step());
+    EXPECT_EQ(host.version(), 2);
+    const int r2 = request(2);
+    host.run();
+    EXPECT_EQ(host.loadedVersions(), 1);
+    host.waitIdle();
+    EXPECT_EQ(host.weightBytes(), bytes);
+
+    std::sort(loading_us.begin(), loading_us.end());
+    std::cout << "reload in " << reload_us << " us: " << loading_us.size() << " steps served meanwhile";
+    if (!loading_us.empty()) {
+        std::cout << ", median " << loading_us[loading_us.size() / 2] << " us, max " << loading_us.back() << " us";
+    }
+    std::cout << "; switching step " << switch_us << " us, retiring step " << retire_us << " us" << std::endl;
+    // neither the load nor the free runs on the serving thread
+    EXPECT_LT(switch_us, reload_us);
+
+    ASSERT_EQ(tokens[r0].size(), 500);
+    for (auto token : tokens[r0]) {
+        ASSERT_EQ(token, 3);
+    }
+    EXPECT_EQ(tokens[r1], vector<token_id_t>({5, 5, 5}));
+    EXPECT_EQ(tokens[r2], vector<token_id_t>({6, 6}));
+
+    // no room for a second version
+    ModelHost small(c->sub_param_, BackendConfig(), 1, bytes + bytes / 2);
+    ASSERT_TRUE(small.load(a));
+    EXPECT_FALSE(small.reload(b));
+    EXPECT_FALSE(small.loading());
+
+    for (const auto &path : {a, b, d}) {
+        std::remove(path.c_str());
+    }
+}
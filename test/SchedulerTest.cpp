@@ -0,0 +1,176 @@
+//
+// Scheduler: a request paused for a more urgent one generates the same tokens as when it runs alone, under both
+// memory policies, and a high priority prefill runs at the next step, ahead of the request decoding.
+//
+
+#include "gtest/gtest.h"
+#include "Scheduler.hpp"
+#include "ParamWriter.hpp"
+#include "express/Express.hpp"
+#include <cstdio>
+#include <random>
+
+using namespace mllm;
+
+static const int vocab = 32;
+static const int hidden = 32;
+static const int heads = 2;
+static const int layers = 2;
+
+// a small llama-like model with random weights, so that every token depends on the whole sequence
+class SchedulerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        c_.reset(new Context());
+        auto *i = _Input(c_.get());
+        i = _Embedding({i}, vocab, hidden, "tok_embeddings");
+        for (int layer = 0; layer < layers; ++layer) {
+            const string name = "layers." + std::to_string(layer) + ".attention";
+            auto *x = _RMSNorm({i}, hidden, 1e-6, "layers." + std::to_string(layer) + ".attention_norm");
+            auto *q = _Linear({x}, hidden, hidden, false, name + ".wq");
+            auto *k = _Linear({x}, hidden, hidden, false, name + ".wk");
+            auto *v = _Linear({x}, hidden, hidden, false, name + ".wv");
+            q = q->view(-1, heads, -1, hidden / heads);
+            k = k->view(-1, heads, -1, hidden / heads);
+            v = v->view(-1, heads, -1, hidden / heads);
+            q = _RoPE({q}, LLAMAROPE, name + ".q_rope");
+            k = _RoPE({k}, LLAMAROPE, name + ".k_rope");
+            k = _KVCache({k}, 64, name + ".k_cache");
+            v = _KVCache({v}, 64, name + ".v_cache");
+            auto *qk = _Matmul({q, k}, false, true, name + ".qk");
+            qk = *qk / 4.0F;
+            qk = _Causalmask({qk}, name + ".mask");
+            qk = _Softmax({qk}, DIMENSION, name + ".softmax");
+            auto *o = _Matmul({qk, v}, false, false, name + ".qkv");
+            o = o->view(-1, 1, -1, hidden);
+            o = _Linear({o}, hidden, hidden, false, name + ".wo");
+            i = *o + i;
+        }
+        i = _Linear({i}, hidden, vocab, false, "output");
+
+        std::mt19937 rng(7);
+        std::normal_distribution<float> normal(0.0F, 0.5F);
+        std::map<string, vector<float>> weights;
+        auto random = [&](const string &name, size_t size) {
+            weights[name].resize(size);
+            for (auto &w : weights[name]) {
+                w = normal(rng);
+            }
+        };
+        random("tok_embeddings.weight", vocab * hidden);
+        random("output.weight", vocab * hidden);
+        for (int layer = 0; layer < layers; ++layer) {
+            weights["layers." + std::to_string(layer) + ".attention_norm.weight"].assign(hidden, 1.0F);
+            for (const char *w : {"wq", "wk", "wv", "wo"}) {
+                random("layers." + std::to_string(layer) + ".attention." + w + ".weight", hidden * hidden);
+            }
+        }
+        vector<string> names;
+        for (const auto &w : weights) {
+            names.push_back(w.first);
+        }
+        ParamWriter writer(path_);
+        writer.paddingIndex(names);
+        for (const auto &w : weights) {
+            writer.writeParam(w.first, MLLM_TYPE_F32, (void *)w.second.data(), w.second.size() * sizeof(float));
+        }
+        writer.writeIndex();
+
+        net_.reset(new Net(BackendConfig()));
+        net_->convert(c_->sub_param_, MLLM_CPU, 1);
+        loader_.reset(new ParamLoader(path_));
+        ex_.reset(new Executor(loader_.get()));
+        ex_->setup(net_.get());
+    }
+    void TearDown() override {
+        std::remove(path_.c_str());
+    }
+
+    GenerationRequest request(const vector<token_id_t> &prompt, int max_new_tokens, int priority = 0) {
+        GenerationRequest r;
+        r.prompt = prompt;
+        r.max_new_tokens = max_new_tokens;
+        r.eos = -1;
+        r.priority = priority;
+        r.on_token = [this](int id, token_id_t token) { order_.emplace_back(id, token); };
+        return r;
+    }
+    // the tokens of a request, in the order they were generated
+    vector<token_id_t> tokens(int id) const {
+        vector<token_id_t> result;
+        for (const auto &t : order_) {
+            if (t.first == id) {
+                result.push_back(t.second);
+            }
+        }
+        return result;
+    }
+
+    const string path_ = "/tmp/mllm_scheduler_test.mllm";
+    std::unique_ptr<Context> c_;
+    std::unique_ptr<Net> net_;
+    std::unique_ptr<ParamLoader> loader_;
+    std::unique_ptr<Executor> ex_;
+    vector<std::pair<int, token_id_t>> order_;
+};
+
+TEST_F(SchedulerTest, PauseResume) {
+    const vector<token_id_t> prompt = {1, 5, 9, 3, 7, 11};
+    const vector<token_id_t> urgent_prompt = {4, 8, 15, 16};
+    for (auto policy : {Scheduler::KEEP_KV, Scheduler::RELEASE_KV}) {
+        order_.clear();
+        Scheduler alone(net_.get(), ex_.get(), policy);
+        const int a = alone.submit(request(prompt, 12));
+        const int b = alone.submit(request(urgent_prompt, 5));
+        alone.run();
+        const auto expected = tokens(a);
+        const auto expected_urgent = tokens(b);
+        ASSERT_EQ(expected.size(), 12);
+        ASSERT_EQ(expected_urgent.size(), 5);
+
+        order_.clear();
+        Scheduler scheduler(net_.get(), ex_.get(), policy);
+        const int paused = scheduler.submit(request(prompt, 12));
+        // the prefill and four decode steps
+        for (int s = 0; s < 5; ++s) {
+            ASSERT_TRUE(scheduler.step());
+        }
+        const int urgent = scheduler.submit(request(urgent_prompt, 5, 1));
+        scheduler.run();
+        EXPECT_EQ(tokens(paused), expected) << "policy " << policy;
+        EXPECT_EQ(tokens(urgent), expected_urgent) << "policy " << policy;
+        EXPECT_EQ(scheduler.stats().at(paused).preemptions, 1);
+        // the urgent request ran in between
+        ASSERT_EQ(order_.size(), 17);
+        for (int t = 5; t < 10; ++t) {
+            EXPECT_EQ(order_[t].first, urgent);
+        }
+    }
+}
+
+TEST_F(SchedulerTest, PriorityPrefill) {
+    Scheduler scheduler(net_.get(), ex_.get());
+    const int first = scheduler.submit(request({1, 2, 3}, 8));
+    const int second = scheduler.submit(request({3, 2, 1}, 8));
+    for (int s = 0; s < 3; ++s) {
+        ASSERT_TRUE(scheduler.step());
+    }
+    const int urgent = scheduler.submit(request({6, 6, 6, 6}, 2, 1));
+    ASSERT_TRUE(scheduler.step());
+    // the next step is the urgent prefill
+    ASSERT_EQ(order_.size(), 4);
+    EXPECT_EQ(order_.back().first, urgent);
+    scheduler.run();
+    // then the urgent decode, the paused request, and the one queued behind it
+    ASSERT_EQ(order_.size(), 18);
+    EXPECT_EQ(order_[4].first, urgent);
+    for (int t = 5; t < 10; ++t) {
+        EXPECT_EQ(order_[t].first, first);
+    }
+    for (int t = 10; t < 18; ++t) {
+        EXPECT_EQ(order_[t].first, second);
+    }
+    EXPECT_LT(scheduler.stats().at(urgent).first_token_us, scheduler.stats().at(second).first_token_us);
+    EXPECT_EQ(scheduler.stats().at(first).preemptions, 1);
+    EXPECT_EQ(scheduler.stats().at(second).preemptions, 0);
+}
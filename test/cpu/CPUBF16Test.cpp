@@ -0,0 +1,110 @@
+//
+// BF16 weights: rounding of the conversions, and a Linear with BF16 weights against the same weights in F32.
+// Also reports the decode and prefill time of both.
+//
+
+#include "CPUTest.hpp"
+#include "ParamLoader.hpp"
+#include "Timing.hpp"
+#include "backends/cpu/CPULinear.hpp"
+#include <cmath>
+#include <random>
+
+// one Linear weight, F32 or BF16
+class BF16Loader : public AbstructLoader {
+public:
+    DataType type;
+    vector<float> weight;
+    bool load(Tensor *tensor) override {
+        if (type == MLLM_TYPE_BF16) {
+            mllm_fp32_to_bf16_row(weight.data(), tensor->hostPtr<mllm_bf16_t>(), (int)weight.size());
+        } else {
+            memcpy(tensor->hostPtr<float>(), weight.data(), weight.size() * sizeof(float));
+        }
+        return true;
+    }
+    bool load(std::shared_ptr<Tensor> tensor) override {
+        return load(tensor.get());
+    }
+    DataType getDataType(string name) override {
+        return name == "proj.weight" ? type : MLLM_TYPE_COUNT;
+    }
+};
+
+TEST_F(CPUTest, BF16Convert) {
+    EXPECT_EQ(mllm_fp32_to_bf16(1.0F), 0x3f80);
+    EXPECT_EQ(mllm_bf16_to_fp32(0x3f80), 1.0F);
+    EXPECT_EQ(mllm_bf16_to_fp32(mllm_fp32_to_bf16(-2.5F)), -2.5F);
+    // halfway cases round to the even mantissa
+    EXPECT_EQ(mllm_fp32_to_bf16(1.0F + std::ldexp(1.0F, -8)), 0x3f80);
+    EXPECT_EQ(mllm_fp32_to_bf16(1.0F + 3 * std::ldexp(1.0F, -8)), 0x3f82);
+    EXPECT_TRUE(std::isnan(mllm_bf16_to_fp32(mllm_fp32_to_bf16(NAN))));
+    EXPECT_TRUE(std::isinf(mllm_bf16_to_fp32(mllm_fp32_to_bf16(INFINITY))));
+    vector<float> row(37);
+    for (int i = 0; i < (int)row.size(); ++i) {
+        row[i] = std::sin((float)i) * 100.0F;
+    }
+    vector<mllm_bf16_t> bf16(row.size());
+    vector<float> back(row.size());
+    mllm_fp32_to_bf16_row(row.data(), bf16.data(), (int)row.size());
+    mllm_bf16_to_fp32_row(bf16.data(), back.data(), (int)row.size());
+    for (int i = 0; i < (int)row.size(); ++i) {
+        EXPECT_EQ(bf16[i], mllm_fp32_to_bf16(row[i]));
+        EXPECT_NEAR(back[i], row[i], std::fabs(row[i]) / 256);
+    }
+}
+
+TEST_F(CPUTest, BF16Linear) {
+    const int in_features = 1024;
+    const int out_features = 1024;
+    std::mt19937 rng(5);
+    std::normal_distribution<float> normal(0.0F, 1.0F);
+    BF16Loader loader;
+    loader.weight.resize((size_t)out_features * in_features);
+    for (auto &w : loader.weight) {
+        w = 0.02F * normal(rng);
+    }
+    uint64_t us[2][2];
+    vector<float> outputs[2][2];
+    const DataType types[2] = {MLLM_TYPE_F32, MLLM_TYPE_BF16};
+    const int seqs[2] = {1, 32};
+    for (int t = 0; t < 2; ++t) {
+        loader.type = types[t];
+        CPULinear linear(bn_, "proj", in_features, out_features, false, 4);
+        linear.load(loader);
+        ASSERT_EQ(linear.weight().dtype(), types[t]);
+        for (int i = 0; i < 2; ++i) {
+            TENSOR(input);
+            TENSOR(output);
+            input->reshape(1, 1, seqs[i], in_features);
+            input->alloc();
+            std::mt19937 input_rng(7);
+            for (int s = 0; s < seqs[i]; ++s) {
+                for (int d = 0; d < in_features; ++d) {
+                    input->setDataAt<float>(0, 0, s, d, normal(input_rng));
+                }
+            }
+            linear.reshape({input}, {output});
+            linear.setUp({input}, {output});
+            linear.execute({input}, {output});
+            const uint64_t start = mllm_time_us();
+            linear.execute({input}, {output});
+            us[t][i] = mllm_time_us() - start;
+            outputs[t][i].assign(output->hostPtr<float>(), output->hostPtr<float>() + output->count());
+        }
+    }
+    for (int i = 0; i < 2; ++i) {
+        double err = 0;
+        double norm = 0;
+        for (size_t j = 0; j < outputs[0][i].size(); ++j) {
+            const double d = (double)outputs[1][i][j] - outputs[0][i][j];
+            err += d * d;
+            norm += (double)outputs[0][i][j] * outputs[0][i][j];
+        }
+        // 8 bits of mantissa, half of the last bit at most on every weight (and activation with MLLM_BF16_DOT)
+        EXPECT_LT(std::sqrt(err / norm), 0.01);
+    }
+    std::cout << "Linear " << in_features << "x" << out_features << " decode: F32 " << us[0][0] << " us, BF16 "
+              << us[1][0] << " us; prefill " << seqs[1] << " tokens: F32 " << us[0][1] << " us, BF16 " << us[1][1]
+              << " us" << std::endl;
+}
@@ -0,0 +1,119 @@
+//
+// Destination passing: a Cat whose inputs are written straight into its output must give the same result as
+// one that copies them, and so must a KVCache whose new rows are written straight into its cache.
+//
+
+#include "CPUTest.hpp"
+#include "backends/cpu/CPUCat.hpp"
+#include "backends/cpu/CPUKVCache.hpp"
+
+static void runCat(Backend *bn_, Chl axis, bool redirect, shared_ptr<Tensor> &output, uint64_t &saved) {
+    CPUCat cat(bn_, "cat", axis, 4);
+    cat.setRedirectableInputs({redirect, redirect});
+    TENSOR(a);
+    TENSOR(b);
+    a->reshape(1, 4, 3, 8);
+    b->reshape(1, 4, 2, 8);
+    if (axis == BATCH) {
+        b->reshape(1, 4, 3, 8);
+    }
+    a->alloc();
+    b->alloc();
+    cat.reshape({a, b}, {output});
+    cat.setUp({a, b}, {output});
+    // the producers run after setUp, writing wherever their outputs now live
+    for (auto *t : {a.get(), b.get()}) {
+        for (int h = 0; h < t->head(); ++h) {
+            for (int s = 0; s < t->sequence(); ++s) {
+                for (int d = 0; d < t->dimension(); ++d) {
+                    t->setDataAt<float>(0, h, s, d, (t == a.get() ? 100.0F : 200.0F) + h * 10 + s + 0.01F * d);
+                }
+            }
+        }
+    }
+    cat.execute({a, b}, {output});
+    saved = cat.bytesSaved();
+}
+
+TEST_F(CPUTest, CatDestinationPassing) {
+    for (Chl axis : {SEQUENCE, BATCH}) {
+        TENSOR(copied);
+        TENSOR(passed);
+        uint64_t copied_saved = 0;
+        uint64_t passed_saved = 0;
+        runCat(bn_, axis, false, copied, copied_saved);
+        runCat(bn_, axis, true, passed, passed_saved);
+        ASSERT_EQ(copied_saved, 0);
+        ASSERT_EQ(passed_saved, sizeof(float) * passed->count());
+        ASSERT_EQ(copied->count(), passed->count());
+        for (int i = 0; i < copied->count(); ++i) {
+            ASSERT_EQ(copied->hostPtr<float>()[i], passed->hostPtr<float>()[i]) << "axis " << axis << " element " << i;
+        }
+    }
+}
+
+// a prompt of 3 tokens then 2 decode steps; the values are exact in F16
+static void runKVCache(Backend *bn_, int n_rep, bool redirect, vector<float> &rows, uint64_t &saved) {
+    CPUKVCache cache(bn_, "cache", n_rep, 16, 4);
+    cache.setRedirectableInputs({redirect});
+    TENSOR(input);
+    TENSOR(output);
+    saved = 0;
+    int position = 0;
+    for (int seq : {3, 1, 1}) {
+        input->reshape(1, 2, seq, 8);
+        cache.reshape({input}, {output});
+        input->alloc();
+        cache.setUp({input}, {output});
+        // the producer writes wherever its output now lives, in the dtype it now has
+        for (int h = 0; h < 2; ++h) {
+            for (int s = 0; s < seq; ++s) {
+                for (int d = 0; d < 8; ++d) {
+                    const float value = (float)(position + s) + 0.5F * h + 0.125F * d;
+                    if (input->dtype() == MLLM_TYPE_F16) {
+                        input->setDataAt<mllm_fp16_t>(0, h, s, d, MLLM_FP32_TO_FP16(value));
+                    } else {
+                        input->setDataAt<float>(0, h, s, d, value);
+                    }
+                }
+            }
+        }
+        cache.execute({input}, {output});
+        saved += cache.bytesSaved();
+        position += seq;
+    }
+    ASSERT_EQ(output->sequence(), position);
+    ASSERT_EQ(output->head(), 2 * n_rep);
+    rows.clear();
+    for (int h = 0; h < output->head(); ++h) {
+        for (int s = 0; s < output->sequence(); ++s) {
+            for (int d = 0; d < output->dimension(); ++d) {
+                rows.push_back(MLLM_FP16_TO_FP32(output->dataAt<mllm_fp16_t>(0, h, s, d)));
+            }
+        }
+    }
+}
+
+TEST_F(CPUTest, KVCacheDestinationPassing) {
+    for (int n_rep : {1, 2}) {
+        vector<float> copied;
+        vector<float> passed;
+        uint64_t copied_saved = 0;
+        uint64_t passed_saved = 0;
+        runKVCache(bn_, n_rep, false, copied, copied_saved);
+        runKVCache(bn_, n_rep, true, passed, passed_saved);
+        EXPECT_EQ(copied_saved, 0);
+        if (n_rep == 1) {
+            EXPECT_EQ(passed_saved, sizeof(mllm_fp16_t) * 2 * 5 * 8);
+        }
+        ASSERT_EQ(copied.size(), passed.size());
+        for (size_t i = 0; i < copied.size(); ++i) {
+            ASSERT_EQ(copied[i], passed[i]) << "n_rep " << n_rep << " element " << i;
+        }
+        // every replica of a head holds its rows
+        const int tokens = 5;
+        for (int h = 0; h < 2 * n_rep; ++h) {
+            EXPECT_EQ(copied[(h * tokens + 4) * 8 + 1], 4.0F + 0.5F * (h / n_rep) + 0.125F) << "head " << h;
+        }
+    }
+}
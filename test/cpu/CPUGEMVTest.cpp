@@ -0,0 +1,87 @@
+//
+// Decode GEMV kernels: correctness against the single-row vec_dot and achieved bandwidth.
+//
+
+#include "CPUTest.hpp"
+#include "Timing.hpp"
+#include "backends/cpu/compute/GEMV.hpp"
+#include "backends/cpu/quantize/QuantizeQ6.hpp"
+#include <cstring>
+#include <random>
+
+typedef void (*quantize_row_fn)(const float *__restrict x, void *__restrict y, int k);
+typedef void (*vec_dot_fn)(const int n, float *__restrict s, const void *__restrict vx, const void *__restrict vy);
+typedef void (*gemv_fn)(const int n, const int nr, float *__restrict s, const void *__restrict vx, size_t row_size,
+                        const void *__restrict vy, const float *__restrict bias, int thread_count);
+
+static void testGEMV(const char *name, DataType w_type, DataType a_type, quantize_row_fn quantize_w, quantize_row_fn quantize_a,
+                     vec_dot_fn vec_dot, gemv_fn gemv, int K, int N) {
+    const int thread_count = 4;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(-1.0F, 1.0F);
+    vector<float> row(K);
+    const size_t row_size = DataTypeSize(w_type, K);
+    vector<char> w(row_size * N);
+    for (int r = 0; r < N; ++r) {
+        for (auto &v : row) { v = dist(rng); }
+        quantize_w(row.data(), w.data() + r * row_size, K);
+    }
+    for (auto &v : row) { v = dist(rng); }
+    vector<char> a(DataTypeSize(a_type, K));
+    quantize_a(row.data(), a.data(), K);
+    vector<float> bias(N);
+    for (auto &v : bias) { v = dist(rng); }
+
+    vector<float> ref(N);
+    vector<float> out(N);
+    for (int r = 0; r < N; ++r) {
+        vec_dot(K, &ref[r], w.data() + r * row_size, a.data());
+        ref[r] += bias[r];
+    }
+    gemv(K, N, out.data(), w.data(), row_size, a.data(), bias.data(), thread_count);
+    for (int r = 0; r < N; ++r) {
+        ASSERT_NEAR(ref[r], out[r], 1e-3 * (1.0F + std::abs(ref[r]))) << name << " row " << r;
+    }
+
+    // Bandwidth: a decode GEMV streams the whole weight once, compare with a memcpy of the same size.
+    const int iters = 10;
+    vector<char> dst(w.size());
+    memcpy(dst.data(), w.data(), w.size());
+    uint64_t t0 = mllm_time_us();
+    for (int i = 0; i < iters; ++i) {
+        memcpy(dst.data(), w.data(), w.size());
+    }
+    uint64_t t1 = mllm_time_us();
+    for (int i = 0; i < iters; ++i) {
+        gemv(K, N, out.data(), w.data(), row_size, a.data(), nullptr, thread_count);
+    }
+    uint64_t t2 = mllm_time_us();
+    // the same rows one at a time, as the blocked matmul does
+    for (int i = 0; i < iters; ++i) {
+#pragma omp parallel for num_threads(thread_count) schedule(static)
+        for (int r = 0; r < N; ++r) {
+            vec_dot(K, &out[r], w.data() + r * row_size, a.data());
+        }
+    }
+    uint64_t t3 = mllm_time_us();
+    const double bytes = (double)w.size() * iters;
+    // memcpy reads and writes every byte
+    const double memcpy_gbs = 2 * bytes / (double)std::max<uint64_t>(t1 - t0, 1) / 1e3;
+    const double gemv_gbs = bytes / (double)std::max<uint64_t>(t2 - t1, 1) / 1e3;
+    const double row_gbs = bytes / (double)std::max<uint64_t>(t3 - t2, 1) / 1e3;
+    std::cout << name << " " << N << "x" << K << ": gemv " << gemv_gbs << " GB/s, single rows " << row_gbs
+              << " GB/s, memcpy " << memcpy_gbs << " GB/s (" << 100.0 * gemv_gbs / memcpy_gbs << "%)" << std::endl;
+}
+
+TEST_F(CPUTest, GEMVQ4_0) {
+    // N is not a multiple of MLLM_GEMV_ROWS so that the tail rows are covered too.
+    testGEMV("Q4_0", MLLM_TYPE_Q4_0, MLLM_TYPE_Q8_0, quantize_row_q4_0, quantize_row_q8_0, vec_dot_q4_0_q8_0, gemv_q4_0_q8_0, 4096, 2050);
+}
+
+TEST_F(CPUTest, GEMVQ4_K) {
+    testGEMV("Q4_K", MLLM_TYPE_Q4_K, MLLM_TYPE_Q8_K, quantize_row_q4_K, quantize_row_q8_K, vec_dot_q4_K_q8_K, gemv_q4_K_q8_K, 4096, 2050);
+}
+
+TEST_F(CPUTest, GEMVQ6_K) {
+    testGEMV("Q6_K", MLLM_TYPE_Q6_K, MLLM_TYPE_Q8_K, quantize_row_q6_K, quantize_row_q8_K, vec_dot_q6_K_q8_K, gemv_q6_K_q8_K, 4096, 2050);
+}
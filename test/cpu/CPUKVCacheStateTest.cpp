@@ -0,0 +1,56 @@
+//
+// Pausing a sequence: a KV cache restored from its saved state must continue exactly where it left off,
+// whatever ran on it in between.
+//
+
+#include "CPUTest.hpp"
+#include "backends/cpu/CPUKVCache.hpp"
+
+static void appendTokens(CPUKVCache &cache, shared_ptr<Tensor> &input, shared_ptr<Tensor> &output, int seq, float value) {
+    input->reshape(1, 2, seq, 16);
+    cache.reshape({input}, {output});
+    cache.setUp({input}, {output});
+    for (int h = 0; h < 2; ++h) {
+        for (int s = 0; s < seq; ++s) {
+            for (int d = 0; d < 16; ++d) {
+                *input->ptrAt<mllm_fp16_t>(0, h, s, d) = MLLM_FP32_TO_FP16(value + s + 0.25F * h + 0.01F * d);
+            }
+        }
+    }
+    cache.execute({input}, {output});
+}
+
+TEST_F(CPUTest, KVCacheState) {
+    CPUKVCache cache(bn_, "cache", 1, 64, 4);
+    CPUKVCache reference(bn_, "reference", 1, 64, 4);
+    TENSOR(input);
+    TENSOR(output);
+    TENSOR(ref_input);
+    TENSOR(ref_output);
+
+    // sequence A: a prompt of 5 tokens
+    appendTokens(cache, input, output, 5, 1.0F);
+    appendTokens(reference, ref_input, ref_output, 5, 1.0F);
+    Op::SequenceState a;
+    cache.saveState(a);
+    ASSERT_EQ(a.position, 5);
+
+    // sequence B runs in between
+    cache.restoreState(Op::SequenceState());
+    appendTokens(cache, input, output, 9, 50.0F);
+    ASSERT_EQ(output->sequence(), 9);
+
+    // A resumes with its next token
+    cache.restoreState(a);
+    appendTokens(cache, input, output, 1, 7.0F);
+    appendTokens(reference, ref_input, ref_output, 1, 7.0F);
+    ASSERT_EQ(output->sequence(), 6);
+    for (int h = 0; h < 2; ++h) {
+        for (int s = 0; s < 6; ++s) {
+            for (int d = 0; d < 16; ++d) {
+                ASSERT_EQ(output->dataAt<mllm_fp16_t>(0, h, s, d), ref_output->dataAt<mllm_fp16_t>(0, h, s, d))
+                    << "head " << h << " token " << s;
+            }
+        }
+    }
+}
@@ -0,0 +1,123 @@
+//
+// Tiered KV cache: a cache spilled to a scratch file must hold the same tokens as one kept in RAM, in both the
+// BSHD and the BHDS layout, with BHDS rows longer and shorter than a page, and the caches must stay within the RAM
+// budget. Also reports what reading the spilled tokens back costs the attention.
+//
+
+#include "CPUTest.hpp"
+#include "Timing.hpp"
+#include "backends/cpu/CPUKVCache.hpp"
+#include "backends/cpu/CPUKVSpill.hpp"
+#include "backends/cpu/compute/Matmul.hpp"
+#include <unistd.h>
+
+static void fillTokens(Tensor *t, int seq, int first_token) {
+    for (int h = 0; h < t->head(); ++h) {
+        for (int s = 0; s < seq; ++s) {
+            for (int d = 0; d < t->dimension(); ++d) {
+                *t->ptrAt<mllm_fp16_t>(0, h, s, d) = MLLM_FP32_TO_FP16((float)((first_token + s) % 97 + h * 0.5 + d * 0.01));
+            }
+        }
+    }
+}
+
+// runs `layers` K/V caches through a prefill of `prompt` tokens and `steps` decode steps, with a q.K^T per BSHD
+// cache
+static double runCaches(Backend *bn, vector<shared_ptr<CPUKVCache>> &caches, vector<shared_ptr<Tensor>> &outputs,
+                        int layers, int prompt, int steps, ChlType ctype) {
+    const int heads = 8;
+    const int dim = 64;
+    vector<shared_ptr<Tensor>> inputs;
+    for (int i = 0; i < layers * 2; ++i) {
+        caches.push_back(std::make_shared<CPUKVCache>(bn, "cache" + std::to_string(i), 1, prompt + steps, 4));
+        inputs.push_back(std::make_shared<Tensor>(bn));
+        outputs.push_back(std::make_shared<Tensor>(bn));
+    }
+    Tensor q(bn);
+    q.reshape(1, heads, 1, dim);
+    q.alloc();
+    for (int i = 0; i < q.count(); ++i) {
+        q.hostPtr<float>()[i] = 0.01F * (float)(i % 13);
+    }
+    Tensor scores(bn);
+    uint64_t decode_us = 0;
+    for (int step = 0; step <= steps; ++step) {
+        const int seq = step == 0 ? prompt : 1;
+        const int first = step == 0 ? 0 : prompt + step - 1;
+        uint64_t start = mllm_time_us();
+        // as in a graph, every cache is reshaped before the first one runs
+        for (int i = 0; i < layers * 2; ++i) {
+            inputs[i]->reshape(1, heads, seq, dim);
+            caches[i]->reshape({inputs[i]}, {outputs[i]});
+            if (step == 0 && ctype == BHDS) {
+                caches[i]->cache().transShape();
+            }
+            caches[i]->setUp({inputs[i]}, {outputs[i]});
+        }
+        for (int i = 0; i < layers * 2; ++i) {
+            fillTokens(inputs[i].get(), seq, first);
+            caches[i]->execute({inputs[i]}, {outputs[i]});
+            if (ctype != BSHD) {
+                continue;
+            }
+            scores.reshape(1, heads, 1, outputs[i]->sequence());
+            scores.alloc();
+            mat_mul_fp32_fp16(&q, outputs[i].get(), &scores, false, nullptr, false, true, 4);
+        }
+        if (step > 0) {
+            decode_us += mllm_time_us() - start;
+        }
+    }
+    return (double)steps * 1e6 / (double)std::max<uint64_t>(decode_us, 1);
+}
+
+TEST_F(CPUTest, KVSpill) {
+    const int layers = 2;
+    const int steps = 16;
+    const std::pair<ChlType, int> runs[] = {{BSHD, 4096}, {BHDS, 4096}, {BHDS, 1024}};
+    for (const auto &run : runs) {
+        const ChlType ctype = run.first;
+        const int prompt = run.second;
+        // scratch files of this run only
+        string dir = ::testing::TempDir() + "mllm_kv_spill_XXXXXX";
+        ASSERT_NE(mkdtemp(&dir[0]), nullptr);
+        auto spill_bn_ptr = std::make_shared<CPUBackend>(mm_);
+        auto *spill_bn = spill_bn_ptr.get();
+        // the K and V caches of the layer attended, and 256 recent tokens of the others
+        const size_t token_bytes = 8 * 64 * sizeof(mllm_fp16_t);
+        const size_t budget = 2 * token_bytes * (prompt + steps) + (layers - 1) * 2 * token_bytes * 256;
+        spill_bn->setKVSpill(dir, budget);
+
+        vector<shared_ptr<CPUKVCache>> ram_caches;
+        vector<shared_ptr<CPUKVCache>> spill_caches;
+        vector<shared_ptr<Tensor>> ram_outputs;
+        vector<shared_ptr<Tensor>> spill_outputs;
+        const double ram_tps = runCaches(bn_, ram_caches, ram_outputs, layers, prompt, steps, ctype);
+        const double spill_tps = runCaches(spill_bn, spill_caches, spill_outputs, layers, prompt, steps, ctype);
+        for (int i = 0; i < layers * 2; ++i) {
+            auto &a = ram_outputs[i];
+            auto &b = spill_outputs[i];
+            ASSERT_EQ(a->sequence(), prompt + steps);
+            ASSERT_EQ(b->sequence(), prompt + steps);
+            for (int s = 0; s < a->sequence(); s += 7) {
+                for (int h = 0; h < a->head(); ++h) {
+                    ASSERT_EQ(a->dataAt<mllm_fp16_t>(0, h, s, 3), b->dataAt<mllm_fp16_t>(0, h, s, 3))
+                        << "cache " << i << " token " << s << (ctype == BSHD ? " BSHD" : " BHDS");
+                }
+            }
+        }
+        const auto &stats = spill_bn->kvSpill()->stats();
+        EXPECT_GT(stats.evicted_bytes, 0);
+        EXPECT_EQ(spill_bn->kvSpill()->hotTokens(prompt + steps), 256);
+        EXPECT_LE(stats.peak_ram_bytes, budget);
+        std::cout << (ctype == BSHD ? "BSHD" : "BHDS") << " KV cache of " << prompt + steps << " tokens, "
+                  << spill_bn->kvSpill()->hotTokens(prompt + steps) << " in RAM: " << ram_tps << " steps/s in RAM, "
+                  << spill_tps << " steps/s spilled (" << 100.0 * spill_tps / ram_tps << "%), "
+                  << stats.evicted_bytes / 1e6 << " MB evicted, " << stats.prefetched_bytes / 1e6 << " MB read back, peak "
+                  << stats.peak_ram_bytes / 1e6 << " MB in RAM of " << budget / 1e6 << std::endl;
+        spill_caches.clear();
+        spill_outputs.clear();
+        spill_bn_ptr.reset();
+        rmdir(dir.c_str());
+    }
+}
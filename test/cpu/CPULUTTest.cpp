@@ -0,0 +1,146 @@
+//
+// Lookup-table kernels: Q2_LUT / Q3_LUT quantization, and a Linear with LUT weights against the same weights
+// dequantized to F32. Also reports the bytes and decode time of Q4_0, Q3_LUT and Q2_LUT.
+//
+
+#include "CPUTest.hpp"
+#include "ParamLoader.hpp"
+#include "Timing.hpp"
+#include "backends/cpu/CPULinear.hpp"
+#include "backends/cpu/quantize/QuantizeLUT.hpp"
+#include "backends/cpu/quantize/QuantizeQ4.hpp"
+#include <cmath>
+#include <random>
+
+// one Linear weight, quantized to `type` when loaded
+class LUTLoader : public AbstructLoader {
+public:
+    DataType type;
+    vector<float> weight;
+    bool load(Tensor *tensor) override {
+        switch (type) {
+        case MLLM_TYPE_F32: memcpy(tensor->hostPtr<float>(), weight.data(), weight.size() * sizeof(float)); break;
+        case MLLM_TYPE_Q4_0: quantize_row_q4_0(weight.data(), tensor->hostPtr<void>(), (int)weight.size()); break;
+        case MLLM_TYPE_Q2_LUT: quantize_row_q2_lut(weight.data(), tensor->hostPtr<void>(), (int)weight.size()); break;
+        case MLLM_TYPE_Q3_LUT: quantize_row_q3_lut(weight.data(), tensor->hostPtr<void>(), (int)weight.size()); break;
+        default: return false;
+        }
+        return true;
+    }
+    bool load(std::shared_ptr<Tensor> tensor) override {
+        return load(tensor.get());
+    }
+    DataType getDataType(string name) override {
+        return name == "proj.weight" ? type : MLLM_TYPE_COUNT;
+    }
+};
+
+TEST_F(CPUTest, LUTQuantize) {
+    std::mt19937 rng(19);
+    std::normal_distribution<float> normal(0.0F, 0.02F);
+    const int k = 4 * QK_LUT;
+    vector<float> weight(k);
+    vector<float> back(k);
+    // ternary weights are exact in Q2_LUT
+    for (int i = 0; i < k; ++i) {
+        weight[i] = 0.03F * (float)((int)(rng() % 3) - 1);
+    }
+    ASSERT_TRUE(is_ternary_lut(weight.data(), k));
+    vector<block_q2_lut> q2(k / QK_LUT);
+    quantize_row_q2_lut(weight.data(), q2.data(), k);
+    dequantize_row_q2_lut(q2.data(), back.data(), k);
+    for (int i = 0; i < k; ++i) {
+        EXPECT_NEAR(back[i], weight[i], 1e-5) << i;
+    }
+    for (auto &w : weight) {
+        w = normal(rng);
+    }
+    ASSERT_FALSE(is_ternary_lut(weight.data(), k));
+    vector<block_q3_lut> q3(k / QK_LUT);
+    quantize_row_q3_lut(weight.data(), q3.data(), k);
+    dequantize_row_q3_lut(q3.data(), back.data(), k);
+    double err = 0;
+    double norm = 0;
+    for (int i = 0; i < k; ++i) {
+        err += (back[i] - weight[i]) * (back[i] - weight[i]);
+        norm += weight[i] * weight[i];
+    }
+    // 8 levels over about 5 standard deviations
+    EXPECT_LT(std::sqrt(err / norm), 0.25);
+}
+
+TEST_F(CPUTest, LUTLinear) {
+    const int in_features = 4096;
+    // not a multiple of QR_LUT: the last tile is padded
+    const int out_features = 1000;
+    const int rounds = 20;
+    std::mt19937 rng(23);
+    std::normal_distribution<float> normal(0.0F, 0.02F);
+    vector<float> weight((size_t)out_features * in_features);
+    for (auto &w : weight) {
+        w = normal(rng);
+    }
+    const DataType types[3] = {MLLM_TYPE_Q4_0, MLLM_TYPE_Q3_LUT, MLLM_TYPE_Q2_LUT};
+    for (auto type : types) {
+        LUTLoader loader;
+        loader.type = type;
+        loader.weight = weight;
+        CPULinear linear(bn_, "proj", in_features, out_features, false, 4);
+        ASSERT_EQ(linear.load(loader), MLLM_NO_ERROR);
+        const size_t bytes = linear.weight().cntSize();
+        // the reference: the same weights, dequantized
+        LUTLoader dense;
+        dense.type = MLLM_TYPE_F32;
+        dense.weight.resize(weight.size());
+        vector<char> blocks(DataTypeSize(type, (int)weight.size()));
+        switch (type) {
+        case MLLM_TYPE_Q4_0:
+            quantize_row_q4_0(weight.data(), blocks.data(), (int)weight.size());
+            dequantize_row_q4_0(blocks.data(), dense.weight.data(), (int)weight.size());
+            break;
+        case MLLM_TYPE_Q3_LUT:
+            quantize_row_q3_lut(weight.data(), blocks.data(), (int)weight.size());
+            dequantize_row_q3_lut(blocks.data(), dense.weight.data(), (int)weight.size());
+            break;
+        default:
+            quantize_row_q2_lut(weight.data(), blocks.data(), (int)weight.size());
+            dequantize_row_q2_lut(blocks.data(), dense.weight.data(), (int)weight.size());
+            break;
+        }
+        CPULinear reference(bn_, "proj", in_features, out_features, false, 4);
+        reference.load(dense);
+        TENSOR(input);
+        TENSOR(output);
+        TENSOR(expected);
+        input->reshape(1, 1, 1, in_features);
+        input->alloc();
+        std::mt19937 input_rng(29);
+        std::normal_distribution<float> activation(0.0F, 1.0F);
+        for (int d = 0; d < in_features; ++d) {
+            input->setDataAt<float>(0, 0, 0, d, activation(input_rng));
+        }
+        reference.reshape({input}, {expected});
+        reference.setUp({input}, {expected});
+        reference.execute({input}, {expected});
+        linear.reshape({input}, {output});
+        linear.setUp({input}, {output});
+        linear.execute({input}, {output});
+        const uint64_t start = mllm_time_us();
+        for (int r = 0; r < rounds; ++r) {
+            linear.execute({input}, {output});
+        }
+        const uint64_t us = (mllm_time_us() - start) / rounds;
+        double err = 0;
+        double norm = 0;
+        for (int o = 0; o < out_features; ++o) {
+            const double d = (double)output->dataAt<float>(0, 0, 0, o) - expected->dataAt<float>(0, 0, 0, o);
+            err += d * d;
+            norm += (double)expected->dataAt<float>(0, 0, 0, o) * expected->dataAt<float>(0, 0, 0, o);
+        }
+        std::cout << "Linear " << in_features << "x" << out_features << " decode: " << DataTypeName(type) << " "
+                  << bytes / 1024 << " KB " << us << " us, error vs its dequantized weights " << std::sqrt(err / norm)
+                  << std::endl;
+        // only the int8 activations differ from the reference
+        EXPECT_LT(std::sqrt(err / norm), 0.01) << DataTypeName(type);
+    }
+}
@@ -0,0 +1,80 @@
+//
+// Tensor parallel Linear and attention: the layers split across NUMA nodes must match the unsplit ones.
+// A machine with a single node runs every shard on it.
+//
+
+#include "CPUTest.hpp"
+#include "backends/cpu/CPULinear.hpp"
+#include "backends/cpu/CPUMatmul.hpp"
+#include <random>
+
+// fills every weight with the same random values, whatever backend it is loaded on
+class RandomLoader : public AbstructLoader {
+public:
+    bool load(Tensor *tensor) override {
+        std::mt19937 rng(std::hash<string>()(tensor->name()));
+        std::uniform_real_distribution<float> dist(-1.0F, 1.0F);
+        for (int i = 0; i < tensor->count(); ++i) {
+            tensor->hostPtr<float>()[i] = dist(rng);
+        }
+        return true;
+    }
+    bool load(shared_ptr<Tensor> tensor) override {
+        return load(tensor.get());
+    }
+    DataType getDataType(string name) override {
+        return MLLM_TYPE_F32;
+    }
+};
+
+static shared_ptr<Tensor> randomTensor(Backend *bn, int batch, int head, int seq, int dim) {
+    auto t = std::make_shared<Tensor>(bn);
+    t->setName("input");
+    t->reshape(batch, head, seq, dim);
+    t->alloc();
+    RandomLoader().load(t);
+    return t;
+}
+
+TEST_F(CPUTest, NumaLinear) {
+    auto numa_bn_ptr = std::make_shared<CPUBackend>(mm_);
+    auto *numa_bn = numa_bn_ptr.get();
+    numa_bn->setNumaNodes(2);
+    ASSERT_NE(numa_bn->numaPool(), nullptr);
+    RandomLoader loader;
+    CPULinear linear(bn_, "linear", 1024, 1030, true, 4);
+    CPULinear numa_linear(numa_bn, "linear", 1024, 1030, true, 4);
+    ASSERT_FALSE(linear.load(loader));
+    ASSERT_FALSE(numa_linear.load(loader));
+    for (int seq : {1, 5}) {
+        auto input = randomTensor(bn_, 1, 1, seq, 1024);
+        auto output = std::make_shared<Tensor>(bn_);
+        auto numa_output = std::make_shared<Tensor>(numa_bn);
+        ASSERT_FALSE(linear.reshape({input}, {output}));
+        ASSERT_FALSE(linear.setUp({input}, {output}));
+        ASSERT_FALSE(linear.execute({input}, {output}));
+        ASSERT_FALSE(numa_linear.reshape({input}, {numa_output}));
+        ASSERT_FALSE(numa_linear.setUp({input}, {numa_output}));
+        ASSERT_FALSE(numa_linear.execute({input}, {numa_output}));
+        COMPARE_TENSOR(output.get(), numa_output.get());
+    }
+}
+
+TEST_F(CPUTest, NumaAttention) {
+    auto numa_bn_ptr = std::make_shared<CPUBackend>(mm_);
+    auto *numa_bn = numa_bn_ptr.get();
+    numa_bn->setNumaNodes(2);
+    CPUMatmul matmul(bn_, "qk", false, true, 4);
+    CPUMatmul numa_matmul(numa_bn, "qk", false, true, 4);
+    auto q = randomTensor(bn_, 1, 5, 3, 64);
+    auto k = randomTensor(bn_, 1, 5, 7, 64);
+    auto output = std::make_shared<Tensor>(bn_);
+    auto numa_output = std::make_shared<Tensor>(numa_bn);
+    ASSERT_FALSE(matmul.reshape({q, k}, {output}));
+    ASSERT_FALSE(matmul.setUp({q, k}, {output}));
+    ASSERT_FALSE(matmul.execute({q, k}, {output}));
+    ASSERT_FALSE(numa_matmul.reshape({q, k}, {numa_output}));
+    ASSERT_FALSE(numa_matmul.setUp({q, k}, {numa_output}));
+    ASSERT_FALSE(numa_matmul.execute({q, k}, {numa_output}));
+    COMPARE_TENSOR(output.get(), numa_output.get());
+}
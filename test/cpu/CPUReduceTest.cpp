@@ -0,0 +1,189 @@
+//
+// reduce_axis / reduce_row against a scalar reference for every op and axis, F32 and F16 inputs, the ops built on
+// them (Mean, Where), and the throughput of a 4096-wide row reduction.
+//
+
+#include "CPUTest.hpp"
+#include "Timing.hpp"
+#include "backends/cpu/CPUMean.hpp"
+#include "backends/cpu/CPUWhere.hpp"
+#include "backends/cpu/compute/Reduce.hpp"
+#include <cmath>
+
+static float referenceReduce(ReduceOp op, const vector<float> &x, float value) {
+    double acc = op == REDUCE_MAX ? -INFINITY : 0.0;
+    int index = 0;
+    for (int i = 0; i < (int)x.size(); ++i) {
+        switch (op) {
+        case REDUCE_SUM:
+        case REDUCE_MEAN: acc += x[i]; break;
+        case REDUCE_MAX: acc = std::max(acc, (double)x[i]); break;
+        case REDUCE_ARGMAX: index = x[i] > x[index] ? i : index; break;
+        case REDUCE_L1: acc += std::fabs(x[i]); break;
+        case REDUCE_L2: acc += (double)x[i] * x[i]; break;
+        case REDUCE_COUNT: acc += x[i] == value; break;
+        }
+    }
+    switch (op) {
+    case REDUCE_MEAN: return (float)(acc / x.size());
+    case REDUCE_ARGMAX: return (float)index;
+    case REDUCE_L2: return (float)std::sqrt(acc);
+    default: return (float)acc;
+    }
+}
+
+// values on a coarse grid, so that COUNT and ties in ARGMAX are exercised and F16 holds them exactly
+static void fillGrid(Tensor &t) {
+    for (int b = 0; b < t.batch(); ++b) {
+        for (int h = 0; h < t.head(); ++h) {
+            for (int s = 0; s < t.sequence(); ++s) {
+                for (int d = 0; d < t.dimension(); ++d) {
+                    const float v = 0.25F * (float)((b * 131 + h * 71 + s * 37 + d * 13) % 29) - 3.0F;
+                    if (t.dtype() == MLLM_TYPE_F16) {
+                        t.setDataAt<mllm_fp16_t>(b, h, s, d, MLLM_FP32_TO_FP16(v));
+                    } else {
+                        t.setDataAt<float>(b, h, s, d, v);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static float valueAt(Tensor &t, const int *pos) {
+    if (t.dtype() == MLLM_TYPE_F16) {
+        return MLLM_FP16_TO_FP32(t.dataAt<mllm_fp16_t>(pos[0], pos[1], pos[2], pos[3]));
+    }
+    return t.dataAt<float>(pos[0], pos[1], pos[2], pos[3]);
+}
+
+static void checkReduceAxis(Backend *bn, DataType type) {
+    Tensor input(bn);
+    input.setDtype(type);
+    // 1100 columns: more than one chunk of the non-DIMENSION path, with a tail
+    input.reshape(2, 3, 5, 1100);
+    input.alloc();
+    fillGrid(input);
+    const int extent[4] = {input.batch(), input.head(), input.sequence(), input.dimension()};
+    for (auto op : {REDUCE_SUM, REDUCE_MEAN, REDUCE_MAX, REDUCE_ARGMAX, REDUCE_L1, REDUCE_L2, REDUCE_COUNT}) {
+        for (auto axis : {BATCH, HEAD, SEQUENCE, DIMENSION}) {
+            int out_extent[4] = {extent[0], extent[1], extent[2], extent[3]};
+            out_extent[axis] = 1;
+            Tensor output(bn);
+            output.reshape(out_extent[0], out_extent[1], out_extent[2], out_extent[3]);
+            output.alloc();
+            reduce_axis(op, input, axis, output, 2, 0.5F);
+            int pos[4];
+            for (pos[0] = 0; pos[0] < out_extent[0]; ++pos[0]) {
+                for (pos[1] = 0; pos[1] < out_extent[1]; ++pos[1]) {
+                    for (pos[2] = 0; pos[2] < out_extent[2]; ++pos[2]) {
+                        for (pos[3] = 0; pos[3] < out_extent[3]; ++pos[3]) {
+                            vector<float> line(extent[axis]);
+                            int at[4] = {pos[0], pos[1], pos[2], pos[3]};
+                            for (int i = 0; i < extent[axis]; ++i) {
+                                at[axis] = i;
+                                line[i] = valueAt(input, at);
+                            }
+                            const float expected = referenceReduce(op, line, 0.5F);
+                            const float actual = output.dataAt<float>(pos[0], pos[1], pos[2], pos[3]);
+                            ASSERT_NEAR(actual, expected, 1e-4F * std::max(1.0F, std::fabs(expected)))
+                                << DataTypeName(type) << " op " << op << " axis " << axis;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_F(CPUTest, ReduceAxis) {
+    checkReduceAxis(bn_, MLLM_TYPE_F32);
+    checkReduceAxis(bn_, MLLM_TYPE_F16);
+}
+
+TEST_F(CPUTest, ReduceOps) {
+    TENSOR(input);
+    TENSOR(mean);
+    input->reshape(3, 4, 2, 6);
+    input->alloc();
+    fillGrid(*input);
+    // the mean over HEAD divides by the number of heads, not by the sequence length
+    CPUMean mean_op(bn_, "mean", HEAD, 1);
+    mean_op.reshape({input}, {mean});
+    mean_op.setUp({input}, {mean});
+    mean_op.execute({input}, {mean});
+    for (int b = 0; b < 3; ++b) {
+        for (int s = 0; s < 2; ++s) {
+            for (int d = 0; d < 6; ++d) {
+                float sum = 0;
+                for (int h = 0; h < 4; ++h) {
+                    sum += input->dataAt<float>(b, h, s, d);
+                }
+                ASSERT_NEAR(mean->dataAt<float>(b, 0, s, d), sum / 4, 1e-5F);
+            }
+        }
+    }
+    // Where lists every match, batch first, then sequence, head and dimension
+    TENSOR(positions);
+    CPUWhere where(bn_, "where", 0.5F, -1, 2);
+    where.reshape({input}, {positions});
+    where.setUp({input}, {positions});
+    where.execute({input}, {positions});
+    vector<vector<float>> expected(4);
+    for (int b = 0; b < 3; ++b) {
+        for (int s = 0; s < 2; ++s) {
+            for (int h = 0; h < 4; ++h) {
+                for (int d = 0; d < 6; ++d) {
+                    if (input->dataAt<float>(b, h, s, d) == 0.5F) {
+                        expected[0].push_back(b);
+                        expected[1].push_back(h);
+                        expected[2].push_back(s);
+                        expected[3].push_back(d);
+                    }
+                }
+            }
+        }
+    }
+    ASSERT_GT(expected[0].size(), 0);
+    ASSERT_EQ(positions->dimension(), expected[0].size());
+    for (int i = 0; i < 4; ++i) {
+        for (int k = 0; k < positions->dimension(); ++k) {
+            ASSERT_EQ(positions->dataAt<float>(0, 0, i, k), expected[i][k]);
+        }
+    }
+}
+
+TEST_F(CPUTest, ReduceRowSpeed) {
+    const int n = 4096;
+    const int rounds = 20000;
+    vector<float> x(n);
+    for (int i = 0; i < n; ++i) {
+        x[i] = 0.001F * (float)(i % 1000) - 0.3F;
+    }
+    float sink = 0;
+    uint64_t start = mllm_time_us();
+    for (int r = 0; r < rounds; ++r) {
+        float sum = 0;
+        for (int i = 0; i < n; ++i) {
+            sum += x[i] * x[i];
+        }
+        sink += sum;
+    }
+    const uint64_t scalar = mllm_time_us() - start;
+    start = mllm_time_us();
+    for (int r = 0; r < rounds; ++r) {
+        sink -= reduce_row(REDUCE_L2, n, x.data());
+    }
+    const uint64_t vector_time = mllm_time_us() - start;
+    start = mllm_time_us();
+    for (int r = 0; r < rounds; ++r) {
+        sink += reduce_row(REDUCE_ARGMAX, n, x.data());
+    }
+    const uint64_t argmax = mllm_time_us() - start;
+    ASSERT_EQ(reduce_row(REDUCE_ARGMAX, n, x.data()), 999.0F);
+    const double bytes = (double)n * sizeof(float) * rounds;
+    std::cout << "4096-wide sum of squares: scalar " << bytes / (double)std::max<uint64_t>(scalar, 1) / 1e3
+              << " GB/s, reduce_row(L2) " << bytes / (double)std::max<uint64_t>(vector_time, 1) / 1e3
+              << " GB/s, reduce_row(ARGMAX) " << bytes / (double)std::max<uint64_t>(argmax, 1) / 1e3 << " GB/s"
+              << " (" << sink << ")" << std::endl;
+}
@@ -0,0 +1,76 @@
+//
+// In-place image splice: image rows written straight into the output of Replace must end up where the
+// placeholder is, whether or not it moved since the previous prompt.
+//
+
+#include "CPUTest.hpp"
+#include "backends/cpu/CPUReplace.hpp"
+
+static void splice(CPUReplace &op, shared_ptr<Tensor> &text, shared_ptr<Tensor> &image, shared_ptr<Tensor> &index,
+                   shared_ptr<Tensor> &output, int placeholder) {
+    const int dim = 8;
+    text->reshape(1, 1, 6, dim);
+    image->reshape(1, 1, 4, dim);
+    index->reshape(1, 1, 1, 1);
+    text->alloc();
+    index->alloc();
+    op.reshape({text, image, index}, {output});
+    op.setUp({text, image, index}, {output});
+    // the producers run after setUp
+    image->alloc();
+    for (int s = 0; s < 6; ++s) {
+        for (int d = 0; d < dim; ++d) {
+            text->setDataAt<float>(0, 0, s, d, (float)(s * 100 + d));
+        }
+    }
+    for (int s = 0; s < 4; ++s) {
+        for (int d = 0; d < dim; ++d) {
+            image->setDataAt<float>(0, 0, s, d, (float)(-1000 - s * 100 - d));
+        }
+    }
+    index->setDataAt<float>(0, 0, 0, 0, (float)placeholder);
+    op.execute({text, image, index}, {output});
+}
+
+static void checkSplice(Tensor &output, int placeholder) {
+    ASSERT_EQ(output.sequence(), 9);
+    for (int s = 0; s < 9; ++s) {
+        for (int d = 0; d < output.dimension(); ++d) {
+            float expected;
+            if (s < placeholder) {
+                expected = (float)(s * 100 + d);
+            } else if (s < placeholder + 4) {
+                expected = (float)(-1000 - (s - placeholder) * 100 - d);
+            } else {
+                expected = (float)((s - 3) * 100 + d);
+            }
+            ASSERT_EQ(output.dataAt<float>(0, 0, s, d), expected) << "row " << s << " placeholder " << placeholder;
+        }
+    }
+}
+
+TEST_F(CPUTest, ReplaceInPlace) {
+    CPUReplace op(bn_, "replace", 1);
+    TENSOR(text);
+    TENSOR(image);
+    TENSOR(index);
+    TENSOR(output);
+    // first prompt: the placeholder position is not known yet
+    splice(op, text, image, index, output, 2);
+    checkSplice(*output, 2);
+    // same template: the image rows land in place
+    splice(op, text, image, index, output, 2);
+    checkSplice(*output, 2);
+    ASSERT_EQ(op.bytesSaved(), 4 * 8 * sizeof(float));
+    // the placeholder moved
+    splice(op, text, image, index, output, 5);
+    checkSplice(*output, 5);
+    ASSERT_EQ(op.bytesSaved(), 0);
+    // and as the copying splice, for an image computed outside the graph
+    CPUReplace copying(bn_, "copying", 1);
+    copying.setRedirectableInputs({false, false, false});
+    TENSOR(image2);
+    TENSOR(output2);
+    splice(copying, text, image2, index, output2, 1);
+    checkSplice(*output2, 1);
+}
@@ -0,0 +1,134 @@
+//
+// 2:4 sparse weights: the sparse blocks against the dense Q4_0 / Q8_0 blocks of the same pruned weight,
+// which quantize the kept weights to the same values. Also reports the bytes and decode time of both.
+//
+
+#include "CPUTest.hpp"
+#include "ParamLoader.hpp"
+#include "Timing.hpp"
+#include "backends/cpu/CPULinear.hpp"
+#include "backends/cpu/quantize/QuantizeSparse.hpp"
+#include <random>
+
+// one Linear weight, quantized to `type` when loaded
+class SparseLoader : public AbstructLoader {
+public:
+    DataType type;
+    vector<float> weight;
+    bool load(Tensor *tensor) override {
+        switch (type) {
+        case MLLM_TYPE_Q4_0: quantize_row_q4_0(weight.data(), tensor->hostPtr<void>(), (int)weight.size()); break;
+        case MLLM_TYPE_Q8_0: quantize_row_q8_0(weight.data(), tensor->hostPtr<void>(), (int)weight.size()); break;
+        case MLLM_TYPE_Q4_0_24: quantize_row_q4_0_24(weight.data(), tensor->hostPtr<void>(), (int)weight.size()); break;
+        case MLLM_TYPE_Q8_0_24: quantize_row_q8_0_24(weight.data(), tensor->hostPtr<void>(), (int)weight.size()); break;
+        default: return false;
+        }
+        return true;
+    }
+    bool load(std::shared_ptr<Tensor> tensor) override {
+        return load(tensor.get());
+    }
+    DataType getDataType(string name) override {
+        return name == "proj.weight" ? type : MLLM_TYPE_COUNT;
+    }
+};
+
+// keeps 2 weights of every group of 4 at random
+static vector<float> prunedWeight(size_t count, std::mt19937 &rng) {
+    std::normal_distribution<float> normal(0.0F, 0.02F);
+    vector<float> weight(count);
+    for (size_t g = 0; g < count; g += 4) {
+        const int zero0 = (int)(rng() % 4);
+        const int zero1 = (zero0 + 1 + (int)(rng() % 3)) % 4;
+        for (int j = 0; j < 4; ++j) {
+            weight[g + j] = j == zero0 || j == zero1 ? 0.0F : normal(rng);
+        }
+    }
+    return weight;
+}
+
+TEST_F(CPUTest, Sparse24Quantize) {
+    std::mt19937 rng(11);
+    const int k = 4 * QK_24;
+    auto weight = prunedWeight(k, rng);
+    ASSERT_TRUE(is_sparse_24(weight.data(), k));
+    weight[1] = weight[2] = weight[3] = 1.0F;
+    ASSERT_FALSE(is_sparse_24(weight.data(), k));
+    weight[0] = 0.0F;
+    // a third weight in a group is pruned: the smallest goes
+    weight[2] = 0.5F;
+    vector<block_q8_0_24> q8(k / QK_24);
+    vector<float> back(k);
+    quantize_row_q8_0_24(weight.data(), q8.data(), k);
+    dequantize_row_q8_0_24(q8.data(), back.data(), k);
+    EXPECT_EQ(back[0], 0.0F);
+    EXPECT_EQ(back[2], 0.0F);
+    EXPECT_NEAR(back[1], 1.0F, 1e-2);
+    EXPECT_NEAR(back[3], 1.0F, 1e-2);
+    weight = prunedWeight(k, rng);
+    for (auto type : {MLLM_TYPE_Q4_0_24, MLLM_TYPE_Q8_0_24}) {
+        vector<char> blocks(DataTypeSize(type, k));
+        if (type == MLLM_TYPE_Q4_0_24) {
+            quantize_row_q4_0_24(weight.data(), blocks.data(), k);
+            dequantize_row_q4_0_24(blocks.data(), back.data(), k);
+        } else {
+            quantize_row_q8_0_24(weight.data(), blocks.data(), k);
+            dequantize_row_q8_0_24(blocks.data(), back.data(), k);
+        }
+        for (int i = 0; i < k; ++i) {
+            if (weight[i] == 0.0F) {
+                EXPECT_EQ(back[i], 0.0F) << DataTypeName(type) << " " << i;
+            } else {
+                EXPECT_NEAR(back[i], weight[i], type == MLLM_TYPE_Q4_0_24 ? 0.01 : 1e-3) << DataTypeName(type) << " " << i;
+            }
+        }
+    }
+}
+
+TEST_F(CPUTest, Sparse24Linear) {
+    const int in_features = 4096;
+    const int out_features = 1024;
+    const int rounds = 20;
+    std::mt19937 rng(13);
+    SparseLoader loader;
+    loader.weight = prunedWeight((size_t)out_features * in_features, rng);
+    const DataType types[2][2] = {{MLLM_TYPE_Q4_0, MLLM_TYPE_Q4_0_24}, {MLLM_TYPE_Q8_0, MLLM_TYPE_Q8_0_24}};
+    for (const auto &pair : types) {
+        vector<float> outputs[2];
+        uint64_t us[2];
+        size_t bytes[2];
+        for (int t = 0; t < 2; ++t) {
+            loader.type = pair[t];
+            CPULinear linear(bn_, "proj", in_features, out_features, false, 4);
+            linear.load(loader);
+            bytes[t] = linear.weight().cntSize();
+            TENSOR(input);
+            TENSOR(output);
+            input->reshape(1, 1, 1, in_features);
+            input->alloc();
+            std::mt19937 input_rng(17);
+            std::normal_distribution<float> normal(0.0F, 1.0F);
+            for (int d = 0; d < in_features; ++d) {
+                input->setDataAt<float>(0, 0, 0, d, normal(input_rng));
+            }
+            linear.reshape({input}, {output});
+            linear.setUp({input}, {output});
+            linear.execute({input}, {output});
+            const uint64_t start = mllm_time_us();
+            for (int r = 0; r < rounds; ++r) {
+                linear.execute({input}, {output});
+            }
+            us[t] = (mllm_time_us() - start) / rounds;
+            outputs[t].assign(output->hostPtr<float>(), output->hostPtr<float>() + output->count());
+        }
+        // the scale of a block only depends on its largest weight, kept by both; the SIMD Q8_0 quantization
+        // rounds ties differently from the reference one
+        for (int o = 0; o < out_features; ++o) {
+            ASSERT_NEAR(outputs[1][o], outputs[0][o], 1e-3 + 1e-3 * std::fabs(outputs[0][o])) << DataTypeName(pair[1]) << " " << o;
+        }
+        std::cout << "Linear " << in_features << "x" << out_features << " decode: " << DataTypeName(pair[0]) << " "
+                  << bytes[0] / 1024 << " KB " << us[0] << " us, " << DataTypeName(pair[1]) << " " << bytes[1] / 1024
+                  << " KB " << us[1] << " us" << std::endl;
+        EXPECT_LT(bytes[1], bytes[0]);
+    }
+}
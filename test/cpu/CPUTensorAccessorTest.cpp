@@ -0,0 +1,146 @@
+//
+// TensorAccessor must reach the same elements as Tensor::ptrAt, for every layout and for ChildTensors.
+// Also compares the cost of the two paths in an RMSNorm-like loop and in CPUCausalMask.
+//
+
+#include "CPUTest.hpp"
+#include "TensorAccessor.hpp"
+#include "Timing.hpp"
+#include "backends/cpu/CPUCausalMask.hpp"
+#include <cmath>
+
+static void checkAccessor(Tensor &t) {
+    TensorAccessor<float> acc(t);
+    for (int b = 0; b < t.batch(); ++b) {
+        for (int h = 0; h < t.head(); ++h) {
+            for (int s = 0; s < t.sequence(); ++s) {
+                for (int d = 0; d < t.dimension(); ++d) {
+                    ASSERT_EQ(acc.ptr(b, h, s, d), t.ptrAt<float>(b, h, s, d)) << b << " " << h << " " << s << " " << d;
+                }
+            }
+        }
+    }
+}
+
+TEST_F(CPUTest, TensorAccessorLayouts) {
+    for (auto ctype : {BSHD, BHDS, SBHD}) {
+        Tensor master(bn_);
+        master.setCtype(ctype);
+        master.reshape(2, 4, 16, 8);
+        master.alloc();
+        checkAccessor(master);
+        // a window of a KV cache: new tokens appended at sequence 5
+        Tensor child(bn_);
+        child.setCtype(ctype);
+        child.reshape(2, 4, 3, 8);
+        child.deepCopyFrom(master, false, {0, 0, 5, 0});
+        checkAccessor(child);
+        ASSERT_TRUE(TensorAccessor<float>(child).direct());
+        // a window running past the end of a ring buffer
+        Tensor wrapped(bn_);
+        wrapped.setCtype(ctype);
+        wrapped.reshape(2, 4, 4, 8);
+        wrapped.deepCopyFrom(master, false, {0, 0, 14, 0});
+        checkAccessor(wrapped);
+        ASSERT_FALSE(TensorAccessor<float>(wrapped).direct());
+    }
+}
+
+// the loop of CPURMSNorm through both paths; returns the time of `rounds` passes in us
+static uint64_t rmsDataAt(Tensor &in, Tensor &out, int rounds) {
+    const uint64_t start = mllm_time_us();
+    for (int r = 0; r < rounds; ++r) {
+        for (int h = 0; h < in.head(); ++h) {
+            for (int s = 0; s < in.sequence(); ++s) {
+                double sum = 0;
+                for (int d = 0; d < in.dimension(); ++d) {
+                    const float v = in.dataAt<float>(0, h, s, d);
+                    sum += (double)v * v;
+                }
+                const float rms = 1.0F / sqrtf((float)(sum / in.dimension()) + 1e-6F);
+                for (int d = 0; d < in.dimension(); ++d) {
+                    out.setDataAt<float>(0, h, s, d, in.dataAt<float>(0, h, s, d) * rms);
+                }
+            }
+        }
+    }
+    return mllm_time_us() - start;
+}
+static uint64_t rmsAccessor(Tensor &input, Tensor &output, int rounds) {
+    const uint64_t start = mllm_time_us();
+    for (int r = 0; r < rounds; ++r) {
+        TensorAccessor<float> in(input);
+        TensorAccessor<float> out(output);
+        for (int h = 0; h < input.head(); ++h) {
+            for (int s = 0; s < input.sequence(); ++s) {
+                double sum = 0;
+                for (int d = 0; d < input.dimension(); ++d) {
+                    const float v = in(0, h, s, d);
+                    sum += (double)v * v;
+                }
+                const float rms = 1.0F / sqrtf((float)(sum / input.dimension()) + 1e-6F);
+                for (int d = 0; d < input.dimension(); ++d) {
+                    out(0, h, s, d) = in(0, h, s, d) * rms;
+                }
+            }
+        }
+    }
+    return mllm_time_us() - start;
+}
+
+TEST_F(CPUTest, TensorAccessorSpeed) {
+    const int rounds = 20;
+    Tensor master(bn_);
+    master.reshape(1, 32, 64, 128);
+    master.alloc();
+    for (int i = 0; i < master.count(); ++i) {
+        master.hostPtr<float>()[i] = 0.001F * (float)(i % 1000);
+    }
+    // the heads of a token window, as RMSNorm sees a child of a Split or a KV cache
+    Tensor child(bn_);
+    child.reshape(1, 32, 32, 128);
+    child.deepCopyFrom(master, false, {0, 0, 16, 0});
+    Tensor out_a(bn_);
+    Tensor out_b(bn_);
+    out_a.reshape(1, 32, 32, 128);
+    out_b.reshape(1, 32, 32, 128);
+    out_a.alloc();
+    out_b.alloc();
+    const uint64_t slow = rmsDataAt(child, out_a, rounds);
+    const uint64_t fast = rmsAccessor(child, out_b, rounds);
+    for (int i = 0; i < out_a.count(); ++i) {
+        ASSERT_EQ(out_a.hostPtr<float>()[i], out_b.hostPtr<float>()[i]);
+    }
+    std::cout << "RMSNorm loop on a child tensor: dataAt " << slow / rounds << " us, TensorAccessor " << fast / rounds
+              << " us (" << (double)slow / (double)std::max<uint64_t>(fast, 1) << "x)" << std::endl;
+
+    // the op, against its former dataAt/setDataAt kernel
+    TENSOR(scores);
+    TENSOR(masked);
+    scores->reshape(1, 32, 64, 64);
+    CPUCausalMask mask(bn_, "mask", 1);
+    mask.reshape({scores}, {masked});
+    mask.setUp({scores}, {masked});
+    for (int i = 0; i < 32 * 64 * 64; ++i) {
+        scores->hostPtr<float>()[i] = 0.01F * (float)(i % 97);
+    }
+    Tensor expected(bn_);
+    expected.reshape(1, 32, 64, 64);
+    expected.alloc();
+    uint64_t start = mllm_time_us();
+    for (int h = 0; h < 32; ++h) {
+        for (int s = 0; s < 64; ++s) {
+            for (int d = 0; d < 64; ++d) {
+                expected.setDataAt<float>({0, h, s, d}, d > s ? -INFINITY : scores->dataAt<float>(0, h, s, d));
+            }
+        }
+    }
+    const uint64_t mask_slow = mllm_time_us() - start;
+    start = mllm_time_us();
+    mask.execute({scores}, {masked});
+    const uint64_t mask_fast = mllm_time_us() - start;
+    for (int i = 0; i < expected.count(); ++i) {
+        ASSERT_EQ(expected.hostPtr<float>()[i], masked->hostPtr<float>()[i]);
+    }
+    std::cout << "CausalMask: dataAt " << mask_slow << " us, op " << mask_fast << " us" << std::endl;
+}
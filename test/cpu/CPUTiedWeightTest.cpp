@@ -0,0 +1,64 @@
+//
+// Tied weights: the input embedding and the LM head of a tied model must read one buffer.
+//
+
+#include "CPUTest.hpp"
+#include "ParamLoader.hpp"
+#include "backends/cpu/CPUEmbedding.hpp"
+#include "backends/cpu/CPULinear.hpp"
+
+// a model file holding only the embedding, with the LM head tied to it
+class TiedLoader : public AbstructLoader {
+public:
+    int loads = 0;
+    bool load(Tensor *tensor) override {
+        EXPECT_EQ(tensor->name(), "embed.weight");
+        for (int i = 0; i < tensor->count(); ++i) {
+            tensor->hostPtr<float>()[i] = 0.01F * (float)i;
+        }
+        ++loads;
+        return true;
+    }
+    bool load(std::shared_ptr<Tensor> tensor) override {
+        return load(tensor.get());
+    }
+    DataType getDataType(string name) override {
+        return name == "embed.weight" ? MLLM_TYPE_F32 : MLLM_TYPE_COUNT;
+    }
+    string tiedTo(string name) override {
+        return name == "embed.weight" || name == "lm_head.weight" ? "embed.weight" : "";
+    }
+};
+
+TEST_F(CPUTest, TiedEmbeddingWeights) {
+    const int vocab = 64;
+    const int hidden = 16;
+    TiedLoader loader;
+    CPUEmbedding embed(bn_, "embed", hidden, vocab, 1);
+    CPULinear lm_head(bn_, "lm_head", hidden, vocab, false, 1);
+    embed.load(loader);
+    lm_head.load(loader);
+    ASSERT_EQ(loader.loads, 1);
+    ASSERT_EQ(embed.weight().hostPtr<float>(), lm_head.weight().hostPtr<float>());
+
+    // token 5 goes through the embedding, then the LM head scores it against every row of the same buffer
+    TENSOR(ids);
+    TENSOR(hidden_states);
+    TENSOR(logits);
+    ids->reshape(1, 1, 1, 1);
+    ids->alloc();
+    ids->setDataAt<float>(0, 0, 0, 0, 5.0F);
+    embed.reshape({ids}, {hidden_states});
+    embed.setUp({ids}, {hidden_states});
+    embed.execute({ids}, {hidden_states});
+    lm_head.reshape({hidden_states}, {logits});
+    lm_head.setUp({hidden_states}, {logits});
+    lm_head.execute({hidden_states}, {logits});
+    for (int v = 0; v < vocab; ++v) {
+        float expected = 0;
+        for (int d = 0; d < hidden; ++d) {
+            expected += 0.01F * (float)(v * hidden + d) * 0.01F * (float)(5 * hidden + d);
+        }
+        ASSERT_NEAR(logits->dataAt<float>(0, 0, 0, v), expected, 1e-3F * std::abs(expected) + 1e-4F) << "token " << v;
+    }
+}
@@ -0,0 +1,148 @@
+//
+// W8A8: a Linear with per-row int8 weights and per-token int8 activations against F32, on activations with
+// outlier channels, with and without smoothing. Also reports the prefill time of F32, Q4_K and W8A8 weights.
+//
+
+#include "CPUTest.hpp"
+#include "ParamLoader.hpp"
+#include "Timing.hpp"
+#include "backends/cpu/CPULinear.hpp"
+#include "backends/cpu/CPUActivationStats.hpp"
+#include "backends/cpu/quantize/QuantizeQ4.hpp"
+#include "backends/cpu/quantize/QuantizeQ8.hpp"
+#include <cmath>
+#include <random>
+
+// params held in memory, by name
+class MemoryLoader : public AbstructLoader {
+public:
+    std::map<string, std::pair<DataType, vector<char>>> params;
+    bool load(Tensor *tensor) override {
+        auto &param = params.at(tensor->name());
+        memcpy(tensor->hostPtr<char>(), param.second.data(), param.second.size());
+        return true;
+    }
+    bool load(std::shared_ptr<Tensor> tensor) override {
+        return load(tensor.get());
+    }
+    DataType getDataType(string name) override {
+        auto it = params.find(name);
+        return it == params.end() ? MLLM_TYPE_COUNT : it->second.first;
+    }
+    void add(const string &name, DataType type, const float *data, size_t count) {
+        vector<char> bytes(DataTypeSize(type, count));
+        switch (type) {
+        case MLLM_TYPE_F32: memcpy(bytes.data(), data, bytes.size()); break;
+        case MLLM_TYPE_Q4_K: quantize_row_q4_K(data, bytes.data(), (int)count); break;
+        default: FAIL() << "unexpected type";
+        }
+        params[name] = {type, std::move(bytes)};
+    }
+    // an I8 weight of `rows` rows and the scales of its rows, as the quantizer writes them
+    void addI8(const string &layer, const float *data, int rows, int cols) {
+        vector<char> bytes((size_t)rows * cols);
+        vector<float> scales(rows);
+        for (int r = 0; r < rows; ++r) {
+            scales[r] = quantize_row_i8(data + (size_t)r * cols, (int8_t *)bytes.data() + (size_t)r * cols, cols);
+        }
+        params[layer + ".weight"] = {MLLM_TYPE_I8, std::move(bytes)};
+        add(layer + ".scale", MLLM_TYPE_F32, scales.data(), scales.size());
+    }
+};
+
+static double relativeError(Tensor &out, Tensor &ref) {
+    double err = 0;
+    double norm = 0;
+    for (int i = 0; i < ref.count(); ++i) {
+        const double d = (double)out.hostPtr<float>()[i] - ref.hostPtr<float>()[i];
+        err += d * d;
+        norm += (double)ref.hostPtr<float>()[i] * ref.hostPtr<float>()[i];
+    }
+    return std::sqrt(err / norm);
+}
+
+// runs `loader`'s weight through a Linear; returns the time of execute() in us
+static uint64_t runLinear(Backend *bn, AbstructLoader &loader, shared_ptr<Tensor> &input, shared_ptr<Tensor> &output) {
+    CPULinear linear(bn, "proj", input->dimension(), output->dimension(), false, 4);
+    linear.load(loader);
+    linear.reshape({input}, {output});
+    linear.setUp({input}, {output});
+    const uint64_t start = mllm_time_us();
+    linear.execute({input}, {output});
+    return mllm_time_us() - start;
+}
+
+TEST_F(CPUTest, W8A8Smoothing) {
+    const int in_features = 1024;
+    const int out_features = 1024;
+    const int seq = 64;
+    std::mt19937 rng(3);
+    std::normal_distribution<float> normal(0.0F, 1.0F);
+    vector<float> weight((size_t)out_features * in_features);
+    for (auto &w : weight) {
+        w = 0.02F * normal(rng);
+    }
+    TENSOR(input);
+    input->reshape(1, 1, seq, in_features);
+    input->alloc();
+    // a few channels carry activations ~60x larger than the others, as the residual stream of LLMs does
+    for (int s = 0; s < seq; ++s) {
+        for (int d = 0; d < in_features; ++d) {
+            const float scale = d % 128 == 7 ? 60.0F : 1.0F;
+            input->setDataAt<float>(0, 0, s, d, scale * normal(rng));
+        }
+    }
+    const auto make_output = [&]() {
+        auto t = std::make_shared<Tensor>(bn_);
+        t->reshape(1, 1, seq, out_features);
+        return t;
+    };
+
+    MemoryLoader f32;
+    f32.add("proj.weight", MLLM_TYPE_F32, weight.data(), weight.size());
+    auto ref = make_output();
+    const uint64_t f32_us = runLinear(bn_, f32, input, ref);
+
+    MemoryLoader q4k;
+    q4k.add("proj.weight", MLLM_TYPE_Q4_K, weight.data(), weight.size());
+    auto out_q4k = make_output();
+    const uint64_t q4k_us = runLinear(bn_, q4k, input, out_q4k);
+
+    MemoryLoader w8a8;
+    w8a8.addI8("proj", weight.data(), out_features, in_features);
+    auto out_w8a8 = make_output();
+    const uint64_t w8a8_us = runLinear(bn_, w8a8, input, out_w8a8);
+
+    // calibration, then the weight smoothed as the quantizer does
+    auto stats = std::make_shared<ActivationStats>();
+    auto *cpu = static_cast<CPUBackend *>(bn_);
+    cpu->setActivationStats(stats);
+    auto calibrated = make_output();
+    runLinear(bn_, f32, input, calibrated);
+    cpu->setActivationStats(nullptr);
+    ASSERT_NE(stats->find("proj"), nullptr);
+    const string path = "w8a8_test.stats";
+    ASSERT_TRUE(stats->save(path));
+    ActivationStats loaded;
+    ASSERT_TRUE(loaded.load(path));
+    std::remove(path.c_str());
+    ASSERT_EQ(*loaded.find("proj"), *stats->find("proj"));
+    vector<float> smoothed = weight;
+    const auto factors = loaded.smoothing("proj", smoothed.data(), out_features, in_features, 0.5F);
+    ASSERT_EQ(factors.size(), in_features);
+    MemoryLoader smooth;
+    smooth.addI8("proj", smoothed.data(), out_features, in_features);
+    smooth.add("proj.smooth", MLLM_TYPE_F32, factors.data(), factors.size());
+    auto out_smooth = make_output();
+    const uint64_t smooth_us = runLinear(bn_, smooth, input, out_smooth);
+
+    const double err_q4k = relativeError(*out_q4k, *ref);
+    const double err_w8a8 = relativeError(*out_w8a8, *ref);
+    const double err_smooth = relativeError(*out_smooth, *ref);
+    std::cout << "relative error vs F32: Q4_K " << err_q4k << ", W8A8 " << err_w8a8 << ", W8A8 smoothed "
+              << err_smooth << std::endl;
+    std::cout << "prefill " << seq << "x" << in_features << "x" << out_features << ": F32 " << f32_us << " us, Q4_K "
+              << q4k_us << " us, W8A8 " << w8a8_us << " us, W8A8 smoothed " << smooth_us << " us" << std::endl;
+    ASSERT_LT(err_smooth, err_w8a8);
+    ASSERT_LT(err_smooth, 0.02);
+}
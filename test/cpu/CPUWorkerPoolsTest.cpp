@@ -0,0 +1,227 @@
+//
+// CPU split between prefill and decode: each phase gets its own CPUs, lends them while idle and takes them back
+// once busy; Scope pins the thread and its OpenMP team, and puts them back on the process CPUs on exit, only
+// when their CPUs change. Runs on four CPUs numbered 0-3 whatever the machine has, pinning to the ones that exist.
+// Power modes: the CPUs each one keeps, the thread counts of Power_Low, and the CPU and wall time of a run of
+// elementwise ops in Power_Normal and Power_Low.
+//
+
+#include "CPUTest.hpp"
+#include "Timing.hpp"
+#include "backends/cpu/CPUSiLU.hpp"
+#include "backends/cpu/CPUWorkerPools.hpp"
+#include <algorithm>
+#include <future>
+#include <omp.h>
+#include <thread>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+static vector<int> affinity() {
+    vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+static vector<int> sorted(vector<int> cpus) {
+    std::sort(cpus.begin(), cpus.end());
+    return cpus;
+}
+
+TEST_F(CPUTest, WorkerPoolsSplit) {
+    const vector<int> all = {0, 1, 2, 3};
+    // the CPUs 0-3 the machine has, where pinning to all of them lands
+    vector<int> landed;
+    for (int cpu : affinity()) {
+        if (cpu < 4) {
+            landed.push_back(cpu);
+        }
+    }
+    CPUWorkerPools::configure(1, BackendConfig::Power_Normal, all);
+    ASSERT_TRUE(CPUWorkerPools::enabled());
+    EXPECT_EQ(CPUWorkerPools::cpuCount(), 4);
+    // both idle: each phase may use every CPU
+    EXPECT_EQ(sorted(CPUWorkerPools::cpus(CPUWorkerPools::PREFILL)), all);
+    EXPECT_EQ(sorted(CPUWorkerPools::cpus(CPUWorkerPools::DECODE)), all);
+    EXPECT_EQ(CPUWorkerPools::threadLimit(), 0);
+
+    // a Net asking for another split keeps this one
+    EXPECT_TRUE(CPUWorkerPools::require(1, BackendConfig::Power_Normal));
+    EXPECT_FALSE(CPUWorkerPools::require(0, BackendConfig::Power_Normal));
+    EXPECT_FALSE(CPUWorkerPools::require(1, BackendConfig::Power_High));
+    EXPECT_TRUE(CPUWorkerPools::enabled());
+
+    {
+        CPUWorkerPools::Scope decode(CPUWorkerPools::DECODE);
+        // prefill idle: decode borrows its CPUs
+        EXPECT_EQ(CPUWorkerPools::threadLimit(), 4);
+        {
+            // nested: stays in decode
+            CPUWorkerPools::Scope nested(CPUWorkerPools::PREFILL);
+            EXPECT_EQ(CPUWorkerPools::threadLimit(), 4);
+        }
+        std::promise<void> entered;
+        std::promise<void> release;
+        std::future<void> released = release.get_future();
+        int prefill_limit = 0;
+        std::thread prefill([&] {
+            CPUWorkerPools::Scope scope(CPUWorkerPools::PREFILL);
+            prefill_limit = CPUWorkerPools::threadLimit();
+            entered.set_value();
+            released.wait();
+        });
+        entered.get_future().wait();
+        // both busy: each phase on its own CPUs, decode takes back the borrowed ones at its next op
+        EXPECT_EQ(prefill_limit, 3);
+        EXPECT_EQ(CPUWorkerPools::cpus(CPUWorkerPools::PREFILL), vector<int>({0, 1, 2}));
+        EXPECT_EQ(CPUWorkerPools::cpus(CPUWorkerPools::DECODE), vector<int>({3}));
+        EXPECT_EQ(CPUWorkerPools::threadLimit(), 1);
+        release.set_value();
+        prefill.join();
+        EXPECT_EQ(CPUWorkerPools::threadLimit(), 4);
+    }
+    EXPECT_EQ(CPUWorkerPools::threadLimit(), 0);
+    // the thread and its whole team are back on every CPU
+    EXPECT_EQ(affinity(), landed);
+    vector<vector<int>> team(omp_get_max_threads());
+#pragma omp parallel num_threads((int)team.size())
+    team[omp_get_thread_num()] = affinity();
+    for (const auto &cpus : team) {
+        EXPECT_EQ(cpus, landed);
+    }
+
+    CPUWorkerPools::configure(0);
+    EXPECT_FALSE(CPUWorkerPools::enabled());
+}
+
+TEST_F(CPUTest, WorkerPoolsPinOnce) {
+    const vector<int> all = {0, 1, 2, 3};
+    CPUWorkerPools::configure(1, BackendConfig::Power_Normal, all);
+    {
+        CPUWorkerPools::Scope decode(CPUWorkerPools::DECODE);
+    }
+    // decode steps with prefill idle: the thread stays on every CPU, nothing to re-pin
+    const unsigned long pins = CPUWorkerPools::pinCount();
+    for (int step = 0; step < 50; ++step) {
+        CPUWorkerPools::Scope decode(CPUWorkerPools::DECODE);
+        EXPECT_EQ(CPUWorkerPools::threadLimit(), 4);
+    }
+    EXPECT_EQ(CPUWorkerPools::pinCount(), pins);
+    // a prefill starting in between changes the decode CPUs: pinned to them, then back on exit
+    std::promise<void> entered;
+    std::promise<void> release;
+    std::future<void> released = release.get_future();
+    std::thread prefill([&] {
+        CPUWorkerPools::Scope scope(CPUWorkerPools::PREFILL);
+        entered.set_value();
+        released.wait();
+    });
+    entered.get_future().wait();
+    const unsigned long busy_pins = CPUWorkerPools::pinCount();
+    {
+        CPUWorkerPools::Scope decode(CPUWorkerPools::DECODE);
+        EXPECT_EQ(CPUWorkerPools::threadLimit(), 1);
+    }
+    EXPECT_EQ(CPUWorkerPools::pinCount(), busy_pins + 2);
+    release.set_value();
+    prefill.join();
+    CPUWorkerPools::configure(0);
+}
+
+TEST_F(CPUTest, WorkerPoolsPowerCpus) {
+    const vector<int> cpus = {0, 1, 2, 3, 4, 5, 6, 7};
+    // big.LITTLE, interleaved
+    const vector<long> capacity = {1024, 1024, 512, 512, 1024, 512, 1024, 512};
+    EXPECT_EQ(CPUWorkerPools::powerCpus(cpus, capacity, BackendConfig::Power_Normal), cpus);
+    // biggest last, where the decode CPUs are taken from
+    EXPECT_EQ(CPUWorkerPools::powerCpus(cpus, capacity, BackendConfig::Power_High), vector<int>({2, 3, 5, 7, 0, 1, 4, 6}));
+    EXPECT_EQ(CPUWorkerPools::powerCpus(cpus, capacity, BackendConfig::Power_Low), vector<int>({2, 3, 5, 7}));
+    // three clusters: the smallest one only
+    EXPECT_EQ(CPUWorkerPools::powerCpus({4, 5, 6, 7}, {800, 400, 1024, 400}, BackendConfig::Power_Low), vector<int>({5, 7}));
+    // all alike, or unknown: half of them, at least one
+    EXPECT_EQ(CPUWorkerPools::powerCpus({0, 1, 2, 3, 4, 5}, vector<long>(6, 0), BackendConfig::Power_Low), vector<int>({0, 1, 2}));
+    EXPECT_EQ(CPUWorkerPools::powerCpus({0, 1, 2, 3, 4, 5}, vector<long>(6, 0), BackendConfig::Power_High), vector<int>({0, 1, 2, 3, 4, 5}));
+    EXPECT_EQ(CPUWorkerPools::powerCpus({3}, {1024}, BackendConfig::Power_Low), vector<int>({3}));
+}
+
+TEST_F(CPUTest, WorkerPoolsLowPowerThreads) {
+    const vector<int> all = {0, 1, 2, 3};
+    const double large = 1e12;
+    CPUWorkerPools::configure(0, BackendConfig::Power_Normal, all);
+    EXPECT_EQ(CPUWorkerPools::cpuCount(), 4);
+    EXPECT_EQ(CPUBackend::threadsFor(large, 8), 8);
+    vector<int> normal;
+    for (double work = 1e3; work < large; work *= 4) {
+        normal.push_back(CPUBackend::threadsFor(work, 8));
+    }
+    CPUWorkerPools::configure(0, BackendConfig::Power_Low, all);
+    const int low_cpus = CPUWorkerPools::cpuCount();
+    EXPECT_GE(low_cpus, 1);
+    EXPECT_LT(low_cpus, 4);
+    // never wider than the CPUs of Power_Low, nor than Power_Normal for the same op
+    EXPECT_EQ(CPUBackend::threadsFor(large, 8), low_cpus);
+    size_t i = 0;
+    for (double work = 1e3; work < large; work *= 4, ++i) {
+        const int threads = CPUBackend::threadsFor(work, 8);
+        EXPECT_LE(threads, std::min(normal[i], low_cpus)) << "work " << work;
+        EXPECT_GE(threads, 1);
+    }
+    EXPECT_EQ(CPUBackend::threadsFor(1, 8), 1);
+    CPUWorkerPools::configure(0);
+}
+
+// a decode step's worth of small elementwise ops, plus a few prefill-sized ones
+static void runOps(Backend *bn, int rounds, uint64_t &wall_us, uint64_t &cpu_us) {
+    CPUSiLU silu(bn, "silu", 4);
+    vector<shared_ptr<Tensor>> inputs;
+    vector<shared_ptr<Tensor>> outputs;
+    for (int seq : {1, 64}) {
+        inputs.push_back(std::make_shared<Tensor>(bn));
+        outputs.push_back(std::make_shared<Tensor>(bn));
+        inputs.back()->reshape(1, 1, seq, 4096);
+        inputs.back()->alloc();
+        for (int i = 0; i < inputs.back()->count(); ++i) {
+            inputs.back()->hostPtr<float>()[i] = 0.001F * (float)(i % 1000);
+        }
+        silu.reshape({inputs.back()}, {outputs.back()});
+        outputs.back()->alloc();
+    }
+    const uint64_t wall_start = mllm_time_us();
+    const uint64_t cpu_start = mllm_cpu_time_us();
+    for (int r = 0; r < rounds; ++r) {
+        for (int op = 0; op < 32; ++op) {
+            silu.execute({inputs[0]}, {outputs[0]});
+        }
+        silu.execute({inputs[1]}, {outputs[1]});
+    }
+    wall_us = mllm_time_us() - wall_start;
+    cpu_us = mllm_cpu_time_us() - cpu_start;
+}
+
+TEST_F(CPUTest, WorkerPoolsPowerTime) {
+    const int rounds = 200;
+    uint64_t wall[2];
+    uint64_t cpu[2];
+    const BackendConfig::PowerMode modes[2] = {BackendConfig::Power_Normal, BackendConfig::Power_Low};
+    // calibrates threadsFor and starts the OpenMP workers
+    runOps(bn_, rounds / 10, wall[0], cpu[0]);
+    for (int m = 0; m < 2; ++m) {
+        CPUWorkerPools::configure(0, modes[m]);
+        runOps(bn_, rounds, wall[m], cpu[m]);
+        std::cout << (m == 0 ? "Power_Normal" : "Power_Low") << " on " << CPUWorkerPools::cpuCount() << " CPUs: "
+                  << wall[m] / rounds << " us wall, " << cpu[m] / rounds << " us CPU per round" << std::endl;
+    }
+    CPUWorkerPools::configure(0);
+    EXPECT_GT(wall[1], 0);
+}
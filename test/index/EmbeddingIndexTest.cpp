@@ -0,0 +1,156 @@
+//
+// EmbeddingIndex: recall of every storage type and of the IVF index against an exact F32 search, persistence
+// through the mapped file, and (disabled by default) the recall@10 / QPS benchmark on 1M vectors.
+//
+
+#include "gtest/gtest.h"
+#include "index/EmbeddingIndex.hpp"
+#include "Timing.hpp"
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <set>
+
+using namespace mllm;
+
+// normalised vectors around `clusters` random centres, as embeddings of a real collection tend to be
+static vector<float> syntheticEmbeddings(int64_t count, int dimension, int clusters, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<float> normal(0.0F, 1.0F);
+    std::mt19937_64 centre_rng(7);
+    vector<float> centres((size_t)clusters * dimension);
+    for (auto &v : centres) {
+        v = normal(centre_rng);
+    }
+    vector<float> vectors((size_t)count * dimension);
+    for (int64_t i = 0; i < count; ++i) {
+        const float *centre = centres.data() + (rng() % clusters) * dimension;
+        float *v = vectors.data() + i * dimension;
+        double norm = 0;
+        for (int d = 0; d < dimension; ++d) {
+            v[d] = centre[d] + 0.8F * normal(rng);
+            norm += (double)v[d] * v[d];
+        }
+        for (int d = 0; d < dimension; ++d) {
+            v[d] = (float)(v[d] / std::sqrt(norm));
+        }
+    }
+    return vectors;
+}
+
+static double recallAt(const vector<int64_t> &expected, const vector<int64_t> &found, int k) {
+    int64_t hits = 0;
+    for (size_t q = 0; q < expected.size() / k; ++q) {
+        std::set<int64_t> truth(expected.begin() + q * k, expected.begin() + (q + 1) * k);
+        for (int i = 0; i < k; ++i) {
+            hits += truth.count(found[q * k + i]);
+        }
+    }
+    return (double)hits / (double)expected.size();
+}
+
+struct SearchResult {
+    vector<int64_t> ids;
+    vector<float> scores;
+    double qps;
+};
+static SearchResult searchAll(const EmbeddingIndex &index, const vector<float> &queries, int k) {
+    const int64_t count = (int64_t)queries.size() / index.dimension();
+    SearchResult result{vector<int64_t>(count * k), vector<float>(count * k), 0};
+    const uint64_t start = mllm_time_us();
+    index.search(queries.data(), count, k, result.ids.data(), result.scores.data());
+    result.qps = (double)count * 1e6 / (double)std::max<uint64_t>(mllm_time_us() - start, 1);
+    return result;
+}
+
+TEST(EmbeddingIndexTest, Recall) {
+    const int dimension = 128;
+    const int k = 10;
+    const auto base = syntheticEmbeddings(20000, dimension, 64, 1);
+    const auto queries = syntheticEmbeddings(50, dimension, 64, 2);
+    EmbeddingIndex exact(dimension);
+    exact.add(base.data(), 20000);
+    ASSERT_EQ(exact.size(), 20000);
+    const auto truth = searchAll(exact, queries, k);
+    for (size_t i = 1; i < truth.scores.size(); ++i) {
+        if (i % k != 0) {
+            ASSERT_GE(truth.scores[i - 1], truth.scores[i]);
+        }
+    }
+    for (auto type : {MLLM_TYPE_F16, MLLM_TYPE_Q8_0}) {
+        EmbeddingIndex index(dimension, type);
+        index.add(base.data(), 20000);
+        const double recall = recallAt(truth.ids, searchAll(index, queries, k).ids, k);
+        std::cout << DataTypeName(type) << " recall@10 " << recall << std::endl;
+        ASSERT_GE(recall, 0.9);
+    }
+    EmbeddingIndex ivf(dimension, MLLM_TYPE_F32, 64);
+    ivf.train(base.data(), 5000);
+    ivf.add(base.data(), 20000);
+    ivf.setProbes(8);
+    const double recall = recallAt(truth.ids, searchAll(ivf, queries, k).ids, k);
+    std::cout << "IVF 64 lists, 8 probes recall@10 " << recall << std::endl;
+    ASSERT_GE(recall, 0.8);
+}
+
+TEST(EmbeddingIndexTest, MappedFile) {
+    const int dimension = 64;
+    const int k = 5;
+    const auto base = syntheticEmbeddings(3000, dimension, 16, 3);
+    const auto queries = syntheticEmbeddings(20, dimension, 16, 4);
+    vector<int64_t> ids(2000);
+    for (int i = 0; i < 2000; ++i) {
+        ids[i] = 1000000 + 3 * i;
+    }
+    const string path = "embedding_index_test.idx";
+    EmbeddingIndex index(dimension, MLLM_TYPE_Q8_0, 16);
+    index.train(base.data(), 3000);
+    index.add(base.data(), 2000, ids.data());
+    ASSERT_TRUE(index.save(path));
+    auto mapped = EmbeddingIndex::open(path);
+    ASSERT_NE(mapped, nullptr);
+    ASSERT_EQ(mapped->size(), 2000);
+    ASSERT_EQ(mapped->type(), MLLM_TYPE_Q8_0);
+    const auto before = searchAll(index, queries, k);
+    const auto after = searchAll(*mapped, queries, k);
+    ASSERT_EQ(before.ids, after.ids);
+    ASSERT_EQ(before.scores, after.scores);
+    // adding to a mapped index copies it to memory first
+    index.add(base.data() + 2000 * dimension, 1000);
+    mapped->add(base.data() + 2000 * dimension, 1000);
+    ASSERT_EQ(mapped->size(), 3000);
+    ASSERT_EQ(searchAll(index, queries, k).ids, searchAll(*mapped, queries, k).ids);
+    std::remove(path.c_str());
+    ASSERT_EQ(EmbeddingIndex::open(path), nullptr);
+}
+
+// run with --gtest_also_run_disabled_tests --gtest_filter='*IndexBenchmark*'
+TEST(EmbeddingIndexTest, DISABLED_IndexBenchmark) {
+    const int64_t count = 1000000;
+    const int dimension = 128;
+    const int k = 10;
+    const auto base = syntheticEmbeddings(count, dimension, 1000, 1);
+    const auto queries = syntheticEmbeddings(200, dimension, 1000, 2);
+    EmbeddingIndex exact(dimension);
+    exact.add(base.data(), count);
+    const auto truth = searchAll(exact, queries, k);
+    std::cout << "exact F32: " << truth.qps << " QPS" << std::endl;
+    for (auto type : {MLLM_TYPE_F16, MLLM_TYPE_Q8_0}) {
+        EmbeddingIndex index(dimension, type);
+        index.add(base.data(), count);
+        const auto result = searchAll(index, queries, k);
+        std::cout << "exact " << DataTypeName(type) << ": recall@10 " << recallAt(truth.ids, result.ids, k) << ", "
+                  << result.qps << " QPS" << std::endl;
+    }
+    for (auto type : {MLLM_TYPE_F32, MLLM_TYPE_Q8_0}) {
+        EmbeddingIndex ivf(dimension, type, 1024);
+        ivf.train(base.data(), 50000, 8);
+        ivf.add(base.data(), count);
+        for (int probes : {8, 32}) {
+            ivf.setProbes(probes);
+            const auto result = searchAll(ivf, queries, k);
+            std::cout << "IVF1024 " << DataTypeName(type) << " probes " << probes << ": recall@10 "
+                      << recallAt(truth.ids, result.ids, k) << ", " << result.qps << " QPS" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,63 @@
+//
+// Score-based BPE (llama vocab): the token ids must not change, and the throughput on a few MB of text is reported.
+//
+
+#include "TokenizorTest.hpp"
+#include "tokenizers/BPE/Bpe.hpp"
+#include "Timing.hpp"
+#include <fstream>
+#include <sstream>
+
+TEST_F(TokenizerTest, BpeScoreMerges) {
+    mllm::BPETokenizer tokenizer("../vocab/llama_vocab.mllm");
+    // ids of the string-keyed implementation
+    const vector<std::pair<string, vector<mllm::token_id_t>>> cases = {
+        {" Hello, my name is Alice and I live in Paris.",
+         {1, 15043, 29892, 590, 1024, 338, 16308, 322, 306, 5735, 297, 3681, 29889}},
+        {" The quick brown fox jumps over the lazy dog 1234567890 times!",
+         {1, 450, 4996, 17354, 1701, 29916, 432, 17204, 975, 278, 17366, 11203, 29871, 29896, 29906, 29941, 29946, 29945,
+          29953, 29955, 29947, 29929, 29900, 3064, 29991}},
+        {" 你好，世界。今天天气很好。",
+         {1, 29871, 30919, 31076, 30214, 30793, 30967, 30267, 31482, 30408, 30408, 233, 179, 151, 232, 193, 139, 31076,
+          30267}},
+        {" internationalization\tnon-ASCII: ééé ☃ \xF0\x9F\x98\x80",
+         {1, 6121, 2133, 12, 5464, 29899, 28599, 2687, 29901, 904, 29948, 29948, 29871, 229, 155, 134, 29871, 243, 162,
+          155, 131}},
+        {" a", {1, 263}},
+    };
+    for (const auto &test : cases) {
+        vector<mllm::token_id_t> tokens;
+        tokenizer.tokenize(test.first, tokens, true);
+        ASSERT_EQ(tokens, test.second) << test.first;
+    }
+}
+
+TEST_F(TokenizerTest, BpeThroughput) {
+    mllm::BPETokenizer tokenizer("../vocab/llama_vocab.mllm");
+    std::ifstream file("../README.md");
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const string readme = buffer.str();
+    ASSERT_FALSE(readme.empty());
+    string corpus;
+    while (corpus.size() < 4 * 1024 * 1024) {
+        corpus += readme;
+    }
+    // prompts of 4 KB
+    const size_t chunk = 4096;
+    size_t count = 0;
+    uint64_t checksum = 0;
+    vector<mllm::token_id_t> tokens;
+    const uint64_t start = mllm::mllm_time_us();
+    for (size_t offset = 0; offset < corpus.size(); offset += chunk) {
+        tokens.clear();
+        tokenizer.tokenize(corpus.substr(offset, chunk), tokens, true);
+        count += tokens.size();
+        for (auto token : tokens) {
+            checksum = checksum * 31 + token;
+        }
+    }
+    const uint64_t elapsed = mllm::mllm_time_us() - start;
+    std::cout << corpus.size() / 1024 << " KB, " << count << " tokens, " << (double)count * 1e6 / (double)elapsed
+              << " tokens/s, checksum " << checksum << std::endl;
+}
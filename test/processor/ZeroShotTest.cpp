@@ -0,0 +1,113 @@
+//
+// Zero-shot classification: the label cache must round-trip, is only reused for the same labels, model and width,
+// and classify must rank labels by cosine similarity.
+//
+
+#include "gtest/gtest.h"
+#include "processor/ZeroShot.hpp"
+#include <cmath>
+#include <cstdio>
+
+using namespace mllm;
+
+static vector<float> labelEmbedding(int label, int dimension) {
+    vector<float> embedding(dimension);
+    for (int d = 0; d < dimension; ++d) {
+        embedding[d] = std::sin(0.37F * (float)(label + 1) * (float)(d + 1));
+    }
+    return embedding;
+}
+
+TEST(ZeroShotTest, CachedLabels) {
+    const int dimension = 96;
+    vector<string> labels;
+    for (int l = 0; l < 50; ++l) {
+        labels.push_back("a photo of label " + std::to_string(l));
+    }
+    const string cache = "zero_shot_test.cache";
+    std::remove(cache.c_str());
+    int encoded = 0;
+    auto encode = [&](const string &label) {
+        ++encoded;
+        return labelEmbedding(std::stoi(label.substr(label.rfind(' ') + 1)), dimension);
+    };
+    const string model = "model-a.mllm 1000 1";
+    ZeroShotClassifier first;
+    ASSERT_FALSE(first.prepare(labels, encode, cache, model, dimension));
+    ASSERT_EQ(encoded, 50);
+    ZeroShotClassifier second;
+    ASSERT_TRUE(second.prepare(labels, encode, cache, model, dimension));
+    ASSERT_EQ(encoded, 50);
+    ASSERT_EQ(second.labels(), labels);
+    ASSERT_EQ(second.dimension(), dimension);
+    ASSERT_EQ(second.model(), model);
+    // another label set invalidates the cache
+    labels.pop_back();
+    ZeroShotClassifier third;
+    ASSERT_FALSE(third.prepare(labels, encode, cache, model, dimension));
+    ASSERT_EQ(encoded, 99);
+    labels.push_back("a photo of label 49");
+    ASSERT_FALSE(second.prepare(labels, encode, cache, model, dimension));
+    ASSERT_EQ(encoded, 149);
+    // so does another model, or another embedding width
+    ZeroShotClassifier other;
+    ASSERT_FALSE(other.prepare(labels, encode, cache, "model-b.mllm 1000 1", dimension));
+    ASSERT_EQ(encoded, 199);
+    ASSERT_EQ(other.model(), "model-b.mllm 1000 1");
+    ASSERT_FALSE(second.prepare(labels, encode, cache, model, dimension));
+    ASSERT_EQ(encoded, 249);
+    const int wide = 2 * dimension;
+    auto encode_wide = [&](const string &label) {
+        ++encoded;
+        return labelEmbedding(std::stoi(label.substr(label.rfind(' ') + 1)), wide);
+    };
+    ZeroShotClassifier widened;
+    ASSERT_FALSE(widened.prepare(labels, encode_wide, cache, model, wide));
+    ASSERT_EQ(widened.dimension(), wide);
+    ASSERT_FALSE(second.prepare(labels, encode, cache, model, dimension));
+    ASSERT_TRUE(second.prepare(labels, encode, cache, model, dimension));
+    // the identity of a file changes with its contents
+    const string file = "zero_shot_test.model";
+    FILE *fp = fopen(file.c_str(), "wb");
+    fputs("weights", fp);
+    fclose(fp);
+    const string before = ZeroShotClassifier::modelIdentity(file);
+    fp = fopen(file.c_str(), "ab");
+    fputs(" and more", fp);
+    fclose(fp);
+    ASSERT_NE(ZeroShotClassifier::modelIdentity(file), before);
+    std::remove(file.c_str());
+
+    // queries: a scaled copy of label 7 and a noisy label 31
+    vector<float> queries = labelEmbedding(7, dimension);
+    for (auto &v : queries) {
+        v *= 3.0F;
+    }
+    auto noisy = labelEmbedding(31, dimension);
+    for (int d = 0; d < dimension; ++d) {
+        noisy[d] += 0.05F * std::cos((float)d);
+    }
+    queries.insert(queries.end(), noisy.begin(), noisy.end());
+    auto matches = second.classify(queries.data(), 2, 5);
+    ASSERT_EQ(matches.size(), 2);
+    ASSERT_EQ(matches[0].size(), 5);
+    ASSERT_EQ(matches[0][0].label, 7);
+    ASSERT_NEAR(matches[0][0].similarity, 1.0F, 2e-3F);
+    ASSERT_EQ(matches[1][0].label, 31);
+    for (const auto &match : matches) {
+        for (size_t i = 1; i < match.size(); ++i) {
+            ASSERT_GE(match[i - 1].similarity, match[i].similarity);
+            ASSERT_GE(match[i - 1].probability, match[i].probability);
+        }
+    }
+    // the similarities against an exact fp32 cosine
+    auto expected = labelEmbedding(matches[1][1].label, dimension);
+    double dot = 0, nq = 0, nl = 0;
+    for (int d = 0; d < dimension; ++d) {
+        dot += (double)noisy[d] * expected[d];
+        nq += (double)noisy[d] * noisy[d];
+        nl += (double)expected[d] * expected[d];
+    }
+    ASSERT_NEAR(matches[1][1].similarity, dot / std::sqrt(nq * nl), 2e-3);
+    std::remove(cache.c_str());
+}
@@ -30,7 +30,7 @@ class Writer:
         self.writer.seek(0)
         self.write_int(MAGIC_NUMBER)
     def __torch_dtype_to_int(self, dtype: torch.dtype) -> int:
-        if dtype == torch.float32 or dtype == torch.bfloat16:
+        if dtype == torch.float32:
             return 0
         elif dtype == torch.float16:
             return 1
@@ -40,6 +40,8 @@ class Writer:
             return 17
         elif dtype == torch.int32:
             return 18
+        elif dtype == torch.bfloat16:
+            return 19
         else:
             raise Exception(f"Unknown dtype: {dtype}")
     def write_int(self, val: int):
@@ -53,11 +55,14 @@ class Writer:
         self.writer.write(val.encode("utf-8"))
 
     def write_tensor(self, tensor: torch.Tensor, name: str) -> [int, int]:
+        if tensor.dtype == torch.bfloat16 and (tensor.dim() != 2 or args.widen_bf16):
+            # only the matrices of Linear and Embedding have bf16 kernels, the rest is small
+            tensor = tensor.detach().to(torch.float32)
         tensor_idx = Tensor(name=name, dtype=self.__torch_dtype_to_int(tensor.dtype))
         self.tensors_map[name] = tensor_idx
         offset = self.writer.tell()
-        if tensor.dtype == torch.bfloat16:  # to float 16
-            tensor_numpy = tensor.detach().to(torch.float32).numpy()
+        if tensor.dtype == torch.bfloat16:  # numpy has no bfloat16, write the bits
+            tensor_numpy = tensor.detach().contiguous().view(torch.int16).numpy()
         else:
             tensor_numpy = tensor.numpy()
         tensor_numpy.tofile(self.writer)
@@ -65,6 +70,13 @@ class Writer:
         tensor_idx.size = size
         tensor_idx.offset = offset
         return offset, size
+    def tie_tensor(self, name: str, target: str):
+        # index `name` on the data of `target`; mllm loads tied weights into one buffer
+        tied = self.tensors_map[target]
+        tensor_idx = Tensor(name=name, dtype=tied.dtype)
+        tensor_idx.offset = tied.offset
+        tensor_idx.size = tied.size
+        self.tensors_map[name] = tensor_idx
     def write_tensor_index(
             self,
     ):
@@ -206,6 +218,37 @@ def key_map(key: str, model_type: str):
     return new_key
 
 
+def write_model(writer: Writer, model: dict, index_: dict, ties: dict):
+    model_keys = all_keys(model, index_)
+    writer.write_tensor_index_padding(model_keys + [key for key in ties if key not in model_keys])
+
+    storages = {}
+    for key in model_keys:
+        if key in ties:
+            continue
+        tensor = get_tensor(model, key, index_)
+        if args.type == "torch":
+            # weights the checkpoint ties share their storage, which the loaded checkpoint keeps alive;
+            # safetensors returns a new tensor per get_tensor and stores no shared tensors, use --tie
+            storage = (tensor.untyped_storage().data_ptr(), tensor.storage_offset(), tuple(tensor.shape),
+                       tuple(tensor.stride()), tensor.dtype)
+            if storage in storages:
+                writer.tie_tensor(key, storages[storage])
+                print(f"Tie tensor {key} to {storages[storage]}")
+                continue
+            storages[storage] = key
+        if tensor.dtype != torch.bfloat16:
+            # bfloat16 is kept or widened by write_tensor, see --widen_bf16
+            tensor = tensor.float()
+        offset, size = writer.write_tensor(tensor, key)
+        print(f"Get tensor {key} to {offset} with size {size}")
+    for key, target in ties.items():
+        writer.tie_tensor(key, target)
+        print(f"Tie tensor {key} to {target}")
+
+    writer.write_tensor_index()
+
+
 if __name__ == "__main__":
     global args
     parser = argparse.ArgumentParser()
@@ -218,6 +261,17 @@ if __name__ == "__main__":
         choices=["torch", "safetensor"],
         default="torch",
     )
+    parser.add_argument(
+        "--widen_bf16",
+        action="store_true",
+        help="store bfloat16 weights as float32 instead of bfloat16",
+    )
+    parser.add_argument(
+        "--tie",
+        action="append",
+        default=[],
+        help="name=target: store `name` as `target` (e.g. output.weight=tok_embeddings.weight)",
+    )
     model = None
     index_ = None
     args = parser.parse_args()
@@ -245,14 +299,4 @@ if __name__ == "__main__":
     else:
         raise Exception("Unknown type")
     writer = Writer(args.output_model)
-    model_keys = all_keys(model, index_)
-    writer.write_tensor_index_padding(model_keys)
-
-    for key in model_keys:
-        tensor = get_tensor(model, key, index_)
-        tensor = tensor.float()
-        offset, size = writer.write_tensor(tensor, key)
-        print(f"Get tensor {key} to {offset} with size {size}")
-
-    writer.write_tensor_index()
-
+    write_model(writer, model, index_, dict(tie.split("=", 1) for tie in args.tie))
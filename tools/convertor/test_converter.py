@@ -0,0 +1,73 @@
+import argparse
+import os
+import struct
+import tempfile
+import unittest
+
+import torch
+
+import converter
+
+
+def read_index(path: str) -> dict:
+    # name -> (size, offset, dtype), see Writer.write_tensor_index
+    index = {}
+    with open(path, "rb") as f:
+        assert struct.unpack("<i", f.read(4))[0] == converter.MAGIC_NUMBER
+        end = 4 + 8 + struct.unpack("<Q", f.read(8))[0]
+        while f.tell() < end:
+            name_len = struct.unpack("<i", f.read(4))[0]
+            if name_len == 0:
+                break
+            name = f.read(name_len).decode("utf-8")
+            size, offset = struct.unpack("<QQ", f.read(16))
+            index[name] = (size, offset, struct.unpack("<i", f.read(4))[0])
+    return index
+
+
+class ConverterTest(unittest.TestCase):
+    # converts a torch checkpoint, returns name -> (data, dtype)
+    def write(self, tensors: dict, widen_bf16: bool = False, ties: dict = None) -> dict:
+        converter.args = argparse.Namespace(type="torch", widen_bf16=widen_bf16)
+        fd, path = tempfile.mkstemp(suffix=".mllm")
+        os.close(fd)
+        self.addCleanup(os.remove, path)
+        writer = converter.Writer(path)
+        converter.write_model(writer, tensors, None, ties or {})
+        writer.close()
+        with open(path, "rb") as f:
+            data = f.read()
+        return {name: (data[offset:offset + size], dtype) for name, (size, offset, dtype) in read_index(path).items()}
+
+    def test_bf16_round_trip(self):
+        matrix = torch.randn(4, 8).to(torch.bfloat16)
+        norm = torch.randn(8).to(torch.bfloat16)
+        written = self.write({"proj.weight": matrix, "norm.weight": norm})
+        data, dtype = written["proj.weight"]
+        self.assertEqual(dtype, 19)
+        back = torch.frombuffer(bytearray(data), dtype=torch.int16).view(torch.bfloat16).reshape(4, 8)
+        self.assertTrue(torch.equal(back, matrix))
+        # no bf16 kernels for vectors
+        data, dtype = written["norm.weight"]
+        self.assertEqual(dtype, 0)
+        self.assertTrue(torch.equal(torch.frombuffer(bytearray(data), dtype=torch.float32), norm.float()))
+
+    def test_widen_bf16(self):
+        matrix = torch.randn(4, 8).to(torch.bfloat16)
+        data, dtype = self.write({"proj.weight": matrix}, widen_bf16=True)["proj.weight"]
+        self.assertEqual(dtype, 0)
+        self.assertEqual(len(data), matrix.numel() * 4)
+
+    def test_ties(self):
+        embedding = torch.randn(4, 8)
+        other = torch.randn(4, 8)
+        written = self.write({"embed.weight": embedding, "head.weight": embedding, "proj.weight": other,
+                              "proj2.weight": other[:2]}, ties={"lm.weight": "proj.weight"})
+        self.assertEqual(written["head.weight"], written["embed.weight"])
+        self.assertEqual(written["lm.weight"], written["proj.weight"])
+        # same storage, not the same tensor
+        self.assertEqual(len(written["proj2.weight"][0]), 2 * 8 * 4)
+
+
+if __name__ == "__main__":
+    unittest.main()